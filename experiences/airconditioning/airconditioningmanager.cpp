@@ -280,7 +280,7 @@ void AirConditioningManager::notificationReceived(const QVariantMap &data)
 
     } else if (notification == "AirConditioning.ZoneChanged") {
         QVariantMap zoneMap = params.value("zone").toMap();
-        qCDebug(dcAirConditioningExperience()) << "Zone changed:" << qUtf8Printable(QJsonDocument::fromVariant(zoneMap).toJson());
+        qCDebug(dcAirConditioningExperience()) << "Zone changed:" << LogPayload(zoneMap);
         QUuid zoneId = zoneMap.value("id").toUuid();
         ZoneInfo *zone = m_zoneInfos->getZoneInfo(zoneId);
         if (!zone) {
@@ -296,7 +296,7 @@ void AirConditioningManager::notificationReceived(const QVariantMap &data)
 void AirConditioningManager::addZoneResponse(int commandId, const QVariantMap &params)
 {
     Q_UNUSED(commandId)
-    qCDebug(dcAirConditioningExperience()) << "Add zone response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcAirConditioningExperience()) << "Add zone response" << LogPayload(params);
     QMetaEnum metaEnum = QMetaEnum::fromType<AirConditioningError>();
     AirConditioningError error = static_cast<AirConditioningError>(metaEnum.keyToValue(params.value("error").toByteArray().data()));
     emit addZoneReply(commandId, error, params.value("zone").toMap().value("id").toUuid());
@@ -313,7 +313,7 @@ void AirConditioningManager::removeZoneResponse(int commandId, const QVariantMap
 void AirConditioningManager::getZonesResponse(int commandId, const QVariantMap &params)
 {
     Q_UNUSED(commandId)
-    qCDebug(dcAirConditioningExperience()) << "get zones response:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcAirConditioningExperience()) << "get zones response:" << LogPayload(params);
 
     foreach (const QVariant &zoneVariant, params.value("zones").toList()) {
         m_zoneInfos->addZoneInfo(unpack(zoneVariant.toMap()));
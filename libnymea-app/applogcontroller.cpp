@@ -29,18 +29,24 @@
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "applogcontroller.h"
+#include "applogwriter.h"
 
 #include <QStandardPaths>
 #include <QDebug>
 #include <QSettings>
 #include <QGuiApplication>
 #include <QDir>
-#include <QMutexLocker>
+#include <QFile>
+#include <QReadLocker>
+#include <QWriteLocker>
 
 #include "logging.h"
 
 QtMessageHandler AppLogController::s_oldLogMessageHandler = nullptr;
 
+// Messages kept in memory for the log viewer
+static const int maxTailSize = 1024;
+
 
 AppLogController::LogLevel AppLogController::qtMsgTypeToLogLevel(QtMsgType msgType)
 {
@@ -109,6 +115,21 @@ AppLogController::AppLogController(QObject *parent) : QObject(parent)
 
     updateFilters();
 
+    qRegisterMetaType<QVector<AppLogRecord>>();
+
+    m_writer = new AppLogWriter();
+    m_writer->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_writer, &QObject::deleteLater);
+    connect(m_writer, &AppLogWriter::recordsAdded, this, &AppLogController::onRecordsAdded);
+    connect(m_writer, &AppLogWriter::droppedMessagesChanged, this, &AppLogController::onDroppedMessagesChanged);
+    m_thread.setObjectName("AppLogWriter");
+    m_thread.start(QThread::LowPriority);
+
+    // The controller usually lives until the very end, make sure nothing is left behind on exit
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this](){
+        QMetaObject::invokeMethod(m_writer, "flush", Qt::BlockingQueuedConnection);
+    });
+
     // Finally, install the logMessageHandler
     s_oldLogMessageHandler = qInstallMessageHandler(&logMessageHandler);
 
@@ -117,6 +138,14 @@ AppLogController::AppLogController(QObject *parent) : QObject(parent)
     }
 }
 
+AppLogController::~AppLogController()
+{
+    qInstallMessageHandler(s_oldLogMessageHandler);
+    QMetaObject::invokeMethod(m_writer, "close", Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
 bool AppLogController::enabled() const
 {
     QSettings settings;
@@ -132,7 +161,7 @@ void AppLogController::setEnabled(bool enabled)
     if (enabled) {
         openLogFile();
     } else {
-        m_logFile.close();
+        QMetaObject::invokeMethod(m_writer, "close", Qt::QueuedConnection);
     }
     QSettings settings;
     settings.setValue("AppLoggingEnabled", enabled);
@@ -146,12 +175,16 @@ LoggingCategories *AppLogController::loggingCategories() const
 
 AppLogController::LogLevel AppLogController::logLevel(const QString &category) const
 {
+    QReadLocker locker(&m_logLevelsLock);
     return m_logLevels.value(category);
 }
 
 void AppLogController::setLogLevel(const QString &category, AppLogController::LogLevel logLevel)
 {
-    m_logLevels[category] = logLevel;
+    {
+        QWriteLocker locker(&m_logLevelsLock);
+        m_logLevels[category] = logLevel;
+    }
 
     QSettings settings;
     settings.beginGroup("LoggingLevels");
@@ -185,9 +218,7 @@ QStringList AppLogController::logFiles() const
 
 QString AppLogController::exportLogs()
 {
-    if (m_logFile.isOpen()) {
-        m_logFile.flush();
-    }
+    QMetaObject::invokeMethod(m_writer, "flush", Qt::BlockingQueuedConnection);
     QFile f(logPath() + "/" + QGuiApplication::applicationName() + "-logs.txt");
     if (!f.open(QFile::WriteOnly)) {
         return QString();
@@ -206,33 +237,50 @@ QString AppLogController::exportLogs()
     return f.fileName();
 }
 
-void AppLogController::logMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+int AppLogController::droppedMessages() const
 {
-    s_oldLogMessageHandler(type, context, message);
-    QMetaObject::invokeMethod(instance(), "append", Q_ARG(QString, context.category), Q_ARG(QString, message), Q_ARG(AppLogController::LogLevel, qtMsgTypeToLogLevel(type)));
+    return m_droppedMessages;
+}
+
+QList<AppLogRecord> AppLogController::tail() const
+{
+    return m_tail;
 }
 
-void AppLogController::append(const QString &category, const QString &message, LogLevel level)
+void AppLogController::logMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
 {
-    if (m_logLevels.value(category) < level) {
+    s_oldLogMessageHandler(type, context, message);
+
+    AppLogController *controller = instance();
+    LogLevel level = qtMsgTypeToLogLevel(type);
+    if (controller->logLevel(QString::fromLatin1(context.category)) < level) {
         return;
     }
 
-    QDateTime timestamp = QDateTime::currentDateTime();
-
-    if (m_logFile.isOpen()) {
-        QHash<LogLevel, QString> t = {
-            {LogLevelDebug, "D"},
-            {LogLevelInfo, "I"},
-            {LogLevelWarning, "W"},
-            {LogLevelCritical, "C"}
-        };
-        QString line = QString("%0:%1:%2: %3\n").arg(timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz"), t.value(level), category, message);
-        m_logFile.write(line.toUtf8());
-        m_logFile.flush();
+    // Formats the message right here and hands it over to the writer thread without blocking
+    controller->m_writer->post(level, context.category, message);
+
+    // We're about to abort, wait for it to hit the disk
+    if (type == QtFatalMsg && QThread::currentThread() != &controller->m_thread) {
+        QMetaObject::invokeMethod(controller->m_writer, "flush", Qt::BlockingQueuedConnection);
     }
+}
 
-    emit messageAdded(timestamp, category, message, level);
+void AppLogController::onRecordsAdded(const QVector<AppLogRecord> &records)
+{
+    foreach (const AppLogRecord &record, records) {
+        m_tail.append(record);
+    }
+    if (m_tail.count() > maxTailSize) {
+        m_tail.erase(m_tail.begin(), m_tail.begin() + (m_tail.count() - maxTailSize));
+    }
+    emit messagesAdded(records);
+}
+
+void AppLogController::onDroppedMessagesChanged(quint64 droppedMessages)
+{
+    m_droppedMessages = static_cast<int>(droppedMessages);
+    emit droppedMessagesChanged();
 }
 
 void AppLogController::updateFilters()
@@ -240,6 +288,7 @@ void AppLogController::updateFilters()
     QStringList loggingRules = {"*.warn=false", "*.info=false", "*.debug=false"};
 
     // Load the rules from nymead.conf file and append them to the rules
+    QReadLocker locker(&m_logLevelsLock);
     foreach (const QString &category, nymeaLoggingCategories()) {
         LogLevel level = m_logLevels.value(category, LogLevelWarning);
         loggingRules << QString("%1.debug=%2").arg(category).arg(level >= LogLevelDebug ? "true" : "false");
@@ -247,68 +296,23 @@ void AppLogController::updateFilters()
         loggingRules << QString("%1.warn=%2").arg(category).arg(level >= LogLevelWarning ? "true" : "false");
     }
     loggingRules << "qt.qml.connections.warning=false";
+    locker.unlock();
 
     QLoggingCategory::setFilterRules(loggingRules.join('\n'));
 }
 
 void AppLogController::openLogFile()
 {
-    // Make sure log dir exists
-    if (!QDir().mkpath(logPath())) {
-        qWarning() << "Cannot create cache location. Logging will not work.";
-    }
-
-    // Rotate old log files, keeping the last 5
-    for (int i = 4; i > 0; i--) {
-        if (QFile::exists(currentLogFile() + "." + QString::number(i))) {
-            if (QFile::exists(currentLogFile() + "." + QString::number(i + 1))) {
-                QFile::remove(currentLogFile() + "." + QString::number(i + 1));
-            }
-            QFile::rename(currentLogFile() + "." + QString::number(i), currentLogFile() + "." + QString::number(i + 1));
-        }
-    }
-    if (QFile::exists(currentLogFile())) {
-        QFile::rename(currentLogFile(), currentLogFile() + ".1");
-    }
-
-    m_logFile.setFileName(currentLogFile());
-    if (!m_logFile.open(QFile::ReadWrite | QFile::Truncate)) {
-        qWarning() << "Cannot open logfile for writing.";
-    } else {
-        qDebug() << "App log opened at" << m_logFile.fileName();
-    }
+    // Rotates old log files, keeping the last 5
+    QMetaObject::invokeMethod(m_writer, "open", Qt::QueuedConnection, Q_ARG(QString, currentLogFile()));
 }
 
 LogMessages::LogMessages(QObject *parent):
     QAbstractListModel(parent)
 {
-    QFile f(AppLogController::instance()->currentLogFile());
-    if (!f.open(QFile::ReadOnly)) {
-        return;
-    }
-    QHash<QString, AppLogController::LogLevel> map = {
-        {"C", AppLogController::LogLevelCritical},
-        {"W", AppLogController::LogLevelWarning},
-        {"I", AppLogController::LogLevelInfo},
-        {"D", AppLogController::LogLevelDebug}
-    };
-    while (!f.atEnd()) {
-        QByteArray line = f.readLine().trimmed();
-        QList<QByteArray> parts = line.split(':');
-        if (parts.length() < 6) {
-            continue;
-        }
-        LogMessage message;
-        QString timestampString = parts.takeFirst();
-        timestampString.append(":" + parts.takeFirst());
-        timestampString.append(":" + parts.takeFirst());
-        message.timestamp = QDateTime::fromString(timestampString, "yyyy-MM-dd hh:mm:ss.zzz");
-        message.level = map.value(parts.takeFirst());
-        message.category = parts.takeFirst();
-        message.message = parts.join(":");
-        m_messages.append(message);
-    }
-    connect(AppLogController::instance(), &AppLogController::messageAdded, this, &LogMessages::append);
+    // Start off with what the controller has in memory instead of parsing the log file
+    m_messages = AppLogController::instance()->tail();
+    connect(AppLogController::instance(), &AppLogController::messagesAdded, this, &LogMessages::append);
 }
 
 int LogMessages::rowCount(const QModelIndex &parent) const
@@ -319,10 +323,10 @@ int LogMessages::rowCount(const QModelIndex &parent) const
 
 QVariant LogMessages::data(const QModelIndex &index, int role) const
 {
-    LogMessage message = m_messages.at(index.row());
+    const AppLogRecord &message = m_messages.at(index.row());
     switch (role) {
     case RoleTimestamp:
-        return message.timestamp;
+        return QDateTime::fromMSecsSinceEpoch(message.timestamp);
     case RoleCategory:
         return message.category;
     case RoleMessage:
@@ -330,7 +334,7 @@ QVariant LogMessages::data(const QModelIndex &index, int role) const
     case RoleLevel:
         return message.level;
     case RoleText:
-        return message.timestamp.toString("hh:mm:ss") + ": " + message.category + ": " + message.message;
+        return QDateTime::fromMSecsSinceEpoch(message.timestamp).toString("hh:mm:ss") + ": " + message.category + ": " + message.message;
     }
     return QVariant();
 }
@@ -346,21 +350,23 @@ QHash<int, QByteArray> LogMessages::roleNames() const
     return roles;
 }
 
-void LogMessages::append(const QDateTime &timestamp, const QString &category, const QString &message, AppLogController::LogLevel level)
+void LogMessages::append(const QVector<AppLogRecord> &records)
 {
-    beginInsertRows(QModelIndex(), m_messages.count(), m_messages.count());
-    LogMessage msg;
-    msg.timestamp = timestamp;
-    msg.category = category;
-    msg.message = message;
-    msg.level = level;
-    m_messages.append(msg);
+    if (records.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_messages.count(), m_messages.count() + records.count() - 1);
+    foreach (const AppLogRecord &record, records) {
+        m_messages.append(record);
+    }
     endInsertRows();
 
     int maxEntries = 1024;
     if (m_messages.size() > maxEntries) {
-        beginRemoveRows(QModelIndex(), 0, 0);
-        m_messages.removeFirst();
+        int excess = m_messages.size() - maxEntries;
+        beginRemoveRows(QModelIndex(), 0, excess - 1);
+        m_messages.erase(m_messages.begin(), m_messages.begin() + excess);
         endRemoveRows();
     }
 }
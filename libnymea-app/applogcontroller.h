@@ -32,14 +32,17 @@
 #define APPLOGCONTROLLER_H
 
 #include <QObject>
-#include <QFile>
+#include <QVector>
 #include <QQmlEngine>
 #include <QAbstractListModel>
-#include <QMutex>
+#include <QReadWriteLock>
+#include <QThread>
 #include <QDateTime>
 
 class LogMessages;
 class LoggingCategories;
+class AppLogWriter;
+struct AppLogRecord;
 
 class AppLogController : public QObject
 {
@@ -47,6 +50,7 @@ class AppLogController : public QObject
     Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
 
     Q_PROPERTY(LoggingCategories* loggingCategories READ loggingCategories CONSTANT)
+    Q_PROPERTY(int droppedMessages READ droppedMessages NOTIFY droppedMessagesChanged)
 
 public:
     // Note: QtMsgType is sorted in a way that we can't compare for >= etc
@@ -62,6 +66,7 @@ public:
 
     static QObject* appLogControllerProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
     static AppLogController* instance();
+    ~AppLogController() override;
 
     bool enabled() const;
     void setEnabled(bool enabled);
@@ -76,12 +81,23 @@ public:
 
     Q_INVOKABLE QString exportLogs();
 
+    // Messages that couldn't be logged because the writer fell behind
+    int droppedMessages() const;
+
+    // The most recent messages, oldest first
+    QList<AppLogRecord> tail() const;
+
 signals:
     void enabledChanged();
     void logToModelChanged();
 
     void categoryChanged(const QString &category, LogLevel level);
-    void messageAdded(const QDateTime &timestamp, const QString &category, const QString &message, LogLevel level);
+    void messagesAdded(const QVector<AppLogRecord> &records);
+    void droppedMessagesChanged();
+
+private slots:
+    void onRecordsAdded(const QVector<AppLogRecord> &records);
+    void onDroppedMessagesChanged(quint64 droppedMessages);
 
 private:
     explicit AppLogController(QObject *parent = nullptr);
@@ -89,19 +105,33 @@ private:
     static QtMessageHandler s_oldLogMessageHandler;
     static void logMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
 
-    Q_INVOKABLE void append(const QString &category, const QString &message, AppLogController::LogLevel level);
-
     void updateFilters();
     void openLogFile();
 
+    // Read by the message handler in whatever thread logs
+    mutable QReadWriteLock m_logLevelsLock;
     QHash<QString, LogLevel> m_logLevels;
 
-    QMutex m_mutex;
-    QFile m_logFile;
+    QThread m_thread;
+    AppLogWriter *m_writer = nullptr;
+    QList<AppLogRecord> m_tail;
+    int m_droppedMessages = 0;
+
     LoggingCategories *m_loggingCategories = nullptr;
 };
 Q_DECLARE_METATYPE(AppLogController::LogLevel)
 
+// A log message on its way from the message handler through the writer to the log viewer
+struct AppLogRecord {
+    qint64 timestamp = 0; // msecs since epoch
+    AppLogController::LogLevel level = AppLogController::LogLevelCritical;
+    QString category;
+    QString message;
+    // Preformatted for the log file, emptied once written
+    QByteArray line;
+};
+Q_DECLARE_METATYPE(AppLogRecord)
+
 class LogMessages: public QAbstractListModel
 {
     Q_OBJECT
@@ -116,13 +146,6 @@ public:
     };
     Q_ENUM(Roles)
 
-    struct LogMessage {
-        QDateTime timestamp;
-        QString category;
-        QString message;
-        AppLogController::LogLevel level;
-    };
-
     LogMessages(QObject *parent = nullptr);
 
     int rowCount(const QModelIndex &parent) const override;
@@ -130,10 +153,10 @@ public:
     QHash<int, QByteArray> roleNames() const override;
 
 private slots:
-    void append(const QDateTime &timestamp, const QString &category, const QString &message, AppLogController::LogLevel level);
+    void append(const QVector<AppLogRecord> &records);
 
 private:
-    QList<LogMessage> m_messages;
+    QList<AppLogRecord> m_messages;
 };
 
 class LoggingCategories: public QAbstractListModel
@@ -0,0 +1,301 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "applogwriter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+#include <cstring>
+
+// Must be a power of two
+static const quint64 ringCapacity = 4096;
+// Collected lines are written once there are that many bytes...
+static const int writeSize = 64 * 1024;
+// ...or that many ms after the first one
+static const int writeInterval = 500;
+// The log file is rotated once it grows beyond that, keeping the last rotatedFiles
+static const qint64 maxFileSize = 5 * 1024 * 1024;
+static const int rotatedFiles = 5;
+
+// Indexed by AppLogController::LogLevel
+static const char levelLetters[] = {'C', 'W', 'I', 'D'};
+
+static char *formatNumber(char *out, int value, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = '0' + value % 10;
+        value /= 10;
+    }
+    return out + digits;
+}
+
+// Same as QDateTime::toString("yyyy-MM-dd hh:mm:ss.zzz"), without parsing the format every time
+static const int timestampLength = 23;
+static char *formatTimestamp(char *out, const QDateTime &timestamp)
+{
+    QDate date = timestamp.date();
+    QTime time = timestamp.time();
+    out = formatNumber(out, date.year(), 4);
+    *out++ = '-';
+    out = formatNumber(out, date.month(), 2);
+    *out++ = '-';
+    out = formatNumber(out, date.day(), 2);
+    *out++ = ' ';
+    out = formatNumber(out, time.hour(), 2);
+    *out++ = ':';
+    out = formatNumber(out, time.minute(), 2);
+    *out++ = ':';
+    out = formatNumber(out, time.second(), 2);
+    *out++ = '.';
+    return formatNumber(out, time.msec(), 3);
+}
+
+static AppLogRecord makeRecord(AppLogController::LogLevel level, const char *category, const QString &message)
+{
+    QDateTime now = QDateTime::currentDateTime();
+    QByteArray text = message.toUtf8();
+    int categoryLength = qstrlen(category);
+
+    AppLogRecord record;
+    record.timestamp = now.toMSecsSinceEpoch();
+    record.level = level;
+    record.category = QString::fromLatin1(category, categoryLength);
+    record.message = message;
+
+    // "<timestamp>:<level>:<category>: <message>\n"
+    record.line.resize(timestampLength + 3 + categoryLength + 2 + text.length() + 1);
+    char *out = formatTimestamp(record.line.data(), now);
+    *out++ = ':';
+    *out++ = levelLetters[level];
+    *out++ = ':';
+    memcpy(out, category, categoryLength);
+    out += categoryLength;
+    *out++ = ':';
+    *out++ = ' ';
+    memcpy(out, text.constData(), text.length());
+    out += text.length();
+    *out = '\n';
+    return record;
+}
+
+AppLogWriter::AppLogWriter(QObject *parent):
+    QObject(parent),
+    m_slots(new Slot[ringCapacity]),
+    m_enqueuePos(0),
+    m_drainScheduled(false),
+    m_dropped(0),
+    m_flushTimer(this)
+{
+    for (quint64 i = 0; i < ringCapacity; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(writeInterval);
+    connect(&m_flushTimer, &QTimer::timeout, this, &AppLogWriter::writeBuffer);
+}
+
+AppLogWriter::~AppLogWriter()
+{
+    delete[] m_slots;
+}
+
+bool AppLogWriter::post(AppLogController::LogLevel level, const char *category, const QString &message)
+{
+    AppLogRecord record = makeRecord(level, category ? category : "default", message);
+    bool pushed = push(record);
+    if (!pushed) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Only one drain is queued at a time, no matter how many messages come in meanwhile
+    if (!m_drainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+    }
+    return pushed;
+}
+
+quint64 AppLogWriter::droppedMessages() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void AppLogWriter::open(const QString &fileName)
+{
+    close();
+
+    if (!QDir().mkpath(QFileInfo(fileName).absolutePath())) {
+        qWarning() << "Cannot create cache location. Logging will not work.";
+    }
+
+    m_file.setFileName(fileName);
+    rotate();
+    if (m_file.isOpen()) {
+        qDebug() << "App log opened at" << m_file.fileName();
+    }
+}
+
+void AppLogWriter::close()
+{
+    flush();
+    m_file.close();
+}
+
+void AppLogWriter::flush()
+{
+    drain();
+    writeBuffer();
+}
+
+void AppLogWriter::drain()
+{
+    // Reset before draining, anything posted from now on schedules another run
+    m_drainScheduled.store(false);
+
+    QVector<AppLogRecord> records;
+    bool critical = false;
+    AppLogRecord record;
+    while (pop(&record)) {
+        if (m_file.isOpen()) {
+            m_buffer.append(record.line);
+        }
+        // Not needed any more, no need to keep it around in the viewer
+        record.line.clear();
+        critical |= record.level == AppLogController::LogLevelCritical;
+        records.append(record);
+        record = AppLogRecord();
+    }
+
+    quint64 dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_droppedReported) {
+        record = makeRecord(AppLogController::LogLevelWarning, "AppLog", QString("Dropped %1 log messages").arg(dropped - m_droppedReported));
+        if (m_file.isOpen()) {
+            m_buffer.append(record.line);
+        }
+        record.line.clear();
+        records.append(record);
+        m_droppedReported = dropped;
+        emit droppedMessagesChanged(dropped);
+    }
+
+    if (!records.isEmpty()) {
+        emit recordsAdded(records);
+    }
+
+    if (critical || m_buffer.size() >= writeSize) {
+        writeBuffer();
+    } else if (!m_buffer.isEmpty() && !m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+bool AppLogWriter::push(AppLogRecord &record)
+{
+    // Bounded multi producer queue: a producer claims a position by advancing m_enqueuePos
+    // and publishes the slot by bumping its sequence once the record is in place
+    quint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    forever {
+        slot = &m_slots[pos & (ringCapacity - 1)];
+        quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        qint64 diff = static_cast<qint64>(sequence - pos);
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The writer hasn't consumed this slot from the previous round yet
+            return false;
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    qSwap(slot->record, record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool AppLogWriter::pop(AppLogRecord *record)
+{
+    Slot *slot = &m_slots[m_dequeuePos & (ringCapacity - 1)];
+    quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+    if (static_cast<qint64>(sequence - (m_dequeuePos + 1)) < 0) {
+        return false;
+    }
+    // record is empty, swapping leaves the slot empty for the next round
+    qSwap(*record, slot->record);
+    slot->sequence.store(m_dequeuePos + ringCapacity, std::memory_order_release);
+    m_dequeuePos++;
+    return true;
+}
+
+void AppLogWriter::writeBuffer()
+{
+    m_flushTimer.stop();
+    if (m_buffer.isEmpty()) {
+        return;
+    }
+    if (m_file.isOpen()) {
+        m_file.write(m_buffer);
+        m_file.flush();
+    }
+    m_buffer.clear();
+
+    if (m_file.isOpen() && m_file.size() >= maxFileSize) {
+        rotate();
+    }
+}
+
+void AppLogWriter::rotate()
+{
+    m_file.close();
+
+    QString fileName = m_file.fileName();
+    for (int i = rotatedFiles - 1; i > 0; i--) {
+        if (QFile::exists(fileName + "." + QString::number(i))) {
+            if (QFile::exists(fileName + "." + QString::number(i + 1))) {
+                QFile::remove(fileName + "." + QString::number(i + 1));
+            }
+            QFile::rename(fileName + "." + QString::number(i), fileName + "." + QString::number(i + 1));
+        }
+    }
+    if (QFile::exists(fileName)) {
+        if (QFile::exists(fileName + ".1")) {
+            QFile::remove(fileName + ".1");
+        }
+        QFile::rename(fileName, fileName + ".1");
+    }
+
+    if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "Cannot open logfile for writing.";
+    }
+}
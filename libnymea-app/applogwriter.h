@@ -0,0 +1,104 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef APPLOGWRITER_H
+#define APPLOGWRITER_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QVector>
+
+#include <atomic>
+
+#include "applogcontroller.h"
+
+/*
+ * Background part of the AppLogController. Messages are formatted by whichever thread logs
+ * them and handed over through a fixed size, lock-free ring buffer, so logging never waits
+ * for the disk or the GUI thread. If the ring is full, messages are dropped and counted.
+ *
+ * The writer lives in its own thread and drains the ring in batches. Lines are collected and
+ * written once enough has piled up or a short while after the first unwritten one, critical
+ * messages are written right away. The log file is rotated when it grows too large.
+ */
+class AppLogWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppLogWriter(QObject *parent = nullptr);
+    ~AppLogWriter() override;
+
+    // Thread safe, may be called from any thread. Returns false if the message had to be dropped.
+    bool post(AppLogController::LogLevel level, const char *category, const QString &message);
+
+    // Messages dropped since the writer has been created
+    quint64 droppedMessages() const;
+
+public slots:
+    // Rotates existing log files and starts a new one
+    void open(const QString &fileName);
+    void close();
+    // Drains the ring and writes everything collected so far to the disk
+    void flush();
+
+signals:
+    // Emitted for every drained batch, whether or not a log file is open
+    void recordsAdded(const QVector<AppLogRecord> &records);
+    void droppedMessagesChanged(quint64 droppedMessages);
+
+private slots:
+    void drain();
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence;
+        AppLogRecord record;
+    };
+
+    bool push(AppLogRecord &record);
+    bool pop(AppLogRecord *record);
+
+    void writeBuffer();
+    void rotate();
+
+    Slot *m_slots = nullptr;
+    std::atomic<quint64> m_enqueuePos;
+    quint64 m_dequeuePos = 0;
+    std::atomic<bool> m_drainScheduled;
+    std::atomic<quint64> m_dropped;
+    quint64 m_droppedReported = 0;
+
+    QFile m_file;
+    QByteArray m_buffer;
+    QTimer m_flushTimer;
+};
+
+#endif // APPLOGWRITER_H
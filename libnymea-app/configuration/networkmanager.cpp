@@ -38,7 +38,6 @@
 #include "jsonrpc/jsonrpcclient.h"
 
 #include <QMetaEnum>
-#include <QJsonDocument>
 
 #include "logging.h"
 
@@ -219,7 +218,7 @@ void NetworkManager::getStatusResponse(int /*commandId*/, const QVariantMap &par
     emit loadingChanged();
 
     if (params.value("networkManagerError").toString() != "NetworkManagerErrorNoError") {
-        qWarning() << "NetworkManager error:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+        qWarning() << "NetworkManager error:" << LogPayload(params);
         m_available = false;
         emit availableChanged();
         return;
@@ -251,7 +250,7 @@ void NetworkManager::getStatusResponse(int /*commandId*/, const QVariantMap &par
 
 void NetworkManager::getDevicesResponse(int /*commandId*/, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "Devices reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "Devices reply" << LogPayload(params);
 
     foreach (const QVariant &deviceVariant, params.value("wiredNetworkDevices").toList()) {
         QVariantMap deviceMap = deviceVariant.toMap();
@@ -287,7 +286,7 @@ void NetworkManager::getDevicesResponse(int /*commandId*/, const QVariantMap &pa
 
 void NetworkManager::getAccessPointsResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "Access points reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "Access points reply" << LogPayload(params);
 
     if (!m_apRequests.contains(commandId)) {
         qWarning() << "NetworkManager received a reply for a request we don't know!";
@@ -318,35 +317,35 @@ void NetworkManager::getAccessPointsResponse(int commandId, const QVariantMap &p
 
 void NetworkManager::connectToWiFiResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "connect to wifi reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "connect to wifi reply" << LogPayload(params);
     QString status = params.value("networkManagerError").toString();
     emit connectToWiFiReply(commandId, status);
 }
 
 void NetworkManager::disconnectResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "disconnect reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "disconnect reply" << LogPayload(params);
     QString status = params.value("networkManagerError").toString();
     emit disconnectReply(commandId, status);
 }
 
 void NetworkManager::enableNetworkingResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "enable networking reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "enable networking reply" << LogPayload(params);
     QString status = params.value("networkManagerError").toString();
     emit enableNetworkingReply(commandId, status);
 }
 
 void NetworkManager::enableWirelessNetworkingResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "enable wireless networking reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "enable wireless networking reply" << LogPayload(params);
     QString status = params.value("networkManagerError").toString();
     emit enableWirelessNetworkingReply(commandId, status);
 }
 
 void NetworkManager::startAccessPointResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "Start access point reply" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    qCDebug(dcNetworkManagement) << "Start access point reply" << LogPayload(params);
     QString status = params.value("networkManagerError").toString();
     emit startAccessPointReply(commandId, status);
 }
@@ -371,7 +370,7 @@ void NetworkManager::createWiredSharedConnectionResponse(int commandId, const QV
 
 void NetworkManager::notificationReceived(const QVariantMap &params)
 {
-    qCDebug(dcNetworkManagement) << "Network management Notification:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcNetworkManagement) << "Network management Notification:" << LogPayload(params);
 
     QString notification = params.value("notification").toString();
     if (notification == "NetworkManager.WirelessNetworkDeviceAdded") {
@@ -466,6 +465,6 @@ void NetworkManager::notificationReceived(const QVariantMap &params)
         }
 
     } else {
-        qCWarning(dcNetworkManagement) << "Unhandled notification received" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+        qCWarning(dcNetworkManagement) << "Unhandled notification received" << LogPayload(params);
     }
 }
@@ -283,7 +283,7 @@ void NymeaConfiguration::deleteMqttPolicy(const QString &clientId)
 void NymeaConfiguration::getConfigurationsResponse(int commandId, const QVariantMap &params)
 {
     Q_UNUSED(commandId)
-    qCDebug(dcNymeaConfiguration) << "GetConfigurations response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcNymeaConfiguration) << "GetConfigurations response" << LogPayload(params);
     QVariantMap basicConfig = params.value("basicConfiguration").toMap();
     m_debugServerEnabled = basicConfig.value("debugServerEnabled").toBool();
     emit debugServerEnabledChanged();
@@ -437,7 +437,7 @@ void NymeaConfiguration::deleteMqttPolicyReply(int commandId, const QVariantMap
 
 void NymeaConfiguration::notificationReceived(const QVariantMap &notification)
 {
-    qCDebug(dcNymeaConfiguration()) << "Config notification received" << qUtf8Printable(QJsonDocument::fromVariant(notification).toJson());
+    qCDebug(dcNymeaConfiguration()) << "Config notification received" << LogPayload(notification);
     QString notif = notification.value("notification").toString();
     QVariantMap params = notification.value("params").toMap();
 
@@ -595,6 +595,6 @@ void NymeaConfiguration::notificationReceived(const QVariantMap &notification)
         qCInfo(dcNymeaConfiguration()) << "MQTT policy removed" << policy->clientId() << policy->username() << policy->password();
         m_mqttPolicies->removePolicy(policy);
     } else {
-        qCWarning(dcNymeaConfiguration) << "Unhandled Configuration notification" << qUtf8Printable(QJsonDocument::fromVariant(notification).toJson());
+        qCWarning(dcNymeaConfiguration) << "Unhandled Configuration notification" << LogPayload(notification);
     }
 }
@@ -43,12 +43,19 @@
 #include <QTimer>
 #include <QGuiApplication>
 
+#include <algorithm>
+
 #include "networkreachabilitymonitor.h"
 #include "nymeatransportinterface.h"
 #include "logging.h"
 
 NYMEA_LOGGING_CATEGORY(dcNymeaConnection, "NymeaConnection")
 
+// Head start for each candidate in a connection race before the next one is started
+static const int connectionAttemptDelay = 250;
+// How long a transport we migrated away from may still deliver replies
+static const int drainTimeout = 10000;
+
 NymeaConnection::NymeaConnection(QObject *parent) : QObject(parent)
 {
     m_networkReachabilityMonitor = new NetworkReachabilityMonitor(this);
@@ -85,6 +92,25 @@ NymeaConnection::NymeaConnection(QObject *parent) : QObject(parent)
         }
     });
 
+    m_clock.start();
+
+    m_raceTimer.setInterval(connectionAttemptDelay);
+    m_raceTimer.setSingleShot(true);
+    connect(&m_raceTimer, &QTimer::timeout, this, [this](){
+        if (!m_currentTransport) {
+            startNextCandidate();
+        } else {
+            m_pendingCandidates.clear();
+        }
+    });
+
+    m_drainTimer.setInterval(drainTimeout);
+    m_drainTimer.setSingleShot(true);
+    connect(&m_drainTimer, &QTimer::timeout, this, [this](){
+        qCInfo(dcNymeaConnection()) << "Timeout waiting for the previous transport to drain.";
+        finishDraining();
+    });
+
     m_reconnectTimer.setInterval(500);
     m_reconnectTimer.setSingleShot(true);
     connect(&m_reconnectTimer, &QTimer::timeout, this, [this](){
@@ -147,6 +173,12 @@ void NymeaConnection::setCurrentHost(NymeaHost *host)
     }
 
 
+    m_raceTimer.stop();
+    m_pendingCandidates.clear();
+    m_drainTimer.stop();
+    m_drainingTransport = nullptr;
+    m_attemptStarts.clear();
+
     if (m_currentTransport) {
         m_currentTransport = nullptr;
         emit currentConnectionChanged();
@@ -199,6 +231,58 @@ void NymeaConnection::sendData(const QByteArray &data)
     }
 }
 
+void NymeaConnection::finishDraining()
+{
+    if (!m_drainingTransport) {
+        return;
+    }
+    NymeaTransportInterface *transport = m_drainingTransport;
+    m_drainingTransport = nullptr;
+    m_drainTimer.stop();
+
+    qCInfo(dcNymeaConnection()) << "Closing previous transport" << transport->url();
+    QObject::disconnect(transport, nullptr, this, nullptr);
+    transport->disconnect();
+    m_transportCandidates.remove(transport);
+    m_attemptStarts.remove(transport);
+    transport->deleteLater();
+
+    emit drainingFinished();
+}
+
+bool NymeaConnection::abortMigration()
+{
+    NymeaTransportInterface *transport = m_currentTransport;
+    if (!transport) {
+        return false;
+    }
+
+    if (!m_drainingTransport) {
+        // Nothing to go back to. Drop the session, the usual reconnect takes over.
+        qCWarning(dcNymeaConnection()) << "Migration to" << transport->url() << "failed and the previous transport is gone already. Reconnecting.";
+        transport->disconnect();
+        return false;
+    }
+
+    qCWarning(dcNymeaConnection()) << "Migration to" << transport->url() << "failed. Going back to" << m_drainingTransport->url();
+    m_currentTransport = m_drainingTransport;
+    m_drainingTransport = nullptr;
+    m_drainTimer.stop();
+
+    Connection *connection = m_transportCandidates.value(transport);
+    if (connection) {
+        connection->addFailure();
+    }
+    QObject::disconnect(transport, nullptr, this, nullptr);
+    transport->disconnect();
+    m_transportCandidates.remove(transport);
+    m_attemptStarts.remove(transport);
+    transport->deleteLater();
+
+    emit currentConnectionChanged();
+    return true;
+}
+
 void NymeaConnection::onSslErrors(const QList<QSslError> &errors)
 {
     NymeaTransportInterface *transport = qobject_cast<NymeaTransportInterface*>(sender());
@@ -268,12 +352,34 @@ void NymeaConnection::onError(QAbstractSocket::SocketError error)
         return;
     }
 
-    if (!m_currentTransport) {
+    if (transport == m_drainingTransport) {
+        // Nothing more to expect from it, its disconnected() will close it
+        qCDebug(dcNymeaConnection()) << "Draining transport failed:" << error;
+        return;
+    }
+
+    Connection *connection = m_transportCandidates.value(transport);
+    if (connection) {
+        connection->addFailure();
+    }
+
+    // Either a candidate racing to connect or one probed while connected already, it's done for
+    // in both cases. Drop it so the connection may be tried again later.
+    if (m_transportCandidates.contains(transport)) {
+        m_transportCandidates.remove(transport);
+        m_attemptStarts.remove(transport);
+        transport->deleteLater();
+    }
+
+    if (m_currentTransport) {
+        qCInfo(dcNymeaConnection()) << "Probing" << transport->url() << "failed:" << error;
+    } else {
         // We're trying to connect and one of the transports failed...
-        if (m_transportCandidates.contains(transport)) {
-            m_transportCandidates.remove(transport);
-            transport->deleteLater();
+        // Don't wait for its head start to run out, give the next candidate a go right away
+        if (!m_pendingCandidates.isEmpty()) {
+            startNextCandidate();
         }
+
         qCWarning(dcNymeaConnection()) << "A transport error happened for" << transport->url() << error << "(Still trying on" << m_transportCandidates.count() << "connections)";
         foreach (Connection *c, m_transportCandidates) {
             qCDebug(dcNymeaConnection()) << "Connection candidate:" << c->url();
@@ -293,9 +399,18 @@ void NymeaConnection::onError(QAbstractSocket::SocketError error)
 void NymeaConnection::onConnected()
 {
     NymeaTransportInterface* newTransport = qobject_cast<NymeaTransportInterface*>(sender());
+    Connection *connection = m_transportCandidates.value(newTransport);
+    if (connection && m_attemptStarts.contains(newTransport)) {
+        connection->addRoundTripTime(m_clock.elapsed() - m_attemptStarts.take(newTransport));
+    }
+
     if (!m_currentTransport) {
+        // First one wins the race, no need to start any more candidates
+        m_raceTimer.stop();
+        m_pendingCandidates.clear();
+
         m_currentTransport = newTransport;
-        qCInfo(dcNymeaConnection()) << "Connected to" << m_currentHost->name() << "via" << m_currentTransport->url() << m_currentTransport->isEncrypted();
+        qCInfo(dcNymeaConnection()) << "Connected to" << m_currentHost->name() << "via" << m_currentTransport->url() << m_currentTransport->isEncrypted() << "in" << (connection ? connection->roundTripTime() : -1) << "ms";
 #ifdef Q_OS_IOS
         // We can't know for sure which transport we're actually using, but let's assume the OS picked from the available ones in the order LAN, WiFi, MobileData
         if (m_networkReachabilityMonitor->availableBearerTypes().testFlag(NymeaConnection::BearerTypeEthernet)) {
@@ -313,27 +428,18 @@ void NymeaConnection::onConnected()
     }
 
     if (m_currentTransport != newTransport) {
-        // In theory, we could roam from one connection to another.
-        // However, in practice it turns out there are too many issues for this to be reliable
-        // So lets just tear down any alternative connection that comes up again.
+        // A candidate which lost the race, or one we've been probing, came up. The current transport
+        // stays in place until this one is up, so switching over to it is safe. Only do so if it's
+        // clearly faster though, and let one migration finish before starting another.
+        Connection *currentConnection = m_transportCandidates.value(m_currentTransport);
+        if (!m_drainingTransport && connection && currentConnection && isBetter(connection, currentConnection)) {
+            migrate(newTransport);
+            return;
+        }
 
         qCInfo(dcNymeaConnection()) << "Dropping successfully established alternative connection to" << newTransport->url() << "again...";
         m_transportCandidates.remove(newTransport);
         newTransport->deleteLater();
-
-
-//        Connection *existingConnection = m_transportCandidates.value(m_currentTransport);
-//        Connection *alternativeConnection = m_transportCandidates.value(newTransport);
-//        if (alternativeConnection->priority() > existingConnection->priority()) {
-//            qDebug() << "New connection has higher priority! Roaming from" << existingConnection->url() << existingConnection->priority() << "to" << alternativeConnection->url() << alternativeConnection->priority();
-//            m_transportCandidates.remove(m_currentTransport);
-//            m_currentTransport->deleteLater();
-//            m_currentTransport = newTransport;
-//        } else {
-//            qDebug() << "Connection" << alternativeConnection->url() << alternativeConnection->priority() << "has lower priority than existing" << existingConnection->url() << existingConnection->priority();
-//            m_transportCandidates.remove(newTransport);
-//            newTransport->deleteLater();
-//        }
         return;
     }
 }
@@ -342,11 +448,16 @@ void NymeaConnection::onDisconnected()
 {
     NymeaTransportInterface* t = qobject_cast<NymeaTransportInterface*>(sender());
     qCInfo(dcNymeaConnection()) << "Disconnected from" << t->url().toString();
+    if (t == m_drainingTransport) {
+        finishDraining();
+        return;
+    }
     if (m_currentTransport != t) {
         qCDebug(dcNymeaConnection()) << "An inactive transport for url" << t->url() << "disconnected... Cleaning up...";
         if (m_transportCandidates.contains(t)) {
             m_transportCandidates.remove(t);
         }
+        m_attemptStarts.remove(t);
         t->deleteLater();
 
         qCDebug(dcNymeaConnection()) << "Current transport:" << m_currentTransport << "Remaining connections:" << m_transportCandidates.count() << "Current host:" << m_currentHost;
@@ -365,7 +476,7 @@ void NymeaConnection::onDisconnected()
     m_currentTransport = nullptr;
 
     foreach (NymeaTransportInterface *candidate, m_transportCandidates.keys()) {
-        if (candidate->connectionState() == NymeaTransportInterface::ConnectionStateConnected) {
+        if (candidate != m_drainingTransport && candidate->connectionState() == NymeaTransportInterface::ConnectionStateConnected) {
             qCInfo(dcNymeaConnection()) << "Alternative connection is still up. Roaming to:" << candidate->url();
             m_currentTransport = candidate;
             break;
@@ -397,6 +508,8 @@ void NymeaConnection::onDataAvailable(const QByteArray &data)
     if (t == m_currentTransport) {
 //        qCDebug(dcNymeaConnection()) << "Data available";
         emit dataAvailable(data);
+    } else if (t == m_drainingTransport) {
+        emit drainingDataAvailable(data);
     } else {
         qCDebug(dcNymeaConnection()) << "Received data from a transport that is not the current one:" << t->url();
     }
@@ -410,16 +523,17 @@ void NymeaConnection::onAvailableBearerTypesUpdated()
         return;
     }
 
-    // In theory we could try to connect via any different/new bearers now. However, in practice
-    // I have observed the following issues:
+    // Roaming by tearing down the current connection has the following issues in practice:
     // - When roaming from WiFi to mobile data, we've already lost WiFi at this point
     //   (Unless aggressive WiFi to mobile handover is enabled on the phone)
     // - When roaming from mobile to Wifi, for some reason, any new connection attempts
     //   fail as long as the mobile data isn't shut down by the OS.
-    // Those issues prevent roaming from working properly, so let's just not do anything at
-    // this point if there already is a connected channel, try reconnecting otherwise.
+    // So if there already is a connected channel, only probe for faster ones in the background
+    // and keep using the current one unless a probe succeeds. Try reconnecting otherwise.
 
-    if (!m_currentTransport) {
+    if (m_currentTransport) {
+        probeBetterConnections();
+    } else {
         // There's a host but no connection. Try connecting now...
         qCInfo(dcNymeaConnection()) << "There's a host but no connection. Trying to connect now...";
         connectInternal(m_currentHost);
@@ -431,6 +545,9 @@ void NymeaConnection::hostConnectionsUpdated()
     if (!m_currentTransport) {
         qCInfo(dcNymeaConnection()) << "Possible connections for host" << m_currentHost->name() << "updated.";
         connectInternal(m_currentHost);
+    } else {
+        // e.g. the host has been discovered in the LAN again while we're connected through the cloud
+        probeBetterConnections();
     }
 }
 
@@ -463,17 +580,78 @@ void NymeaConnection::connectInternal(NymeaHost *host)
         qCWarning(dcNymeaConnection()) << "Preferred connection set but no bearer available for it.";
     }
 
+    // Race the candidates (happy eyeballs): The one expected to be fastest goes first, each following
+    // one gets started a bit later, or as soon as the ones before have failed.
+    m_pendingCandidates.clear();
+    foreach (Connection *connection, connectionCandidates(host)) {
+        m_pendingCandidates.append(connection);
+    }
+    startNextCandidate();
+
+    if (m_transportCandidates.isEmpty() && m_pendingCandidates.isEmpty()) {
+        qCWarning(dcNymeaConnection()) << "No available bearers available for host:" << host->name() << host->uuid();
+        m_connectionStatus = ConnectionStatusNoBearerAvailable;
+    } else {
+        m_connectionStatus = ConnectionStatusConnecting;
+    }
+    emit connectionStatusChanged();
+}
+
+bool NymeaConnection::connectInternal(Connection *connection)
+{
+    if (!m_transportFactories.contains(connection->url().scheme())) {
+        qCCritical(dcNymeaConnection()) << "Cannot connect to urls of scheme" << connection->url().scheme() << "Supported schemes are" << m_transportFactories.keys();
+        return false;
+    }
+
+    if (m_transportCandidates.values().contains(connection)) {
+        qCInfo(dcNymeaConnection()) << "Already have a connection (or connection attempt) for" << connection->url();
+        return false;
+    }
+
+    // Create a new transport
+    NymeaTransportInterface* newTransport = m_transportFactories.value(connection->url().scheme())->createTransport(this);
+    QObject::connect(newTransport, &NymeaTransportInterface::sslErrors, this, &NymeaConnection::onSslErrors);
+    QObject::connect(newTransport, &NymeaTransportInterface::error, this, &NymeaConnection::onError);
+    QObject::connect(newTransport, &NymeaTransportInterface::connected, this, &NymeaConnection::onConnected);
+    QObject::connect(newTransport, &NymeaTransportInterface::disconnected, this, &NymeaConnection::onDisconnected);
+    QObject::connect(newTransport, &NymeaTransportInterface::dataReady, this, &NymeaConnection::onDataAvailable, Qt::QueuedConnection);
+
+    m_transportCandidates.insert(newTransport, connection);
+    m_attemptStarts.insert(newTransport, m_clock.elapsed());
+    qCInfo(dcNymeaConnection()) << "Connecting to:" << connection->url() << newTransport << m_transportCandidates.value(newTransport) << "expecting" << connection->expectedRoundTripTime() << "ms";
+    return newTransport->connect(connection->url());
+}
+
+void NymeaConnection::startNextCandidate()
+{
+    m_raceTimer.stop();
+    while (!m_pendingCandidates.isEmpty()) {
+        QPointer<Connection> connection = m_pendingCandidates.takeFirst();
+        if (!connection.isNull() && connectInternal(connection.data())) {
+            break;
+        }
+    }
+    if (!m_pendingCandidates.isEmpty()) {
+        m_raceTimer.start();
+    }
+}
+
+QList<Connection*> NymeaConnection::connectionCandidates(NymeaHost *host) const
+{
+    QList<Connection*> candidates;
+
     Connection *loopbackConnection = host->connections()->bestMatch(Connection::BearerTypeLoopback);
     if (loopbackConnection) {
         qCDebug(dcNymeaConnection()) << "Best candidate Loopback connection:" << loopbackConnection->url();
-        connectInternal(loopbackConnection);
+        candidates.append(loopbackConnection);
 
     } else if (m_networkReachabilityMonitor->availableBearerTypes().testFlag(NymeaConnection::BearerTypeWiFi)
             || m_networkReachabilityMonitor->availableBearerTypes().testFlag(NymeaConnection::BearerTypeEthernet)) {
         Connection* lanConnection = host->connections()->bestMatch(Connection::BearerTypeLan | Connection::BearerTypeWan);
         if (lanConnection) {
             qCDebug(dcNymeaConnection()) << "Best candidate LAN/WAN connection:" << lanConnection->url();
-            connectInternal(lanConnection);
+            candidates.append(lanConnection);
         } else {
             qCDebug(dcNymeaConnection()) << "No available LAN/WAN connection to" << host->name();
         }
@@ -482,7 +660,7 @@ void NymeaConnection::connectInternal(NymeaHost *host)
         Connection* wanConnection = host->connections()->bestMatch(Connection::BearerTypeWan);
         if (wanConnection) {
             qCDebug(dcNymeaConnection()) << "Best candidate WAN connection:" << wanConnection->url();
-            connectInternal(wanConnection);
+            candidates.append(wanConnection);
         } else {
             qCDebug(dcNymeaConnection()) << "No available WAN connection to" << host->name();
         }
@@ -491,43 +669,54 @@ void NymeaConnection::connectInternal(NymeaHost *host)
     Connection* cloudConnection = host->connections()->bestMatch(Connection::BearerTypeCloud);
     if (cloudConnection) {
         qCDebug(dcNymeaConnection()) << "Best candidate Cloud connection:" << cloudConnection->url();
-        connectInternal(cloudConnection);
+        candidates.append(cloudConnection);
     } else {
         qCDebug(dcNymeaConnection()) << "No available Cloud connection to" << host->name();
     }
 
-    if (m_transportCandidates.isEmpty()) {
-        qCWarning(dcNymeaConnection()) << "No available bearers available for host:" << host->name() << host->uuid();
-        m_connectionStatus = ConnectionStatusNoBearerAvailable;
-    } else {
-        m_connectionStatus = ConnectionStatusConnecting;
-    }
-    emit connectionStatusChanged();
+    // Stable, so the order above decides between equally fast ones
+    std::stable_sort(candidates.begin(), candidates.end(), [](Connection *a, Connection *b) {
+        return a->expectedRoundTripTime() < b->expectedRoundTripTime();
+    });
+    return candidates;
 }
 
-bool NymeaConnection::connectInternal(Connection *connection)
+void NymeaConnection::probeBetterConnections()
 {
-    if (!m_transportFactories.contains(connection->url().scheme())) {
-        qCCritical(dcNymeaConnection()) << "Cannot connect to urls of scheme" << connection->url().scheme() << "Supported schemes are" << m_transportFactories.keys();
-        return false;
+    Connection *current = currentConnection();
+    // Don't second guess the user, and one migration at a time
+    if (!current || m_preferredConnection || m_drainingTransport) {
+        return;
     }
+    foreach (Connection *candidate, connectionCandidates(m_currentHost)) {
+        if (candidate != current && isBetter(candidate, current)) {
+            qCInfo(dcNymeaConnection()) << "Probing" << candidate->url() << "as faster alternative to" << current->url();
+            connectInternal(candidate);
+        }
+    }
+}
 
-    if (m_transportCandidates.values().contains(connection)) {
-        qCInfo(dcNymeaConnection()) << "Already have a connection (or connection attempt) for" << connection->url();
+bool NymeaConnection::isBetter(Connection *candidate, Connection *current) const
+{
+    if (m_preferredConnection) {
         return false;
     }
+    // Some margin to not flip flop between two similar ones
+    return candidate->expectedRoundTripTime() < current->expectedRoundTripTime() * 7 / 10;
+}
 
-    // Create a new transport
-    NymeaTransportInterface* newTransport = m_transportFactories.value(connection->url().scheme())->createTransport(this);
-    QObject::connect(newTransport, &NymeaTransportInterface::sslErrors, this, &NymeaConnection::onSslErrors);
-    QObject::connect(newTransport, &NymeaTransportInterface::error, this, &NymeaConnection::onError);
-    QObject::connect(newTransport, &NymeaTransportInterface::connected, this, &NymeaConnection::onConnected);
-    QObject::connect(newTransport, &NymeaTransportInterface::disconnected, this, &NymeaConnection::onDisconnected);
-    QObject::connect(newTransport, &NymeaTransportInterface::dataReady, this, &NymeaConnection::onDataAvailable, Qt::QueuedConnection);
+void NymeaConnection::migrate(NymeaTransportInterface *transport)
+{
+    Connection *from = m_transportCandidates.value(m_currentTransport);
+    Connection *to = m_transportCandidates.value(transport);
+    qCInfo(dcNymeaConnection()) << "Migrating from" << from->url() << from->roundTripTime() << "ms to" << to->url() << to->roundTripTime() << "ms";
 
-    m_transportCandidates.insert(newTransport, connection);
-    qCInfo(dcNymeaConnection()) << "Connecting to:" << connection->url() << newTransport << m_transportCandidates.value(newTransport);
-    return newTransport->connect(connection->url());
+    m_drainingTransport = m_currentTransport;
+    m_currentTransport = transport;
+    m_drainTimer.start();
+
+    emit currentConnectionChanged();
+    emit migrated();
 }
 
 bool NymeaConnection::isConnectionBearerAvailable(Connection::BearerType connectionBearerType) const
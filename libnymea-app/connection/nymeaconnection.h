@@ -38,6 +38,8 @@
 #include <QUrl>
 #include <QNetworkConfigurationManager>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
 
 #include "nymeahost.h"
 
@@ -106,6 +108,12 @@ public:
 
     void sendData(const QByteArray &data);
 
+    // Closes the transport left over from the last migration, once nothing is expected from it any more
+    void finishDraining();
+    // Goes back to the previous transport if the session couldn't be resumed on the new one.
+    // Returns false if there is none left, the current transport is closed then.
+    bool abortMigration();
+
 signals:
     void availableBearerTypesChanged();
     void verifyConnectionCertificate(const QString &url, const QStringList &issuerInfo, const QByteArray &fingerprint, const QByteArray &pem);
@@ -115,6 +123,12 @@ signals:
     void currentConnectionChanged();
     void dataAvailable(const QByteArray &data);
 
+    // The session moved to a faster transport. The previous one is kept open for a while to
+    // deliver what's still in flight on it, see finishDraining().
+    void migrated();
+    void drainingDataAvailable(const QByteArray &data);
+    void drainingFinished();
+
 private slots:
     void onSslErrors(const QList<QSslError> &errors);
     void onError(QAbstractSocket::SocketError error);
@@ -127,6 +141,13 @@ private slots:
 private:
     void connectInternal(NymeaHost *host);
     bool connectInternal(Connection *connection);
+    void startNextCandidate();
+
+    // The connections worth trying with the currently available bearers, expected fastest first
+    QList<Connection*> connectionCandidates(NymeaHost *host) const;
+    void probeBetterConnections();
+    bool isBetter(Connection *candidate, Connection *current) const;
+    void migrate(NymeaTransportInterface *transport);
 
     bool isConnectionBearerAvailable(Connection::BearerType connectionBearerType) const;
 
@@ -140,6 +161,15 @@ private:
     NymeaHost *m_currentHost = nullptr;
     Connection *m_preferredConnection = nullptr;
 
+    // Candidates not started yet in the current race
+    QList<QPointer<Connection>> m_pendingCandidates;
+    QTimer m_raceTimer;
+    QElapsedTimer m_clock;
+    QHash<NymeaTransportInterface*, qint64> m_attemptStarts;
+
+    NymeaTransportInterface *m_drainingTransport = nullptr;
+    QTimer m_drainTimer;
+
     QTimer m_reconnectTimer;
 
 #ifdef Q_OS_IOS
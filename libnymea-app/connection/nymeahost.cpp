@@ -359,3 +359,53 @@ int Connection::priority() const
     }
     return prio;
 }
+
+int Connection::roundTripTime() const
+{
+    return m_roundTripTime;
+}
+
+void Connection::addRoundTripTime(int msecs)
+{
+    // Smoothed like TCP does it, a single slow handshake shouldn't flip the order
+    int roundTripTime = m_roundTripTime < 0 ? msecs : (7 * m_roundTripTime + msecs) / 8;
+    m_failures = 0;
+    if (m_roundTripTime != roundTripTime) {
+        m_roundTripTime = roundTripTime;
+        emit roundTripTimeChanged();
+    }
+}
+
+int Connection::failures() const
+{
+    return m_failures;
+}
+
+void Connection::addFailure()
+{
+    m_failures++;
+}
+
+int Connection::expectedRoundTripTime() const
+{
+    int expected = m_roundTripTime;
+    if (expected < 0) {
+        switch (m_bearerType) {
+        case BearerTypeLoopback:
+            expected = 1;
+            break;
+        case BearerTypeLan:
+            expected = 50;
+            break;
+        case BearerTypeWan:
+            expected = 150;
+            break;
+        case BearerTypeCloud:
+            expected = 300;
+            break;
+        default:
+            expected = 500;
+        }
+    }
+    return expected + qMin(m_failures, 10) * 1000;
+}
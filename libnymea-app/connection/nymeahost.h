@@ -49,6 +49,7 @@ class Connection: public QObject {
     Q_PROPERTY(QString displayName READ displayName CONSTANT)
     Q_PROPERTY(bool online READ online NOTIFY onlineChanged)
     Q_PROPERTY(int priority READ priority NOTIFY priorityChanged)
+    Q_PROPERTY(int roundTripTime READ roundTripTime NOTIFY roundTripTimeChanged)
 
 public:
     enum BearerType {
@@ -79,9 +80,20 @@ public:
     void setManual(bool manual);
     int priority() const;
 
+    // Smoothed time it took to establish the transport, in ms. -1 if it has never been connected.
+    int roundTripTime() const;
+    void addRoundTripTime(int msecs);
+    // Consecutive failed connection attempts, reset by a successful one
+    int failures() const;
+    void addFailure();
+    // What to expect when racing this connection against others, in ms. Estimated from the
+    // bearer type as long as it's never been connected, recent failures are penalized.
+    int expectedRoundTripTime() const;
+
 signals:
     void onlineChanged();
     void priorityChanged();
+    void roundTripTimeChanged();
 
 private:
     QUrl m_url;
@@ -91,6 +103,8 @@ private:
     bool m_online = false;
     bool m_manual = false;
     QDateTime m_lastSeen;
+    int m_roundTripTime = -1;
+    int m_failures = 0;
 };
 
 class Connections: public QAbstractListModel
@@ -1,6 +1,10 @@
 #include "energylogs.h"
 
 #include <QMetaEnum>
+#include <QMetaMethod>
+
+#include <algorithm>
+#include <functional>
 #include <QJsonDocument>
 
 #include "logging.h"
@@ -23,12 +27,9 @@ QDateTime EnergyLogEntry::timestamp() const
     return m_timestamp;
 }
 
-EnergyLogs::EnergyLogs(QObject *parent) : QAbstractListModel(parent)
+EnergyLogs::EnergyLogs(int columnCount, QObject *parent) : QAbstractListModel(parent),
+    m_series(columnCount)
 {
-    // Workaround for older Qt versions (5.12 and older) which can't deal with the QList<EnergyLogEntry*> argument
-    connect(this, &EnergyLogs::entriesAdded, this, [this](int index, const QList<EnergyLogEntry*> &entries){
-        emit entriesAddedIdx(index, entries.count());
-    });
 }
 
 EnergyLogs::~EnergyLogs()
@@ -61,7 +62,12 @@ void EnergyLogs::setEngine(Engine *engine)
         });
 
         if (m_engine->jsonRpcClient()->experiences().value("Energy").toString() >= "1.0") {
-            m_engine->jsonRpcClient()->registerNotificationHandler(this, "Energy", "notificationReceivedInternal");
+            m_engine->jsonRpcClient()->registerNotificationCallback(this, "Energy.PowerBalanceLogEntryAdded", [this](const QJsonObject &params) {
+                notificationReceivedInternal("Energy.PowerBalanceLogEntryAdded", params);
+            });
+            m_engine->jsonRpcClient()->registerNotificationCallback(this, "Energy.ThingPowerLogEntryAdded", [this](const QJsonObject &params) {
+                notificationReceivedInternal("Energy.ThingPowerLogEntryAdded", params);
+            });
 
 //            if (m_ready && !m_loadingInhibited) {
 //                fetchLogs();
@@ -78,9 +84,29 @@ EnergyLogs::SampleRate EnergyLogs::sampleRate() const
 void EnergyLogs::setSampleRate(SampleRate sampleRate)
 {
     if (m_sampleRate != sampleRate) {
+        // Keep what we have for the old sample rate for when zooming back. Locally downsampled
+        // data isn't worth keeping, but its ranges are still being fetched.
+        Tier tier;
+        if (!m_provisional) {
+            tier.series = m_series;
+            tier.minValue = m_minValue;
+            tier.maxValue = m_maxValue;
+        }
+        tier.fetchedRanges = m_fetchedRanges;
+        m_tiers.insert(m_sampleRate, tier);
+
         m_sampleRate = sampleRate;
         emit sampleRateChanged();
-        clear();
+
+        resetSeries();
+        tier = m_tiers.take(m_sampleRate);
+        m_fetchedRanges = tier.fetchedRanges;
+        m_provisional = false;
+        if (!tier.series.isEmpty()) {
+            insertSeries(0, tier.series);
+        }
+        updateValueRange(tier.minValue, tier.maxValue, true);
+        updateFetchingData(false);
     }
 }
 
@@ -159,7 +185,7 @@ void EnergyLogs::componentComplete()
 int EnergyLogs::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_list.count();
+    return m_series.count();
 }
 
 QVariant EnergyLogs::data(const QModelIndex &index, int role) const
@@ -181,49 +207,34 @@ double EnergyLogs::maxValue() const
 
 EnergyLogEntry *EnergyLogs::get(int index) const
 {
-    if (index < 0 || index >= m_list.count()) {
+    if (index < 0 || index >= m_series.count()) {
         return nullptr;
     }
-    return m_list.at(index);
+    qint64 timestamp = m_series.timestamp(index);
+    EnergyLogEntry *entry = m_entries.value(timestamp);
+    if (!entry) {
+        entry = const_cast<EnergyLogs*>(this)->createEntry(index);
+        m_entries.insert(timestamp, entry);
+    }
+    return entry;
 }
 
 int EnergyLogs::indexOf(const QDateTime &timestamp)
 {
-    if (m_list.isEmpty()) {
+    if (m_series.isEmpty()) {
         return -1;
     }
-    QDateTime first = m_list.first()->timestamp();
 
-    int index = qRound(1.0 * first.secsTo(timestamp) / (m_sampleRate * 60));
-    if (index < 0 || index >= m_list.count()) {
-        qCDebug(dcEnergyLogs()) << "finding:" << timestamp << index << first.toString() << "NOT FOUND" << m_list.last()->timestamp() << m_list.count();
+    // Samples are sorted by timestamp, so a binary search finds the closest one even if the
+    // DB isn't in a perfectly consistent state, e.g. when the user changed the timezone during
+    // the lifetime or NTP caused the same time to pass twice.
+    qint64 secs = timestamp.toSecsSinceEpoch();
+    qint64 halfSample = m_sampleRate * 30;
+    if (secs < m_series.firstTimestamp() - halfSample || secs >= m_series.lastTimestamp() + halfSample) {
+        qCDebug(dcEnergyLogs()) << "finding:" << timestamp << "NOT FOUND" << m_series.count();
         return -1;
     }
-    qCDebug(dcEnergyLogs()) << "finding:" << timestamp << index << first.toString() << m_list.at(index)->timestamp();
-
-
-    // Normally, if the DB is in a consistent state, we can rely that the above finds the correct entry.
-    // However, if the user changes the timezone, during the lifetime, or other woes may appear like NTP
-    // changing time which may cause inconsistent entries like passing the same time twice, we could end up
-    // off by one. In order to compensate for that, we'll see if the next or previous entries may be closer
-    // In theory we could even be off by some more samples in very rare circumstances, but unlikely enough
-    // to not bother with that at this point.
-    QDateTime found = m_list.at(index)->timestamp();
-    QDateTime previous = index > 0 ? m_list.at(index-1)->timestamp() : found;
-    QDateTime next = index < m_list.count() - 1 ? m_list.at(index+1)->timestamp() : found;
-
-    int diffToFound = qAbs(timestamp.secsTo(found));
-    int diffToPrevious = qAbs(timestamp.secsTo(previous));
-    int diffToNext = qAbs(timestamp.secsTo(next));
-    if (diffToPrevious < diffToFound && diffToPrevious < diffToNext) {
-//        qWarning() << "Correcting to previous" << index << m_list.count() << found << previous << diffToPrevious << diffToFound;
-        return index - 1;
-    }
-    if (diffToNext < diffToFound) {
-//        qWarning() << "Correcting to next" << index << m_list.count() << found << next << diffToNext << diffToFound;
-        return index + 1;
-    }
-    return index;
+    return m_series.nearestIndex(secs);
 }
 
 EnergyLogEntry *EnergyLogs::find(const QDateTime &timestamp)
@@ -232,47 +243,156 @@ EnergyLogEntry *EnergyLogs::find(const QDateTime &timestamp)
     if (index < 0) {
         return nullptr;
     }
-    return m_list.at(index);
+    return get(index);
 }
 
 QList<EnergyLogEntry *> EnergyLogs::entries() const
 {
-    return m_list;
+    QList<EnergyLogEntry*> ret;
+    ret.reserve(m_series.count());
+    for (int i = 0; i < m_series.count(); i++) {
+        ret.append(get(i));
+    }
+    return ret;
 }
 
-void EnergyLogs::appendEntry(EnergyLogEntry *entry, double minValue, double maxValue)
+const EnergyLogSeries &EnergyLogs::series() const
 {
-    entry->setParent(this);
-    int index = m_list.count();
+    return m_series;
+}
+
+void EnergyLogs::appendEntry(qint64 timestamp, const double *values, double minValue, double maxValue)
+{
+    if (!m_series.isEmpty() && timestamp <= m_series.lastTimestamp()) {
+        EnergyLogSeries series(m_series.columnCount());
+        series.append(timestamp, values);
+        mergeSeries(&m_series, series);
+        updateValueRange(minValue, maxValue, false);
+        return;
+    }
+
+    int index = m_series.count();
     beginInsertRows(QModelIndex(), index, index);
-    m_list.append(entry);
+    m_series.append(timestamp, values);
     endInsertRows();
     emit countChanged();
-    emit entryAdded(index, entry);
-    emit entriesAdded(index, {entry});
-    if (minValue < m_minValue) {
+    static const QMetaMethod entryAddedSignal = QMetaMethod::fromSignal(&EnergyLogs::entryAdded);
+    if (isSignalConnected(entryAddedSignal)) {
+        emit entryAdded(index, get(index));
+    }
+    emitEntriesAdded(index, 1);
+    updateValueRange(minValue, maxValue, false);
+}
+
+EnergyLogSeries::Aggregation EnergyLogs::columnAggregation(int column) const
+{
+    Q_UNUSED(column)
+    return EnergyLogSeries::AggregationAverage;
+}
+
+void EnergyLogs::resetSeries()
+{
+    int count = m_series.count();
+    beginResetModel();
+    qDeleteAll(m_entries);
+    m_entries.clear();
+    m_series.clear();
+    endResetModel();
+    emit countChanged();
+    emit entriesRemoved(0, count);
+}
+
+void EnergyLogs::insertSeries(int index, const EnergyLogSeries &series)
+{
+    beginInsertRows(QModelIndex(), index, index + series.count() - 1);
+    m_series.insert(index, series);
+    endInsertRows();
+    emit countChanged();
+    emitEntriesAdded(index, series.count());
+}
+
+void EnergyLogs::mergeSeries(EnergyLogSeries *target, const EnergyLogSeries &series)
+{
+    // Runs of new samples are inserted at their position, samples which exist already are kept
+    int i = 0;
+    while (i < series.count()) {
+        int index = target->lowerBound(series.timestamp(i));
+        if (index < target->count() && target->timestamp(index) == series.timestamp(i)) {
+            i++;
+            continue;
+        }
+        int end = i + 1;
+        if (index < target->count()) {
+            while (end < series.count() && series.timestamp(end) < target->timestamp(index)) {
+                end++;
+            }
+        } else {
+            end = series.count();
+        }
+        EnergyLogSeries run = (i == 0 && end == series.count()) ? series : series.mid(i, end - i);
+        if (target == &m_series) {
+            insertSeries(index, run);
+        } else {
+            target->insert(index, run);
+        }
+        i = end;
+    }
+}
+
+void EnergyLogs::emitEntriesAdded(int index, int count)
+{
+    // Only create entry objects if someone actually listens for them
+    static const QMetaMethod entriesAddedSignal = QMetaMethod::fromSignal(&EnergyLogs::entriesAdded);
+    if (isSignalConnected(entriesAddedSignal)) {
+        QList<EnergyLogEntry*> entries;
+        entries.reserve(count);
+        for (int i = index; i < index + count; i++) {
+            entries.append(get(i));
+        }
+        emit entriesAdded(index, entries);
+    }
+    // For older Qt versions (5.12 and older) which can't deal with the QList<EnergyLogEntry*> argument
+    emit entriesAddedIdx(index, count);
+}
+
+void EnergyLogs::valueRange(const EnergyLogSeries &series, double *minValue, double *maxValue) const
+{
+    for (int column = 0; column < series.columnCount(); column++) {
+        if (columnAggregation(column) != EnergyLogSeries::AggregationAverage) {
+            continue;
+        }
+        for (int i = 0; i < series.count(); i++) {
+            *minValue = qMin(*minValue, series.value(i, column));
+            *maxValue = qMax(*maxValue, series.value(i, column));
+        }
+    }
+}
+
+void EnergyLogs::updateValueRange(double minValue, double maxValue, bool reset)
+{
+    if (reset ? minValue != m_minValue : minValue < m_minValue) {
         m_minValue = minValue;
         emit minValueChanged();
     }
-    if (maxValue > m_maxValue) {
+    if (reset ? maxValue != m_maxValue : maxValue > m_maxValue) {
         m_maxValue = maxValue;
         emit maxValueChanged();
     }
 }
 
-void EnergyLogs::appendEntries(const QList<EnergyLogEntry *> &entries)
+void EnergyLogs::updateFetchingData(bool forceNotify)
 {
-    int index = m_list.count();
-    beginInsertRows(QModelIndex(), index, index + entries.count());
-    for (int i = 0; i < entries.count(); i++) {
-        EnergyLogEntry* entry = entries.at(i);
-        entry->setParent(this);
-        m_list.append(entry);
-        emit entryAdded(index + i, entry);
+    bool fetchingData = false;
+    foreach (const PendingFetch &fetch, m_pendingFetches) {
+        if (fetch.sampleRate == m_sampleRate && !fetch.prefetch && !fetch.discard) {
+            fetchingData = true;
+            break;
+        }
+    }
+    if (m_fetchingData != fetchingData || forceNotify) {
+        m_fetchingData = fetchingData;
+        emit fetchingDataChanged();
     }
-    endInsertRows();
-    emit entriesAdded(index, entries);
-    emit countChanged();
 }
 
 QVariantMap EnergyLogs::fetchParams() const
@@ -282,131 +402,96 @@ QVariantMap EnergyLogs::fetchParams() const
 
 void EnergyLogs::getLogsResponse(int commandId, const QVariantMap &params)
 {
-    Q_UNUSED(commandId)
+    // Responses to the ThingPowerLogsLoader aren't tracked and always belong to the current sample rate
+    PendingFetch fetch;
+    fetch.sampleRate = m_sampleRate;
+    fetch.requestedAt = 0;
+    fetch.prefetch = false;
+    fetch.discard = false;
+    bool tracked = m_pendingFetches.contains(commandId);
+    if (tracked) {
+        fetch = m_pendingFetches.take(commandId);
+    }
+
+    if (fetch.discard) {
+        qCDebug(dcEnergyLogs()) << "Discarding logs response for cleared model";
+        updateFetchingData(false);
+        return;
+    }
 
     double minValue = 0, maxValue = 0;
-    qCDebug(dcEnergyLogs()) << "Logs response:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
-    QList<EnergyLogEntry*> entries = unpackEntries(params, &minValue, &maxValue);
-    qCDebug(dcEnergyLogs()) << "Energy logs received" << entries.count();
+    qCDebug(dcEnergyLogs()) << "Logs response:" << LogPayload(params);
+    EnergyLogSeries entries(m_series.columnCount());
+    unpackEntries(params, &entries, &minValue, &maxValue);
+    qCDebug(dcEnergyLogs()) << "Energy logs received" << entries.count() << "for sample rate" << fetch.sampleRate << (fetch.prefetch ? "(prefetch)" : "");
+
+    // Data up to the time of the request is complete, anything newer needs to be fetched again
+    TimeRange fetchedRange(fetch.range.first, qMin(fetch.range.second, fetch.requestedAt));
+
+    if (fetch.sampleRate != m_sampleRate) {
+        // Zoomed to another sample rate in the meantime, keep it for when zooming back
+        Tier &tier = m_tiers[fetch.sampleRate];
+        mergeSeries(&tier.series, entries);
+        tier.minValue = qMin(tier.minValue, minValue);
+        tier.maxValue = qMax(tier.maxValue, maxValue);
+        if (tracked) {
+            addRange(&tier.fetchedRanges, fetchedRange);
+        }
+        return;
+    }
 
-    if (!entries.isEmpty()) {
-        if (m_list.isEmpty()) {
-//            qCDebug(dcEnergyLogs()) << "Energy logs received" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
-            beginInsertRows(QModelIndex(), 0, entries.count());
-            m_list.append(entries);
-            endInsertRows();
-            emit entriesAdded(0, entries);
-            m_minValue = minValue;
-            emit minValueChanged();
-            m_maxValue = maxValue;
-            emit maxValueChanged();
-
-        } else if (entries.first()->timestamp() < m_list.first()->timestamp()) {
-
-            if (entries.last()->timestamp().addSecs(m_sampleRate * 60) == m_list.first()->timestamp()) {
-                beginInsertRows(QModelIndex(), 0, entries.count());
-                m_list = entries + m_list;
-                endInsertRows();
-                emit entriesAdded(0, entries);
-                if (minValue < m_minValue) {
-                    m_minValue = minValue;
-                    emit minValueChanged();
-                }
-                if (maxValue > m_maxValue) {
-                    m_maxValue = maxValue;
-                    emit maxValueChanged();
-                }
-            } else {
-                // End of fetched entries does not line up with start of existing entries. Discarding existing entries
-                qCDebug(dcEnergyLogs()) << "End of fetched entrie does not line up with start of existing entries. Discarding existing entries" << entries.last()->timestamp().addSecs(m_sampleRate * 60).toString() << " - " << m_list.first()->timestamp().toString();
-                clear();
-
-                // If the mismatch is in the visible area, we'll discard everything and fetch again
-                // Else if the mismatch is outside the visible area, we'll just discard the old data and work with what we received
-                if (entries.first()->timestamp() <= m_startTime && entries.last()->timestamp() >= m_endTime) {
-                    beginInsertRows(QModelIndex(), 0, entries.count());
-                    m_list.append(entries);
-                    endInsertRows();
-                    emit entriesAdded(0, entries);
-                    m_minValue = minValue;
-                    emit minValueChanged();
-                    m_maxValue = maxValue;
-                    emit maxValueChanged();
-                } else {
-                    qDeleteAll(entries);
-                    fetchLogs();
-                }
-            }
+    if (tracked) {
+        addRange(&m_fetchedRanges, fetchedRange);
+    }
 
-        } else if (entries.first()->timestamp().addSecs(-m_sampleRate * 60) == m_list.last()->timestamp()) {
-            int index = m_list.count();
-            beginInsertRows(QModelIndex(), m_list.count(), m_list.count() + entries.count());
-            m_list.append(entries);
-            endInsertRows();
-            emit entriesAdded(index, entries);
-            if (minValue < m_minValue) {
-                m_minValue = minValue;
-                emit minValueChanged();
-            }
-            if (maxValue > m_maxValue) {
-                m_maxValue = maxValue;
-                emit maxValueChanged();
-            }
-        } else {
-            // Start of fetched entries does not line up with end of existing entries. Discarding existing entries
-            clear();
-            beginInsertRows(QModelIndex(), 0, entries.count());
-            m_list.append(entries);
-            endInsertRows();
-            emit entriesAdded(0, entries);
-            m_minValue = minValue;
-            emit minValueChanged();
-            m_maxValue = maxValue;
-            emit maxValueChanged();
+    if (!entries.isEmpty()) {
+        bool reset = m_series.isEmpty() || m_provisional;
+        if (m_provisional) {
+            // Replace what was downsampled locally with the real thing
+            qCDebug(dcEnergyLogs()) << "Replacing downsampled data with fetched data";
+            resetSeries();
+            m_provisional = false;
         }
-
+        mergeSeries(&m_series, entries);
+        updateValueRange(minValue, maxValue, reset);
     } else {
         qCDebug(dcEnergyLogs()) << "Received empty log entries set.";
     }
 
-    m_fetchingData = false;
+    // Notify on every response once nothing is pending anymore, like for responses to the loader of ThingPowerLogs
+    updateFetchingData(!m_fetchingData);
 
-    if (m_fetchAgain) {
-        qCDebug(dcEnergyLogs()) << "Fetching again...";
-        m_fetchAgain = false;
-        fetchLogs();
-    } else {
-        emit fetchingDataChanged();
+    if (!m_fetchingData) {
+        prefetchLogs();
     }
 }
 
-void EnergyLogs::notificationReceivedInternal(const QVariantMap &data)
+void EnergyLogs::notificationReceivedInternal(const QString &notification, const QJsonObject &params)
 {
 
     if (!m_live) {
         return;
     }
 
-    if (!data.value("notification").toString().contains("Log")) {
-        return;
-    }
-
-    notificationReceived(data);
+    notificationReceived(notification, params.toVariantMap());
 }
 
 void EnergyLogs::clear()
 {
-    int count = m_list.count();
-    beginResetModel();
-    qDeleteAll(m_list);
-    m_list.clear();
-    endResetModel();
-    emit countChanged();
-    emit entriesRemoved(0, count);
+    resetSeries();
+    m_fetchedRanges.clear();
+    m_provisional = false;
+    m_tiers.clear();
+    for (QHash<int, PendingFetch>::iterator it = m_pendingFetches.begin(); it != m_pendingFetches.end(); ++it) {
+        it->discard = true;
+    }
+    m_lastStartTime = QDateTime();
+    m_panDirection = 0;
     m_minValue = 0;
     emit minValueChanged();
     m_maxValue = 0;
     emit maxValueChanged();
+    updateFetchingData(false);
 }
 
 void EnergyLogs::fetchLogs()
@@ -415,51 +500,187 @@ void EnergyLogs::fetchLogs()
         return;
     }
 
-    if (m_fetchingData) {
-        qCDebug(dcEnergyLogs()) << "Already busy.. queing up call";
-        m_fetchAgain = true;
+    if (m_startTime.isNull() || m_endTime.isNull()) {
+        // No time frame set, fetch everything there is, once
+        if (m_fetchedRanges.isEmpty() && !m_fetchingData) {
+            requestLogs(0, QDateTime::currentSecsSinceEpoch(), false);
+        }
         return;
     }
 
+    qint64 from = m_startTime.toSecsSinceEpoch();
+    qint64 to = m_endTime.toSecsSinceEpoch();
+    qCDebug(dcEnergyLogs()) << "request timeframe: " << m_startTime.toString() << " - " << m_endTime.toString();
+
+    if (!m_lastStartTime.isNull() && m_startTime != m_lastStartTime) {
+        m_panDirection = m_startTime < m_lastStartTime ? -1 : 1;
+    }
+    m_lastStartTime = m_startTime;
+
+    // Fetch all the gaps in the requested time frame which aren't fetched or being fetched yet.
+    // Requests don't wait for each other, already loaded data is merged with what arrives.
+    QList<TimeRange> covered = coveredRanges();
+    TimeRange missing;
+    bool requested = false;
+    qint64 cursor = from;
+    while (cursor <= to && missingRange(covered, TimeRange(cursor, to), &missing)) {
+        if (!requested && m_series.isEmpty()) {
+            // Show something from a finer sample rate while waiting for the server
+            loadDownsampled();
+        }
+        requestLogs(missing.first, missing.second, false);
+        requested = true;
+        cursor = missing.second + 1;
+    }
+
+    if (!requested) {
+        prefetchLogs();
+    }
+}
+
+QList<EnergyLogs::TimeRange> EnergyLogs::coveredRanges() const
+{
+    QList<TimeRange> ret = m_fetchedRanges;
+    foreach (const PendingFetch &fetch, m_pendingFetches) {
+        if (fetch.sampleRate == m_sampleRate && !fetch.discard) {
+            addRange(&ret, fetch.range);
+        }
+    }
+    return ret;
+}
+
+void EnergyLogs::requestLogs(qint64 from, qint64 to, bool prefetch)
+{
     QVariantMap params = fetchParams();
     QMetaEnum metaEnum = QMetaEnum::fromType<SampleRate>();
     params.insert("sampleRate", metaEnum.valueToKey(m_sampleRate));
-
     if (!m_startTime.isNull() && !m_endTime.isNull()) {
-        QDateTime startTime;
-        QDateTime endTime;
+        params.insert("from", from);
+        params.insert("to", to);
+    }
+    qCDebug(dcEnergyLogs()) << (prefetch ? "Prefetching" : "Fetching") << "from" << QDateTime::fromSecsSinceEpoch(from).toString() << "to" << QDateTime::fromSecsSinceEpoch(to).toString() << "with sample rate" << m_sampleRate;
 
-        QDateTime oldestExisting = m_list.count() > 0 ? m_list.first()->timestamp() : QDateTime();
-        QDateTime newestExisting = m_list.count() > 0 ? m_list.last()->timestamp() : QDateTime();
-        qCDebug(dcEnergyLogs()) << "request timeframe: " << m_startTime.toString() << " - " << m_endTime.toString();
-        qCDebug(dcEnergyLogs()) << "existing timeframe:" << oldestExisting.toString() << "- " << newestExisting.toString();
+    int commandId = m_engine->jsonRpcClient()->sendCommand("Energy.Get" + logsName(), params, this, "getLogsResponse");
 
-        if (oldestExisting.isNull() || newestExisting.isNull()) {
-            startTime = m_startTime;
-            endTime = m_endTime;
-        } else {
+    PendingFetch fetch;
+    fetch.sampleRate = m_sampleRate;
+    fetch.range = TimeRange(from, to);
+    fetch.requestedAt = QDateTime::currentSecsSinceEpoch();
+    fetch.prefetch = prefetch;
+    fetch.discard = false;
+    m_pendingFetches.insert(commandId, fetch);
+    updateFetchingData(false);
+}
 
-            if (m_startTime < oldestExisting) {
-                startTime = m_startTime;
-                endTime = qMin(m_endTime, oldestExisting.addSecs(-m_sampleRate * 60));
-            } else if (newestExisting < m_endTime) {
-                startTime = qMax(m_startTime, newestExisting.addSecs(m_sampleRate * 60));
-                endTime = m_endTime;
-            } else {
-                // Nothing to do...
-                return;
-            }
+void EnergyLogs::prefetchLogs()
+{
+    if (m_panDirection == 0 || m_startTime.isNull() || m_endTime.isNull() || !m_engine) {
+        return;
+    }
+
+    // One request ahead of the user is enough, wait until everything for this sample rate has arrived
+    foreach (const PendingFetch &fetch, m_pendingFetches) {
+        if (fetch.sampleRate == m_sampleRate && !fetch.discard) {
+            return;
         }
+    }
 
-        params.insert("from", startTime.toSecsSinceEpoch());
-        params.insert("to", endTime.toSecsSinceEpoch());
-        qCDebug(dcEnergyLogs()) << "Fetching from" << startTime.toString() << "to" << endTime.toString() << "with sample rate" << m_sampleRate;
+    // Prefetch the neighbouring window in the direction the user is panning
+    qint64 from = m_startTime.toSecsSinceEpoch();
+    qint64 to = m_endTime.toSecsSinceEpoch();
+    qint64 length = to - from;
+    TimeRange window = m_panDirection < 0 ? TimeRange(from - length, from - 1) : TimeRange(to + 1, qMin(to + length, QDateTime::currentSecsSinceEpoch()));
+    TimeRange missing;
+    if (window.first <= window.second && missingRange(coveredRanges(), window, &missing)) {
+        requestLogs(missing.first, missing.second, true);
+    }
+}
+
+bool EnergyLogs::loadDownsampled()
+{
+    QVector<EnergyLogSeries::Aggregation> aggregations;
+    for (int column = 0; column < m_series.columnCount(); column++) {
+        aggregations.append(columnAggregation(column));
     }
 
-    m_fetchingData = true;
-    fetchingDataChanged();
+    // Buckets are fixed in length, so for weeks, months and years this is only an approximation
+    // of what the server will deliver, good enough to show until the real data arrives.
+    // The coarsest finer tier needs the least work.
+    QList<int> sampleRates = m_tiers.keys();
+    std::sort(sampleRates.begin(), sampleRates.end(), std::greater<int>());
+    foreach (int sampleRate, sampleRates) {
+        if (sampleRate >= m_sampleRate) {
+            continue;
+        }
+        EnergyLogSeries downsampled = m_tiers.value(sampleRate).series.downsampled(m_startTime.toSecsSinceEpoch(), m_endTime.toSecsSinceEpoch(), m_sampleRate * 60, aggregations);
+        if (downsampled.isEmpty()) {
+            continue;
+        }
+        qCDebug(dcEnergyLogs()) << "Showing" << downsampled.count() << "samples downsampled from sample rate" << sampleRate << "while fetching";
+        insertSeries(0, downsampled);
+        double minValue = 0, maxValue = 0;
+        valueRange(downsampled, &minValue, &maxValue);
+        updateValueRange(minValue, maxValue, true);
+        m_provisional = true;
+        return true;
+    }
+    return false;
+}
 
-    qCDebug(dcEnergyLogs()) << "Fetching energy logs:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
-    m_engine->jsonRpcClient()->sendCommand("Energy.Get" + logsName(), params, this, "getLogsResponse");
+void EnergyLogs::addRange(QList<TimeRange> *ranges, const TimeRange &range)
+{
+    if (range.first > range.second) {
+        return;
+    }
+    TimeRange merged = range;
+    QList<TimeRange> ret;
+    bool inserted = false;
+    foreach (const TimeRange &existing, *ranges) {
+        // Ranges are inclusive, adjacent ones are merged too
+        if (existing.second + 1 < merged.first) {
+            ret.append(existing);
+        } else if (existing.first - 1 > merged.second) {
+            if (!inserted) {
+                ret.append(merged);
+                inserted = true;
+            }
+            ret.append(existing);
+        } else {
+            merged.first = qMin(merged.first, existing.first);
+            merged.second = qMax(merged.second, existing.second);
+        }
+    }
+    if (!inserted) {
+        ret.append(merged);
+    }
+    *ranges = ret;
 }
 
+bool EnergyLogs::missingRange(const QList<TimeRange> &ranges, const TimeRange &range, TimeRange *missing)
+{
+    qint64 cursor = range.first;
+    foreach (const TimeRange &existing, ranges) {
+        if (existing.second < cursor) {
+            continue;
+        }
+        if (existing.first > cursor) {
+            break;
+        }
+        if (existing.second >= range.second) {
+            return false;
+        }
+        cursor = existing.second + 1;
+    }
+    if (cursor > range.second) {
+        return false;
+    }
+    qint64 end = range.second;
+    foreach (const TimeRange &existing, ranges) {
+        if (existing.first > cursor) {
+            end = qMin(end, existing.first - 1);
+            break;
+        }
+    }
+    *missing = TimeRange(cursor, end);
+    return true;
+}
@@ -2,6 +2,7 @@
 #define ENERGYLOGS_H
 
 #include "engine.h"
+#include "energylogseries.h"
 
 #include <QObject>
 #include <QUuid>
@@ -52,7 +53,7 @@ public:
     };
     Q_ENUM(SampleRate)
 
-    explicit EnergyLogs(QObject *parent = nullptr);
+    explicit EnergyLogs(int columnCount, QObject *parent = nullptr);
     virtual ~EnergyLogs();
 
     Engine *engine() const;
@@ -84,11 +85,15 @@ public:
     double minValue() const;
     double maxValue() const;
 
+    // Samples are stored in an EnergyLogSeries, entry objects are only created when accessed
     Q_INVOKABLE EnergyLogEntry* get(int index) const;
     Q_INVOKABLE int indexOf(const QDateTime &timestamp);
     Q_INVOKABLE EnergyLogEntry* find(const QDateTime &timestamp);
+    // Note: Creates entry objects for all samples, prefer get() where possible
     Q_INVOKABLE QList<EnergyLogEntry*> entries() const;
 
+    const EnergyLogSeries &series() const;
+
 public slots:
     void clear();
     void fetchLogs();
@@ -114,17 +119,40 @@ signals:
 protected:
     virtual QString logsName() const = 0;
     virtual QVariantMap fetchParams() const;
-    virtual QList<EnergyLogEntry*> unpackEntries(const QVariantMap &params, double *minValue, double *maxValue) = 0;
-    virtual void notificationReceived(const QVariantMap &data) = 0;
+    virtual void unpackEntries(const QVariantMap &params, EnergyLogSeries *series, double *minValue, double *maxValue) = 0;
+    virtual EnergyLogEntry *createEntry(int index) = 0;
+    // Average columns also make up minValue/maxValue
+    virtual EnergyLogSeries::Aggregation columnAggregation(int column) const;
+    virtual void notificationReceived(const QString &notification, const QVariantMap &params) = 0;
 
-    void appendEntry(EnergyLogEntry *entry, double minValue, double maxValue);
-    void appendEntries(const QList<EnergyLogEntry *> &entries);
+    // values must hold series().columnCount() doubles
+    void appendEntry(qint64 timestamp, const double *values, double minValue, double maxValue);
 
 protected slots:
     void getLogsResponse(int commandId, const QVariantMap &params);
-    void notificationReceivedInternal(const QVariantMap &data);
+    void notificationReceivedInternal(const QString &notification, const QJsonObject &params);
 
 private:
+    typedef QPair<qint64, qint64> TimeRange;
+
+    // Everything fetched for a sample rate which is not the current one
+    struct Tier {
+        EnergyLogSeries series;
+        QList<TimeRange> fetchedRanges;
+        double minValue = 0;
+        double maxValue = 0;
+        bool provisional = false;
+    };
+
+    struct PendingFetch {
+        SampleRate sampleRate;
+        TimeRange range;
+        qint64 requestedAt;
+        bool prefetch;
+        // Set when the model was cleared while the request was in flight
+        bool discard;
+    };
+
     Engine *m_engine = nullptr;
     SampleRate m_sampleRate = SampleRate15Mins;
     bool m_fetchPowerBalance = true;
@@ -134,12 +162,39 @@ private:
     bool m_fetchingData = false;
     bool m_loadingInhibited = false;
     bool m_ready = false;
-    bool m_fetchAgain = false;
 
     double m_minValue = 0;
     double m_maxValue = 0;
 
-    QList<EnergyLogEntry*> m_list;
+    EnergyLogSeries m_series;
+    // Entry objects handed out by get(), by timestamp as indices shift when prepending
+    mutable QHash<qint64, EnergyLogEntry*> m_entries;
+    // Ranges fetched or being fetched for the current sample rate, sorted and merged
+    QList<TimeRange> m_fetchedRanges;
+    // Set while the model shows data downsampled from a finer tier instead of server data
+    bool m_provisional = false;
+
+    QHash<int, Tier> m_tiers;
+    QHash<int, PendingFetch> m_pendingFetches;
+    QDateTime m_lastStartTime;
+    int m_panDirection = 0;
+
+    void resetSeries();
+    void insertSeries(int index, const EnergyLogSeries &series);
+    // Inserts the samples of series not in target yet, target may be m_series or an inactive tier
+    void mergeSeries(EnergyLogSeries *target, const EnergyLogSeries &series);
+    void emitEntriesAdded(int index, int count);
+    void valueRange(const EnergyLogSeries &series, double *minValue, double *maxValue) const;
+    void updateValueRange(double minValue, double maxValue, bool reset);
+    void updateFetchingData(bool forceNotify);
+
+    QList<TimeRange> coveredRanges() const;
+    void requestLogs(qint64 from, qint64 to, bool prefetch);
+    void prefetchLogs();
+    bool loadDownsampled();
+
+    static void addRange(QList<TimeRange> *ranges, const TimeRange &range);
+    static bool missingRange(const QList<TimeRange> &ranges, const TimeRange &range, TimeRange *missing);
 };
 
 #endif // ENERGYLOGS_H
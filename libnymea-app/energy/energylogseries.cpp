@@ -0,0 +1,243 @@
+#include "energylogseries.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+
+EnergyLogSeries::EnergyLogSeries(int columnCount):
+    m_columns(columnCount)
+{
+
+}
+
+int EnergyLogSeries::count() const
+{
+    return m_count;
+}
+
+bool EnergyLogSeries::isEmpty() const
+{
+    return m_count == 0;
+}
+
+int EnergyLogSeries::columnCount() const
+{
+    return m_columns.count();
+}
+
+qint64 EnergyLogSeries::timestamp(int index) const
+{
+    return m_timestamps.at(m_offset + index);
+}
+
+double EnergyLogSeries::value(int index, int column) const
+{
+    return m_columns.at(column).at(m_offset + index);
+}
+
+qint64 EnergyLogSeries::firstTimestamp() const
+{
+    return timestamp(0);
+}
+
+qint64 EnergyLogSeries::lastTimestamp() const
+{
+    return timestamp(m_count - 1);
+}
+
+void EnergyLogSeries::append(qint64 timestamp, const double *values)
+{
+    reserve(0, 1);
+    int pos = m_offset + m_count;
+    m_timestamps[pos] = timestamp;
+    for (int i = 0; i < m_columns.count(); i++) {
+        m_columns[i][pos] = values[i];
+    }
+    m_count++;
+}
+
+void EnergyLogSeries::append(const EnergyLogSeries &other)
+{
+    Q_ASSERT(other.columnCount() == columnCount());
+    if (other.isEmpty()) {
+        return;
+    }
+    reserve(0, other.m_count);
+    int pos = m_offset + m_count;
+    std::copy_n(other.m_timestamps.constData() + other.m_offset, other.m_count, m_timestamps.data() + pos);
+    for (int i = 0; i < m_columns.count(); i++) {
+        std::copy_n(other.m_columns.at(i).constData() + other.m_offset, other.m_count, m_columns[i].data() + pos);
+    }
+    m_count += other.m_count;
+}
+
+void EnergyLogSeries::prepend(const EnergyLogSeries &other)
+{
+    Q_ASSERT(other.columnCount() == columnCount());
+    if (other.isEmpty()) {
+        return;
+    }
+    reserve(other.m_count, 0);
+    m_offset -= other.m_count;
+    std::copy_n(other.m_timestamps.constData() + other.m_offset, other.m_count, m_timestamps.data() + m_offset);
+    for (int i = 0; i < m_columns.count(); i++) {
+        std::copy_n(other.m_columns.at(i).constData() + other.m_offset, other.m_count, m_columns[i].data() + m_offset);
+    }
+    m_count += other.m_count;
+}
+
+void EnergyLogSeries::insert(int index, const EnergyLogSeries &other)
+{
+    Q_ASSERT(other.columnCount() == columnCount());
+    Q_ASSERT(index >= 0 && index <= m_count);
+    if (index == 0) {
+        prepend(other);
+        return;
+    }
+    if (index == m_count) {
+        append(other);
+        return;
+    }
+    if (other.isEmpty()) {
+        return;
+    }
+    reserve(0, other.m_count);
+    int pos = m_offset + index;
+    int tail = m_count - index;
+    qint64 *timestamps = m_timestamps.data();
+    std::copy_backward(timestamps + pos, timestamps + pos + tail, timestamps + pos + tail + other.m_count);
+    std::copy_n(other.m_timestamps.constData() + other.m_offset, other.m_count, timestamps + pos);
+    for (int i = 0; i < m_columns.count(); i++) {
+        double *column = m_columns[i].data();
+        std::copy_backward(column + pos, column + pos + tail, column + pos + tail + other.m_count);
+        std::copy_n(other.m_columns.at(i).constData() + other.m_offset, other.m_count, column + pos);
+    }
+    m_count += other.m_count;
+}
+
+void EnergyLogSeries::clear()
+{
+    m_timestamps.clear();
+    m_timestamps.squeeze();
+    for (int i = 0; i < m_columns.count(); i++) {
+        m_columns[i].clear();
+        m_columns[i].squeeze();
+    }
+    m_offset = 0;
+    m_count = 0;
+}
+
+EnergyLogSeries EnergyLogSeries::mid(int index, int count) const
+{
+    Q_ASSERT(index >= 0 && count >= 0 && index + count <= m_count);
+    EnergyLogSeries ret(m_columns.count());
+    ret.reserve(0, count);
+    std::copy_n(m_timestamps.constData() + m_offset + index, count, ret.m_timestamps.data() + ret.m_offset);
+    for (int i = 0; i < m_columns.count(); i++) {
+        std::copy_n(m_columns.at(i).constData() + m_offset + index, count, ret.m_columns[i].data() + ret.m_offset);
+    }
+    ret.m_count = count;
+    return ret;
+}
+
+int EnergyLogSeries::lowerBound(qint64 timestamp) const
+{
+    const qint64 *begin = m_timestamps.constData() + m_offset;
+    return std::lower_bound(begin, begin + m_count, timestamp) - begin;
+}
+
+int EnergyLogSeries::nearestIndex(qint64 timestamp) const
+{
+    if (m_count == 0) {
+        return -1;
+    }
+    const qint64 *begin = m_timestamps.constData() + m_offset;
+    const qint64 *end = begin + m_count;
+    const qint64 *it = std::lower_bound(begin, end, timestamp);
+    if (it == end) {
+        return m_count - 1;
+    }
+    int index = it - begin;
+    if (index > 0 && timestamp - *(it - 1) < *it - timestamp) {
+        return index - 1;
+    }
+    return index;
+}
+
+EnergyLogSeries EnergyLogSeries::downsampled(qint64 from, qint64 to, qint64 bucketSecs, const QVector<Aggregation> &aggregations) const
+{
+    Q_ASSERT(aggregations.count() == columnCount());
+    EnergyLogSeries ret(m_columns.count());
+    if (bucketSecs <= 0) {
+        return ret;
+    }
+
+    qint64 utcOffset = QDateTime::fromSecsSinceEpoch(from).offsetFromUtc();
+    QVector<double> values(m_columns.count());
+    qint64 bucket = 0;
+    int samples = 0;
+    for (int i = lowerBound(from); i < m_count && timestamp(i) <= to; i++) {
+        qint64 local = timestamp(i) + utcOffset;
+        qint64 sampleBucket = local - (local % bucketSecs + bucketSecs) % bucketSecs - utcOffset;
+        if (samples > 0 && sampleBucket != bucket) {
+            for (int c = 0; c < values.count(); c++) {
+                if (aggregations.at(c) == AggregationAverage) {
+                    values[c] /= samples;
+                }
+            }
+            ret.append(bucket, values.constData());
+            values.fill(0);
+            samples = 0;
+        }
+        bucket = sampleBucket;
+        for (int c = 0; c < values.count(); c++) {
+            if (aggregations.at(c) == AggregationAverage) {
+                values[c] += value(i, c);
+            } else {
+                values[c] = value(i, c);
+            }
+        }
+        samples++;
+    }
+    if (samples > 0) {
+        for (int c = 0; c < values.count(); c++) {
+            if (aggregations.at(c) == AggregationAverage) {
+                values[c] /= samples;
+            }
+        }
+        ret.append(bucket, values.constData());
+    }
+    return ret;
+}
+
+qint64 EnergyLogSeries::capacityBytes() const
+{
+    qint64 bytes = m_timestamps.capacity() * sizeof(qint64);
+    for (int i = 0; i < m_columns.count(); i++) {
+        bytes += m_columns.at(i).capacity() * sizeof(double);
+    }
+    return bytes;
+}
+
+void EnergyLogSeries::reserve(int front, int back)
+{
+    int capacity = m_timestamps.count();
+    if (m_offset >= front && capacity - m_offset - m_count >= back) {
+        return;
+    }
+
+    // Grow geometrically and split the spare room between both ends, so repeated
+    // prepends as well as appends stay amortised O(1)
+    int newCapacity = qMax(qMax(capacity * 2, m_count + front + back), 16);
+    int newOffset = front + (newCapacity - m_count - front - back) / 2;
+
+    QVector<qint64> timestamps(newCapacity);
+    std::copy_n(m_timestamps.constData() + m_offset, m_count, timestamps.data() + newOffset);
+    m_timestamps = timestamps;
+    for (int i = 0; i < m_columns.count(); i++) {
+        QVector<double> column(newCapacity);
+        std::copy_n(m_columns.at(i).constData() + m_offset, m_count, column.data() + newOffset);
+        m_columns[i] = column;
+    }
+    m_offset = newOffset;
+}
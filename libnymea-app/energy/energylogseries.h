@@ -0,0 +1,65 @@
+#ifndef ENERGYLOGSERIES_H
+#define ENERGYLOGSERIES_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/*
+ * Column wise storage for energy log samples. Timestamps (seconds since epoch) and each value
+ * column are kept in contiguous arrays, with free room at both ends so that logs can grow into
+ * the past as well as into the future with amortised O(1) cost per sample.
+ *
+ * Timestamps are expected to be ascending.
+ */
+class EnergyLogSeries
+{
+public:
+    // How samples of a column are combined when downsampling
+    enum Aggregation {
+        AggregationAverage, // e.g. power
+        AggregationLast     // e.g. energy counters
+    };
+
+    explicit EnergyLogSeries(int columnCount = 0);
+
+    int count() const;
+    bool isEmpty() const;
+    int columnCount() const;
+
+    qint64 timestamp(int index) const;
+    double value(int index, int column) const;
+
+    qint64 firstTimestamp() const;
+    qint64 lastTimestamp() const;
+
+    // values must hold columnCount() doubles
+    void append(qint64 timestamp, const double *values);
+    void append(const EnergyLogSeries &other);
+    void prepend(const EnergyLogSeries &other);
+    void insert(int index, const EnergyLogSeries &other);
+    void clear();
+
+    EnergyLogSeries mid(int index, int count) const;
+
+    // Returns the index of the first sample not older than timestamp, count() if there is none
+    int lowerBound(qint64 timestamp) const;
+    // Returns the index of the sample closest to timestamp, or -1 if the series is empty
+    int nearestIndex(qint64 timestamp) const;
+
+    // Combines the samples in [from, to] into buckets of bucketSecs, aligned to the local
+    // time offset of from. The timestamp of a bucket is its start.
+    EnergyLogSeries downsampled(qint64 from, qint64 to, qint64 bucketSecs, const QVector<Aggregation> &aggregations) const;
+
+    // Bytes held by the backing arrays, including unused head and tail room
+    qint64 capacityBytes() const;
+
+private:
+    void reserve(int front, int back);
+
+    QVector<qint64> m_timestamps;
+    QVector<QVector<double>> m_columns;
+    int m_offset = 0;
+    int m_count = 0;
+};
+
+#endif // ENERGYLOGSERIES_H
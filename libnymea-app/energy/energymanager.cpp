@@ -35,7 +35,8 @@ void EnergyManager::setEngine(Engine *engine)
 
         if (m_engine) {
             connect(engine, &Engine::destroyed, this, [engine, this]{ if (m_engine == engine) m_engine = nullptr; });
-            m_engine->jsonRpcClient()->registerNotificationHandler(this, "Energy", "notificationReceived");
+            m_engine->jsonRpcClient()->registerNotificationCallback(this, "Energy.RootMeterChanged", &EnergyManager::rootMeterChangedNotification);
+            m_engine->jsonRpcClient()->registerNotificationCallback(this, "Energy.PowerBalanceChanged", &EnergyManager::powerBalanceChangedNotification);
             m_engine->jsonRpcClient()->sendCommand("Energy.GetRootMeter", QVariantMap(), this, "getRootMeterResponse");
             m_engine->jsonRpcClient()->sendCommand("Energy.GetPowerBalance", QVariantMap(), this, "getPowerBalanceResponse");
         }
@@ -97,33 +98,23 @@ double EnergyManager::totalReturn() const
     return m_totalReturn;
 }
 
-void EnergyManager::notificationReceived(const QVariantMap &data)
-{
-    QString notification = data.value("notification").toString();
-    QVariantMap params = data.value("params").toMap();
-    if (notification == "Energy.RootMeterChanged") {
-        m_rootMeterId = params.value("rootMeterThingId").toUuid();
-        emit rootMeterIdChanged();
-
-    } else if (notification == "Energy.PowerBalanceChanged") {
-        m_currentPowerConsumption = params.value("currentPowerConsumption").toDouble();
-        m_currentPowerProduction = params.value("currentPowerProduction").toDouble();
-        m_currentPowerAcquisition = params.value("currentPowerAcquisition").toDouble();
-        m_currentPowerStorage = params.value("currentPowerStorage").toDouble();
-        m_totalConsumption = params.value("totalConsumption").toDouble();
-        m_totalProduction = params.value("totalProduction").toDouble();
-        m_totalAcquisition = params.value("totalAcquisition").toDouble();
-        m_totalReturn = params.value("totalReturn").toDouble();
-        emit powerBalanceChanged();
-
-    } else if (notification == "Energy.PowerBalanceLogEntryAdded") {
-        // Handled in EnergyLogs
-    } else if (notification == "Energy.ThingPowerLogEntryAdded") {
-        // Handled in EnergyLogs
-
-    } else {
-        qCDebug(dcEnergyExperience()) << "Unhandled energy notification received" << data;
-    }
+void EnergyManager::rootMeterChangedNotification(const QJsonObject &params)
+{
+    m_rootMeterId = QUuid(params.value("rootMeterThingId").toString());
+    emit rootMeterIdChanged();
+}
+
+void EnergyManager::powerBalanceChangedNotification(const QJsonObject &params)
+{
+    m_currentPowerConsumption = params.value("currentPowerConsumption").toDouble();
+    m_currentPowerProduction = params.value("currentPowerProduction").toDouble();
+    m_currentPowerAcquisition = params.value("currentPowerAcquisition").toDouble();
+    m_currentPowerStorage = params.value("currentPowerStorage").toDouble();
+    m_totalConsumption = params.value("totalConsumption").toDouble();
+    m_totalProduction = params.value("totalProduction").toDouble();
+    m_totalAcquisition = params.value("totalAcquisition").toDouble();
+    m_totalReturn = params.value("totalReturn").toDouble();
+    emit powerBalanceChanged();
 }
 
 void EnergyManager::getRootMeterResponse(int commandId, const QVariantMap &params)
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QUuid>
+#include <QJsonObject>
 
 class Engine;
 
@@ -46,11 +47,13 @@ signals:
     void powerBalanceChanged();
 
 private slots:
-    void notificationReceived(const QVariantMap &data);
     void getRootMeterResponse(int commandId, const QVariantMap &params);
     void getPowerBalanceResponse(int commandId, const QVariantMap &params);
 
 private:
+    void rootMeterChangedNotification(const QJsonObject &params);
+    void powerBalanceChangedNotification(const QJsonObject &params);
+
     Engine *m_engine = nullptr;
     QUuid m_rootMeterId;
 
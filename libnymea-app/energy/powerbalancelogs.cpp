@@ -61,7 +61,7 @@ double PowerBalanceLogEntry::totalReturn() const
     return m_totalReturn;
 }
 
-PowerBalanceLogs::PowerBalanceLogs(QObject *parent) : EnergyLogs(parent)
+PowerBalanceLogs::PowerBalanceLogs(QObject *parent) : EnergyLogs(ColumnCount, parent)
 {
 
 }
@@ -71,60 +71,78 @@ QString PowerBalanceLogs::logsName() const
     return "PowerBalanceLogs";
 }
 
-QList<EnergyLogEntry *> PowerBalanceLogs::unpackEntries(const QVariantMap &params, double *minValue, double *maxValue)
+void PowerBalanceLogs::unpackEntries(const QVariantMap &params, EnergyLogSeries *series, double *minValue, double *maxValue)
 {
-    QList<EnergyLogEntry*> ret;
+    double values[ColumnCount];
     foreach (const QVariant &variant, params.value("powerBalanceLogEntries").toList()) {
-        QVariantMap map = variant.toMap();
-        QDateTime timestamp = QDateTime::fromSecsSinceEpoch(map.value("timestamp").toLongLong());
-        double consumption = map.value("consumption").toDouble();
-        double production = map.value("production").toDouble();
-        double acquisition = map.value("acquisition").toDouble();
-        double storage = map.value("storage").toDouble();
-        double totalConsumption = map.value("totalConsumption").toDouble();
-        double totalProduction = map.value("totalProduction").toDouble();
-        double totalAcquisition = map.value("totalAcquisition").toDouble();
-        double totalReturn = map.value("totalReturn").toDouble();
-        PowerBalanceLogEntry *entry = new PowerBalanceLogEntry(timestamp, consumption, production, acquisition, storage, totalConsumption, totalProduction, totalAcquisition, totalReturn, this);
-
-        *minValue = qMin(qMin(qMin(qMin(*minValue, consumption), production), acquisition), storage);
-        *maxValue = qMax(qMax(qMax(qMax(*maxValue, consumption), production), acquisition), storage);
-
-        ret.append(entry);
+        qint64 timestamp = unpack(variant.toMap(), values);
+        series->append(timestamp, values);
+
+        *minValue = qMin(qMin(qMin(qMin(*minValue, values[ColumnConsumption]), values[ColumnProduction]), values[ColumnAcquisition]), values[ColumnStorage]);
+        *maxValue = qMax(qMax(qMax(qMax(*maxValue, values[ColumnConsumption]), values[ColumnProduction]), values[ColumnAcquisition]), values[ColumnStorage]);
     }
-    return ret;
 }
 
-void PowerBalanceLogs::notificationReceived(const QVariantMap &data)
+EnergyLogEntry *PowerBalanceLogs::createEntry(int index)
+{
+    const EnergyLogSeries &s = series();
+    return new PowerBalanceLogEntry(QDateTime::fromSecsSinceEpoch(s.timestamp(index)),
+                                    s.value(index, ColumnConsumption),
+                                    s.value(index, ColumnProduction),
+                                    s.value(index, ColumnAcquisition),
+                                    s.value(index, ColumnStorage),
+                                    s.value(index, ColumnTotalConsumption),
+                                    s.value(index, ColumnTotalProduction),
+                                    s.value(index, ColumnTotalAcquisition),
+                                    s.value(index, ColumnTotalReturn),
+                                    this);
+}
+
+EnergyLogSeries::Aggregation PowerBalanceLogs::columnAggregation(int column) const
+{
+    switch (column) {
+    case ColumnConsumption:
+    case ColumnProduction:
+    case ColumnAcquisition:
+    case ColumnStorage:
+        return EnergyLogSeries::AggregationAverage;
+    default:
+        return EnergyLogSeries::AggregationLast;
+    }
+}
+
+void PowerBalanceLogs::notificationReceived(const QString &notification, const QVariantMap &params)
 {
-    QString notification = data.value("notification").toString();
-    QVariantMap params = data.value("params").toMap();
 
     QMetaEnum sampleRateEnum = QMetaEnum::fromType<EnergyLogs::SampleRate>();
-    SampleRate sampleRate = static_cast<SampleRate>(sampleRateEnum.keyToValue(data.value("params").toMap().value("sampleRate").toByteArray()));
+    SampleRate sampleRate = static_cast<SampleRate>(sampleRateEnum.keyToValue(params.value("sampleRate").toByteArray()));
 
     if (sampleRate != this->sampleRate()) {
         return;
     }
 
     if (notification == "Energy.PowerBalanceLogEntryAdded") {
-        QVariantMap map = params.value("powerBalanceLogEntry").toMap();
-        QDateTime timestamp = QDateTime::fromSecsSinceEpoch(map.value("timestamp").toLongLong());
-        double consumption = map.value("consumption").toDouble();
-        double production = map.value("production").toDouble();
-        double acquisition = map.value("acquisition").toDouble();
-        double storage = map.value("storage").toDouble();
-        double totalConsumption = map.value("totalConsumption").toDouble();
-        double totalProduction = map.value("totalProduction").toDouble();
-        double totalAcquisition = map.value("totalAcquisition").toDouble();
-        double totalReturn = map.value("totalReturn").toDouble();
-        PowerBalanceLogEntry *entry = new PowerBalanceLogEntry(timestamp, consumption, production, acquisition, storage, totalConsumption, totalProduction, totalAcquisition, totalReturn, this);
-        double minValue = qMin(qMin(qMin(consumption, production), acquisition), storage);
-        double maxValue = qMax(qMax(qMax(consumption, production), acquisition), storage);
-        appendEntry(entry, minValue, maxValue);
+        double values[ColumnCount];
+        qint64 timestamp = unpack(params.value("powerBalanceLogEntry").toMap(), values);
+        double minValue = qMin(qMin(qMin(values[ColumnConsumption], values[ColumnProduction]), values[ColumnAcquisition]), values[ColumnStorage]);
+        double maxValue = qMax(qMax(qMax(values[ColumnConsumption], values[ColumnProduction]), values[ColumnAcquisition]), values[ColumnStorage]);
+        appendEntry(timestamp, values, minValue, maxValue);
     }
 }
 
+qint64 PowerBalanceLogs::unpack(const QVariantMap &map, double *values)
+{
+    values[ColumnConsumption] = map.value("consumption").toDouble();
+    values[ColumnProduction] = map.value("production").toDouble();
+    values[ColumnAcquisition] = map.value("acquisition").toDouble();
+    values[ColumnStorage] = map.value("storage").toDouble();
+    values[ColumnTotalConsumption] = map.value("totalConsumption").toDouble();
+    values[ColumnTotalProduction] = map.value("totalProduction").toDouble();
+    values[ColumnTotalAcquisition] = map.value("totalAcquisition").toDouble();
+    values[ColumnTotalReturn] = map.value("totalReturn").toDouble();
+    return map.value("timestamp").toLongLong();
+}
+
 PowerBalanceLogs *PowerBalanceLogsProxy::powerBalanceLogs() const
 {
     return m_powerBalanceLogs;
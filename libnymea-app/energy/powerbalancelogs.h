@@ -47,12 +47,29 @@ class PowerBalanceLogs : public EnergyLogs
 {
     Q_OBJECT
 public:
+    enum Column {
+        ColumnConsumption,
+        ColumnProduction,
+        ColumnAcquisition,
+        ColumnStorage,
+        ColumnTotalConsumption,
+        ColumnTotalProduction,
+        ColumnTotalAcquisition,
+        ColumnTotalReturn,
+        ColumnCount
+    };
+
     explicit PowerBalanceLogs(QObject *parent = nullptr);
 
 protected:
     QString logsName() const override;
-    QList<EnergyLogEntry*> unpackEntries(const QVariantMap &params, double *minValue, double *maxValue) override;
-    void notificationReceived(const QVariantMap &data) override;
+    void unpackEntries(const QVariantMap &params, EnergyLogSeries *series, double *minValue, double *maxValue) override;
+    EnergyLogEntry *createEntry(int index) override;
+    EnergyLogSeries::Aggregation columnAggregation(int column) const override;
+    void notificationReceived(const QString &notification, const QVariantMap &params) override;
+
+private:
+    static qint64 unpack(const QVariantMap &map, double *values);
 };
 
 
@@ -40,7 +40,7 @@ double ThingPowerLogEntry::totalProduction() const
     return m_totalProduction;
 }
 
-ThingPowerLogs::ThingPowerLogs(QObject *parent) : EnergyLogs(parent)
+ThingPowerLogs::ThingPowerLogs(QObject *parent) : EnergyLogs(ColumnCount, parent)
 {
 }
 
@@ -84,15 +84,6 @@ ThingPowerLogEntry *ThingPowerLogs::liveEntry()
     return m_liveEntry;
 }
 
-void ThingPowerLogs::addEntries(const QList<ThingPowerLogEntry *> &entries)
-{
-    QList<EnergyLogEntry*> energyLogEntries;
-    foreach (ThingPowerLogEntry* entry, entries) {
-        energyLogEntries.append(entry);
-    }
-    appendEntries(energyLogEntries);
-}
-
 ThingPowerLogEntry *ThingPowerLogs::unpack(const QVariantMap &map)
 {
     QDateTime timestamp = QDateTime::fromSecsSinceEpoch(map.value("timestamp").toLongLong());
@@ -103,6 +94,14 @@ ThingPowerLogEntry *ThingPowerLogs::unpack(const QVariantMap &map)
     return new ThingPowerLogEntry(timestamp, thingId, currentPower, totalConsumption, totalProduction, this);
 }
 
+qint64 ThingPowerLogs::unpack(const QVariantMap &map, double *values)
+{
+    values[ColumnCurrentPower] = map.value("currentPower").toDouble();
+    values[ColumnTotalConsumption] = map.value("totalConsumption").toDouble();
+    values[ColumnTotalProduction] = map.value("totalProduction").toDouble();
+    return map.value("timestamp").toLongLong();
+}
+
 QString ThingPowerLogs::logsName() const
 {
     return "ThingPowerLogs";
@@ -116,7 +115,7 @@ QVariantMap ThingPowerLogs::fetchParams() const
     return ret;
 }
 
-QList<EnergyLogEntry *> ThingPowerLogs::unpackEntries(const QVariantMap &params, double *minValue, double *maxValue)
+void ThingPowerLogs::unpackEntries(const QVariantMap &params, EnergyLogSeries *series, double *minValue, double *maxValue)
 {
     foreach (const QVariant &variant, params.value("currentEntries").toList()) {
         QVariantMap map = variant.toMap();
@@ -131,36 +130,41 @@ QList<EnergyLogEntry *> ThingPowerLogs::unpackEntries(const QVariantMap &params,
         break;
     }
 
-    QList<EnergyLogEntry*> ret;
+    double values[ColumnCount];
     foreach (const QVariant &variant, params.value("thingPowerLogEntries").toList()) {
         QVariantMap map = variant.toMap();
         if (map.value("thingId").toUuid() != m_thingId) {
             continue;
         }
-        QDateTime timestamp = QDateTime::fromSecsSinceEpoch(map.value("timestamp").toLongLong());
-        QUuid thingId = map.value("thingId").toUuid();
-        double currentPower = map.value("currentPower").toDouble();
-        double totalConsumption = map.value("totalConsumption").toDouble();
-        double totalProduction = map.value("totalProduction").toDouble();
-        ThingPowerLogEntry *entry = new ThingPowerLogEntry(timestamp, thingId, currentPower, totalConsumption, totalProduction, this);
-//        qWarning() << "Adding entry:" << entry->thingId() << entry->timestamp().toString() << entry->totalConsumption();
-
-        *minValue = qMin(*minValue, currentPower);
-        *maxValue = qMax(*maxValue, currentPower);
-
-        ret.append(entry);
+        qint64 timestamp = unpack(map, values);
+        series->append(timestamp, values);
+
+        *minValue = qMin(*minValue, values[ColumnCurrentPower]);
+        *maxValue = qMax(*maxValue, values[ColumnCurrentPower]);
     }
+}
 
-    return ret;
+EnergyLogEntry *ThingPowerLogs::createEntry(int index)
+{
+    const EnergyLogSeries &s = series();
+    return new ThingPowerLogEntry(QDateTime::fromSecsSinceEpoch(s.timestamp(index)),
+                                  m_thingId,
+                                  s.value(index, ColumnCurrentPower),
+                                  s.value(index, ColumnTotalConsumption),
+                                  s.value(index, ColumnTotalProduction),
+                                  this);
+}
+
+EnergyLogSeries::Aggregation ThingPowerLogs::columnAggregation(int column) const
+{
+    return column == ColumnCurrentPower ? EnergyLogSeries::AggregationAverage : EnergyLogSeries::AggregationLast;
 }
 
-void ThingPowerLogs::notificationReceived(const QVariantMap &data)
+void ThingPowerLogs::notificationReceived(const QString &notification, const QVariantMap &params)
 {
-    QString notification = data.value("notification").toString();
-    QVariantMap params = data.value("params").toMap();
 
     QMetaEnum sampleRateEnum = QMetaEnum::fromType<EnergyLogs::SampleRate>();
-    SampleRate sampleRate = static_cast<SampleRate>(sampleRateEnum.keyToValue(data.value("params").toMap().value("sampleRate").toByteArray()));
+    SampleRate sampleRate = static_cast<SampleRate>(sampleRateEnum.keyToValue(params.value("sampleRate").toByteArray()));
     QVariantMap entryMap = params.value("thingPowerLogEntry").toMap();
     QUuid thingId = entryMap.value("thingId").toUuid();
 
@@ -184,14 +188,9 @@ void ThingPowerLogs::notificationReceived(const QVariantMap &data)
     }
 
     if (notification == "Energy.ThingPowerLogEntryAdded") {
-        QVariantMap map = params.value("thingPowerLogEntry").toMap();
-        QDateTime timestamp = QDateTime::fromSecsSinceEpoch(map.value("timestamp").toLongLong());
-        QUuid thingId = map.value("thingId").toUuid();
-        double currentPower = map.value("currentPower").toDouble();
-        double totalConsumption = map.value("totalConsumption").toDouble();
-        double totalProduction = map.value("totalProduction").toDouble();
-        ThingPowerLogEntry *entry = new ThingPowerLogEntry(timestamp, thingId, currentPower, totalConsumption, totalProduction, this);
-        appendEntry(entry, currentPower, currentPower);
+        double values[ColumnCount];
+        qint64 timestamp = unpack(entryMap, values);
+        appendEntry(timestamp, values, values[ColumnCurrentPower], values[ColumnCurrentPower]);
     }
 }
 
@@ -37,6 +37,13 @@ class ThingPowerLogs : public EnergyLogs
     Q_PROPERTY(QUuid thingId READ thingId WRITE setThingId NOTIFY thingIdChanged)
     Q_PROPERTY(ThingPowerLogsLoader* loader READ loader WRITE setLoader NOTIFY loaderChanged)
 public:
+    enum Column {
+        ColumnCurrentPower,
+        ColumnTotalConsumption,
+        ColumnTotalProduction,
+        ColumnCount
+    };
+
     explicit ThingPowerLogs(QObject *parent = nullptr);
 
     QUuid thingId() const;
@@ -55,13 +62,14 @@ signals:
 protected:
     QString logsName() const override;
     QVariantMap fetchParams() const override;
-    QList<EnergyLogEntry*> unpackEntries(const QVariantMap &params, double *minValue, double *maxValue) override;
-    void notificationReceived(const QVariantMap &data) override;
+    void unpackEntries(const QVariantMap &params, EnergyLogSeries *series, double *minValue, double *maxValue) override;
+    EnergyLogEntry *createEntry(int index) override;
+    EnergyLogSeries::Aggregation columnAggregation(int column) const override;
+    void notificationReceived(const QString &notification, const QVariantMap &params) override;
 
 private:
-    void addEntries(const QList<ThingPowerLogEntry *> &entries);
-
     ThingPowerLogEntry *unpack(const QVariantMap &map);
+    static qint64 unpack(const QVariantMap &map, double *values);
 
     QUuid m_thingId;
     ThingPowerLogEntry* m_liveEntry = nullptr;
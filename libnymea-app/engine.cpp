@@ -37,6 +37,8 @@
 #include "configuration/nymeaconfiguration.h"
 #include "system/systemcontroller.h"
 #include "configuration/networkmanager.h"
+#include "enginesnapshot.h"
+#include "startupscheduler.h"
 
 Engine::Engine(QObject *parent) :
     QObject(parent),
@@ -47,16 +49,81 @@ Engine::Engine(QObject *parent) :
     m_logManager(new LogManager(m_jsonRpcClient, this)),
     m_tagsManager(new TagsManager(m_jsonRpcClient, this)),
     m_nymeaConfiguration(new NymeaConfiguration(m_jsonRpcClient, this)),
-    m_systemController(new SystemController(m_jsonRpcClient, this))
+    m_systemController(new SystemController(m_jsonRpcClient, this)),
+    m_startupScheduler(new StartupScheduler(this))
 {
 
     connect(m_jsonRpcClient, &JsonRpcClient::connectedChanged, this, &Engine::onConnectedChanged);
 
-    connect(m_thingManager, &ThingManager::fetchingDataChanged, this, &Engine::onThingManagerFetchingChanged);
+    // None of the managers depend on each other's data to issue their requests, so everything is
+    // sent in one burst. Things need their thing classes, but ThingManager handles that internally
+    // without waiting for a round trip.
+    m_startupScheduler->addPhase("things", {}, [this](){ m_thingManager->init(); });
+    m_startupScheduler->addPhase("tags", {}, [this](){ m_tagsManager->init(); });
+    m_startupScheduler->addPhase("rules", {}, [this](){ m_ruleManager->init(); });
+    m_startupScheduler->addPhase("scripts", {}, [this](){ m_scriptManager->init(); });
+    m_startupScheduler->addPhase("configuration", {}, [this](){ m_nymeaConfiguration->init(); });
+    // SystemController has no completion signal, its data trickles in whenever it arrives
+    m_startupScheduler->addPhase("system", {}, [this](){ m_systemController->init(); m_startupScheduler->finishPhase("system"); });
+    // Milestone: everything needed to render the main views is available
+    m_startupScheduler->addPhase("interactive", {"things", "tags"});
+
+    connect(m_thingManager, &ThingManager::fetchingDataChanged, this, [this](){
+        if (!m_thingManager->fetchingData()) {
+            m_startupScheduler->finishPhase("things");
+        }
+    });
+    connect(m_tagsManager, &TagsManager::busyChanged, this, [this](){
+        if (!m_tagsManager->busy()) {
+            m_startupScheduler->finishPhase("tags");
+        }
+    });
+    connect(m_ruleManager, &RuleManager::fetchingDataChanged, this, [this](){
+        if (!m_ruleManager->fetchingData()) {
+            m_startupScheduler->finishPhase("rules");
+        }
+    });
+    connect(m_scriptManager, &ScriptManager::fetchingDataChanged, this, [this](){
+        if (!m_scriptManager->fetchingData()) {
+            m_startupScheduler->finishPhase("scripts");
+        }
+    });
+    connect(m_nymeaConfiguration, &NymeaConfiguration::fetchingDataChanged, this, [this](){
+        if (!m_nymeaConfiguration->fetchingData()) {
+            m_startupScheduler->finishPhase("configuration");
+        }
+    });
+    connect(m_startupScheduler, &StartupScheduler::phaseFinished, this, [this](const QString &name){
+        if (name == "interactive") {
+            qDebug() << "Engine: Time to interactive:" << m_startupScheduler->phaseFinishedAt(name) << "ms";
+        }
+    });
+    connect(m_startupScheduler, &StartupScheduler::finished, &m_snapshotTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
 
     connect(m_jsonRpcClient, &JsonRpcClient::connectedChanged, this, [this]() {
         qDebug() << "JSONRpc connected changed:" << m_jsonRpcClient->connected();
     });
+
+    // Give the initial fetch some time to settle before taking a snapshot
+    m_snapshotTimer.setInterval(10000);
+    m_snapshotTimer.setSingleShot(true);
+    connect(&m_snapshotTimer, &QTimer::timeout, this, &Engine::saveSnapshot);
+
+    qRegisterMetaType<EngineSnapshot>();
+    m_snapshotWriter = new EngineSnapshotWriter();
+    m_snapshotWriter->moveToThread(&m_snapshotThread);
+    connect(&m_snapshotThread, &QThread::finished, m_snapshotWriter, &QObject::deleteLater);
+    m_snapshotThread.setObjectName("EngineSnapshot");
+    m_snapshotThread.start(QThread::LowPriority);
+}
+
+Engine::~Engine()
+{
+    // Write the final snapshot before stopping the writer. quit() would drop saves still queued,
+    // e.g. the one taken on disconnect, so the blocking call also flushes those in order.
+    QMetaObject::invokeMethod(m_snapshotWriter, "save", Qt::BlockingQueuedConnection, Q_ARG(EngineSnapshot, takeSnapshot()));
+    m_snapshotThread.quit();
+    m_snapshotThread.wait();
 }
 
 ThingManager *Engine::thingManager() const
@@ -99,27 +166,71 @@ SystemController *Engine::systemController() const
     return m_systemController;
 }
 
+StartupScheduler *Engine::startupScheduler() const
+{
+    return m_startupScheduler;
+}
+
 void Engine::onConnectedChanged()
 {
     qDebug() << "Engine: connected changed:" << m_jsonRpcClient->connected();
+    if (!m_jsonRpcClient->connected()) {
+        // Needs to happen before the server uuid and the managers are reset below
+        saveSnapshot();
+    }
+    m_snapshotTimer.stop();
+    m_startupScheduler->reset();
+    m_snapshotServerUuid = QUuid();
     m_thingManager->clear();
     m_ruleManager->clear();
     m_tagsManager->clear();
     if (m_jsonRpcClient->connected()) {
         qDebug() << "Engine: inital setup required:" << m_jsonRpcClient->initialSetupRequired() << "auth required:" << m_jsonRpcClient->authenticationRequired();
         if (!m_jsonRpcClient->initialSetupRequired() && !m_jsonRpcClient->authenticationRequired()) {
-            m_thingManager->init();
+            loadSnapshot();
+            m_startupScheduler->start();
         }
     }
 }
 
-void Engine::onThingManagerFetchingChanged()
+
+void Engine::loadSnapshot()
+{
+    m_snapshotServerUuid = QUuid(m_jsonRpcClient->serverUuid());
+    m_snapshotJsonRpcVersion = m_jsonRpcClient->jsonRpcVersion();
+    EngineSnapshot snapshot = EngineSnapshot::load(m_snapshotServerUuid, m_snapshotJsonRpcVersion);
+    if (!snapshot.isValid()) {
+        return;
+    }
+    m_tagsManager->loadSnapshot(snapshot.tags());
+    m_ruleManager->loadSnapshot(snapshot.rules(), snapshot.activeRules());
+    m_thingManager->loadSnapshot(snapshot.thingClasses(), snapshot.things(), snapshot.thingStates());
+}
+
+EngineSnapshot Engine::takeSnapshot() const
+{
+    EngineSnapshot snapshot;
+    // Only snapshot complete data sets
+    if (m_snapshotServerUuid.isNull() || m_thingManager->fetchingData() || m_ruleManager->fetchingData() || m_tagsManager->busy()) {
+        return snapshot;
+    }
+    // All of this is implicitly shared, serializing happens in the writer thread
+    snapshot.setServerUuid(m_snapshotServerUuid);
+    snapshot.setJsonRpcVersion(m_snapshotJsonRpcVersion);
+    snapshot.setThingClasses(m_thingManager->snapshotThingClasses());
+    snapshot.setThings(m_thingManager->snapshotThings());
+    snapshot.setThingStates(m_thingManager->snapshotThingStates());
+    snapshot.setTags(m_tagsManager->snapshotTags());
+    snapshot.setRules(m_ruleManager->snapshotRules());
+    snapshot.setActiveRules(m_ruleManager->snapshotActiveRules());
+    return snapshot;
+}
+
+void Engine::saveSnapshot()
 {
-    if (!m_thingManager->fetchingData()) {
-        m_tagsManager->init();
-        m_ruleManager->init();
-        m_scriptManager->init();
-        m_nymeaConfiguration->init();
-        m_systemController->init();
+    EngineSnapshot snapshot = takeSnapshot();
+    if (!snapshot.isValid()) {
+        return;
     }
+    QMetaObject::invokeMethod(m_snapshotWriter, "save", Qt::QueuedConnection, Q_ARG(EngineSnapshot, snapshot));
 }
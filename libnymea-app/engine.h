@@ -32,6 +32,9 @@
 #define ENGINE_H
 
 #include <QObject>
+#include <QTimer>
+#include <QThread>
+#include <QUuid>
 
 #include "thingmanager.h"
 #include "connection/nymeatransportinterface.h"
@@ -44,6 +47,9 @@ class TagsManager;
 class NymeaConfiguration;
 class SystemController;
 class NetworkManager;
+class StartupScheduler;
+class EngineSnapshot;
+class EngineSnapshotWriter;
 
 class Engine : public QObject
 {
@@ -55,9 +61,11 @@ class Engine : public QObject
     Q_PROPERTY(JsonRpcClient* jsonRpcClient READ jsonRpcClient CONSTANT)
     Q_PROPERTY(NymeaConfiguration* nymeaConfiguration READ nymeaConfiguration CONSTANT)
     Q_PROPERTY(SystemController* systemController READ systemController CONSTANT)
+    Q_PROPERTY(StartupScheduler* startupScheduler READ startupScheduler CONSTANT)
 
 public:
     explicit Engine(QObject *parent = nullptr);
+    ~Engine() override;
 
     ThingManager *thingManager() const;
     RuleManager *ruleManager() const;
@@ -67,6 +75,7 @@ public:
     LogManager *logManager() const;
     NymeaConfiguration *nymeaConfiguration() const;
     SystemController *systemController() const;
+    StartupScheduler *startupScheduler() const;
 
 private:
     JsonRpcClient *m_jsonRpcClient;
@@ -77,10 +86,22 @@ private:
     TagsManager *m_tagsManager;
     NymeaConfiguration *m_nymeaConfiguration;
     SystemController *m_systemController;
+    StartupScheduler *m_startupScheduler;
+
+    QUuid m_snapshotServerUuid;
+    QString m_snapshotJsonRpcVersion;
+    QTimer m_snapshotTimer;
+    QThread m_snapshotThread;
+    EngineSnapshotWriter *m_snapshotWriter = nullptr;
+
+    void loadSnapshot();
+    // Invalid if the data set isn't complete
+    EngineSnapshot takeSnapshot() const;
+    // Writes the snapshot in the background
+    void saveSnapshot();
 
 private slots:
     void onConnectedChanged();
-    void onThingManagerFetchingChanged();
 
 };
 
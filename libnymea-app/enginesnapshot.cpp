@@ -0,0 +1,251 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "enginesnapshot.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QDataStream>
+#include <QStandardPaths>
+
+#include "logging.h"
+NYMEA_LOGGING_CATEGORY(dcEngineSnapshot, "EngineSnapshot")
+
+static const QDataStream::Version snapshotStreamVersion = QDataStream::Qt_5_9;
+// magic + format version + stream version
+static const int snapshotHeaderSize = 3 * sizeof(quint32);
+
+EngineSnapshot::EngineSnapshot()
+{
+
+}
+
+bool EngineSnapshot::isValid() const
+{
+    return !m_serverUuid.isNull();
+}
+
+QUuid EngineSnapshot::serverUuid() const
+{
+    return m_serverUuid;
+}
+
+void EngineSnapshot::setServerUuid(const QUuid &serverUuid)
+{
+    m_serverUuid = serverUuid;
+}
+
+QString EngineSnapshot::jsonRpcVersion() const
+{
+    return m_jsonRpcVersion;
+}
+
+void EngineSnapshot::setJsonRpcVersion(const QString &jsonRpcVersion)
+{
+    m_jsonRpcVersion = jsonRpcVersion;
+}
+
+QDateTime EngineSnapshot::timestamp() const
+{
+    return m_timestamp;
+}
+
+QByteArray EngineSnapshot::thingClasses() const
+{
+    return m_thingClasses;
+}
+
+void EngineSnapshot::setThingClasses(const QByteArray &thingClasses)
+{
+    m_thingClasses = thingClasses;
+}
+
+QList<QByteArray> EngineSnapshot::things() const
+{
+    return m_things;
+}
+
+void EngineSnapshot::setThings(const QList<QByteArray> &things)
+{
+    m_things = things;
+}
+
+QHash<QUuid, QVariantList> EngineSnapshot::thingStates() const
+{
+    return m_thingStates;
+}
+
+void EngineSnapshot::setThingStates(const QHash<QUuid, QVariantList> &thingStates)
+{
+    m_thingStates = thingStates;
+}
+
+QVariantList EngineSnapshot::tags() const
+{
+    return m_tags;
+}
+
+void EngineSnapshot::setTags(const QVariantList &tags)
+{
+    m_tags = tags;
+}
+
+QList<QByteArray> EngineSnapshot::rules() const
+{
+    return m_rules;
+}
+
+void EngineSnapshot::setRules(const QList<QByteArray> &rules)
+{
+    m_rules = rules;
+}
+
+QSet<QUuid> EngineSnapshot::activeRules() const
+{
+    return m_activeRules;
+}
+
+void EngineSnapshot::setActiveRules(const QSet<QUuid> &activeRules)
+{
+    m_activeRules = activeRules;
+}
+
+EngineSnapshot EngineSnapshot::load(const QUuid &serverUuid, const QString &jsonRpcVersion)
+{
+    EngineSnapshot snapshot;
+
+    QFile f(fileName(serverUuid));
+    if (!f.exists()) {
+        qCDebug(dcEngineSnapshot()) << "No snapshot for" << serverUuid.toString();
+        return snapshot;
+    }
+    if (!f.open(QFile::ReadOnly) || f.size() < snapshotHeaderSize) {
+        qCWarning(dcEngineSnapshot()) << "Cannot open snapshot file" << f.fileName();
+        return snapshot;
+    }
+
+    QByteArray data;
+    uchar *mapped = f.map(0, f.size());
+    if (mapped) {
+        data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), static_cast<int>(f.size()));
+    } else {
+        data = f.readAll();
+    }
+
+    QDataStream stream(data);
+    quint32 magic, formatVersion, streamVersion;
+    stream >> magic >> formatVersion >> streamVersion;
+    if (magic != Magic || formatVersion != FormatVersion || streamVersion != static_cast<quint32>(snapshotStreamVersion)) {
+        qCInfo(dcEngineSnapshot()) << "Discarding snapshot with incompatible format" << formatVersion << "for" << serverUuid.toString();
+        f.close();
+        remove(serverUuid);
+        return snapshot;
+    }
+    stream.setVersion(snapshotStreamVersion);
+
+    QUuid storedServerUuid;
+    QString storedJsonRpcVersion;
+    stream >> storedServerUuid >> storedJsonRpcVersion;
+    if (storedServerUuid != serverUuid || storedJsonRpcVersion != jsonRpcVersion) {
+        qCInfo(dcEngineSnapshot()) << "Discarding snapshot for" << serverUuid.toString() << "taken with JSON-RPC version" << storedJsonRpcVersion;
+        return snapshot;
+    }
+
+    stream >> snapshot.m_timestamp >> snapshot.m_thingClasses >> snapshot.m_things >> snapshot.m_thingStates >> snapshot.m_tags >> snapshot.m_rules >> snapshot.m_activeRules;
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(dcEngineSnapshot()) << "Snapshot file" << f.fileName() << "is corrupt. Discarding it.";
+        f.close();
+        remove(serverUuid);
+        return EngineSnapshot();
+    }
+    snapshot.m_serverUuid = storedServerUuid;
+    snapshot.m_jsonRpcVersion = storedJsonRpcVersion;
+
+    qCInfo(dcEngineSnapshot()) << "Loaded snapshot for" << serverUuid.toString() << "from" << snapshot.m_timestamp.toString() << "with" << snapshot.m_things.count() << "things";
+    return snapshot;
+}
+
+bool EngineSnapshot::save()
+{
+    if (!isValid()) {
+        return false;
+    }
+
+    QString path = fileName(m_serverUuid);
+    QDir dir(QFileInfo(path).absolutePath());
+    if (!dir.exists() && !dir.mkpath(dir.absolutePath())) {
+        qCWarning(dcEngineSnapshot()) << "Cannot create snapshot directory" << dir.absolutePath();
+        return false;
+    }
+
+    m_timestamp = QDateTime::currentDateTime();
+
+    QSaveFile f(path);
+    if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+        qCWarning(dcEngineSnapshot()) << "Cannot open snapshot file for writing:" << f.errorString();
+        return false;
+    }
+    QDataStream stream(&f);
+    stream << Magic << FormatVersion << static_cast<quint32>(snapshotStreamVersion);
+    stream.setVersion(snapshotStreamVersion);
+    stream << m_serverUuid << m_jsonRpcVersion << m_timestamp << m_thingClasses << m_things << m_thingStates << m_tags << m_rules << m_activeRules;
+    if (stream.status() != QDataStream::Ok || !f.commit()) {
+        qCWarning(dcEngineSnapshot()) << "Error writing snapshot file" << path;
+        return false;
+    }
+    qCDebug(dcEngineSnapshot()) << "Saved snapshot for" << m_serverUuid.toString() << "with" << m_things.count() << "things";
+    return true;
+}
+
+void EngineSnapshot::remove(const QUuid &serverUuid)
+{
+    QFile::remove(fileName(serverUuid));
+}
+
+QString EngineSnapshot::fileName(const QUuid &serverUuid)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/snapshots/" + serverUuid.toString().remove(QRegExp("[{}]")) + ".snapshot";
+}
+
+EngineSnapshotWriter::EngineSnapshotWriter(QObject *parent):
+    QObject(parent)
+{
+
+}
+
+void EngineSnapshotWriter::save(const EngineSnapshot &snapshot)
+{
+    EngineSnapshot copy = snapshot;
+    copy.save();
+}
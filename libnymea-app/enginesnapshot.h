@@ -0,0 +1,121 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ENGINESNAPSHOT_H
+#define ENGINESNAPSHOT_H
+
+#include <QObject>
+#include <QUuid>
+#include <QDateTime>
+#include <QVariantList>
+#include <QHash>
+#include <QSet>
+
+/*
+ * On-disk snapshot of the data required to render the UI for a server: thing classes,
+ * things including their last known state values, tags and rules. It is loaded synchronously
+ * when connecting and reconciled against the live data afterwards. Thing classes, things and
+ * rules are kept in the compact JSON form the managers hold on to anyway.
+ *
+ * File layout: a fixed size header (magic, format version, QDataStream version) followed by
+ * the QDataStream serialized payload. The file is memory mapped for loading, so a stale or
+ * foreign snapshot is rejected by looking at the header only.
+ */
+class EngineSnapshot
+{
+public:
+    static const quint32 Magic = 0x4e594d53; // "NYMS"
+    // Bump this whenever the payload layout changes
+    static const quint32 FormatVersion = 2;
+
+    EngineSnapshot();
+
+    bool isValid() const;
+
+    QUuid serverUuid() const;
+    void setServerUuid(const QUuid &serverUuid);
+
+    // The snapshot contains raw JSON-RPC data. It's only used if the API version still matches.
+    QString jsonRpcVersion() const;
+    void setJsonRpcVersion(const QString &jsonRpcVersion);
+
+    QDateTime timestamp() const;
+
+    QByteArray thingClasses() const;
+    void setThingClasses(const QByteArray &thingClasses);
+
+    QList<QByteArray> things() const;
+    void setThings(const QList<QByteArray> &things);
+
+    QHash<QUuid, QVariantList> thingStates() const;
+    void setThingStates(const QHash<QUuid, QVariantList> &thingStates);
+
+    QVariantList tags() const;
+    void setTags(const QVariantList &tags);
+
+    QList<QByteArray> rules() const;
+    void setRules(const QList<QByteArray> &rules);
+
+    QSet<QUuid> activeRules() const;
+    void setActiveRules(const QSet<QUuid> &activeRules);
+
+    static EngineSnapshot load(const QUuid &serverUuid, const QString &jsonRpcVersion);
+    bool save();
+    static void remove(const QUuid &serverUuid);
+
+private:
+    static QString fileName(const QUuid &serverUuid);
+
+    QUuid m_serverUuid;
+    QString m_jsonRpcVersion;
+    QDateTime m_timestamp;
+    QByteArray m_thingClasses;
+    QList<QByteArray> m_things;
+    QHash<QUuid, QVariantList> m_thingStates;
+    QVariantList m_tags;
+    QList<QByteArray> m_rules;
+    QSet<QUuid> m_activeRules;
+};
+
+Q_DECLARE_METATYPE(EngineSnapshot)
+
+// Serializes and writes snapshots, meant to live in a worker thread
+class EngineSnapshotWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EngineSnapshotWriter(QObject *parent = nullptr);
+
+public slots:
+    void save(const EngineSnapshot &snapshot);
+};
+
+#endif // ENGINESNAPSHOT_H
@@ -30,6 +30,7 @@
 
 #include "jsonrpcclient.h"
 #include "connection/nymeaconnection.h"
+#include "jsonrpc/jsonrpcresultcache.h"
 #include "types/param.h"
 #include "types/params.h"
 
@@ -39,6 +40,7 @@
 #include "connection/tunnelproxytransport.h"
 
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QVariantMap>
 #include <QDebug>
 #include <QUuid>
@@ -48,13 +50,31 @@
 #include <QLocale>
 #include <QDir>
 #include <QStandardPaths>
+#include <QTimer>
 
 #include "logging.h"
 NYMEA_LOGGING_CATEGORY(dcJsonRpc, "JsonRpc")
 
+// Per JsonRpcClient::RequestPriority, in ms
+static const int requestTimeouts[] = { 30000, 30000, 60000 };
+
+// Calls which take as long as they take, e.g. waiting for the user or for hardware. A dead
+// connection is noticed by the transport for those.
+static const QStringList untimedMethods = {
+    "JSONRPC.Hello",
+    "Integrations.DiscoverThings", "Integrations.PairThing", "Integrations.ConfirmPairing",
+    "Integrations.AddThing", "Integrations.ReconfigureThing",
+    "System.CheckForUpdates", "System.UpdatePackages", "System.RemovePackages", "System.EnableRepository",
+    "NetworkManager.ConnectWifiNetwork", "NetworkManager.StartAccessPoint",
+    "Zigbee.AddNetwork", "Zigbee.FactoryResetNetwork", "Zigbee.RefreshNeighborTables",
+    "ZWave.AddNetwork", "ZWave.FactoryResetNetwork", "ZWave.AddNode", "ZWave.RemoveNode",
+    "ModbusRtu.AddModbusRtuMaster", "ModbusRtu.ReconfigureModbusRtuMaster"
+};
+
 JsonRpcClient::JsonRpcClient(QObject *parent) :
     QObject(parent),
-    m_id(0)
+    m_id(0),
+    m_resultCache(new JsonRpcResultCache(this))
 {
     m_connection = new NymeaConnection(this);
     m_connection->registerTransport(new TcpSocketTransportFactory());
@@ -65,13 +85,24 @@ JsonRpcClient::JsonRpcClient(QObject *parent) :
     connect(m_connection, &NymeaConnection::availableBearerTypesChanged, this, &JsonRpcClient::availableBearerTypesChanged);
     connect(m_connection, &NymeaConnection::connectionStatusChanged, this, &JsonRpcClient::connectionStatusChanged);
     connect(m_connection, &NymeaConnection::connectedChanged, this, &JsonRpcClient::onInterfaceConnectedChanged);
+    connect(m_connection, &NymeaConnection::migrated, this, &JsonRpcClient::onConnectionMigrated);
+    connect(m_connection, &NymeaConnection::drainingDataAvailable, this, &JsonRpcClient::drainingDataReceived);
+    connect(m_connection, &NymeaConnection::drainingFinished, this, &JsonRpcClient::onDrainingFinished);
     connect(m_connection, &NymeaConnection::currentHostChanged, this, &JsonRpcClient:: currentHostChanged);
     connect(m_connection, &NymeaConnection::currentConnectionChanged, this, &JsonRpcClient:: currentConnectionChanged);
     // We'll connect this Queued, because in case of a disconnect we'll want to react on that ASAP instead of processing a queue that may be left in buffers
     // Especially on mobile platforms (hello Android) we get a huge queue of buffers upon resume from suspend just to get a disconnect after that.
     connect(m_connection, &NymeaConnection::dataAvailable, this, &JsonRpcClient::dataReceived, Qt::QueuedConnection);
 
-    registerNotificationHandler(this, QStringLiteral("JSONRPC"), "notificationReceived");
+    m_clock.start();
+    m_timeoutTimer.setInterval(1000);
+    connect(&m_timeoutTimer, &QTimer::timeout, this, &JsonRpcClient::checkTimeouts);
+    m_statisticsTimer.setSingleShot(true);
+    m_statisticsTimer.setInterval(250);
+    connect(&m_statisticsTimer, &QTimer::timeout, this, &JsonRpcClient::schedulerStatisticsChanged);
+
+    registerNotificationCallback(this, QStringLiteral("JSONRPC.PushButtonAuthFinished"), &JsonRpcClient::pushButtonAuthFinishedNotification);
+    registerNotificationCallback(this, QStringLiteral("Users.UserChanged"), &JsonRpcClient::userChangedNotification);
 }
 
 void JsonRpcClient::registerNotificationHandler(QObject *handler, const QString &nameSpace, const QString &method)
@@ -80,8 +111,24 @@ void JsonRpcClient::registerNotificationHandler(QObject *handler, const QString
         qWarning() << "Notification handler" << handler << " already registered for namespace" << nameSpace;
         return;
     }
+    // Resolve the method once here instead of looking it up by name for every notification
+    QByteArray signature = QMetaObject::normalizedSignature(QString("%1(QVariantMap)").arg(method).toLatin1().constData());
+    int methodIndex = handler->metaObject()->indexOfMethod(signature.constData());
+    if (methodIndex < 0) {
+        qCWarning(dcJsonRpc()) << "Notification handler" << handler << "does not have a method" << signature;
+        return;
+    }
     m_notificationHandlers.insert(nameSpace, handler);
-    m_notificationHandlerMethods.insert(handler, method);
+    m_notificationHandlerMethods.insert(handler, handler->metaObject()->method(methodIndex));
+    setNotificationsEnabled();
+}
+
+void JsonRpcClient::registerNotificationCallback(QObject *receiver, const QString &notification, NotificationCallback callback)
+{
+    NotificationCallbackEntry entry;
+    entry.receiver = receiver;
+    entry.callback = callback;
+    m_notificationCallbacks[notificationId(notification)].append(entry);
     setNotificationsEnabled();
 }
 
@@ -91,39 +138,67 @@ void JsonRpcClient::unregisterNotificationHandler(QObject *handler)
         m_notificationHandlers.remove(nameSpace, handler);
     }
     m_notificationHandlerMethods.remove(handler);
+
+    for (int i = 0; i < m_notificationCallbacks.count(); i++) {
+        QList<NotificationCallbackEntry> &callbacks = m_notificationCallbacks[i];
+        for (int j = callbacks.count() - 1; j >= 0; j--) {
+            if (callbacks.at(j).receiver.isNull() || callbacks.at(j).receiver == handler) {
+                callbacks.removeAt(j);
+            }
+        }
+    }
     setNotificationsEnabled();
 }
 
 int JsonRpcClient::sendCommand(const QString &method, const QVariantMap &params, QObject *caller, const QString &callbackMethod)
 {
-
     JsonRpcReply *reply = createReply(method, params, caller, callbackMethod);
+    return sendReply(reply);
+}
+
+int JsonRpcClient::sendCommand(const QString &method, const QVariantMap &params, QObject *receiver, ReplyCallback callback)
+{
+    JsonRpcReply *reply = createReply(method, params, receiver, QString());
+    reply->setReplyCallback(callback);
+    return sendReply(reply);
+}
 
-    if (m_cacheHashes.contains(method)) {
-        QString hash = m_cacheHashes.value(method);
-        QString callSignature = method + '-' + QJsonDocument::fromVariant(params).toJson() + '-' + QLocale().name();
-        QString callSignatureHash = QCryptographicHash::hash(callSignature.toUtf8(), QCryptographicHash::Md5).toHex();
-        QFile f(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + '/' + method + '-' + callSignatureHash + '-' + hash + ".cache");
-        if (f.exists() && f.open(QFile::ReadOnly)) {
-            QJsonParseError error;
-            QVariantMap cachedParams = QJsonDocument::fromJson(f.readAll(), &error).toVariant().toMap();
-            f.close();
-            if (error.error == QJsonParseError::NoError) {
-                qDebug() << "Loaded results for" << reply->nameSpace() + '.' + reply->method() << "from cache";
+int JsonRpcClient::sendReply(JsonRpcReply *reply)
+{
+    QString method = reply->nameSpace() + '.' + reply->method();
+    QVariantMap params = reply->params();
+    if (m_resultCache->isCacheable(method)) {
+        int commandId = reply->commandId();
+        m_resultCache->lookup(method, params, [this, reply](bool found, const QVariantMap &cachedParams) {
+            if (found) {
+                qCDebug(dcJsonRpc()) << "Loaded results for" << reply->nameSpace() + '.' + reply->method() << "from cache";
                 // We want to make sure this is an async operation even if we have stuff in cache, so only call callbacks using Qt::QueuedConnection
                 if (!reply->caller().isNull() && !reply->callback().isEmpty()) {
                     QMetaObject::invokeMethod(reply->caller(), reply->callback().toLatin1().data(), Qt::QueuedConnection, Q_ARG(int, reply->commandId()), Q_ARG(QVariantMap, cachedParams));
                 }
+                if (!reply->caller().isNull() && reply->replyCallback()) {
+                    int commandId = reply->commandId();
+                    JsonRpcClient::ReplyCallback callback = reply->replyCallback();
+                    QTimer::singleShot(0, reply->caller(), [commandId, callback, cachedParams]() {
+                        callback(commandId, QJsonObject::fromVariantMap(cachedParams));
+                    });
+                }
                 QMetaObject::invokeMethod(this, "responseReceived", Qt::QueuedConnection, Q_ARG(int, reply->commandId()), Q_ARG(QVariantMap, cachedParams));
                 QMetaObject::invokeMethod(reply, "deleteLater", Qt::QueuedConnection);
-                return reply->commandId();
+                return;
             }
-        }
+            if (!m_connection->connected()) {
+                reply->deleteLater();
+                return;
+            }
+            enqueue(reply);
+        });
+        return commandId;
     }
 
-    m_replies.insert(reply->commandId(), reply);
-    sendRequest(reply->requestMap());
-    return reply->commandId();
+    int commandId = reply->commandId();
+    enqueue(reply);
+    return commandId;
 }
 
 int JsonRpcClient::sendCommand(const QString &method, QObject *caller, const QString &callbackMethod)
@@ -182,48 +257,68 @@ void JsonRpcClient::addToken(const QString &serverUuid, const QByteArray &token)
 
 void JsonRpcClient::setNotificationsEnabledResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcJsonRpc()) << "Notification configuration response:" << commandId << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcJsonRpc()) << "Notification configuration response:" << commandId << LogPayload(params);
 
     if (!m_connected) {
         m_connected = true;
         emit connectedChanged(true);
     }
+
+    if (m_migrating && params.isEmpty()) {
+        qCWarning(dcJsonRpc()) << "Enabling notifications on the new transport failed.";
+        abortMigration();
+        return;
+    }
+
+    if (m_migrating) {
+        m_migrating = false;
+        qCInfo(dcJsonRpc()) << "Connection migration finished." << m_drainingReplies.count() << "replies still pending on the previous transport.";
+        if (m_drainingReplies.isEmpty()) {
+            m_connection->finishDraining();
+        }
+    }
 }
 
-void JsonRpcClient::notificationReceived(const QVariantMap &data)
+void JsonRpcClient::pushButtonAuthFinishedNotification(const QJsonObject &params)
 {
-    qCDebug(dcJsonRpc()) << "Notification received:" << qUtf8Printable(QJsonDocument::fromVariant(data).toJson());
-    if (data.value("notification").toString() == "JSONRPC.PushButtonAuthFinished") {
-        qCInfo(dcJsonRpc()) << "Push button auth finished.";
-        if (data.value("params").toMap().value("transactionId").toInt() != m_pendingPushButtonTransaction) {
-            qCWarning(dcJsonRpc()) << "This push button transaction is not what we're waiting for...";
-            return;
-        }
-        m_pendingPushButtonTransaction = -1;
-        if (data.value("params").toMap().value("success").toBool()) {
-            qCInfo(dcJsonRpc()) << "Push button auth succeeded";
-            m_token = data.value("params").toMap().value("token").toByteArray();
-            QSettings settings;
-            settings.beginGroup("jsonTokens");
-            settings.setValue(m_connection->currentHost()->uuid().toString(), m_token);
-            settings.endGroup();
+    qCInfo(dcJsonRpc()) << "Push button auth finished.";
+    if (params.value("transactionId").toInt() != m_pendingPushButtonTransaction) {
+        qCWarning(dcJsonRpc()) << "This push button transaction is not what we're waiting for...";
+        return;
+    }
+    m_pendingPushButtonTransaction = -1;
+    if (params.value("success").toBool()) {
+        qCInfo(dcJsonRpc()) << "Push button auth succeeded";
+        m_token = params.value("token").toString().toUtf8();
+        QSettings settings;
+        settings.beginGroup("jsonTokens");
+        settings.setValue(m_connection->currentHost()->uuid().toString(), m_token);
+        settings.endGroup();
 
-            m_initialSetupRequired = false;
+        m_initialSetupRequired = false;
 
-            emit authenticationRequiredChanged();
+        emit authenticationRequiredChanged();
 
-            // Push button auth will always hand out admin tokens
-            m_permissionScopes = UserInfo::PermissionScopeAdmin;
-            emit permissionsChanged();
+        // Push button auth will always hand out admin tokens
+        m_permissionScopes = UserInfo::PermissionScopeAdmin;
+        emit permissionsChanged();
 
-            setNotificationsEnabled();
-        } else {
-            emit pushButtonAuthFailed();
-        }
-        return;
+        setNotificationsEnabled();
+    } else {
+        emit pushButtonAuthFailed();
     }
+}
 
-    qCWarning(dcJsonRpc()) << "JsonRpcClient: Unhandled notification received" << data;
+void JsonRpcClient::userChangedNotification(const QJsonObject &params)
+{
+    // Check if our permissions changed
+    QJsonObject userInfo = params.value("userInfo").toObject();
+    if (userInfo.value("username").toString() == m_username) {
+        QStringList scopes = userInfo.value("scopes").toVariant().toStringList();
+        m_permissionScopes = UserInfo::listToScopes(scopes);
+        qCInfo(dcJsonRpc()) << "Permissions changed for" << m_username << scopes.join(",") << m_permissionScopes;
+        emit permissionsChanged();
+    }
 }
 
 void JsonRpcClient::getVersionsReply(int /*commandId*/, const QVariantMap &data)
@@ -296,6 +391,112 @@ QHash<QString, QString> JsonRpcClient::cacheHashes() const
     return m_cacheHashes;
 }
 
+JsonRpcResultCache *JsonRpcClient::resultCache() const
+{
+    return m_resultCache;
+}
+
+QString JsonRpcClient::wireEncoding() const
+{
+    return m_codec.name();
+}
+
+JsonRpcClient::RequestPriority JsonRpcClient::methodPriority(const QString &method)
+{
+    QHash<QString, RequestPriority>::const_iterator it = m_methodPriorities.constFind(method);
+    if (it != m_methodPriorities.constEnd()) {
+        return it.value();
+    }
+
+    QString nameSpace = method.left(method.indexOf('.'));
+    QString name = method.mid(nameSpace.length() + 1);
+    RequestPriority priority = RequestPriorityStartup;
+    if (nameSpace == "JSONRPC" || !name.startsWith("Get")) {
+        priority = RequestPriorityInteractive;
+    } else if (nameSpace == "Logging" || nameSpace == "Energy" || name.contains("Log")) {
+        priority = RequestPriorityBackground;
+    }
+    m_methodPriorities.insert(method, priority);
+    return priority;
+}
+
+void JsonRpcClient::setMethodPriority(const QString &method, RequestPriority priority)
+{
+    m_methodPriorities.insert(method, priority);
+}
+
+int JsonRpcClient::methodTimeout(const QString &method)
+{
+    QHash<QString, int>::const_iterator it = m_methodTimeouts.constFind(method);
+    if (it != m_methodTimeouts.constEnd()) {
+        return it.value();
+    }
+
+    int timeout = untimedMethods.contains(method) ? 0 : requestTimeouts[methodPriority(method)];
+    m_methodTimeouts.insert(method, timeout);
+    return timeout;
+}
+
+void JsonRpcClient::setMethodTimeout(const QString &method, int timeout)
+{
+    m_methodTimeouts.insert(method, timeout);
+}
+
+bool JsonRpcClient::isTimeout(const QVariantMap &params)
+{
+    return params.value("status").toString() == "timeout";
+}
+
+bool JsonRpcClient::isTimeout(const QJsonObject &params)
+{
+    return params.value("status").toString() == "timeout";
+}
+
+int JsonRpcClient::maxInFlight() const
+{
+    return m_maxInFlight;
+}
+
+void JsonRpcClient::setMaxInFlight(int maxInFlight)
+{
+    maxInFlight = qMax(1, maxInFlight);
+    if (m_maxInFlight != maxInFlight) {
+        m_maxInFlight = maxInFlight;
+        emit maxInFlightChanged();
+        dispatch();
+    }
+}
+
+int JsonRpcClient::inFlight() const
+{
+    return m_replies.count();
+}
+
+int JsonRpcClient::queueDepth() const
+{
+    return m_queues[RequestPriorityInteractive].count() + m_queues[RequestPriorityStartup].count() + m_queues[RequestPriorityBackground].count();
+}
+
+int JsonRpcClient::averageWaitTime() const
+{
+    return qRound(m_averageWaitTime);
+}
+
+int JsonRpcClient::maxWaitTime() const
+{
+    return m_maxWaitTime;
+}
+
+int JsonRpcClient::coalescedRequests() const
+{
+    return m_coalescedRequests;
+}
+
+int JsonRpcClient::timedOutRequests() const
+{
+    return m_timedOutRequests;
+}
+
 UserInfo::PermissionScopes JsonRpcClient::permissions() const
 {
     return m_permissionScopes;
@@ -353,7 +554,7 @@ int JsonRpcClient::createUser(const QString &username, const QString &password,
     }
     JsonRpcReply* reply = createReply("JSONRPC.CreateUser", params, this, "processCreateUser");
     m_replies.insert(reply->commandId(), reply);
-    m_connection->sendData(QJsonDocument::fromVariant(reply->requestMap()).toJson());
+    sendRequest(reply->requestMap());
     return reply->commandId();
 }
 
@@ -366,7 +567,7 @@ int JsonRpcClient::authenticate(const QString &username, const QString &password
     qDebug() << "Authenticating:" << username << password << deviceName;
     JsonRpcReply* reply = createReply("JSONRPC.Authenticate", params, this, "processAuthenticate");
     m_replies.insert(reply->commandId(), reply);
-    m_connection->sendData(QJsonDocument::fromVariant(reply->requestMap()).toJson());
+    sendRequest(reply->requestMap());
     return reply->commandId();
 }
 
@@ -377,7 +578,7 @@ int JsonRpcClient::requestPushButtonAuth(const QString &deviceName)
     params.insert("deviceName", deviceName);
     JsonRpcReply *reply = createReply("JSONRPC.RequestPushButtonAuth", params, this, "processRequestPushButtonAuth");
     m_replies.insert(reply->commandId(), reply);
-    m_connection->sendData(QJsonDocument::fromVariant(reply->requestMap()).toJson());
+    sendRequest(reply->requestMap());
     return reply->commandId();
 }
 
@@ -448,12 +649,30 @@ JsonRpcReply *JsonRpcClient::createReply(const QString &method, const QVariantMa
     return new JsonRpcReply(m_id, callParts.first(), callParts.last(), params, caller, callback);
 }
 
+int JsonRpcClient::notificationId(const QString &notification)
+{
+    QHash<QString, int>::const_iterator it = m_notificationIds.constFind(notification);
+    if (it != m_notificationIds.constEnd()) {
+        return it.value();
+    }
+    int id = m_notificationCallbacks.count();
+    m_notificationIds.insert(notification, id);
+    m_notificationCallbacks.append(QList<NotificationCallbackEntry>());
+    return id;
+}
+
 void JsonRpcClient::setNotificationsEnabled()
 {
     QStringList namespaces;
     foreach (const QString &nameSpace, m_notificationHandlers.keys()) {
         namespaces.append(nameSpace);
     }
+    for (QHash<QString, int>::const_iterator it = m_notificationIds.constBegin(); it != m_notificationIds.constEnd(); ++it) {
+        QString nameSpace = it.key().left(it.key().indexOf('.'));
+        if (!m_notificationCallbacks.at(it.value()).isEmpty() && !namespaces.contains(nameSpace)) {
+            namespaces.append(nameSpace);
+        }
+    }
 
     if (!m_connection->connected()) {
         return;
@@ -477,12 +696,181 @@ void JsonRpcClient::setNotificationsEnabled()
     sendRequest(reply->requestMap());
 }
 
+void JsonRpcClient::enqueue(JsonRpcReply *reply)
+{
+    QString method = reply->nameSpace() + '.' + reply->method();
+    RequestPriority priority = methodPriority(method);
+    reply->setPriority(priority);
+    reply->setTimeout(methodTimeout(method));
+    reply->setQueuedAt(m_clock.elapsed());
+
+    // There's no point in asking the same thing twice while the first answer is still due
+    if (reply->method().startsWith("Get")) {
+        QByteArray readKey = method.toUtf8() + ' ' + QJsonDocument(QJsonObject::fromVariantMap(reply->params())).toJson(QJsonDocument::Compact);
+        int leader = m_pendingReads.value(readKey, -1);
+        if (leader >= 0) {
+            qCDebug(dcJsonRpc()) << "Coalescing" << method << reply->commandId() << "with request" << leader;
+            m_coalescedReplies[leader].append(reply);
+            m_coalescedRequests++;
+            updateSchedulerStatistics();
+            return;
+        }
+        reply->setReadKey(readKey);
+        m_pendingReads.insert(readKey, reply->commandId());
+    }
+
+    m_queues[priority].enqueue(reply);
+    dispatch();
+}
+
+void JsonRpcClient::dispatch()
+{
+    for (int priority = RequestPriorityInteractive; priority <= RequestPriorityBackground; priority++) {
+        QQueue<JsonRpcReply*> &queue = m_queues[priority];
+        // Interactive requests never wait for the others
+        while (!queue.isEmpty() && (priority == RequestPriorityInteractive || m_replies.count() < m_maxInFlight)) {
+            JsonRpcReply *reply = queue.dequeue();
+            qint64 now = m_clock.elapsed();
+            int waitTime = now - reply->queuedAt();
+            m_averageWaitTime += (waitTime - m_averageWaitTime) / 8;
+            m_maxWaitTime = qMax(m_maxWaitTime, waitTime);
+            reply->setSentAt(now);
+            m_replies.insert(reply->commandId(), reply);
+            sendRequest(reply->requestMap());
+        }
+    }
+    if (!m_replies.isEmpty() && !m_timeoutTimer.isActive()) {
+        m_timeoutTimer.start();
+    }
+    updateSchedulerStatistics();
+}
+
+void JsonRpcClient::checkTimeouts()
+{
+    qint64 now = m_clock.elapsed();
+    // Callbacks may send or drop requests, so look up each one again
+    foreach (int commandId, m_replies.keys()) {
+        JsonRpcReply *reply = m_replies.value(commandId);
+        if (!reply || reply->sentAt() < 0 || reply->timeout() <= 0) {
+            continue;
+        }
+        // Replies are sent one after the other, as long as data is coming in this one may be next
+        if (now - qMax(reply->sentAt(), m_lastDataAt) < reply->timeout()) {
+            continue;
+        }
+        qCWarning(dcJsonRpc()) << "Request" << commandId << reply->nameSpace() + '.' + reply->method() << "timed out after" << (now - reply->sentAt()) << "ms";
+        m_replies.remove(commandId);
+        m_drainingReplies.remove(commandId);
+        m_timedOutRequests++;
+        reply->deleteLater();
+        // Callers tell this apart from a reply through isTimeout()
+        finishReply(reply, QJsonObject{{"status", "timeout"}});
+    }
+
+    if (m_replies.isEmpty()) {
+        m_timeoutTimer.stop();
+    }
+    dispatch();
+}
+
+void JsonRpcClient::finishReply(JsonRpcReply *reply, const QJsonObject &params)
+{
+    // Release the read first, so that callbacks asking again get a fresh answer
+    if (!reply->readKey().isEmpty() && m_pendingReads.value(reply->readKey(), -1) == reply->commandId()) {
+        m_pendingReads.remove(reply->readKey());
+    }
+    QList<JsonRpcReply*> coalescedReplies = m_coalescedReplies.take(reply->commandId());
+
+    if (!reply->caller().isNull() && reply->replyCallback()) {
+        reply->replyCallback()(reply->commandId(), params);
+    }
+
+    // Only build the variant tree if someone still wants it that way
+    bool legacyCallback = !reply->caller().isNull() && !reply->callback().isEmpty();
+    if (legacyCallback || isSignalConnected(QMetaMethod::fromSignal(&JsonRpcClient::responseReceived))) {
+        QVariantMap variantParams = params.toVariantMap();
+        if (legacyCallback) {
+            QMetaObject::invokeMethod(reply->caller(), reply->callback().toLatin1().data(), Q_ARG(int, reply->commandId()), Q_ARG(QVariantMap, variantParams));
+        }
+        emit responseReceived(reply->commandId(), variantParams);
+    }
+
+    foreach (JsonRpcReply *coalescedReply, coalescedReplies) {
+        coalescedReply->deleteLater();
+        finishReply(coalescedReply, params);
+    }
+}
+
+void JsonRpcClient::clearRequests()
+{
+    for (int priority = RequestPriorityInteractive; priority <= RequestPriorityBackground; priority++) {
+        foreach (JsonRpcReply *reply, m_queues[priority]) {
+            reply->deleteLater();
+        }
+        m_queues[priority].clear();
+    }
+    foreach (JsonRpcReply *reply, m_replies) {
+        reply->deleteLater();
+    }
+    m_replies.clear();
+    foreach (const QList<JsonRpcReply*> &replies, m_coalescedReplies) {
+        foreach (JsonRpcReply *reply, replies) {
+            reply->deleteLater();
+        }
+    }
+    m_coalescedReplies.clear();
+    m_pendingReads.clear();
+    m_timeoutTimer.stop();
+    updateSchedulerStatistics();
+}
+
+void JsonRpcClient::updateSchedulerStatistics()
+{
+    if (!m_statisticsTimer.isActive()) {
+        m_statisticsTimer.start();
+    }
+}
+
 void JsonRpcClient::sendRequest(const QVariantMap &request)
 {
     QVariantMap newRequest = request;
     newRequest.insert("token", m_token);
-    //    qDebug() << "Sending request" << qUtf8Printable(QJsonDocument::fromVariant(newRequest).toJson());
-    m_connection->sendData(QJsonDocument::fromVariant(newRequest).toJson(QJsonDocument::Compact) + "\n");
+    //    qDebug() << "Sending request" << LogPayload(newRequest);
+    m_connection->sendData(m_codec.encode(newRequest));
+}
+
+QStringList JsonRpcClient::offeredEncodings() const
+{
+    // Don't have the Hello rejected by a core we know doesn't understand encodings, see helloReply()
+    QSettings settings;
+    settings.beginGroup("wireEncodings");
+    if (m_connection->currentHost() && settings.contains(m_connection->currentHost()->uuid().toString())) {
+        return QStringList();
+    }
+    settings.endGroup();
+
+    // Compression only pays off where bandwidth is scarce
+    Connection *connection = m_connection->currentConnection();
+    bool preferCompression = !connection
+            || (connection->bearerType() != Connection::BearerTypeLan && connection->bearerType() != Connection::BearerTypeLoopback);
+    return JsonRpcCodec::supportedEncodings(preferCompression);
+}
+
+void JsonRpcClient::applyEncoding(const QVariantMap &helloParams)
+{
+    QString name = helloParams.value("encoding").toString();
+    if (name.isEmpty() || m_codec.isBinary()) {
+        return;
+    }
+    JsonRpcCodec::Encoding encoding;
+    if (!JsonRpcCodec::encodingFromName(name, &encoding)) {
+        qCWarning(dcJsonRpc()) << "Core picked wire encoding" << name << "which hasn't been offered";
+        return;
+    }
+    qCInfo(dcJsonRpc()) << "Switching wire encoding to" << name;
+    m_codec = JsonRpcCodec(encoding);
+    m_framer.setMode(m_codec.isBinary() ? JsonRpcFramer::FramingModeLengthPrefixed : JsonRpcFramer::FramingModeJson);
+    emit wireEncodingChanged();
 }
 
 bool JsonRpcClient::loadPem(const QUuid &serverUud, QByteArray &pem)
@@ -520,17 +908,31 @@ void JsonRpcClient::onInterfaceConnectedChanged(bool connected)
         m_initialSetupRequired = false;
         m_authenticationRequired = false;
         m_authenticated = false;
-        m_receiveBuffer.clear();
+        m_framer.reset();
+        m_drainingFramer.reset();
+        m_drainingReplies.clear();
+        m_migrating = false;
+        m_encodingsRejected = false;
+        if (m_codec.isBinary()) {
+            m_codec = JsonRpcCodec();
+            emit wireEncodingChanged();
+        }
         m_serverQtVersion.clear();
         m_serverQtBuildVersion.clear();
+        m_resultCache->close();
+        // Nothing will answer those anymore
+        clearRequests();
         if (m_connected) {
             m_connected = false;
             emit connectedChanged(false);
         }
     } else {
         qCInfo(dcJsonRpc()) << "JsonRpcClient: Transport connected. Starting handshake.";
-        // Clear anything that might be left in the buffer from a previous connection.
-        m_receiveBuffer.clear();
+        // Clear anything that might be left in the buffer from a previous connection. Unless we're just
+        // saying Hello again on this one and the encoding has been switched already.
+        if (!m_codec.isBinary()) {
+            m_framer.reset();
+        }
 
         // Load token for this host
         QSettings settings;
@@ -541,6 +943,10 @@ void JsonRpcClient::onInterfaceConnectedChanged(bool connected)
 
         QVariantMap params;
         params.insert("locale", QLocale().name());
+        QStringList encodings = m_codec.isBinary() ? QStringList() : offeredEncodings();
+        if (!encodings.isEmpty()) {
+            params.insert("encodings", encodings);
+        }
         sendCommand("JSONRPC.Hello", params, this, "helloReply");
     }
 }
@@ -553,54 +959,73 @@ void JsonRpcClient::dataReceived(const QByteArray &data)
         return;
     }
     //    qDebug() << "JsonRpcClient: received data:" << qUtf8Printable(data);
-    m_receiveBuffer.append(data);
+    m_lastDataAt = m_clock.elapsed();
+    m_framer.append(data);
+
+    // Drain all complete messages in one pass. Handlers may disconnect us while doing so, in which case the framer is reset.
+    QByteArray frame;
+    while (m_connection->connected()) {
+        JsonRpcFramer::FrameStatus status = m_framer.takeFrame(&frame);
+        if (status == JsonRpcFramer::FrameStatusIncomplete) {
+            break;
+        }
+        if (status == JsonRpcFramer::FrameStatusError) {
+            qCWarning(dcJsonRpc()) << "Framing error in data from nymea:" << m_framer.errorString();
+            continue;
+        }
 
-    int splitIndex = m_receiveBuffer.indexOf("}\n{") + 1;
-    if (splitIndex <= 0) {
-        splitIndex = m_receiveBuffer.length();
-    }
-    QJsonParseError error;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(m_receiveBuffer.left(splitIndex), &error);
-    if (error.error != QJsonParseError::NoError) {
-        //        qWarning() << "Could not parse json data from nymea" << m_receiveBuffer.left(splitIndex) << error.errorString();
-        return;
-    }
-    //    qDebug() << "received response" << qUtf8Printable(jsonDoc.toJson(QJsonDocument::Indented));
-    m_receiveBuffer = m_receiveBuffer.right(m_receiveBuffer.length() - splitIndex - 1);
-    if (!m_receiveBuffer.isEmpty()) {
-        staticMetaObject.invokeMethod(this, "dataReceived", Qt::QueuedConnection, Q_ARG(QByteArray, QByteArray()));
+        QJsonObject message;
+        QString errorString;
+        if (!m_codec.decode(frame, &message, &errorString)) {
+            qCWarning(dcJsonRpc()) << "Could not decode" << m_codec.name() << "data from nymea:" << errorString;
+            continue;
+        }
+        processMessage(QJsonDocument(message));
     }
+}
 
-    QVariantMap dataMap = jsonDoc.toVariant().toMap();
+void JsonRpcClient::processMessage(const QJsonDocument &jsonDoc)
+{
+    //    qDebug() << "received response" << qUtf8Printable(jsonDoc.toJson(QJsonDocument::Indented));
+    QJsonObject message = jsonDoc.object();
 
     // check if this is a notification
-    if (dataMap.contains("notification")) {
-        qCDebug(dcJsonRpc()) << "Incoming notification:" << qUtf8Printable(jsonDoc.toJson());
-        // Check if our permissions changed
-        if (dataMap.value("notification").toString() == "Users.UserChanged") {
-            QVariantMap userMap = dataMap.value("params").toMap().value("userInfo").toMap();
-            if (userMap.value("username").toString() == m_username) {
-                m_permissionScopes = UserInfo::listToScopes(userMap.value("scopes").toStringList());
-                qCInfo(dcJsonRpc()) << "Permissions changed for" << userMap.value("username") << userMap.value("scopes").toStringList().join(",") << m_permissionScopes;
-                emit permissionsChanged();
+    if (message.contains("notification")) {
+        qCDebug(dcJsonRpc()) << "Incoming notification:" << LogPayload(jsonDoc);
+        QString notification = message.value("notification").toString();
+
+        int id = m_notificationIds.value(notification, -1);
+        if (id >= 0) {
+            QJsonObject params = message.value("params").toObject();
+            // Copy, callbacks might (un)register handlers
+            const QList<NotificationCallbackEntry> callbacks = m_notificationCallbacks.at(id);
+            foreach (const NotificationCallbackEntry &entry, callbacks) {
+                if (!entry.receiver.isNull()) {
+                    entry.callback(params);
+                }
             }
         }
-        QStringList notification = dataMap.value("notification").toString().split(".");
-        QString nameSpace = notification.first();
-        foreach (QObject *handler, m_notificationHandlers.values(nameSpace)) {
-            QMetaObject::invokeMethod(handler, m_notificationHandlerMethods.value(handler).toLatin1().data(), Q_ARG(QVariantMap, dataMap));
+
+        // Only build the variant tree if there's someone still listening to the whole namespace
+        QList<QObject*> handlers = m_notificationHandlers.values(notification.left(notification.indexOf('.')));
+        if (!handlers.isEmpty()) {
+            QVariantMap dataMap = message.toVariantMap();
+            foreach (QObject *handler, handlers) {
+                m_notificationHandlerMethods.value(handler).invoke(handler, Q_ARG(QVariantMap, dataMap));
+            }
         }
         return;
     }
 
     // check if this is a reply to a request
-    int commandId = dataMap.value("id").toInt();
+    int commandId = message.value("id").toInt();
     JsonRpcReply *reply = m_replies.take(commandId);
     if (reply) {
         reply->deleteLater();
 //        qWarning() << QString("JsonRpc: got response for %1.%2: %3").arg(reply->nameSpace(), reply->method(), QString::fromUtf8(jsonDoc.toJson(QJsonDocument::Indented))) << reply->callback() << reply->callback();
 
-        if (dataMap.value("status").toString() == "unauthorized") {
+        QString status = message.value("status").toString();
+        if (status == "unauthorized") {
             qCWarning(dcJsonRpc()) << "Something's off with the token";
             m_authenticationRequired = true;
             m_token.clear();
@@ -613,45 +1038,49 @@ void JsonRpcClient::dataReceived(const QByteArray &data)
             emit authenticatedChanged();
         }
 
-        if (dataMap.value("status").toString() == "error") {
-            qCWarning(dcJsonRpc()) << "An error happened in the JSONRPC layer:" << dataMap.value("error").toString();
-            qCWarning(dcJsonRpc()) << "Request was:" << qUtf8Printable(QJsonDocument::fromVariant(reply->requestMap()).toJson());
-            if (reply->nameSpace() == "JSONRPC" && reply->method() == "Hello") {
-                qCInfo(dcJsonRpc()) << "Hello call failed. Trying again without locale";
+        if (status == "error") {
+            qCWarning(dcJsonRpc()) << "An error happened in the JSONRPC layer:" << message.value("error").toString();
+            qCWarning(dcJsonRpc()) << "Request was:" << LogPayload(reply->requestMap());
+            if (reply->nameSpace() == "JSONRPC" && reply->method() == "Hello" && !reply->params().isEmpty()) {
+                QVariantMap params = reply->params();
+                if (params.contains("encodings")) {
+                    // Older cores don't know about wire encodings, stay with JSON text
+                    qCInfo(dcJsonRpc()) << "Hello call failed. Trying again without wire encodings";
+                    params.remove("encodings");
+                    m_encodingsRejected = true;
+                } else {
+                    qCInfo(dcJsonRpc()) << "Hello call failed. Trying again without locale";
+                    params.clear();
+                }
                 m_id = 0;
-                sendCommand("JSONRPC.Hello", QVariantMap(), this, "helloReply");
+                sendCommand("JSONRPC.Hello", params, this, reply->callback());
+                // The retry will be answered instead
+                return;
             }
         }
         // Note: We're still forwarding a failed call, params will be empty tho...
         // This should never really happen as errors on this layer indicate a but in the caller code in the first place
         // Some methods however, like authenticate might fail on an invalid token tho and stil need to act on it
 
-        if (!reply->caller().isNull() && !reply->callback().isEmpty()) {
-            QMetaObject::invokeMethod(reply->caller(), reply->callback().toLatin1().data(), Q_ARG(int, commandId), Q_ARG(QVariantMap, dataMap.value("params").toMap()));
-        }
-
-        emit responseReceived(reply->commandId(), dataMap.value("params").toMap());
-
+        QJsonObject paramsObject = message.value("params").toObject();
+        finishReply(reply, paramsObject);
 
         // If the server supports cache hashes, cache stuff locally
-        QString fullMethod = reply->nameSpace() + '.' + reply->method();
-        if (m_cacheHashes.contains(fullMethod)) {
-            QString hash = m_cacheHashes.value(fullMethod);
-            QString callSignature = fullMethod + '-' + QJsonDocument::fromVariant(reply->params()).toJson() + '-' + QLocale().name();
-            QString callSignatureHash = QCryptographicHash::hash(callSignature.toUtf8(), QCryptographicHash::Md5).toHex();
-            QFile f(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + '/' + fullMethod + '-' + callSignatureHash + '-' + hash + ".cache");
-            if (!f.exists() && f.open(QFile::WriteOnly | QFile::Truncate)) {
-                f.write(QJsonDocument::fromVariant(dataMap.value("params")).toJson());
-                f.close();
-            }
+        if (status != "error") {
+            m_resultCache->insert(reply->nameSpace() + '.' + reply->method(), reply->params(), paramsObject);
         }
 
+        // There's room for the next one now
+        dispatch();
         return;
     }
 }
 
 void JsonRpcClient::helloReply(int /*commandId*/, const QVariantMap &params)
 {
+    // The core switches right after sending this reply, no matter what we think of it
+    applyEncoding(params);
+
     m_initialSetupRequired = params.value("initialSetupRequired").toBool();
     m_authenticationRequired = params.value("authenticationRequired").toBool();
     m_pushButtonAuthAvailable = params.value("pushButtonAuthAvailable").toBool();
@@ -660,6 +1089,21 @@ void JsonRpcClient::helloReply(int /*commandId*/, const QVariantMap &params)
     m_serverVersion = params.value("version").toString();
     QUuid serverUuid = params.value("uuid").toUuid();
     QString name = params.value("name").toString();
+
+    // Remember cores which rejected the Hello for offering encodings, so connecting to them doesn't
+    // take an extra round trip each time. Until they're updated, that is.
+    if (!serverUuid.isNull()) {
+        QSettings settings;
+        settings.beginGroup("wireEncodings");
+        if (m_encodingsRejected) {
+            settings.setValue(serverUuid.toString(), m_serverVersion);
+        } else if (settings.contains(serverUuid.toString()) && settings.value(serverUuid.toString()).toString() != m_serverVersion) {
+            settings.remove(serverUuid.toString());
+        }
+        settings.endGroup();
+    }
+    m_encodingsRejected = false;
+
     m_experiences.clear();
     foreach (const QVariant &experience, params.value("experiences").toList()) {
         m_experiences.insert(experience.toMap().value("name").toString(), experience.toMap().value("version").toString());
@@ -704,42 +1148,17 @@ void JsonRpcClient::helloReply(int /*commandId*/, const QVariantMap &params)
     }
 
 
-    // Verify SSL certificate
-    if (m_connection->isEncrypted()) {
-        QByteArray oldPem;
-        QSslCertificate certificate = m_connection->sslCertificate();
-        if (!loadPem(serverUuid, oldPem)) {
-            qCInfo(dcJsonRpc()) << "No SSL certificate for this host stored. Accepting and pinning new certificate.";
-            // No certificate yet! Inform ui about it.
-            emit newSslCertificate();
-            storePem(serverUuid, m_connection->sslCertificate().toPem());
-        } else {
-            // We have a certificate pinned already. Check if it's the same
-            if (certificate.toPem() != oldPem) {
-                // Uh oh, the certificate has changed
-                qCWarning(dcJsonRpc()) << "This connections certificate has changed!";
-                qCWarning(dcJsonRpc()) << "Old PEM:" << oldPem;
-                qCWarning(dcJsonRpc()) << "New PEM:" << certificate.toPem();
-
-                // Extract certificate info before disconnecting.
-                QVariantMap issuerInfo = certificateIssuerInfo();
-
-                // Reject the connection until the UI explicitly accepts this...
-                m_connection->disconnectFromHost();
-
-                emit verifyConnectionCertificate(serverUuid.toString(), issuerInfo, certificate.toPem());
-                return;
-            }
-            qCInfo(dcJsonRpc()) << "This connections certificate is trusted.";
-        }
+    if (!verifyCertificate(serverUuid)) {
+        return;
     }
 
     m_cacheHashes.clear();
-    qCDebug(dcJsonRpc()) << "Hello reply:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcJsonRpc()) << "Hello reply:" << LogPayload(params);
     QVariantList cacheHashes = params.value("cacheHashes").toList();
     foreach (const QVariant &cacheHash, cacheHashes) {
         m_cacheHashes.insert(cacheHash.toMap().value("method").toString(), cacheHash.toMap().value("hash").toString());
     }
+    m_resultCache->open(serverUuid, m_cacheHashes);
 //    qDebug() << "Caches:" << m_cacheHashes;
 
     if (m_jsonRpcVersion.majorVersion() >= 6 && m_authenticationRequired) {
@@ -791,6 +1210,190 @@ void JsonRpcClient::helloReply(int /*commandId*/, const QVariantMap &params)
     setNotificationsEnabled();
 }
 
+bool JsonRpcClient::verifyCertificate(const QUuid &serverUuid)
+{
+    if (m_connection->isEncrypted()) {
+        QByteArray oldPem;
+        QSslCertificate certificate = m_connection->sslCertificate();
+        if (!loadPem(serverUuid, oldPem)) {
+            qCInfo(dcJsonRpc()) << "No SSL certificate for this host stored. Accepting and pinning new certificate.";
+            // No certificate yet! Inform ui about it.
+            emit newSslCertificate();
+            storePem(serverUuid, m_connection->sslCertificate().toPem());
+        } else {
+            // We have a certificate pinned already. Check if it's the same
+            if (certificate.toPem() != oldPem) {
+                // Uh oh, the certificate has changed
+                qCWarning(dcJsonRpc()) << "This connections certificate has changed!";
+                qCWarning(dcJsonRpc()) << "Old PEM:" << oldPem;
+                qCWarning(dcJsonRpc()) << "New PEM:" << certificate.toPem();
+
+                // Extract certificate info before disconnecting.
+                QVariantMap issuerInfo = certificateIssuerInfo();
+
+                // Reject the connection until the UI explicitly accepts this...
+                m_connection->disconnectFromHost();
+
+                emit verifyConnectionCertificate(serverUuid.toString(), issuerInfo, certificate.toPem());
+                return false;
+            }
+            qCInfo(dcJsonRpc()) << "This connections certificate is trusted.";
+        }
+    }
+    return true;
+}
+
+void JsonRpcClient::onConnectionMigrated()
+{
+    qCInfo(dcJsonRpc()) << "Connection migrated to" << m_connection->currentConnection()->url() << "Renewing handshake.";
+
+    // Whatever is left in the framer belongs to the previous transport, as do all pending replies
+    m_drainingFramer = m_framer;
+    m_drainingCodec = m_codec;
+    m_framer.reset();
+    if (m_codec.isBinary()) {
+        m_codec = JsonRpcCodec();
+        emit wireEncodingChanged();
+    }
+    m_drainingReplies.clear();
+    foreach (int commandId, m_replies.keys()) {
+        m_drainingReplies.insert(commandId);
+    }
+    m_migrating = true;
+
+    QVariantMap params;
+    params.insert("locale", QLocale().name());
+    QStringList encodings = offeredEncodings();
+    if (!encodings.isEmpty()) {
+        params.insert("encodings", encodings);
+    }
+    int commandId = sendCommand("JSONRPC.Hello", params, this, "migrationHelloReply");
+    // Unlike the initial handshake, there's a working transport to go back to if this one is stuck
+    JsonRpcReply *reply = m_replies.value(commandId);
+    if (reply) {
+        reply->setTimeout(requestTimeouts[RequestPriorityInteractive]);
+    }
+}
+
+void JsonRpcClient::migrationHelloReply(int /*commandId*/, const QVariantMap &params)
+{
+    if (!params.contains("uuid")) {
+        qCWarning(dcJsonRpc()) << "Handshake on the new transport" << (isTimeout(params) ? "timed out." : "failed.");
+        abortMigration();
+        return;
+    }
+
+    applyEncoding(params);
+
+    QUuid serverUuid = params.value("uuid").toUuid();
+    if (serverUuid != m_connection->currentHost()->uuid()) {
+        // The session is still fine on the previous transport
+        qCWarning(dcJsonRpc()) << "Migrated to an unexpected server" << serverUuid.toString() << "expected:" << m_connection->currentHost()->uuid();
+        abortMigration();
+        return;
+    }
+    if (!verifyCertificate(serverUuid)) {
+        abortMigration();
+        return;
+    }
+    // Notifications are enabled per connection, the rest of the session carries over
+    setNotificationsEnabled();
+}
+
+void JsonRpcClient::drainingDataReceived(const QByteArray &data)
+{
+    m_lastDataAt = m_clock.elapsed();
+    m_drainingFramer.append(data);
+
+    QByteArray frame;
+    while (m_connection->connected()) {
+        JsonRpcFramer::FrameStatus status = m_drainingFramer.takeFrame(&frame);
+        if (status == JsonRpcFramer::FrameStatusIncomplete) {
+            break;
+        }
+        if (status == JsonRpcFramer::FrameStatusError) {
+            continue;
+        }
+        QJsonObject message;
+        if (!m_drainingCodec.decode(frame, &message)) {
+            continue;
+        }
+        if (message.contains("notification")) {
+            // Only until they're coming in on the new transport
+            if (m_migrating) {
+                processMessage(QJsonDocument(message));
+            }
+            continue;
+        }
+        if (m_drainingReplies.remove(message.value("id").toInt())) {
+            processMessage(QJsonDocument(message));
+        }
+    }
+
+    if (!m_migrating && m_drainingReplies.isEmpty()) {
+        m_connection->finishDraining();
+    }
+}
+
+void JsonRpcClient::onDrainingFinished()
+{
+    // Whatever didn't make it back on the previous transport
+    resendReplies(m_drainingReplies);
+    m_drainingReplies.clear();
+    m_drainingFramer.reset();
+    m_drainingCodec = JsonRpcCodec();
+    dispatch();
+}
+
+void JsonRpcClient::abortMigration()
+{
+    m_migrating = false;
+    if (!m_connection->abortMigration()) {
+        // Starting over, see onInterfaceConnectedChanged()
+        return;
+    }
+
+    // Back to the previous transport, along with what's still buffered for it
+    m_framer = m_drainingFramer;
+    m_codec = m_drainingCodec;
+    emit wireEncodingChanged();
+    m_drainingFramer.reset();
+    m_drainingCodec = JsonRpcCodec();
+
+    // Anything sent since the migration went to the new transport and won't be answered
+    QSet<int> lostReplies;
+    foreach (int commandId, m_replies.keys()) {
+        if (!m_drainingReplies.contains(commandId)) {
+            lostReplies.insert(commandId);
+        }
+    }
+    m_drainingReplies.clear();
+    resendReplies(lostReplies);
+    dispatch();
+}
+
+void JsonRpcClient::resendReplies(const QSet<int> &commandIds)
+{
+    // Reading again is harmless, anything else might have been executed already and isn't sent twice
+    foreach (int commandId, commandIds) {
+        JsonRpcReply *reply = m_replies.value(commandId);
+        if (!reply) {
+            continue;
+        }
+        if (reply->method().startsWith("Get") || reply->method() == "Hello") {
+            qCInfo(dcJsonRpc()) << "Replaying" << reply->nameSpace() + '.' + reply->method() << "on" << m_connection->currentConnection()->url();
+            reply->setSentAt(m_clock.elapsed());
+            sendRequest(reply->requestMap());
+        } else {
+            qCWarning(dcJsonRpc()) << "Reply for" << reply->nameSpace() + '.' + reply->method() << "lost while migrating the connection";
+            m_replies.remove(commandId);
+            reply->deleteLater();
+            // Whether it has been executed is as unknown as for a request timing out, report it as such
+            finishReply(reply, QJsonObject{{"status", "timeout"}});
+        }
+    }
+}
+
 JsonRpcReply::JsonRpcReply(int commandId, QString nameSpace, QString method, QVariantMap params, QPointer<QObject> caller, const QString &callback):
     m_commandId(commandId),
     m_nameSpace(nameSpace),
@@ -845,3 +1448,63 @@ QString JsonRpcReply::callback() const
 {
     return m_callback;
 }
+
+JsonRpcClient::ReplyCallback JsonRpcReply::replyCallback() const
+{
+    return m_replyCallback;
+}
+
+void JsonRpcReply::setReplyCallback(JsonRpcClient::ReplyCallback replyCallback)
+{
+    m_replyCallback = replyCallback;
+}
+
+JsonRpcClient::RequestPriority JsonRpcReply::priority() const
+{
+    return m_priority;
+}
+
+void JsonRpcReply::setPriority(JsonRpcClient::RequestPriority priority)
+{
+    m_priority = priority;
+}
+
+qint64 JsonRpcReply::queuedAt() const
+{
+    return m_queuedAt;
+}
+
+void JsonRpcReply::setQueuedAt(qint64 queuedAt)
+{
+    m_queuedAt = queuedAt;
+}
+
+qint64 JsonRpcReply::sentAt() const
+{
+    return m_sentAt;
+}
+
+void JsonRpcReply::setSentAt(qint64 sentAt)
+{
+    m_sentAt = sentAt;
+}
+
+int JsonRpcReply::timeout() const
+{
+    return m_timeout;
+}
+
+void JsonRpcReply::setTimeout(int timeout)
+{
+    m_timeout = timeout;
+}
+
+QByteArray JsonRpcReply::readKey() const
+{
+    return m_readKey;
+}
+
+void JsonRpcReply::setReadKey(const QByteArray &readKey)
+{
+    m_readKey = readKey;
+}
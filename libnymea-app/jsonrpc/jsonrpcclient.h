@@ -33,13 +33,26 @@
 
 #include <QObject>
 #include <QVariantMap>
+#include <QJsonObject>
+#include <QMetaMethod>
 #include <QPointer>
+#include <QSet>
+#include <QVector>
 #include <QVersionNumber>
+#include <QQueue>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <functional>
 
 #include "connection/nymeaconnection.h"
+#include "jsonrpc/jsonrpccodec.h"
+#include "jsonrpc/jsonrpcframer.h"
 #include "types/userinfo.h"
 
 class JsonRpcReply;
+class JsonRpcResultCache;
+class QJsonDocument;
 class Param;
 class Params;
 
@@ -64,15 +77,53 @@ class JsonRpcClient : public QObject
     Q_PROPERTY(QVariantMap certificateIssuerInfo READ certificateIssuerInfo NOTIFY currentConnectionChanged)
     Q_PROPERTY(QVariantMap experiences READ experiences NOTIFY currentConnectionChanged)
     Q_PROPERTY(UserInfo::PermissionScopes permissions READ permissions NOTIFY permissionsChanged)
+    Q_PROPERTY(JsonRpcResultCache* resultCache READ resultCache CONSTANT)
+    Q_PROPERTY(QString wireEncoding READ wireEncoding NOTIFY wireEncodingChanged)
+
+    Q_PROPERTY(int maxInFlight READ maxInFlight WRITE setMaxInFlight NOTIFY maxInFlightChanged)
+    Q_PROPERTY(int inFlight READ inFlight NOTIFY schedulerStatisticsChanged)
+    Q_PROPERTY(int queueDepth READ queueDepth NOTIFY schedulerStatisticsChanged)
+    Q_PROPERTY(int averageWaitTime READ averageWaitTime NOTIFY schedulerStatisticsChanged)
+    Q_PROPERTY(int maxWaitTime READ maxWaitTime NOTIFY schedulerStatisticsChanged)
+    Q_PROPERTY(int coalescedRequests READ coalescedRequests NOTIFY schedulerStatisticsChanged)
+    Q_PROPERTY(int timedOutRequests READ timedOutRequests NOTIFY schedulerStatisticsChanged)
 
 public:
+    // Outgoing requests are queued per priority. Interactive ones are sent right away, the
+    // others only as long as there are less than maxInFlight requests waiting for a reply.
+    enum RequestPriority {
+        RequestPriorityInteractive,
+        RequestPriorityStartup,
+        RequestPriorityBackground
+    };
+    Q_ENUM(RequestPriority)
+
+    typedef std::function<void(const QJsonObject &params)> NotificationCallback;
+    typedef std::function<void(int commandId, const QJsonObject &params)> ReplyCallback;
+
     explicit JsonRpcClient(QObject *parent = nullptr);
 
+    // Legacy handlers get every notification of the given namespace as QVariantMap
     void registerNotificationHandler(QObject *handler, const QString &nameSpace, const QString &method);
+    // Callbacks are dispatched directly for a single notification, e.g. "Integrations.StateChanged",
+    // and get the notification params as parsed from the wire without a detour through QVariant.
+    void registerNotificationCallback(QObject *receiver, const QString &notification, NotificationCallback callback);
+    template <typename T>
+    void registerNotificationCallback(T *receiver, const QString &notification, void (T::*method)(const QJsonObject &params)) {
+        registerNotificationCallback(receiver, notification, [receiver, method](const QJsonObject &params) { (receiver->*method)(params); });
+    }
+    // Unregisters legacy handlers as well as callbacks
     void unregisterNotificationHandler(QObject *handler);
 
     int sendCommand(const QString &method, const QVariantMap &params, QObject *caller = nullptr, const QString &callbackMethod = QString());
     int sendCommand(const QString &method, QObject *caller = nullptr, const QString &callbackMethod = QString());
+    // Like the above, but the callback gets the response params as parsed from the wire without a detour
+    // through QVariant. It is not called if receiver has been destroyed in the meantime.
+    int sendCommand(const QString &method, const QVariantMap &params, QObject *receiver, ReplyCallback callback);
+    template <typename T>
+    int sendCommand(const QString &method, const QVariantMap &params, T *receiver, void (T::*callback)(int commandId, const QJsonObject &params)) {
+        return sendCommand(method, params, receiver, [receiver, callback](int commandId, const QJsonObject &params) { (receiver->*callback)(commandId, params); });
+    }
 
     NymeaConnection::BearerTypes availableBearerTypes() const;
     NymeaConnection::ConnectionStatus connectionStatus() const;
@@ -85,6 +136,35 @@ public:
     bool pushButtonAuthAvailable() const;
     bool authenticated() const;
     QHash<QString, QString> cacheHashes() const;
+    JsonRpcResultCache *resultCache() const;
+    // The encoding negotiated with the core, see JsonRpcCodec
+    QString wireEncoding() const;
+
+    // By default, JSONRPC calls and anything that's not a Get* are interactive, fetching logs
+    // goes to the background and all other Get* calls are startup fetches.
+    RequestPriority methodPriority(const QString &method);
+    void setMethodPriority(const QString &method, RequestPriority priority);
+    // In ms, 0 waits forever. Defaults to a timeout per priority, calls known to take long,
+    // like discovery, pairing or system updates, and the handshake aren't timed out.
+    // The timeout only runs while nothing is received, so large replies arriving slowly,
+    // e.g. over bluetooth, don't time out the requests queued up behind them.
+    int methodTimeout(const QString &method);
+    void setMethodTimeout(const QString &method, int timeout);
+    // Whether the params passed to a reply callback are those of a timed out request
+    static bool isTimeout(const QVariantMap &params);
+    static bool isTimeout(const QJsonObject &params);
+
+    int maxInFlight() const;
+    void setMaxInFlight(int maxInFlight);
+    int inFlight() const;
+    int queueDepth() const;
+    // Time requests spent in the queue, in ms
+    int averageWaitTime() const;
+    int maxWaitTime() const;
+    // Read requests answered by an identical one which has been in flight already
+    int coalescedRequests() const;
+    int timedOutRequests() const;
+
     // Note: This does not reflect the actual permission scopes of the user but is translated to effective permissions
     // That, is, if the user has the admin permission, all of the other scopes will be set too even if they might not be explicitly set
     UserInfo::PermissionScopes permissions() const;
@@ -138,21 +218,71 @@ signals:
 
     void responseReceived(const int &commandId, const QVariantMap &response);
 
+    void wireEncodingChanged();
+    void maxInFlightChanged();
+    void schedulerStatisticsChanged();
+
 private slots:
     void onInterfaceConnectedChanged(bool connected);
     void dataReceived(const QByteArray &data);
 
     void helloReply(int commandId, const QVariantMap &params);
 
+    // Moving the session over to a faster transport, see NymeaConnection::migrated()
+    void onConnectionMigrated();
+    void migrationHelloReply(int commandId, const QVariantMap &params);
+    void drainingDataReceived(const QByteArray &data);
+    void onDrainingFinished();
+
 private:
+    // Resumes the session on the previous transport if the handshake on the new one failed
+    void abortMigration();
+    // Sends reads again on the current transport, the rest is dropped as it may have been executed
+    void resendReplies(const QSet<int> &commandIds);
+
+    struct NotificationCallbackEntry {
+        QPointer<QObject> receiver;
+        NotificationCallback callback;
+    };
+
     int m_id;
     // < namespace, method> >
-    QHash<QObject*, QString> m_notificationHandlerMethods;
+    QHash<QObject*, QMetaMethod> m_notificationHandlerMethods;
     QMultiHash<QString, QObject*> m_notificationHandlers;
+    // Notification names are interned once, the id is an index into m_notificationCallbacks
+    QHash<QString, int> m_notificationIds;
+    QVector<QList<NotificationCallbackEntry>> m_notificationCallbacks;
     QHash<int, JsonRpcReply *> m_replies;
     NymeaConnection *m_connection = nullptr;
 
     JsonRpcReply *createReply(const QString &method, const QVariantMap &params, QObject *caller, const QString &callback);
+    int sendReply(JsonRpcReply *reply);
+
+    // Request scheduling
+    void enqueue(JsonRpcReply *reply);
+    void dispatch();
+    void checkTimeouts();
+    // Calls the callbacks of reply and of all replies coalesced with it
+    void finishReply(JsonRpcReply *reply, const QJsonObject &params);
+    void clearRequests();
+    void updateSchedulerStatistics();
+
+    QQueue<JsonRpcReply*> m_queues[3];
+    QHash<QString, RequestPriority> m_methodPriorities;
+    QHash<QString, int> m_methodTimeouts;
+    // Read requests in the queue or in flight by method and params, and the ones waiting for them
+    QHash<QByteArray, int> m_pendingReads;
+    QHash<int, QList<JsonRpcReply*>> m_coalescedReplies;
+    int m_maxInFlight = 16;
+    QElapsedTimer m_clock;
+    // m_clock time at which data was last received
+    qint64 m_lastDataAt = 0;
+    QTimer m_timeoutTimer;
+    QTimer m_statisticsTimer;
+    qreal m_averageWaitTime = 0;
+    int m_maxWaitTime = 0;
+    int m_coalescedRequests = 0;
+    int m_timedOutRequests = 0;
 
     bool m_connected = false;
     bool m_initialSetupRequired = false;
@@ -165,13 +295,23 @@ private:
     QString m_serverQtVersion;
     QString m_serverQtBuildVersion;
     QByteArray m_token;
-    QByteArray m_receiveBuffer;
+    JsonRpcFramer m_framer;
+    JsonRpcCodec m_codec;
+    // The transport we've migrated away from, and the replies still expected on it
+    JsonRpcFramer m_drainingFramer;
+    JsonRpcCodec m_drainingCodec;
+    QSet<int> m_drainingReplies;
+    bool m_migrating = false;
+    // The core didn't know about wire encodings in the last Hello
+    bool m_encodingsRejected = false;
     QHash<QString, QString> m_cacheHashes;
+    JsonRpcResultCache *m_resultCache = nullptr;
     QVariantMap m_experiences;
     UserInfo::PermissionScopes m_permissionScopes = UserInfo::PermissionScopeNone;
     QString m_username;
 
     void setNotificationsEnabled();
+    bool verifyCertificate(const QUuid &serverUuid);
 
     // json handler
     Q_INVOKABLE void processAuthenticate(int commandId, const QVariantMap &data);
@@ -179,10 +319,15 @@ private:
     Q_INVOKABLE void processRequestPushButtonAuth(int commandId, const QVariantMap &data);
 
     Q_INVOKABLE void setNotificationsEnabledResponse(int commandId, const QVariantMap &params);
-    Q_INVOKABLE void notificationReceived(const QVariantMap &data);
+    void pushButtonAuthFinishedNotification(const QJsonObject &params);
+    void userChangedNotification(const QJsonObject &params);
     Q_INVOKABLE void getVersionsReply(int commandId, const QVariantMap &data);
 
+    int notificationId(const QString &notification);
+    void processMessage(const QJsonDocument &jsonDoc);
     void sendRequest(const QVariantMap &request);
+    QStringList offeredEncodings() const;
+    void applyEncoding(const QVariantMap &helloParams);
 
     bool loadPem(const QUuid &serverUud, QByteArray &pem);
     bool storePem(const QUuid &serverUuid, const QByteArray &pem);
@@ -206,6 +351,21 @@ public:
     QPointer<QObject> caller() const;
     QString callback() const;
 
+    JsonRpcClient::ReplyCallback replyCallback() const;
+    void setReplyCallback(JsonRpcClient::ReplyCallback replyCallback);
+
+    // Scheduling state, maintained by JsonRpcClient. Times are in ms on its clock, -1 if not yet.
+    JsonRpcClient::RequestPriority priority() const;
+    void setPriority(JsonRpcClient::RequestPriority priority);
+    qint64 queuedAt() const;
+    void setQueuedAt(qint64 queuedAt);
+    qint64 sentAt() const;
+    void setSentAt(qint64 sentAt);
+    int timeout() const;
+    void setTimeout(int timeout);
+    QByteArray readKey() const;
+    void setReadKey(const QByteArray &readKey);
+
 private:
     int m_commandId;
     QString m_nameSpace;
@@ -214,6 +374,13 @@ private:
 
     QPointer<QObject> m_caller;
     QString m_callback;
+    JsonRpcClient::ReplyCallback m_replyCallback;
+
+    JsonRpcClient::RequestPriority m_priority = JsonRpcClient::RequestPriorityInteractive;
+    qint64 m_queuedAt = -1;
+    qint64 m_sentAt = -1;
+    int m_timeout = 0;
+    QByteArray m_readKey;
 };
 
 
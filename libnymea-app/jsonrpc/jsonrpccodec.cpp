@@ -0,0 +1,225 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "jsonrpccodec.h"
+
+#include <QJsonDocument>
+#include <QtEndian>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QCborMap>
+#include <QCborValue>
+#define JSONRPC_CODEC_CBOR
+#endif
+
+JsonRpcCodec::JsonRpcCodec(Encoding encoding):
+    m_encoding(encoding)
+{
+}
+
+QStringList JsonRpcCodec::supportedEncodings(bool preferCompression)
+{
+    QList<Encoding> encodings;
+#ifdef JSONRPC_CODEC_CBOR
+    if (preferCompression) {
+        encodings << EncodingCborQCompress << EncodingJsonQCompress << EncodingCbor;
+    } else {
+        encodings << EncodingCbor << EncodingCborQCompress << EncodingJsonQCompress;
+    }
+#else
+    encodings << EncodingJsonQCompress;
+    Q_UNUSED(preferCompression)
+#endif
+
+    QStringList names;
+    foreach (Encoding encoding, encodings) {
+        names.append(encodingName(encoding));
+    }
+    return names;
+}
+
+bool JsonRpcCodec::encodingFromName(const QString &name, Encoding *encoding)
+{
+    if (name == "json") {
+        *encoding = EncodingJson;
+    } else if (name == "json+qcompress") {
+        *encoding = EncodingJsonQCompress;
+#ifdef JSONRPC_CODEC_CBOR
+    } else if (name == "cbor") {
+        *encoding = EncodingCbor;
+    } else if (name == "cbor+qcompress") {
+        *encoding = EncodingCborQCompress;
+#endif
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString JsonRpcCodec::encodingName(Encoding encoding)
+{
+    switch (encoding) {
+    case EncodingJson:
+        return QStringLiteral("json");
+    case EncodingJsonQCompress:
+        return QStringLiteral("json+qcompress");
+    case EncodingCbor:
+        return QStringLiteral("cbor");
+    case EncodingCborQCompress:
+        return QStringLiteral("cbor+qcompress");
+    }
+    return QString();
+}
+
+JsonRpcCodec::Encoding JsonRpcCodec::encoding() const
+{
+    return m_encoding;
+}
+
+QString JsonRpcCodec::name() const
+{
+    return encodingName(m_encoding);
+}
+
+bool JsonRpcCodec::isBinary() const
+{
+    return m_encoding != EncodingJson;
+}
+
+QByteArray JsonRpcCodec::encode(const QVariantMap &message) const
+{
+    if (m_encoding == EncodingJson) {
+        return QJsonDocument::fromVariant(message).toJson(QJsonDocument::Compact) + "\n";
+    }
+    // Go through JSON types so both encodings carry exactly the same data, e.g. uuids as strings
+    return encode(QJsonObject::fromVariantMap(message));
+}
+
+QByteArray JsonRpcCodec::encode(const QJsonObject &message) const
+{
+    switch (m_encoding) {
+    case EncodingJson:
+        return QJsonDocument(message).toJson(QJsonDocument::Compact) + "\n";
+    case EncodingJsonQCompress:
+        return frame(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    case EncodingCbor:
+    case EncodingCborQCompress:
+#ifdef JSONRPC_CODEC_CBOR
+        return frame(QCborMap::fromJsonObject(message).toCborValue().toCbor());
+#else
+        break;
+#endif
+    }
+    return QByteArray();
+}
+
+bool JsonRpcCodec::decode(const QByteArray &frame, QJsonObject *message, QString *errorString) const
+{
+    QByteArray payload = frame;
+    if (isBinary()) {
+        if (frame.isEmpty()) {
+            if (errorString) {
+                *errorString = QStringLiteral("Empty frame");
+            }
+            return false;
+        }
+        quint8 flags = static_cast<quint8>(frame.at(0));
+        payload = frame.mid(1);
+        if (flags & FrameFlagQCompress) {
+            payload = qUncompress(payload);
+            if (payload.isEmpty()) {
+                if (errorString) {
+                    *errorString = QStringLiteral("Could not uncompress %1 bytes").arg(frame.size() - 1);
+                }
+                return false;
+            }
+        }
+    }
+
+    if (m_encoding == EncodingJson || m_encoding == EncodingJsonQCompress) {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            if (errorString) {
+                *errorString = QStringLiteral("%1 at offset %2 of %3 bytes").arg(error.errorString()).arg(error.offset).arg(payload.size());
+            }
+            return false;
+        }
+        if (!jsonDoc.isObject()) {
+            if (errorString) {
+                *errorString = QStringLiteral("Message is not an object");
+            }
+            return false;
+        }
+        *message = jsonDoc.object();
+        return true;
+    }
+
+#ifdef JSONRPC_CODEC_CBOR
+    QCborParserError error;
+    QCborValue value = QCborValue::fromCbor(payload, &error);
+    if (error.error != QCborError::NoError) {
+        if (errorString) {
+            *errorString = QStringLiteral("%1 at offset %2 of %3 bytes").arg(error.errorString()).arg(error.offset).arg(payload.size());
+        }
+        return false;
+    }
+    if (!value.isMap()) {
+        if (errorString) {
+            *errorString = QStringLiteral("Message is not a map");
+        }
+        return false;
+    }
+    *message = value.toMap().toJsonObject();
+    return true;
+#else
+    if (errorString) {
+        *errorString = QStringLiteral("Encoding %1 is not supported").arg(name());
+    }
+    return false;
+#endif
+}
+
+QByteArray JsonRpcCodec::frame(const QByteArray &payload) const
+{
+    quint8 flags = FrameFlagNone;
+    QByteArray data = payload;
+    if ((m_encoding == EncodingJsonQCompress || m_encoding == EncodingCborQCompress) && payload.size() >= CompressionThreshold) {
+        data = qCompress(payload);
+        flags |= FrameFlagQCompress;
+    }
+
+    QByteArray ret(5, Qt::Uninitialized);
+    qToBigEndian<quint32>(data.size() + 1, reinterpret_cast<uchar*>(ret.data()));
+    ret[4] = static_cast<char>(flags);
+    ret.append(data);
+    return ret;
+}
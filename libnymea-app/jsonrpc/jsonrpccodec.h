@@ -0,0 +1,99 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef JSONRPCCODEC_H
+#define JSONRPCCODEC_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QStringList>
+#include <QVariantMap>
+
+/*
+ * Wire encoding of JSON-RPC messages, as negotiated in JSONRPC.Hello.
+ *
+ * The client offers the encodings it supports in the "encodings" param of the Hello call, in
+ * order of preference. A core which supports any of them picks one and returns it as
+ * "encoding" in the Hello reply, which itself is still sent as JSON text. Everything the core
+ * sends after that uses the picked encoding. Older cores reject the unknown param, in which
+ * case the client says Hello again without it and stays with JSON text.
+ *
+ * All encodings but plain JSON use binary frames: a 32 bit big endian length, followed by
+ * a flags byte and the payload. If the qCompress flag is set, the payload is in qCompress()
+ * format, i.e. the uncompressed size as 32 bit big endian integer followed by a zlib stream
+ * (RFC 1950), not raw deflate. Small messages aren't worth compressing and are sent as they are.
+ * Requests sent before the Hello reply arrived are still JSON text, cores tell them apart
+ * from binary frames by their first byte.
+ */
+class JsonRpcCodec
+{
+public:
+    enum Encoding {
+        EncodingJson,
+        EncodingJsonQCompress,
+        EncodingCbor,
+        EncodingCborQCompress
+    };
+
+    enum FrameFlag {
+        FrameFlagNone = 0x00,
+        FrameFlagQCompress = 0x01
+    };
+
+    // Payloads smaller than that are sent uncompressed
+    static const int CompressionThreshold = 512;
+
+    explicit JsonRpcCodec(Encoding encoding = EncodingJson);
+
+    // Names of the encodings supported by this build, in order of preference. Compression costs
+    // CPU time on both ends and is only worth it on slow links.
+    static QStringList supportedEncodings(bool preferCompression);
+    static bool encodingFromName(const QString &name, Encoding *encoding);
+    static QString encodingName(Encoding encoding);
+
+    Encoding encoding() const;
+    QString name() const;
+    // Whether messages are sent in length prefixed binary frames instead of JSON text
+    bool isBinary() const;
+
+    // Returns the message ready to be written to the transport
+    QByteArray encode(const QVariantMap &message) const;
+    QByteArray encode(const QJsonObject &message) const;
+
+    // Decodes a frame as returned by JsonRpcFramer in the matching framing mode
+    bool decode(const QByteArray &frame, QJsonObject *message, QString *errorString = nullptr) const;
+
+private:
+    QByteArray frame(const QByteArray &payload) const;
+
+    Encoding m_encoding = EncodingJson;
+};
+
+#endif // JSONRPCCODEC_H
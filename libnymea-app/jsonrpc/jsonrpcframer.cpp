@@ -0,0 +1,258 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "jsonrpcframer.h"
+
+#include <QtEndian>
+
+JsonRpcFramer::JsonRpcFramer(int maxFrameSize):
+    m_maxFrameSize(maxFrameSize)
+{
+}
+
+void JsonRpcFramer::append(const QByteArray &data)
+{
+    m_buffer.append(data);
+}
+
+JsonRpcFramer::FrameStatus JsonRpcFramer::takeFrame(QByteArray *frame)
+{
+    m_error = FramingErrorNoError;
+
+    if (m_mode == FramingModeLengthPrefixed) {
+        return takeLengthPrefixedFrame(frame);
+    }
+
+    const char *data = m_buffer.constData();
+    const int size = m_buffer.size();
+
+    for (; m_scanPos < size; m_scanPos++) {
+        const char c = data[m_scanPos];
+
+        // Between frames: skip whitespace (including the newline delimiter) until the next message starts
+        if (m_frameStart < 0) {
+            if (c == '{' || c == '[') {
+                m_frameStart = m_scanPos;
+                m_depth = 1;
+                m_discarding = false;
+                continue;
+            }
+            if (c == '\n' || c == ' ' || c == '\r' || c == '\t' || m_discarding) {
+                continue;
+            }
+            // Report garbage only once per run of unexpected data
+            m_discarding = true;
+            m_error = FramingErrorUnexpectedData;
+            m_scanPos++;
+            return FrameStatusError;
+        }
+
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (c == '\\') {
+                m_escaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            break;
+        case '{':
+        case '[':
+            // Nested objects are never placed at the start of a line, neither in compact nor in indented
+            // messages. If we see one, the previous message has been truncated. Resync on the new one.
+            if (m_scanPos > m_frameStart && data[m_scanPos - 1] == '\n') {
+                m_frameStart = m_scanPos;
+                m_depth = 1;
+                m_skipFrame = false;
+                m_error = FramingErrorUnbalanced;
+                m_scanPos++;
+                return FrameStatusError;
+            }
+            m_depth++;
+            break;
+        case '}':
+        case ']':
+            m_depth--;
+            if (m_depth == 0) {
+                const int frameStart = m_frameStart;
+                const bool skipFrame = m_skipFrame;
+                m_frameStart = -1;
+                m_skipFrame = false;
+                if (skipFrame) {
+                    continue;
+                }
+                *frame = m_buffer.mid(frameStart, m_scanPos - frameStart + 1);
+                m_scanPos++;
+                return FrameStatusComplete;
+            }
+            break;
+        }
+
+        if (!m_skipFrame && m_scanPos - m_frameStart >= m_maxFrameSize) {
+            m_skipFrame = true;
+            m_error = FramingErrorFrameTooLarge;
+            m_scanPos++;
+            return FrameStatusError;
+        }
+    }
+
+    compact();
+    return FrameStatusIncomplete;
+}
+
+void JsonRpcFramer::reset()
+{
+    m_buffer.clear();
+    m_scanPos = 0;
+    m_frameStart = -1;
+    m_depth = 0;
+    m_inString = false;
+    m_escaped = false;
+    m_discarding = false;
+    m_skipFrame = false;
+    m_mode = FramingModeJson;
+    m_skipWhitespace = false;
+    m_skipBytes = 0;
+    m_error = FramingErrorNoError;
+}
+
+JsonRpcFramer::FramingMode JsonRpcFramer::mode() const
+{
+    return m_mode;
+}
+
+void JsonRpcFramer::setMode(FramingMode mode)
+{
+    Q_ASSERT_X(m_frameStart < 0, "JsonRpcFramer", "Framing mode changed in the middle of a frame");
+    m_mode = mode;
+    m_skipWhitespace = mode == FramingModeLengthPrefixed;
+    m_skipBytes = 0;
+    m_discarding = false;
+}
+
+int JsonRpcFramer::bufferedBytes() const
+{
+    return m_buffer.size();
+}
+
+JsonRpcFramer::FramingError JsonRpcFramer::error() const
+{
+    return m_error;
+}
+
+QString JsonRpcFramer::errorString() const
+{
+    switch (m_error) {
+    case FramingErrorNoError:
+        return QString();
+    case FramingErrorUnexpectedData:
+        return QStringLiteral("Unexpected data between messages");
+    case FramingErrorUnbalanced:
+        return QStringLiteral("Truncated message, new message started before the previous one was closed");
+    case FramingErrorFrameTooLarge:
+        return QStringLiteral("Message exceeds the maximum frame size of %1 bytes").arg(m_maxFrameSize);
+    }
+    return QString();
+}
+
+JsonRpcFramer::FrameStatus JsonRpcFramer::takeLengthPrefixedFrame(QByteArray *frame)
+{
+    const char *data = m_buffer.constData();
+    const int size = m_buffer.size();
+
+    if (m_skipBytes > 0) {
+        int skip = static_cast<int>(qMin<qint64>(m_skipBytes, size - m_scanPos));
+        m_scanPos += skip;
+        m_skipBytes -= skip;
+        if (m_skipBytes > 0) {
+            compact();
+            return FrameStatusIncomplete;
+        }
+    }
+
+    while (m_skipWhitespace && m_scanPos < size) {
+        const char c = data[m_scanPos];
+        if (c != '\n' && c != ' ' && c != '\r' && c != '\t') {
+            m_skipWhitespace = false;
+            break;
+        }
+        m_scanPos++;
+    }
+
+    if (size - m_scanPos < 4) {
+        compact();
+        return FrameStatusIncomplete;
+    }
+
+    const quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + m_scanPos));
+    if (length > static_cast<quint32>(m_maxFrameSize)) {
+        // There's no way to resync on a binary stream, but at least the length is known
+        m_skipBytes = 4 + static_cast<qint64>(length);
+        m_error = FramingErrorFrameTooLarge;
+        return FrameStatusError;
+    }
+    if (static_cast<quint32>(size - m_scanPos - 4) < length) {
+        compact();
+        return FrameStatusIncomplete;
+    }
+
+    *frame = m_buffer.mid(m_scanPos + 4, length);
+    m_scanPos += 4 + length;
+    return FrameStatusComplete;
+}
+
+void JsonRpcFramer::compact()
+{
+    // Everything before the current frame has been handed out already. Frames that are being
+    // skipped don't need to be retained at all.
+    int keepFrom = m_scanPos;
+    if (m_frameStart >= 0 && !m_skipFrame) {
+        keepFrom = m_frameStart;
+    }
+    if (keepFrom == 0) {
+        return;
+    }
+    if (keepFrom >= m_buffer.size()) {
+        m_buffer.clear();
+    } else {
+        m_buffer.remove(0, keepFrom);
+    }
+    m_scanPos -= keepFrom;
+    if (m_frameStart >= 0) {
+        m_frameStart = m_skipFrame ? m_scanPos : m_frameStart - keepFrom;
+    }
+}
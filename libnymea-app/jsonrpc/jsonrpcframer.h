@@ -0,0 +1,110 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef JSONRPCFRAMER_H
+#define JSONRPCFRAMER_H
+
+#include <QByteArray>
+#include <QString>
+
+/*
+ * Incremental framer for the newline delimited JSON-RPC stream.
+ *
+ * Incoming chunks are appended to an internal buffer which is scanned exactly
+ * once. The scanner keeps track of nesting depth and string/escape state so
+ * it works with compact as well as indented messages. A frame is complete
+ * when its top level object is closed, the newline delimiter following it is
+ * consumed as whitespace. Consumed data is dropped from the buffer only once
+ * per drain, not per message, keeping the cost linear in the input size.
+ *
+ * Once a binary wire encoding has been negotiated, the stream switches to length prefixed
+ * frames (see JsonRpcCodec). Data buffered beyond the last frame taken is kept when switching.
+ */
+class JsonRpcFramer
+{
+public:
+    enum FrameStatus {
+        FrameStatusIncomplete,
+        FrameStatusComplete,
+        FrameStatusError
+    };
+
+    enum FramingMode {
+        FramingModeJson,
+        FramingModeLengthPrefixed
+    };
+
+    enum FramingError {
+        FramingErrorNoError,
+        FramingErrorUnexpectedData,
+        FramingErrorUnbalanced,
+        FramingErrorFrameTooLarge
+    };
+
+    static const int DefaultMaxFrameSize = 64 * 1024 * 1024;
+
+    explicit JsonRpcFramer(int maxFrameSize = DefaultMaxFrameSize);
+
+    void append(const QByteArray &data);
+    FrameStatus takeFrame(QByteArray *frame);
+    // Resets the buffer, the state and the framing mode
+    void reset();
+
+    FramingMode mode() const;
+    // Must only be called between frames
+    void setMode(FramingMode mode);
+
+    int bufferedBytes() const;
+    FramingError error() const;
+    QString errorString() const;
+
+private:
+    FrameStatus takeLengthPrefixedFrame(QByteArray *frame);
+    void compact();
+
+    int m_maxFrameSize = DefaultMaxFrameSize;
+    FramingMode m_mode = FramingModeJson;
+    QByteArray m_buffer;
+    int m_scanPos = 0;
+    int m_frameStart = -1;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escaped = false;
+    bool m_discarding = false;
+    bool m_skipFrame = false;
+    // Length prefixed mode: the newline delimiter of the last JSON frame may still be due, and
+    // bytes left to skip of a frame which is too large
+    bool m_skipWhitespace = false;
+    qint64 m_skipBytes = 0;
+    FramingError m_error = FramingErrorNoError;
+};
+
+#endif // JSONRPCFRAMER_H
@@ -0,0 +1,332 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "jsonrpcresultcache.h"
+#include "jsonrpcresultstore.h"
+
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QLocale>
+#include <QRegExp>
+
+#include "logging.h"
+Q_DECLARE_LOGGING_CATEGORY(dcJsonRpcCache)
+
+// Seconds a server's store is kept on disk without being used
+static const qint64 maxStoreAge = 30 * 24 * 60 * 60;
+
+// Appends value in a form that is equal for equal params, e.g. map keys are always sorted.
+// Lengths are part of it, so no two different values map to the same bytes.
+static void appendCanonical(QByteArray &out, const QVariant &value)
+{
+    switch (static_cast<int>(value.type())) {
+    case QVariant::Map:
+    case QVariant::Hash: {
+        QVariantMap map = value.toMap();
+        out += 'm' + QByteArray::number(map.count()) + ':';
+        for (QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it) {
+            appendCanonical(out, it.key());
+            appendCanonical(out, it.value());
+        }
+        break;
+    }
+    case QVariant::List:
+    case QVariant::StringList: {
+        QVariantList list = value.toList();
+        out += 'l' + QByteArray::number(list.count()) + ':';
+        foreach (const QVariant &item, list) {
+            appendCanonical(out, item);
+        }
+        break;
+    }
+    case QVariant::Invalid:
+        out += 'n';
+        break;
+    case QVariant::Bool:
+        out += value.toBool() ? 't' : 'f';
+        break;
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+        out += 'd' + QByteArray::number(value.toDouble(), 'g', 17) + ';';
+        break;
+    default: {
+        // Strings, uuids and everything else which has a string representation
+        QByteArray string = value.toString().toUtf8();
+        out += 's' + QByteArray::number(string.length()) + ':' + string;
+        break;
+    }
+    }
+}
+
+JsonRpcResultCache::JsonRpcResultCache(QObject *parent) :
+    QObject(parent),
+    m_store(new JsonRpcResultStore())
+{
+    m_memory.setMaxCost(8 * 1024 * 1024);
+
+    m_store->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_store, &QObject::deleteLater);
+    connect(m_store, &JsonRpcResultStore::keysLoaded, this, &JsonRpcResultCache::onKeysLoaded);
+    connect(m_store, &JsonRpcResultStore::lookupFinished, this, &JsonRpcResultCache::onLookupFinished);
+    connect(m_store, &JsonRpcResultStore::statisticsChanged, this, &JsonRpcResultCache::onStoreStatisticsChanged);
+    m_thread.setObjectName("JsonRpcResultCache");
+    m_thread.start(QThread::LowPriority);
+
+    QMetaObject::invokeMethod(m_store, "removeLegacyFiles", Qt::QueuedConnection, Q_ARG(QString, QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+
+    // Drop the caches of servers we haven't connected to for a while
+    QMetaObject::invokeMethod(m_store, "removeStaleStores", Qt::QueuedConnection, Q_ARG(QString, QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/jsonrpc"), Q_ARG(qint64, maxStoreAge));
+}
+
+JsonRpcResultCache::~JsonRpcResultCache()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void JsonRpcResultCache::open(const QUuid &serverUuid, const QHash<QString, QString> &cacheHashes)
+{
+    close();
+    if (serverUuid.isNull() || cacheHashes.isEmpty()) {
+        return;
+    }
+    m_serverUuid = serverUuid;
+    m_cacheHashes = cacheHashes;
+
+    QVariantMap hashes;
+    for (QHash<QString, QString>::const_iterator it = cacheHashes.constBegin(); it != cacheHashes.constEnd(); ++it) {
+        hashes.insert(it.key(), it.value());
+    }
+    QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/jsonrpc/" + serverUuid.toString().remove(QRegExp("[{}]"));
+    m_pendingOpens++;
+    QMetaObject::invokeMethod(m_store, "open", Qt::QueuedConnection, Q_ARG(QString, path), Q_ARG(QVariantMap, hashes), Q_ARG(bool, true));
+}
+
+void JsonRpcResultCache::close()
+{
+    m_serverUuid = QUuid();
+    m_cacheHashes.clear();
+    m_memory.clear();
+    m_diskKeys.clear();
+    m_diskKeysLoaded = false;
+    QMetaObject::invokeMethod(m_store, "close", Qt::QueuedConnection);
+
+    QHash<QByteArray, QList<LookupCallback>> pendingLookups = m_pendingLookups;
+    m_pendingLookups.clear();
+    foreach (const QList<LookupCallback> &callbacks, pendingLookups) {
+        foreach (const LookupCallback &callback, callbacks) {
+            callback(false, QVariantMap());
+        }
+    }
+    emit statisticsChanged();
+}
+
+bool JsonRpcResultCache::isCacheable(const QString &method) const
+{
+    return m_cacheHashes.contains(method);
+}
+
+void JsonRpcResultCache::lookup(const QString &method, const QVariantMap &params, LookupCallback callback)
+{
+    QByteArray cacheKey = key(method, params);
+
+    QByteArray *data = m_memory.object(cacheKey);
+    if (data) {
+        bool ok;
+        QVariantMap result = decode(*data, &ok);
+        if (ok) {
+            m_hits++;
+            m_bytesServed += data->size();
+            emit statisticsChanged();
+            qCDebug(dcJsonRpcCache()) << "Memory hit for" << method;
+            callback(true, result);
+            return;
+        }
+        m_memory.remove(cacheKey);
+    }
+
+    if (m_diskKeysLoaded && !m_diskKeys.contains(cacheKey)) {
+        m_misses++;
+        emit statisticsChanged();
+        callback(false, QVariantMap());
+        return;
+    }
+
+    // Only ask the disk once for concurrent lookups of the same call
+    bool alreadyPending = m_pendingLookups.contains(cacheKey);
+    m_pendingLookups[cacheKey].append(callback);
+    if (!alreadyPending) {
+        QMetaObject::invokeMethod(m_store, "lookup", Qt::QueuedConnection, Q_ARG(QByteArray, cacheKey));
+    }
+}
+
+void JsonRpcResultCache::insert(const QString &method, const QVariantMap &params, const QJsonObject &result)
+{
+    if (!isCacheable(method)) {
+        return;
+    }
+    QByteArray cacheKey = key(method, params);
+    QByteArray data = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    m_memory.insert(cacheKey, new QByteArray(data), data.size());
+    m_diskKeys.insert(cacheKey);
+    QMetaObject::invokeMethod(m_store, "store", Qt::QueuedConnection, Q_ARG(QByteArray, cacheKey), Q_ARG(QString, method), Q_ARG(QString, m_cacheHashes.value(method)), Q_ARG(QByteArray, data));
+    emit statisticsChanged();
+}
+
+void JsonRpcResultCache::clear()
+{
+    m_memory.clear();
+    m_diskKeys.clear();
+    m_hits = 0;
+    m_misses = 0;
+    m_bytesServed = 0;
+    QMetaObject::invokeMethod(m_store, "clear", Qt::QueuedConnection);
+    emit statisticsChanged();
+}
+
+int JsonRpcResultCache::hits() const
+{
+    return m_hits;
+}
+
+int JsonRpcResultCache::misses() const
+{
+    return m_misses;
+}
+
+qint64 JsonRpcResultCache::bytesServed() const
+{
+    return m_bytesServed;
+}
+
+int JsonRpcResultCache::memoryEntries() const
+{
+    return m_memory.count();
+}
+
+qint64 JsonRpcResultCache::memoryBytes() const
+{
+    return m_memory.totalCost();
+}
+
+int JsonRpcResultCache::diskEntries() const
+{
+    return m_diskEntries;
+}
+
+qint64 JsonRpcResultCache::diskBytes() const
+{
+    return m_diskBytes;
+}
+
+int JsonRpcResultCache::memoryLimit() const
+{
+    return m_memory.maxCost();
+}
+
+void JsonRpcResultCache::setMemoryLimit(int memoryLimit)
+{
+    if (m_memory.maxCost() != memoryLimit) {
+        m_memory.setMaxCost(memoryLimit);
+        emit memoryLimitChanged();
+        emit statisticsChanged();
+    }
+}
+
+void JsonRpcResultCache::onKeysLoaded(const QList<QByteArray> &keys)
+{
+    m_pendingOpens--;
+    if (m_pendingOpens > 0 || m_serverUuid.isNull()) {
+        // Reopened or closed in the meantime
+        return;
+    }
+    // Keys inserted while the store was opening are kept
+    foreach (const QByteArray &key, keys) {
+        m_diskKeys.insert(key);
+    }
+    m_diskKeysLoaded = true;
+}
+
+void JsonRpcResultCache::onLookupFinished(const QByteArray &key, const QByteArray &data, bool found)
+{
+    if (!m_pendingLookups.contains(key)) {
+        // Closed in the meantime
+        return;
+    }
+    QList<LookupCallback> callbacks = m_pendingLookups.take(key);
+
+    QVariantMap result;
+    if (found) {
+        result = decode(data, &found);
+    }
+    if (found) {
+        m_hits += callbacks.count();
+        m_bytesServed += data.size() * callbacks.count();
+        m_memory.insert(key, new QByteArray(data), data.size());
+    } else {
+        m_diskKeys.remove(key);
+        m_misses += callbacks.count();
+    }
+    emit statisticsChanged();
+
+    foreach (const LookupCallback &callback, callbacks) {
+        callback(found, result);
+    }
+}
+
+void JsonRpcResultCache::onStoreStatisticsChanged(qint64 diskBytes, int entries)
+{
+    m_diskBytes = diskBytes;
+    m_diskEntries = entries;
+    emit statisticsChanged();
+}
+
+QByteArray JsonRpcResultCache::key(const QString &method, const QVariantMap &params) const
+{
+    // Server and generation are part of the key so a late result from a previous session can never match
+    QByteArray key = m_serverUuid.toRfc4122();
+    appendCanonical(key, method);
+    appendCanonical(key, m_cacheHashes.value(method));
+    appendCanonical(key, QLocale().name());
+    appendCanonical(key, params);
+    return key;
+}
+
+QVariantMap JsonRpcResultCache::decode(const QByteArray &data, bool *ok) const
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    *ok = error.error == QJsonParseError::NoError && jsonDoc.isObject();
+    return jsonDoc.object().toVariantMap();
+}
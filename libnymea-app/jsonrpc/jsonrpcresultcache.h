@@ -0,0 +1,131 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef JSONRPCRESULTCACHE_H
+#define JSONRPCRESULTCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QUuid>
+#include <QThread>
+#include <QVariantMap>
+#include <QJsonObject>
+
+#include <functional>
+
+class JsonRpcResultStore;
+
+/*
+ * Caches results of methods the server announces cacheHashes for in its handshake. A result
+ * stays valid as long as the server reports the same hash for its method.
+ *
+ * Results are kept as compact JSON in a size limited in-memory LRU, backed by a per-server
+ * JsonRpcResultStore on disk. All disk I/O happens in a worker thread. The keys on disk are
+ * mirrored here, so only lookups which actually need to read from disk are asynchronous.
+ */
+class JsonRpcResultCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int hits READ hits NOTIFY statisticsChanged)
+    Q_PROPERTY(int misses READ misses NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 bytesServed READ bytesServed NOTIFY statisticsChanged)
+    Q_PROPERTY(int memoryEntries READ memoryEntries NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 memoryBytes READ memoryBytes NOTIFY statisticsChanged)
+    Q_PROPERTY(int diskEntries READ diskEntries NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 diskBytes READ diskBytes NOTIFY statisticsChanged)
+    Q_PROPERTY(int memoryLimit READ memoryLimit WRITE setMemoryLimit NOTIFY memoryLimitChanged)
+
+public:
+    typedef std::function<void(bool found, const QVariantMap &result)> LookupCallback;
+
+    explicit JsonRpcResultCache(QObject *parent = nullptr);
+    ~JsonRpcResultCache() override;
+
+    void open(const QUuid &serverUuid, const QHash<QString, QString> &cacheHashes);
+    // Pending lookups are finished as not found
+    void close();
+
+    bool isCacheable(const QString &method) const;
+    // The callback is called synchronously on memory hits and on misses, once the disk has been
+    // read otherwise. Until the store has reported its keys after open(), the disk is always asked.
+    void lookup(const QString &method, const QVariantMap &params, LookupCallback callback);
+    void insert(const QString &method, const QVariantMap &params, const QJsonObject &result);
+
+    Q_INVOKABLE void clear();
+
+    int hits() const;
+    int misses() const;
+    qint64 bytesServed() const;
+    int memoryEntries() const;
+    qint64 memoryBytes() const;
+    int diskEntries() const;
+    qint64 diskBytes() const;
+
+    // In bytes
+    int memoryLimit() const;
+    void setMemoryLimit(int memoryLimit);
+
+signals:
+    void statisticsChanged();
+    void memoryLimitChanged();
+
+private slots:
+    void onKeysLoaded(const QList<QByteArray> &keys);
+    void onLookupFinished(const QByteArray &key, const QByteArray &data, bool found);
+    void onStoreStatisticsChanged(qint64 diskBytes, int entries);
+
+private:
+    QByteArray key(const QString &method, const QVariantMap &params) const;
+    QVariantMap decode(const QByteArray &data, bool *ok) const;
+
+    QThread m_thread;
+    JsonRpcResultStore *m_store = nullptr;
+
+    QUuid m_serverUuid;
+    QHash<QString, QString> m_cacheHashes;
+    QCache<QByteArray, QByteArray> m_memory;
+    QHash<QByteArray, QList<LookupCallback>> m_pendingLookups;
+    // Keys believed to be on disk. Entries the store has dropped meanwhile are removed on lookup.
+    QSet<QByteArray> m_diskKeys;
+    bool m_diskKeysLoaded = false;
+    // Stores opened whose keys haven't been reported yet. Only the latest one counts.
+    int m_pendingOpens = 0;
+
+    int m_hits = 0;
+    int m_misses = 0;
+    qint64 m_bytesServed = 0;
+    int m_diskEntries = 0;
+    qint64 m_diskBytes = 0;
+};
+
+#endif // JSONRPCRESULTCACHE_H
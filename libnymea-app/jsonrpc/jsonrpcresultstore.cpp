@@ -0,0 +1,339 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "jsonrpcresultstore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <algorithm>
+
+#include "logging.h"
+NYMEA_LOGGING_CATEGORY(dcJsonRpcCache, "JsonRpcCache")
+
+static const quint32 indexMagic = 0x4e595243; // "NYRC"
+static const quint32 indexVersion = 3;
+// Don't bother compacting for less than this
+static const qint64 compactionThreshold = 1024 * 1024;
+// Live (compressed) bytes per server before least recently used entries are dropped
+static const qint64 maxStoreSize = 16 * 1024 * 1024;
+
+JsonRpcResultStore::JsonRpcResultStore(QObject *parent) : QObject(parent)
+{
+
+}
+
+JsonRpcResultStore::~JsonRpcResultStore()
+{
+    close();
+}
+
+void JsonRpcResultStore::open(const QString &path, const QVariantMap &cacheHashes, bool compress)
+{
+    close();
+
+    QDir dir(path);
+    if (!dir.exists() && !dir.mkpath(path)) {
+        qCWarning(dcJsonRpcCache()) << "Cannot create cache directory" << path;
+        emit keysLoaded(QList<QByteArray>());
+        return;
+    }
+    m_path = path;
+    m_compress = compress;
+
+    if (!loadIndex()) {
+        m_index.clear();
+        QFile::remove(m_path + "/data");
+    }
+    m_dataFile.setFileName(m_path + "/data");
+    if (!m_dataFile.open(QFile::ReadWrite)) {
+        qCWarning(dcJsonRpcCache()) << "Cannot open cache data file" << m_dataFile.fileName() << m_dataFile.errorString();
+        m_index.clear();
+        m_path.clear();
+        emit keysLoaded(QList<QByteArray>());
+        return;
+    }
+
+    // Drop everything that is not of the current generation
+    int dropped = 0;
+    QMutableHashIterator<QByteArray, Entry> it(m_index);
+    while (it.hasNext()) {
+        it.next();
+        if (cacheHashes.value(it.value().method).toString() != it.value().generation) {
+            m_liveBytes -= it.value().size;
+            it.remove();
+            dropped++;
+        }
+    }
+    if (dropped > 0) {
+        qCDebug(dcJsonRpcCache()) << "Dropped" << dropped << "outdated cache entries";
+    }
+    // Also marks the store as used for removeStaleStores()
+    saveIndex();
+    compactIfNeeded();
+    emit keysLoaded(m_index.keys());
+    updateStatistics();
+}
+
+void JsonRpcResultStore::close()
+{
+    if (m_indexDirty && !m_path.isEmpty()) {
+        saveIndex();
+    }
+    m_dataFile.close();
+    m_index.clear();
+    m_liveBytes = 0;
+    m_path.clear();
+}
+
+void JsonRpcResultStore::lookup(const QByteArray &key)
+{
+    if (!m_dataFile.isOpen() || !m_index.contains(key)) {
+        emit lookupFinished(key, QByteArray(), false);
+        return;
+    }
+
+    Entry entry = m_index.value(key);
+    QByteArray data;
+    if (m_dataFile.seek(entry.offset)) {
+        data = m_dataFile.read(entry.size);
+    }
+    bool ok = data.size() == entry.size;
+    if (ok && entry.compressed) {
+        data = qUncompress(data);
+        ok = !data.isEmpty();
+    }
+    if (!ok) {
+        qCWarning(dcJsonRpcCache()) << "Cannot read cache entry for" << entry.method << "Dropping it.";
+        m_liveBytes -= entry.size;
+        m_index.remove(key);
+        saveIndex();
+        updateStatistics();
+        emit lookupFinished(key, QByteArray(), false);
+        return;
+    }
+    // Written with the next change or when closing
+    m_index[key].lastUsed = QDateTime::currentSecsSinceEpoch();
+    m_indexDirty = true;
+    emit lookupFinished(key, data, true);
+}
+
+void JsonRpcResultStore::store(const QByteArray &key, const QString &method, const QString &generation, const QByteArray &data)
+{
+    if (!m_dataFile.isOpen()) {
+        return;
+    }
+
+    QByteArray blob = m_compress ? qCompress(data) : data;
+
+    if (m_index.contains(key)) {
+        m_liveBytes -= m_index.value(key).size;
+        m_index.remove(key);
+    }
+
+    Entry entry;
+    entry.method = method;
+    entry.generation = generation;
+    entry.offset = m_dataFile.size();
+    entry.size = blob.size();
+    entry.compressed = m_compress;
+    entry.lastUsed = QDateTime::currentSecsSinceEpoch();
+    if (!m_dataFile.seek(entry.offset) || m_dataFile.write(blob) != blob.size() || !m_dataFile.flush()) {
+        qCWarning(dcJsonRpcCache()) << "Error writing cache entry for" << method << m_dataFile.errorString();
+        return;
+    }
+    m_index.insert(key, entry);
+    m_liveBytes += entry.size;
+    evictIfNeeded();
+    saveIndex();
+    compactIfNeeded();
+    updateStatistics();
+}
+
+void JsonRpcResultStore::clear()
+{
+    if (m_path.isEmpty()) {
+        return;
+    }
+    m_index.clear();
+    m_liveBytes = 0;
+    m_dataFile.resize(0);
+    saveIndex();
+    updateStatistics();
+}
+
+void JsonRpcResultStore::removeLegacyFiles(const QString &path)
+{
+    QDir dir(path);
+    foreach (const QString &fileName, dir.entryList({"*.cache"}, QDir::Files)) {
+        dir.remove(fileName);
+    }
+}
+
+void JsonRpcResultStore::removeStaleStores(const QString &path, qint64 maxAge)
+{
+    QDir dir(path);
+    QDateTime oldest = QDateTime::currentDateTime().addSecs(-maxAge);
+    foreach (const QString &serverUuid, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QString storePath = dir.absoluteFilePath(serverUuid);
+        if (storePath == m_path) {
+            continue;
+        }
+        // Stores without an index are unusable anyways
+        QFileInfo index(storePath + "/index");
+        if (index.exists() && index.lastModified() >= oldest) {
+            continue;
+        }
+        qCDebug(dcJsonRpcCache()) << "Removing cache of server" << serverUuid << "unused since" << index.lastModified();
+        QDir(storePath).removeRecursively();
+    }
+}
+
+bool JsonRpcResultStore::loadIndex()
+{
+    m_index.clear();
+    m_liveBytes = 0;
+
+    QFile f(m_path + "/index");
+    if (!f.exists()) {
+        return false;
+    }
+    if (!f.open(QFile::ReadOnly)) {
+        qCWarning(dcJsonRpcCache()) << "Cannot open cache index" << f.fileName() << f.errorString();
+        return false;
+    }
+    QDataStream stream(&f);
+    quint32 magic, version, count;
+    stream >> magic >> version;
+    if (magic != indexMagic || version != indexVersion) {
+        qCInfo(dcJsonRpcCache()) << "Discarding cache with incompatible index version" << version;
+        return false;
+    }
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QByteArray key;
+        Entry entry;
+        stream >> key >> entry.method >> entry.generation >> entry.offset >> entry.size >> entry.compressed >> entry.lastUsed;
+        m_index.insert(key, entry);
+        m_liveBytes += entry.size;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(dcJsonRpcCache()) << "Cache index" << f.fileName() << "is corrupt. Discarding cache.";
+        m_index.clear();
+        m_liveBytes = 0;
+        return false;
+    }
+    return true;
+}
+
+bool JsonRpcResultStore::saveIndex()
+{
+    QSaveFile f(m_path + "/index");
+    if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+        qCWarning(dcJsonRpcCache()) << "Cannot write cache index" << f.fileName() << f.errorString();
+        return false;
+    }
+    QDataStream stream(&f);
+    stream << indexMagic << indexVersion << static_cast<quint32>(m_index.count());
+    for (QHash<QByteArray, Entry>::const_iterator it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        stream << it.key() << it.value().method << it.value().generation << it.value().offset << it.value().size << it.value().compressed << it.value().lastUsed;
+    }
+    m_indexDirty = false;
+    return f.commit();
+}
+
+void JsonRpcResultStore::evictIfNeeded()
+{
+    if (m_liveBytes <= maxStoreSize) {
+        return;
+    }
+
+    QList<QPair<qint64, QByteArray>> usage;
+    for (QHash<QByteArray, Entry>::const_iterator it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        usage.append(qMakePair(it.value().lastUsed, it.key()));
+    }
+    std::sort(usage.begin(), usage.end());
+
+    int evicted = 0;
+    for (int i = 0; i < usage.count() && m_liveBytes > maxStoreSize; i++) {
+        m_liveBytes -= m_index.take(usage.at(i).second).size;
+        evicted++;
+    }
+    // The cache finds out about evicted keys on their next lookup
+    qCDebug(dcJsonRpcCache()) << "Evicted" << evicted << "least recently used cache entries";
+}
+
+void JsonRpcResultStore::compactIfNeeded()
+{
+    qint64 garbage = m_dataFile.size() - m_liveBytes;
+    if (garbage < compactionThreshold || garbage < m_liveBytes) {
+        return;
+    }
+
+    qCDebug(dcJsonRpcCache()) << "Compacting cache data file. Live:" << m_liveBytes << "Garbage:" << garbage;
+    QSaveFile newDataFile(m_dataFile.fileName());
+    if (!newDataFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        qCWarning(dcJsonRpcCache()) << "Cannot compact cache data file:" << newDataFile.errorString();
+        return;
+    }
+    QHash<QByteArray, Entry> newIndex;
+    qint64 offset = 0;
+    for (QHash<QByteArray, Entry>::const_iterator it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        Entry entry = it.value();
+        if (!m_dataFile.seek(entry.offset)) {
+            continue;
+        }
+        QByteArray blob = m_dataFile.read(entry.size);
+        if (blob.size() != entry.size || newDataFile.write(blob) != blob.size()) {
+            continue;
+        }
+        entry.offset = offset;
+        offset += entry.size;
+        newIndex.insert(it.key(), entry);
+    }
+    m_dataFile.close();
+    if (!newDataFile.commit()) {
+        qCWarning(dcJsonRpcCache()) << "Error compacting cache data file:" << newDataFile.errorString();
+        m_dataFile.open(QFile::ReadWrite);
+        return;
+    }
+    m_index = newIndex;
+    m_liveBytes = offset;
+    saveIndex();
+    m_dataFile.open(QFile::ReadWrite);
+}
+
+void JsonRpcResultStore::updateStatistics()
+{
+    emit statisticsChanged(m_dataFile.isOpen() ? m_dataFile.size() : 0, m_index.count());
+}
@@ -0,0 +1,104 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef JSONRPCRESULTSTORE_H
+#define JSONRPCRESULTSTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QFile>
+#include <QVariantMap>
+#include <QStringList>
+
+/*
+ * On-disk part of the JsonRpcResultCache. Lives in the cache's worker thread and is only
+ * ever talked to through queued invocations.
+ *
+ * There is one store per server, consisting of two files in its directory:
+ *  - "data": result blobs, appended as they come in
+ *  - "index": key -> method, cache hash generation, offset and size of the blob in "data"
+ * Blobs of dropped entries stay in "data" until their share grows too large, at which point
+ * the data file is compacted. Once the live entries exceed the size limit, the least recently
+ * used ones are dropped. The index is written whenever a store is opened, so its modification
+ * time tells when the store was used last.
+ */
+class JsonRpcResultStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit JsonRpcResultStore(QObject *parent = nullptr);
+    ~JsonRpcResultStore() override;
+
+public slots:
+    // cacheHashes: method -> current hash. Entries of other generations are dropped.
+    void open(const QString &path, const QVariantMap &cacheHashes, bool compress);
+    void close();
+    void lookup(const QByteArray &key);
+    void store(const QByteArray &key, const QString &method, const QString &generation, const QByteArray &data);
+    void clear();
+    // Removes result files written by older app versions, one file per call, which were never cleaned up
+    void removeLegacyFiles(const QString &path);
+    // Removes the stores in path which haven't been opened for maxAge seconds
+    void removeStaleStores(const QString &path, qint64 maxAge);
+
+signals:
+    // Emitted once a store has been opened, with the keys of all entries in it
+    void keysLoaded(const QList<QByteArray> &keys);
+    void lookupFinished(const QByteArray &key, const QByteArray &data, bool found);
+    void statisticsChanged(qint64 diskBytes, int entries);
+
+private:
+    struct Entry {
+        QString method;
+        QString generation;
+        qint64 offset = 0;
+        int size = 0;
+        bool compressed = false;
+        // Seconds since epoch
+        qint64 lastUsed = 0;
+    };
+
+    bool loadIndex();
+    bool saveIndex();
+    void evictIfNeeded();
+    void compactIfNeeded();
+    void updateStatistics();
+
+    QString m_path;
+    bool m_compress = true;
+    QFile m_dataFile;
+    QHash<QByteArray, Entry> m_index;
+    qint64 m_liveBytes = 0;
+    // Only usage times changed since the index was last written
+    bool m_indexDirty = false;
+};
+
+#endif // JSONRPCRESULTSTORE_H
@@ -32,6 +32,8 @@
 #define LIBNYMEAAPPCORE_H
 
 #include "engine.h"
+#include "startupscheduler.h"
+#include "jsonrpc/jsonrpcresultcache.h"
 #include "connection/nymeahosts.h"
 #include "connection/nymeahost.h"
 #include "connection/discovery/nymeadiscovery.h"
@@ -179,7 +181,9 @@ void registerQmlTypes() {
     qmlRegisterType<LogMessages>("Nymea", 1, 0, "LogMessages");
 
     qmlRegisterUncreatableType<ThingManager>(uri, 1, 0, "ThingManager", "Can't create this in QML. Get it from the Engine.");
+    qmlRegisterUncreatableType<StartupScheduler>(uri, 1, 0, "StartupScheduler", "Can't create this in QML. Get it from the Engine.");
     qmlRegisterUncreatableType<JsonRpcClient>(uri, 1, 0, "JsonRpcClient", "Can't create this in QML. Get it from the Engine.");
+    qmlRegisterUncreatableType<JsonRpcResultCache>(uri, 1, 0, "JsonRpcResultCache", "Can't create this in QML. Get it from the JsonRpcClient.");
     qmlRegisterUncreatableType<NymeaConnection>(uri, 1, 0, "NymeaConnection", "Can't create this in QML. Get it from the Engine.");
 
     // libnymea-common
@@ -23,6 +23,7 @@ SOURCES += \
     $$PWD/appdata.cpp \
     $$PWD/connection/networkreachabilitymonitor.cpp \
     $$PWD/energy/energylogs.cpp \
+    $$PWD/energy/energylogseries.cpp \
     $$PWD/energy/energymanager.cpp \
     $$PWD/energy/powerbalancelogs.cpp \
     $$PWD/energy/thingpowerlogs.cpp \
@@ -41,6 +42,7 @@ SOURCES += \
     $$PWD/zwave/zwavenode.cpp \
     $${PWD}/logging.cpp \
     $${PWD}/applogcontroller.cpp \
+    $${PWD}/applogwriter.cpp \
     $${PWD}/wifisetup/btwifisetup.cpp \
     $$PWD/modbus/modbusrtumanager.cpp \
     $$PWD/modbus/modbusrtumaster.cpp \
@@ -50,13 +52,16 @@ SOURCES += \
     $$PWD/types/serialportsproxy.cpp \
     $${PWD}/configuration/networkmanager.cpp \
     $${PWD}/engine.cpp \
+    $${PWD}/enginesnapshot.cpp \
     $${PWD}/models/barseriesadapter.cpp \
     $${PWD}/models/sortfilterproxymodel.cpp \
     $${PWD}/models/xyseriesadapter.cpp \
+    $${PWD}/models/xyserieslod.cpp \
     $${PWD}/ruletemplates/calendaritemtemplate.cpp \
     $${PWD}/ruletemplates/timedescriptortemplate.cpp \
     $${PWD}/ruletemplates/timeeventitemtemplate.cpp \
     $${PWD}/scripting/scriptautosaver.cpp \
+    $${PWD}/scripting/scriptoutline.cpp \
     $${PWD}/types/browseritem.cpp \
     $${PWD}/types/browseritems.cpp \
     $${PWD}/types/networkdevice.cpp \
@@ -133,6 +138,10 @@ SOURCES += \
     $${PWD}/connection/discovery/bluetoothservicediscovery.cpp \
     $${PWD}/thingmanager.cpp \
     $${PWD}/jsonrpc/jsonrpcclient.cpp \
+    $${PWD}/jsonrpc/jsonrpccodec.cpp \
+    $${PWD}/jsonrpc/jsonrpcframer.cpp \
+    $${PWD}/jsonrpc/jsonrpcresultcache.cpp \
+    $${PWD}/jsonrpc/jsonrpcresultstore.cpp \
     $${PWD}/things.cpp \
     $${PWD}/thingsproxy.cpp \
     $${PWD}/thingclasses.cpp \
@@ -144,6 +153,7 @@ SOURCES += \
     $${PWD}/scripting/completionmodel.cpp \
     $${PWD}/scriptmanager.cpp \
     $${PWD}/scriptsyntaxhighlighter.cpp \
+    $${PWD}/startupscheduler.cpp \
     $${PWD}/usermanager.cpp \
     $${PWD}/vendorsproxy.cpp \
     $${PWD}/pluginsproxy.cpp \
@@ -163,6 +173,8 @@ SOURCES += \
     $${PWD}/models/wirelessaccesspointsproxy.cpp \
     $${PWD}/ruletemplates/ruletemplate.cpp \
     $${PWD}/ruletemplates/ruletemplates.cpp \
+    $${PWD}/ruletemplates/ruletemplatecatalogue.cpp \
+    $${PWD}/ruletemplates/ruletemplatecatalogue_data.cpp \
     $${PWD}/ruletemplates/eventdescriptortemplate.cpp \
     $${PWD}/ruletemplates/ruleactiontemplate.cpp \
     $${PWD}/ruletemplates/stateevaluatortemplate.cpp \
@@ -189,6 +201,7 @@ HEADERS += \
     $$PWD/appdata.h \
     $$PWD/connection/networkreachabilitymonitor.h \
     $$PWD/energy/energylogs.h \
+    $$PWD/energy/energylogseries.h \
     $$PWD/energy/energymanager.h \
     $$PWD/energy/powerbalancelogs.h \
     $$PWD/energy/thingpowerlogs.h \
@@ -207,6 +220,7 @@ HEADERS += \
     $$PWD/zwave/zwavenode.h \
     $${PWD}/logging.h \
     $${PWD}/applogcontroller.h \
+    $${PWD}/applogwriter.h \
     $${PWD}/wifisetup/btwifisetup.h \
     $$PWD/modbus/modbusrtumanager.h \
     $$PWD/modbus/modbusrtumaster.h \
@@ -216,13 +230,16 @@ HEADERS += \
     $$PWD/types/serialportsproxy.h \
     $${PWD}/configuration/networkmanager.h \
     $${PWD}/engine.h \
+    $${PWD}/enginesnapshot.h \
     $${PWD}/models/barseriesadapter.h \
     $${PWD}/models/sortfilterproxymodel.h \
     $${PWD}/models/xyseriesadapter.h \
+    $${PWD}/models/xyserieslod.h \
     $${PWD}/ruletemplates/calendaritemtemplate.h \
     $${PWD}/ruletemplates/timedescriptortemplate.h \
     $${PWD}/ruletemplates/timeeventitemtemplate.h \
     $${PWD}/scripting/scriptautosaver.h \
+    $${PWD}/scripting/scriptoutline.h \
     $${PWD}/types/browseritem.h \
     $${PWD}/types/browseritems.h \
     $${PWD}/types/networkdevice.h \
@@ -299,6 +316,10 @@ HEADERS += \
     $${PWD}/connection/discovery/bluetoothservicediscovery.h \
     $${PWD}/thingmanager.h \
     $${PWD}/jsonrpc/jsonrpcclient.h \
+    $${PWD}/jsonrpc/jsonrpccodec.h \
+    $${PWD}/jsonrpc/jsonrpcframer.h \
+    $${PWD}/jsonrpc/jsonrpcresultcache.h \
+    $${PWD}/jsonrpc/jsonrpcresultstore.h \
     $${PWD}/things.h \
     $${PWD}/thingsproxy.h \
     $${PWD}/thingclasses.h \
@@ -310,6 +331,7 @@ HEADERS += \
     $${PWD}/scripting/completionmodel.h \
     $${PWD}/scriptmanager.h \
     $${PWD}/scriptsyntaxhighlighter.h \
+    $${PWD}/startupscheduler.h \
     $${PWD}/usermanager.h \
     $${PWD}/vendorsproxy.h \
     $${PWD}/pluginsproxy.h \
@@ -330,6 +352,7 @@ HEADERS += \
     $${PWD}/models/wirelessaccesspointsproxy.h \
     $${PWD}/ruletemplates/ruletemplate.h \
     $${PWD}/ruletemplates/ruletemplates.h \
+    $${PWD}/ruletemplates/ruletemplatecatalogue.h \
     $${PWD}/ruletemplates/eventdescriptortemplate.h \
     $${PWD}/ruletemplates/ruleactiontemplate.h \
     $${PWD}/ruletemplates/stateevaluatortemplate.h \
@@ -1,6 +1,252 @@
 #include "logging.h"
 
+#include <QJsonArray>
+#include <QUuid>
+
+#include <atomic>
+
 QStringList& nymeaLoggingCategories() {
     static QStringList _nymeaLoggingCategories;
     return _nymeaLoggingCategories;
 }
+
+static std::atomic<quint64> s_payloads(0);
+static std::atomic<quint64> s_truncatedPayloads(0);
+static std::atomic<quint64> s_bytes(0);
+
+// Compact JSON writer which gives up as soon as maxSize is reached
+class PayloadWriter
+{
+public:
+    explicit PayloadWriter(int maxSize): m_maxSize(maxSize) {}
+
+    bool write(const QVariant &value);
+    bool write(const QJsonValue &value);
+
+    QByteArray result;
+    bool truncated = false;
+
+private:
+    bool append(const QByteArray &data);
+    bool writeString(const QString &string);
+
+    int m_maxSize;
+};
+
+bool PayloadWriter::append(const QByteArray &data)
+{
+    if (result.size() + data.size() > m_maxSize) {
+        result.append(data.left(m_maxSize - result.size()));
+        truncated = true;
+        return false;
+    }
+    result.append(data);
+    return true;
+}
+
+bool PayloadWriter::writeString(const QString &string)
+{
+    QByteArray escaped;
+    escaped.reserve(string.size() + 2);
+    escaped.append('"');
+    foreach (char c, string.toUtf8()) {
+        switch (c) {
+        case '"':
+            escaped.append("\\\"");
+            break;
+        case '\\':
+            escaped.append("\\\\");
+            break;
+        case '\n':
+            escaped.append("\\n");
+            break;
+        case '\r':
+            escaped.append("\\r");
+            break;
+        case '\t':
+            escaped.append("\\t");
+            break;
+        default:
+            if (static_cast<uchar>(c) < 0x20) {
+                escaped.append(QByteArray("\\u00") + QByteArray::number(static_cast<uchar>(c), 16).rightJustified(2, '0'));
+            } else {
+                escaped.append(c);
+            }
+        }
+    }
+    escaped.append('"');
+    return append(escaped);
+}
+
+bool PayloadWriter::write(const QVariant &value)
+{
+    switch (static_cast<QMetaType::Type>(value.type())) {
+    case QMetaType::UnknownType:
+        return append("null");
+    case QMetaType::Bool:
+        return append(value.toBool() ? "true" : "false");
+    case QMetaType::Int:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+        return append(QByteArray::number(value.toLongLong()));
+    case QMetaType::UInt:
+    case QMetaType::ULong:
+    case QMetaType::ULongLong:
+        return append(QByteArray::number(value.toULongLong()));
+    case QMetaType::Float:
+    case QMetaType::Double:
+        return append(QByteArray::number(value.toDouble(), 'g', QLocale::FloatingPointShortest));
+    case QMetaType::QVariantMap: {
+        const QVariantMap map = value.toMap();
+        if (!append("{")) {
+            return false;
+        }
+        for (QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it) {
+            if ((it != map.constBegin() && !append(",")) || !writeString(it.key()) || !append(":") || !write(it.value())) {
+                return false;
+            }
+        }
+        return append("}");
+    }
+    case QMetaType::QVariantHash: {
+        const QVariantHash hash = value.toHash();
+        if (!append("{")) {
+            return false;
+        }
+        for (QVariantHash::const_iterator it = hash.constBegin(); it != hash.constEnd(); ++it) {
+            if ((it != hash.constBegin() && !append(",")) || !writeString(it.key()) || !append(":") || !write(it.value())) {
+                return false;
+            }
+        }
+        return append("}");
+    }
+    case QMetaType::QVariantList:
+    case QMetaType::QStringList: {
+        const QVariantList list = value.toList();
+        if (!append("[")) {
+            return false;
+        }
+        for (int i = 0; i < list.count(); i++) {
+            if ((i > 0 && !append(",")) || !write(list.at(i))) {
+                return false;
+            }
+        }
+        return append("]");
+    }
+    case QMetaType::QJsonValue:
+        return write(value.toJsonValue());
+    case QMetaType::QJsonObject:
+        return write(QJsonValue(value.toJsonObject()));
+    case QMetaType::QJsonArray:
+        return write(QJsonValue(value.toJsonArray()));
+    case QMetaType::QUuid:
+        // Like QJsonValue::fromVariant(), without braces
+        return writeString(value.toUuid().toString().remove('{').remove('}'));
+    default:
+        return writeString(value.toString());
+    }
+}
+
+bool PayloadWriter::write(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Null:
+    case QJsonValue::Undefined:
+        return append("null");
+    case QJsonValue::Bool:
+        return append(value.toBool() ? "true" : "false");
+    case QJsonValue::Double:
+        return append(QByteArray::number(value.toDouble(), 'g', QLocale::FloatingPointShortest));
+    case QJsonValue::String:
+        return writeString(value.toString());
+    case QJsonValue::Array: {
+        const QJsonArray array = value.toArray();
+        if (!append("[")) {
+            return false;
+        }
+        for (int i = 0; i < array.count(); i++) {
+            if ((i > 0 && !append(",")) || !write(array.at(i))) {
+                return false;
+            }
+        }
+        return append("]");
+    }
+    case QJsonValue::Object: {
+        const QJsonObject object = value.toObject();
+        if (!append("{")) {
+            return false;
+        }
+        for (QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd(); ++it) {
+            if ((it != object.constBegin() && !append(",")) || !writeString(it.key()) || !append(":") || !write(it.value())) {
+                return false;
+            }
+        }
+        return append("}");
+    }
+    }
+    return append("null");
+}
+
+LogPayload::LogPayload(const QVariant &data, int maxSize):
+    m_variant(data),
+    m_maxSize(maxSize)
+{
+
+}
+
+LogPayload::LogPayload(const QJsonObject &data, int maxSize):
+    m_object(data),
+    m_isJson(true),
+    m_maxSize(maxSize)
+{
+
+}
+
+LogPayload::LogPayload(const QJsonDocument &data, int maxSize):
+    m_object(data.object()),
+    m_isJson(true),
+    m_maxSize(maxSize)
+{
+
+}
+
+QByteArray LogPayload::toJson() const
+{
+    PayloadWriter writer(m_maxSize);
+    if (m_isJson) {
+        writer.write(QJsonValue(m_object));
+    } else {
+        writer.write(m_variant);
+    }
+
+    s_payloads.fetch_add(1, std::memory_order_relaxed);
+    s_bytes.fetch_add(writer.result.size(), std::memory_order_relaxed);
+    if (writer.truncated) {
+        s_truncatedPayloads.fetch_add(1, std::memory_order_relaxed);
+        writer.result.append("... (truncated)");
+    }
+    return writer.result;
+}
+
+LogPayload::Statistics LogPayload::statistics()
+{
+    Statistics statistics;
+    statistics.payloads = s_payloads.load(std::memory_order_relaxed);
+    statistics.truncatedPayloads = s_truncatedPayloads.load(std::memory_order_relaxed);
+    statistics.bytes = s_bytes.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void LogPayload::resetStatistics()
+{
+    s_payloads.store(0, std::memory_order_relaxed);
+    s_truncatedPayloads.store(0, std::memory_order_relaxed);
+    s_bytes.store(0, std::memory_order_relaxed);
+}
+
+QDebug operator<<(QDebug debug, const LogPayload &payload)
+{
+    QDebugStateSaver saver(debug);
+    debug.noquote() << QString::fromUtf8(payload.toJson());
+    return debug;
+}
@@ -2,6 +2,10 @@
 #define LOGGING_H
 
 #include <QLoggingCategory>
+#include <QDebug>
+#include <QVariant>
+#include <QJsonObject>
+#include <QJsonDocument>
 
 QStringList& nymeaLoggingCategories();
 
@@ -16,5 +20,43 @@ QStringList& nymeaLoggingCategories();
         return s_##name; \
     } \
 
+/*
+ * A JSON payload to be streamed into a log message:
+ *
+ *   qCDebug(dcThingManager()) << "GetThingClasses response:" << LogPayload(params);
+ *
+ * The data is only shallow copied and gets serialised (compact) when streamed, that is,
+ * not at all if the category is disabled. Serialisation stops after maxSize bytes instead
+ * of writing out the whole document first, the output is marked as truncated then.
+ */
+class LogPayload
+{
+public:
+    enum { DefaultMaxSize = 8 * 1024 };
+
+    // Counts the serialisation work done for log messages, see resetStatistics()
+    struct Statistics {
+        quint64 payloads = 0;
+        quint64 truncatedPayloads = 0;
+        quint64 bytes = 0;
+    };
+
+    explicit LogPayload(const QVariant &data, int maxSize = DefaultMaxSize);
+    explicit LogPayload(const QJsonObject &data, int maxSize = DefaultMaxSize);
+    explicit LogPayload(const QJsonDocument &data, int maxSize = DefaultMaxSize);
+
+    QByteArray toJson() const;
+
+    static Statistics statistics();
+    static void resetStatistics();
+
+private:
+    QVariant m_variant;
+    QJsonObject m_object;
+    bool m_isJson = false;
+    int m_maxSize = DefaultMaxSize;
+};
+
+QDebug operator<<(QDebug debug, const LogPayload &payload);
 
 #endif // LOGGING_H
@@ -32,14 +32,16 @@
 
 #include "engine.h"
 
+#include <QJsonObject>
+
 LogManager::LogManager(JsonRpcClient *jsonClient, QObject *parent) :
     QObject(parent),
     m_client(jsonClient)
 {
-    m_client->registerNotificationHandler(this, "Logging", "notificationReceived");
+    m_client->registerNotificationCallback(this, "Logging.LogEntryAdded", &LogManager::logEntryAddedNotification);
 }
 
-void LogManager::notificationReceived(const QVariantMap &data)
+void LogManager::logEntryAddedNotification(const QJsonObject &params)
 {
-    emit logEntryReceived(data.value("params").toMap().value("logEntry").toMap());
+    emit logEntryReceived(params.value("logEntry").toObject().toVariantMap());
 }
@@ -34,6 +34,7 @@
 #include <QObject>
 
 class JsonRpcClient;
+class QJsonObject;
 
 class LogManager : public QObject
 {
@@ -45,7 +46,7 @@ signals:
     void logEntryReceived(const QVariantMap &data);
 
 private:
-    Q_INVOKABLE void notificationReceived(const QVariantMap &data);
+    void logEntryAddedNotification(const QJsonObject &params);
 
 private:
     JsonRpcClient *m_client = nullptr;
@@ -309,7 +309,7 @@ void LogsModel::logsReply(int /*commandId*/, const QVariantMap &data)
     int count = data.value("count").toInt();
 
     qCInfo(dcLogEngine()) << objectName() << "Logs reply:" << m_fetchStartTime.msecsTo(QDateTime::currentDateTime());
-    qCDebug(dcLogEngine()) << objectName() << qUtf8Printable(QJsonDocument::fromVariant(data).toJson());
+    qCDebug(dcLogEngine()) << objectName() << LogPayload(data);
 
     m_fetchStartTime = QDateTime::currentDateTime();
 
@@ -446,7 +446,7 @@ void LogsModel::fetchMore(const QModelIndex &parent)
     params.insert("offset", m_list.count() - m_generatedEntries);
 
     qCInfo(dcLogEngine()) << "Fetching logs from:" << m_list.count() - m_generatedEntries << "max" << m_blockSize;
-    qCCritical(dcLogEngine()) << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCCritical(dcLogEngine()) << LogPayload(params);
 
     m_engine->jsonRpcClient()->sendCommand("Logging.GetLogEntries", params, this, "logsReply");
     m_fetchStartTime = QDateTime::currentDateTime();
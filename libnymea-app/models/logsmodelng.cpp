@@ -32,18 +32,48 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QMetaEnum>
+#include <QJsonArray>
 #include <QJsonDocument>
 
+#include <algorithm>
+
 #include "engine.h"
 #include "types/logentry.h"
 #include "logmanager.h"
+#include "xyserieslod.h"
 
 #include "logging.h"
 Q_DECLARE_LOGGING_CATEGORY(dcLogEngine)
 
-LogsModelNg::LogsModelNg(QObject *parent) : QAbstractListModel(parent)
+// Enum keys are resolved through a table built once instead of QMetaEnum::keyToValue() for every entry
+template <typename T>
+static QHash<QString, int> buildEnumLookup()
+{
+    QHash<QString, int> lookup;
+    QMetaEnum metaEnum = QMetaEnum::fromType<T>();
+    for (int i = 0; i < metaEnum.keyCount(); i++) {
+        lookup.insert(QString::fromLatin1(metaEnum.key(i)), metaEnum.value(i));
+    }
+    return lookup;
+}
+
+static const QHash<QString, int> &loggingSourceLookup()
 {
+    static const QHash<QString, int> lookup = buildEnumLookup<LogEntry::LoggingSource>();
+    return lookup;
+}
+
+static const QHash<QString, int> &loggingEventTypeLookup()
+{
+    static const QHash<QString, int> lookup = buildEnumLookup<LogEntry::LoggingEventType>();
+    return lookup;
+}
 
+LogsModelNg::LogsModelNg(QObject *parent) : QAbstractListModel(parent)
+{
+    // Index 0 is reserved for "no id"/"no error code"
+    m_ids.append(QUuid());
+    m_errorCodes.append(QString());
 }
 
 Engine *LogsModelNg::engine() const
@@ -72,24 +102,32 @@ void LogsModelNg::setEngine(Engine *engine)
 int LogsModelNg::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_list.count();
+    return static_cast<int>(m_rows.size());
 }
 
 QVariant LogsModelNg::data(const QModelIndex &index, int role) const
 {
+    const LogRow &row = m_rows.at(index.row());
     switch (role) {
     case RoleTimestamp:
-        return m_list.at(index.row())->timestamp();
+        return QDateTime::fromMSecsSinceEpoch(row.timestamp);
     case RoleValue:
-        return m_list.at(index.row())->value();
+        return row.value;
     case RoleThingId:
-        return m_list.at(index.row())->thingId();
+        return m_ids.at(row.thingIdIndex);
     case RoleTypeId:
-        return m_list.at(index.row())->typeId();
+        return m_ids.at(row.typeIdIndex);
     case RoleSource:
-        return m_list.at(index.row())->source();
+        // Left undefined for QML rather than passing on a value no page knows about
+        if (row.source == LogEntry::LoggingSourceUnknown) {
+            return QVariant();
+        }
+        return static_cast<LogEntry::LoggingSource>(row.source);
     case RoleLoggingEventType:
-        return m_list.at(index.row())->loggingEventType();
+        if (row.loggingEventType == LogEntry::LoggingEventTypeUnknown) {
+            return QVariant();
+        }
+        return static_cast<LogEntry::LoggingEventType>(row.loggingEventType);
     }
     return QVariant();
 }
@@ -167,8 +205,7 @@ void LogsModelNg::setTypeIds(const QStringList &typeIds)
         m_typeIds = fixedTypeIds;
         emit typeIdsChanged();
         beginResetModel();
-        qDeleteAll(m_list);
-        m_list.clear();
+        clearRows();
         endResetModel();
         fetchMore();
     }
@@ -208,6 +245,8 @@ QtCharts::QXYSeries *LogsModelNg::graphSeries() const
 void LogsModelNg::setGraphSeries(QtCharts::QXYSeries *graphSeries)
 {
     m_graphSeries = graphSeries;
+    m_lod = XYSeriesLod::attach(graphSeries);
+    updateViewport();
 }
 
 QDateTime LogsModelNg::viewStartTime() const
@@ -220,7 +259,8 @@ void LogsModelNg::setViewStartTime(const QDateTime &viewStartTime)
     if (m_viewStartTime != viewStartTime) {
         m_viewStartTime = viewStartTime;
         emit viewStartTimeChanged();
-        if (m_list.count() == 0 || m_list.last()->timestamp() > m_viewStartTime) {
+        updateViewport();
+        if (m_rows.empty() || m_rows.back().timestamp > m_viewStartTime.toMSecsSinceEpoch()) {
             if (canFetchMore()) {
                 fetchMore();
             }
@@ -228,6 +268,34 @@ void LogsModelNg::setViewStartTime(const QDateTime &viewStartTime)
     }
 }
 
+QDateTime LogsModelNg::viewEndTime() const
+{
+    return m_viewEndTime;
+}
+
+void LogsModelNg::setViewEndTime(const QDateTime &viewEndTime)
+{
+    if (m_viewEndTime != viewEndTime) {
+        m_viewEndTime = viewEndTime;
+        emit viewEndTimeChanged();
+        updateViewport();
+    }
+}
+
+int LogsModelNg::viewWidth() const
+{
+    return m_viewWidth;
+}
+
+void LogsModelNg::setViewWidth(int viewWidth)
+{
+    if (m_viewWidth != viewWidth) {
+        m_viewWidth = viewWidth;
+        emit viewWidthChanged();
+        updateViewport();
+    }
+}
+
 QVariant LogsModelNg::minValue() const
 {
 
@@ -241,95 +309,40 @@ QVariant LogsModelNg::maxValue() const
 
 LogEntry *LogsModelNg::get(int index) const
 {
-    if (index >= 0 && index < m_list.count()) {
-        return m_list.at(index);
+    if (index >= 0 && index < rowCount()) {
+        return entryAt(index);
     }
     return nullptr;
 }
 
 LogEntry *LogsModelNg::findClosest(const QDateTime &dateTime) const
 {
-//    qWarning() << "********************Finding closest for:" << dateTime.toString();
-//    foreach (LogEntry *entry, m_list) {
-//        qWarning() << "List entry:" << entry->timestamp().toString();
-//    }
-    if (m_list.isEmpty()) {
-//        qWarning() << "No entries here...";
+    if (m_rows.empty()) {
         return nullptr;
     }
-    int newest = 0;
-    int oldest = m_list.count() - 1;
-    LogEntry *entry = nullptr;
-    int step = 0;
-
-    LogEntry *allTimeOldestEntry = m_list.at(oldest);
-    if (dateTime < allTimeOldestEntry->timestamp()) {
-//        qWarning() << "All time oldest is newer than searched";
+    // Rows are sorted newest first, find the newest entry which is not newer than dateTime
+    qint64 timestamp = dateTime.toMSecsSinceEpoch();
+    std::deque<LogRow>::const_iterator it = std::partition_point(m_rows.cbegin(), m_rows.cend(), [timestamp](const LogRow &row) {
+        return row.timestamp > timestamp;
+    });
+    if (it == m_rows.cend()) {
+        // All time oldest is newer than searched
         return nullptr;
     }
-//    qWarning() << "Oldest:" << oldest << "newest:" << newest << "step" << step << "count" << m_list.count();
-    while (oldest >= newest && step < m_list.count()) {
-        LogEntry *oldestEntry = m_list.at(oldest);
-        LogEntry *newestEntry = m_list.at(newest);
-        int middle = (oldest - newest) / 2 + newest;
-        LogEntry *middleEntry = m_list.at(middle);
-//        qWarning() << "Oldest:" << oldest << oldestEntry->timestamp().toString() << oldestEntry->value() << "Middle:" << middle << middleEntry->timestamp().toString() << middleEntry->value() << "Newest:" << newest << newestEntry->timestamp().toString() << newestEntry->value() << ":" << (oldest - newest);
-        if (dateTime <= oldestEntry->timestamp()) {
-//            qWarning() << "Returning oldest";
-            return oldestEntry;
-        }
-        if (dateTime >= newestEntry->timestamp()) {
-//            qWarning() << "Returning newest";
-            return newestEntry;
-        }
-
-        if (dateTime == middleEntry->timestamp()) {
-//            qWarning() << "Returning middle";
-            return middleEntry;
-        }
-
-        if (dateTime < middleEntry->timestamp()) {
-            newest = middle;
-        } else {
-            oldest = middle;
-        }
-
-        if (oldest - newest == 1) {
-            if (oldest > middle) {
-//                qWarning() << "EOL. Returning oldest";
-                return oldestEntry;
-            } else {
-//                qWarning() << "EOL. Returning middle";
-                return middleEntry;
-            }
-        }
-        step++;
-    }
-    return entry;
+    return entryAt(static_cast<int>(it - m_rows.cbegin()));
 }
 
-void LogsModelNg::logsReply(int commandId, const QVariantMap &data)
+void LogsModelNg::logsReply(int commandId, const QJsonObject &data)
 {
     Q_UNUSED(commandId)
     int offset = data.value("offset").toInt();
     int count = data.value("count").toInt();
 
-//    qDebug() << qUtf8Printable(QJsonDocument::fromVariant(data).toJson());
-
-    QList<LogEntry*> newBlock;
-    QList<QVariant> logEntries = data.value("logEntries").toList();
-    foreach (const QVariant &logEntryVariant, logEntries) {
-        QVariantMap entryMap = logEntryVariant.toMap();
-        QDateTime timeStamp = QDateTime::fromMSecsSinceEpoch(entryMap.value("timestamp").toLongLong());
-        QString thingId = entryMap.value("thingId").toString();
-        QString typeId = entryMap.value("typeId").toString();
-        QMetaEnum sourceEnum = QMetaEnum::fromType<LogEntry::LoggingSource>();
-        LogEntry::LoggingSource loggingSource = static_cast<LogEntry::LoggingSource>(sourceEnum.keyToValue(entryMap.value("source").toByteArray()));
-        QMetaEnum loggingEventTypeEnum = QMetaEnum::fromType<LogEntry::LoggingEventType>();
-        LogEntry::LoggingEventType loggingEventType = static_cast<LogEntry::LoggingEventType>(loggingEventTypeEnum.keyToValue(entryMap.value("eventType").toByteArray()));
-        QVariant value = loggingEventType == LogEntry::LoggingEventTypeActiveChange ? entryMap.value("active").toBool() : entryMap.value("value");
-        LogEntry *entry = new LogEntry(timeStamp, value, thingId, typeId, loggingSource, loggingEventType, entryMap.value("errorCode").toString(), this);
-        newBlock.append(entry);
+    QJsonArray logEntries = data.value("logEntries").toArray();
+    QVector<LogRow> newBlock;
+    newBlock.reserve(logEntries.count());
+    for (QJsonArray::const_iterator it = logEntries.constBegin(); it != logEntries.constEnd(); ++it) {
+        newBlock.append(decodeRow((*it).toObject()));
     }
 
     qDebug() << "Received logs from" << offset << "to" << offset + count << "Actual count:" << newBlock.count();
@@ -344,78 +357,79 @@ void LogsModelNg::logsReply(int commandId, const QVariantMap &data)
         return;
     }
 
+    offset = qBound(0, offset, rowCount());
     beginInsertRows(QModelIndex(), offset, offset + newBlock.count() - 1);
+    m_rows.insert(m_rows.begin() + offset, newBlock.constBegin(), newBlock.constEnd());
+
     QVariant newMin = m_minValue;
     QVariant newMax = m_maxValue;
-    for (int i = 0; i < newBlock.count(); i++) {
-        LogEntry *entry = newBlock.at(i);
-        m_list.insert(offset + i, entry);
-        Thing *thing = m_engine->thingManager()->things()->getThing(entry->thingId());
-        if (!thing) {
-            qWarning() << "Thing not found in system. Cannot add item to graph series.";
-            continue;
-        }
-
-        StateType *entryStateType = thing->thingClass()->stateTypes()->getStateType(entry->typeId());
+    // Things and state types are resolved once per block, not for every row
+    QHash<QPair<int, int>, StateType*> stateTypes;
+    // Graph points of this block, newest first like the rows. They go to the level of detail at once.
+    QVector<QPointF> blockPoints;
+    for (int i = 0; m_lod && i < newBlock.count(); i++) {
+        const LogRow &entry = newBlock.at(i);
+        StateType *entryStateType = resolveStateType(entry, &stateTypes);
         if (!entryStateType) {
-            qWarning() << "StateType" << entry->typeId() << "not found on thing" << thing->name();
             continue;
         }
 
-        if (m_graphSeries) {
-            if (entryStateType->type().toLower() == "bool") {
+        if (entryStateType->type().toLower() == "bool") {
 
-                // We don't want bools painting triangles, add a toggle point to keep lines straight
-                if (i > 0) {
-                    LogEntry *newerEntry = newBlock.at(i - 1);
-                    if (newerEntry->value().toBool() != entry->value().toBool()) {
-                        m_graphSeries->append(QPointF(newerEntry->timestamp().addMSecs(-1).toMSecsSinceEpoch(), entry->value().toBool() ? 1 : 0));
-                    }
+            // We don't want bools painting triangles, add a toggle point to keep lines straight
+            if (i > 0) {
+                const LogRow &newerEntry = newBlock.at(i - 1);
+                if (newerEntry.value.toBool() != entry.value.toBool()) {
+                    blockPoints.append(QPointF(newerEntry.timestamp - 1, entry.value.toBool() ? 1 : 0));
                 }
+            }
 
-                if (m_graphSeries->count() == 0) {
-                    // If it's the first one, make sure we add an ending point at 1
-                    m_graphSeries->append(QPointF(QDateTime::currentDateTime().addDays(1).toMSecsSinceEpoch(), 1));
-                    m_graphSeries->append(QPointF(QDateTime::currentDateTime().addDays(1).toMSecsSinceEpoch(), entry->value().toBool() ? 1 : 0));
-                } else if (i == 0) {
-                    // Adding a new batch...  remove the last appended 1 from the previous batch
-                    m_graphSeries->remove(m_graphSeries->count() - 1);
-                }
-                m_graphSeries->append(QPointF(entry->timestamp().toMSecsSinceEpoch(), entry->value().toBool() ? 1 : 0));
-                if (i == newBlock.count() - 1) {
-                    // End the batch at 1 again
-                    m_graphSeries->append(QPointF(entry->timestamp().addSecs(60).toMSecsSinceEpoch(), 1));
-                }
+            if (m_lod->isEmpty() && blockPoints.isEmpty()) {
+                // If it's the first one, make sure we add an ending point at 1
+                blockPoints.append(QPointF(QDateTime::currentDateTime().addDays(1).toMSecsSinceEpoch(), 1));
+                blockPoints.append(QPointF(QDateTime::currentDateTime().addDays(1).toMSecsSinceEpoch(), entry.value.toBool() ? 1 : 0));
+            } else if (i == 0) {
+                // Adding a new batch...  remove the closing 1 from the previous batch
+                m_lod->removeFirst();
+            }
+            blockPoints.append(QPointF(entry.timestamp, entry.value.toBool() ? 1 : 0));
+            if (i == newBlock.count() - 1) {
+                // End the batch at 1 again
+                blockPoints.append(QPointF(entry.timestamp - 1, 1));
+            }
 
-                // Adjust min/max
-                if (!newMin.isValid() || newMin > entry->value()) {
-                    newMin = 0;
-                }
-                if (!newMax.isValid() || newMax < entry->value()) {
-                    newMax = 1;
-                }
+            // Adjust min/max
+            if (!newMin.isValid() || newMin > entry.value) {
+                newMin = 0;
+            }
+            if (!newMax.isValid() || newMax < entry.value) {
+                newMax = 1;
+            }
 
-            } else {
+        } else {
 
-                // Add a point in the future to extend the graph (so it can scroll with time and the graph wouldn't end at the last known value)
-                if (m_graphSeries->count() == 0) {
-                    m_graphSeries->append(QPointF(QDateTime::currentDateTime().addDays(1).toMSecsSinceEpoch(), Types::instance()->toUiValue(entry->value(), entryStateType->unit()).toReal()));
-                }
+            // Add a point in the future to extend the graph (so it can scroll with time and the graph wouldn't end at the last known value)
+            if (m_lod->isEmpty() && blockPoints.isEmpty()) {
+                blockPoints.append(QPointF(QDateTime::currentDateTime().addDays(1).toMSecsSinceEpoch(), Types::instance()->toUiValue(entry.value, entryStateType->unit()).toReal()));
+            }
 
-                // Add the actual value
-                QVariant value = Types::instance()->toUiValue(entry->value(), entryStateType->unit());
-                m_graphSeries->append(QPointF(entry->timestamp().toMSecsSinceEpoch(), value.toReal()));
+            // Add the actual value
+            QVariant value = Types::instance()->toUiValue(entry.value, entryStateType->unit());
+            blockPoints.append(QPointF(entry.timestamp, value.toReal()));
 
-                // Adjust min/max
-                if (!newMin.isValid() || newMin > value) {
-                    newMin = value.toReal();
-                }
-                if (!newMax.isValid() || newMax < value) {
-                    newMax = value.toReal();
-                }
+            // Adjust min/max
+            if (!newMin.isValid() || newMin > value) {
+                newMin = value.toReal();
+            }
+            if (!newMax.isValid() || newMax < value) {
+                newMax = value.toReal();
             }
         }
     }
+    if (m_lod) {
+        std::reverse(blockPoints.begin(), blockPoints.end());
+        m_lod->prepend(blockPoints);
+    }
     endInsertRows();
     emit countChanged();
 
@@ -432,7 +446,7 @@ void LogsModelNg::logsReply(int commandId, const QVariantMap &data)
     m_busy = false;
     emit busyChanged();
 
-    if (m_viewStartTime.isValid() && m_list.count() > 0 && m_list.last()->timestamp() > m_viewStartTime && canFetchMore()) {
+    if (m_viewStartTime.isValid() && !m_rows.empty() && m_rows.back().timestamp > m_viewStartTime.toMSecsSinceEpoch() && canFetchMore()) {
         fetchMore();
     }
 }
@@ -483,11 +497,11 @@ void LogsModelNg::fetchMore(const QModelIndex &parent)
     }
 
     params.insert("limit", m_blockSize);
-    params.insert("offset", m_list.count());
+    params.insert("offset", rowCount());
 
-//    qDebug() << "Fetching logs:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+//    qDebug() << "Fetching logs:" << LogPayload(params);
 
-    m_engine->jsonRpcClient()->sendCommand("Logging.GetLogEntries", params, this, "logsReply");
+    m_engine->jsonRpcClient()->sendCommand("Logging.GetLogEntries", params, this, &LogsModelNg::logsReply);
 //    qDebug() << "GetLogEntries called";
 }
 
@@ -505,79 +519,71 @@ void LogsModelNg::newLogEntryReceived(const QVariantMap &data)
         return;
     }
 
-    QVariantMap entryMap = data;
-    QUuid thingId = entryMap.value("thingId").toUuid();
+    QUuid thingId = data.value("thingId").toUuid();
     if (!m_thingId.isNull() && thingId != m_thingId) {
         return;
     }
 
-    QUuid typeId = entryMap.value("typeId").toUuid();
+    QUuid typeId = data.value("typeId").toUuid();
     if (!m_typeIds.isEmpty() && !m_typeIds.contains(typeId)) {
         return;
     }
 
-    QDateTime timeStamp = QDateTime::fromMSecsSinceEpoch(entryMap.value("timestamp").toLongLong());
-    QMetaEnum sourceEnum = QMetaEnum::fromType<LogEntry::LoggingSource>();
-    LogEntry::LoggingSource loggingSource = static_cast<LogEntry::LoggingSource>(sourceEnum.keyToValue(entryMap.value("source").toByteArray()));
-    QMetaEnum loggingEventTypeEnum = QMetaEnum::fromType<LogEntry::LoggingEventType>();
-    LogEntry::LoggingEventType loggingEventType = static_cast<LogEntry::LoggingEventType>(loggingEventTypeEnum.keyToValue(entryMap.value("eventType").toByteArray()));
-    QVariant value = loggingEventType == LogEntry::LoggingEventTypeActiveChange ? entryMap.value("active").toBool() : entryMap.value("value");
-    LogEntry *entry = new LogEntry(timeStamp, value, thingId, typeId, loggingSource, loggingEventType, entryMap.value("errorCode").toString(), this);
+    LogRow entry = decodeRow(QJsonObject::fromVariantMap(data));
 
-    Thing *dev = m_engine->thingManager()->things()->getThing(entry->thingId());
+    Thing *dev = m_engine->thingManager()->things()->getThing(thingId);
     if (!dev) {
-        delete entry;
         qCWarning(dcLogEngine) << "Received a log entry for a thing we don't know. Discarding.";
         return;
     }
 
     beginInsertRows(QModelIndex(), 0, 0);
-    m_list.prepend(entry);
-    if (m_graphSeries) {
+    m_rows.push_front(entry);
+    StateType *entryStateType = dev->thingClass()->stateTypes()->getStateType(typeId);
+    if (m_lod && entryStateType) {
 
-        StateType *entryStateType = dev->thingClass()->stateTypes()->getStateType(entry->typeId());
-
-        if (dev && dev->thingClass()->stateTypes()->getStateType(entry->typeId())->type().toLower() == "bool") {
+        if (entryStateType->type().toLower() == "bool") {
             // First, remove the 2 rightmost (newest on the timeline) values. They're the ones in the future we added to extend the graph and making it end at 1
-            if (m_graphSeries->count() > 1) {
-                m_graphSeries->removePoints(0, 2);
+            if (m_lod->count() > 1) {
+                m_lod->removeLast(2);
             }
 
             // Prevent triangles, add a point right before the new one which reflects the old value (if there is one)
-            if (m_graphSeries->points().count() > 0) {
-                qreal previousValue = m_graphSeries->points().at(0).y();
-                m_graphSeries->insert(0, QPointF(entry->timestamp().addMSecs(-1).toMSecsSinceEpoch(), previousValue));
+            if (!m_lod->isEmpty()) {
+                qreal previousValue = m_lod->last().y();
+                m_lod->append(QPointF(entry.timestamp - 1, previousValue));
             }
 
             // Add the actual value
-            m_graphSeries->insert(0, QPointF(entry->timestamp().toMSecsSinceEpoch(), entry->value().toBool() ? 1 : 0));
+            m_lod->append(QPointF(entry.timestamp, entry.value.toBool() ? 1 : 0));
 
             // And add the 2 "future" points again
-            m_graphSeries->insert(0, QPointF(entry->timestamp().addDays(1).toMSecsSinceEpoch(), entry->value().toBool() ? 1 : 0));
-            m_graphSeries->insert(0, QPointF(entry->timestamp().addDays(1).toMSecsSinceEpoch(), 1));
+            qint64 future = QDateTime::fromMSecsSinceEpoch(entry.timestamp).addDays(1).toMSecsSinceEpoch();
+            m_lod->append(QPointF(future, entry.value.toBool() ? 1 : 0));
+            m_lod->append(QPointF(future, 1));
 
         } else {
 
             // First, remove the rightmost (newest on the timeline) value. It's the one in the future we added to extend the graph
-            if (m_graphSeries->count() > 1) {
-                m_graphSeries->removePoints(0, 1);
+            if (m_lod->count() > 1) {
+                m_lod->removeLast();
             }
 
             // Add the actual value
-            QVariant value = Types::instance()->toUiValue(entry->value(), entryStateType->unit());
-            m_graphSeries->insert(0, QPointF(entry->timestamp().toMSecsSinceEpoch(), value.toReal()));
+            QVariant value = Types::instance()->toUiValue(entry.value, entryStateType->unit());
+            m_lod->append(QPointF(entry.timestamp, value.toReal()));
 
             // And add the "future" point again
-            m_graphSeries->insert(0, QPointF(entry->timestamp().addDays(1).toMSecsSinceEpoch(), value.toReal()));
+            m_lod->append(QPointF(QDateTime::fromMSecsSinceEpoch(entry.timestamp).addDays(1).toMSecsSinceEpoch(), value.toReal()));
         }
 
 
-        if (m_minValue > entry->value().toReal()) {
-            m_minValue = entry->value().toReal();
+        if (m_minValue > entry.value.toReal()) {
+            m_minValue = entry.value.toReal();
             emit minValueChanged();
         }
-        if (m_maxValue < entry->value().toReal()) {
-            m_maxValue = entry->value().toReal();
+        if (m_maxValue < entry.value.toReal()) {
+            m_maxValue = entry.value.toReal();
             emit maxValueChanged();
         }
     }
@@ -586,4 +592,107 @@ void LogsModelNg::newLogEntryReceived(const QVariantMap &data)
 
 }
 
+void LogsModelNg::updateViewport()
+{
+    if (!m_lod) {
+        return;
+    }
+    if (m_viewStartTime.isValid() && m_viewEndTime.isValid()) {
+        m_lod->setViewport(m_viewStartTime.toMSecsSinceEpoch(), m_viewEndTime.toMSecsSinceEpoch());
+    } else {
+        m_lod->setViewport(0, 0);
+    }
+    if (m_viewWidth > 0) {
+        m_lod->setPixelWidth(m_viewWidth);
+    }
+}
+
+LogsModelNg::LogRow LogsModelNg::decodeRow(const QJsonObject &entryObject)
+{
+    LogRow row;
+    row.timestamp = static_cast<qint64>(entryObject.value("timestamp").toDouble());
+    row.thingIdIndex = internId(entryObject.value("thingId").toString());
+    row.typeIdIndex = internId(entryObject.value("typeId").toString());
+    row.source = static_cast<quint8>(loggingSourceLookup().value(entryObject.value("source").toString(), LogEntry::LoggingSourceUnknown));
+    int loggingEventType = loggingEventTypeLookup().value(entryObject.value("eventType").toString(), LogEntry::LoggingEventTypeUnknown);
+    row.loggingEventType = static_cast<quint8>(loggingEventType);
+    row.value = loggingEventType == LogEntry::LoggingEventTypeActiveChange ? QVariant(entryObject.value("active").toBool()) : entryObject.value("value").toVariant();
+    row.errorCodeIndex = internErrorCode(entryObject.value("errorCode").toString());
+    return row;
+}
+
+int LogsModelNg::internId(const QString &id)
+{
+    if (id.isEmpty()) {
+        return 0;
+    }
+    QHash<QString, int>::const_iterator it = m_idIndexes.constFind(id);
+    if (it != m_idIndexes.constEnd()) {
+        return it.value();
+    }
+    int index = m_ids.count();
+    m_ids.append(QUuid(id));
+    m_idIndexes.insert(id, index);
+    return index;
+}
+
+int LogsModelNg::internErrorCode(const QString &errorCode)
+{
+    if (errorCode.isEmpty()) {
+        return 0;
+    }
+    QHash<QString, int>::const_iterator it = m_errorCodeIndexes.constFind(errorCode);
+    if (it != m_errorCodeIndexes.constEnd()) {
+        return it.value();
+    }
+    int index = m_errorCodes.count();
+    m_errorCodes.append(errorCode);
+    m_errorCodeIndexes.insert(errorCode, index);
+    return index;
+}
 
+StateType *LogsModelNg::resolveStateType(const LogRow &row, QHash<QPair<int, int>, StateType*> *cache) const
+{
+    QPair<int, int> key(row.thingIdIndex, row.typeIdIndex);
+    QHash<QPair<int, int>, StateType*>::const_iterator it = cache->constFind(key);
+    if (it != cache->constEnd()) {
+        return it.value();
+    }
+
+    StateType *stateType = nullptr;
+    Thing *thing = m_engine->thingManager()->things()->getThing(m_ids.at(row.thingIdIndex));
+    if (!thing) {
+        qWarning() << "Thing not found in system. Cannot add item to graph series.";
+    } else {
+        stateType = thing->thingClass()->stateTypes()->getStateType(m_ids.at(row.typeIdIndex));
+        if (!stateType) {
+            qWarning() << "StateType" << m_ids.at(row.typeIdIndex) << "not found on thing" << thing->name();
+        }
+    }
+    cache->insert(key, stateType);
+    return stateType;
+}
+
+LogEntry *LogsModelNg::entryAt(int index) const
+{
+    const LogRow &row = m_rows.at(index);
+    if (!row.entry) {
+        row.entry = new LogEntry(QDateTime::fromMSecsSinceEpoch(row.timestamp),
+                                 row.value,
+                                 m_ids.at(row.thingIdIndex),
+                                 m_ids.at(row.typeIdIndex),
+                                 static_cast<LogEntry::LoggingSource>(row.source),
+                                 static_cast<LogEntry::LoggingEventType>(row.loggingEventType),
+                                 m_errorCodes.at(row.errorCodeIndex),
+                                 const_cast<LogsModelNg*>(this));
+    }
+    return row.entry;
+}
+
+void LogsModelNg::clearRows()
+{
+    for (const LogRow &row : m_rows) {
+        delete row.entry;
+    }
+    m_rows.clear();
+}
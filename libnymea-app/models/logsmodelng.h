@@ -37,9 +37,17 @@
 #include <QLineSeries>
 #include <QUuid>
 #include <QQmlParserStatus>
+#include <QJsonObject>
+#include <QVector>
+#include <QPointer>
+
+#include <deque>
+
+#include "xyserieslod.h"
 
 class LogEntry;
 class Engine;
+class StateType;
 
 class LogsModelNg : public QAbstractListModel, public QQmlParserStatus
 {
@@ -58,6 +66,9 @@ class LogsModelNg : public QAbstractListModel, public QQmlParserStatus
 
     Q_PROPERTY(QtCharts::QXYSeries *graphSeries READ graphSeries WRITE setGraphSeries NOTIFY graphSeriesChanged)
     Q_PROPERTY(QDateTime viewStartTime READ viewStartTime WRITE setViewStartTime NOTIFY viewStartTimeChanged)
+    Q_PROPERTY(QDateTime viewEndTime READ viewEndTime WRITE setViewEndTime NOTIFY viewEndTimeChanged)
+    // Width of the plot area in pixels, the graph series is reduced to about one bucket per pixel
+    Q_PROPERTY(int viewWidth READ viewWidth WRITE setViewWidth NOTIFY viewWidthChanged)
 
 public:
     enum Roles {
@@ -103,6 +114,12 @@ public:
     QDateTime viewStartTime() const;
     void setViewStartTime(const QDateTime &viewStartTime);
 
+    QDateTime viewEndTime() const;
+    void setViewEndTime(const QDateTime &viewEndTime);
+
+    int viewWidth() const;
+    void setViewWidth(int viewWidth);
+
     QVariant minValue() const;
     QVariant maxValue() const;
 
@@ -124,15 +141,43 @@ signals:
     void engineChanged();
     void graphSeriesChanged();
     void viewStartTimeChanged();
+    void viewEndTimeChanged();
+    void viewWidthChanged();
     void minValueChanged();
     void maxValueChanged();
 
 private slots:
     void newLogEntryReceived(const QVariantMap &data);
-    void logsReply(int commandId, const QVariantMap &data);
 
 private:
-    QList<LogEntry*> m_list;
+    // Compact, value typed storage for a log entry. Ids and error codes are interned, the
+    // LogEntry QObject is only created once someone asks for the row through get().
+    struct LogRow {
+        qint64 timestamp = 0; // msecs since epoch
+        QVariant value;
+        int thingIdIndex = 0;
+        int typeIdIndex = 0;
+        int errorCodeIndex = 0;
+        quint8 source = 0;
+        quint8 loggingEventType = 0;
+        mutable LogEntry *entry = nullptr;
+    };
+
+    void logsReply(int commandId, const QJsonObject &data);
+    LogRow decodeRow(const QJsonObject &entryObject);
+    int internId(const QString &id);
+    int internErrorCode(const QString &errorCode);
+    StateType *resolveStateType(const LogRow &row, QHash<QPair<int, int>, StateType*> *cache) const;
+    LogEntry *entryAt(int index) const;
+    void clearRows();
+    void updateViewport();
+
+    // Newest first. Live entries go to the front, fetched blocks to the back, both in constant time.
+    std::deque<LogRow> m_rows;
+    QVector<QUuid> m_ids;
+    QHash<QString, int> m_idIndexes;
+    QStringList m_errorCodes;
+    QHash<QString, int> m_errorCodeIndexes;
 
     Engine *m_engine = nullptr;
     bool m_busy = false;
@@ -144,11 +189,14 @@ private:
     int m_blockSize = 1000;
     bool m_canFetchMore = true;
     QDateTime m_viewStartTime;
+    QDateTime m_viewEndTime;
+    int m_viewWidth = 0;
     QVariant m_minValue;
     QVariant m_maxValue;
     bool m_ready = false;
 
     QtCharts::QXYSeries *m_graphSeries = nullptr;
+    QPointer<XYSeriesLod> m_lod;
 
     QList<QPair<QDateTime, bool> > m_fetchedPeriods;
 };
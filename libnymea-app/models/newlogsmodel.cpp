@@ -389,7 +389,7 @@ void NewLogsModel::fetchLogs()
     QMetaEnum sortOrderEnum = QMetaEnum::fromType<Qt::SortOrder>();
     params.insert("sortOrder", sortOrderEnum.valueToKey(m_sortOrder));
 
-    qCDebug(dcLogEngine()) << "Fetching logs:" << QJsonDocument::fromVariant(params).toJson();
+    qCDebug(dcLogEngine()) << "Fetching logs:" << LogPayload(params);
     m_engine->jsonRpcClient()->sendCommand("Logging.GetLogEntries", params, this, "logsReply");
 
     m_busy = true;
@@ -2,6 +2,8 @@
 
 #include <QDebug>
 
+#include <cmath>
+
 #include <QLoggingCategory>
 Q_DECLARE_LOGGING_CATEGORY(dcLogEngine)
 
@@ -36,6 +38,9 @@ void XYSeriesAdapter::setXySeries(QtCharts::QXYSeries *series)
         m_series = series;
         emit xySeriesChanged();
 
+        m_lod = XYSeriesLod::attach(series);
+        updateViewport();
+
         ensureSamples(QDateTime::currentDateTime(), QDateTime::currentDateTime().addMSecs(2 * 60000));
     }
 }
@@ -48,41 +53,18 @@ QtCharts::QXYSeries *XYSeriesAdapter::baseSeries() const
 void XYSeriesAdapter::setBaseSeries(QtCharts::QXYSeries *series)
 {
     if (m_baseSeries != series) {
+        if (m_baseLod) {
+            disconnect(m_baseLod, &XYSeriesLod::dataChanged, this, &XYSeriesAdapter::baseDataChanged);
+        }
+
         m_baseSeries = series;
         emit baseSeriesChanged();
 
-        connect(m_baseSeries, &QtCharts::QXYSeries::pointAdded, this, [=](int index){
-            if (m_series->count() > index) {
-                qreal value = calculateSampleValue(index);
-                m_series->replace(index, m_series->at(index).x(), value);
-                if (value < m_minValue) {
-                    m_minValue = value;
-//                    qDebug() << "New min:" << m_minValue;
-                    emit minValueChanged();
-                }
-                if (value > m_maxValue) {
-                    m_maxValue = value;
-//                    qDebug() << "New max:" << m_maxValue;
-                    emit maxValueChanged();
-                }
-            }
-        });
-        connect(m_baseSeries, &QtCharts::QXYSeries::pointReplaced, this, [=](int index){
-            if (m_series->count() > index) {
-                qreal value = calculateSampleValue(index);
-                m_series->replace(index, m_series->at(index).x(), value);
-                if (value < m_minValue) {
-                    m_minValue = value;
-//                    qDebug() << "New min:" << m_minValue;
-                    emit minValueChanged();
-                }
-                if (value > m_maxValue) {
-                    m_maxValue = value;
-//                    qDebug() << "New max:" << m_maxValue;
-                    emit maxValueChanged();
-                }
-            }
-        });
+        // Stack on the full resolution data of the base, its series only holds what's visible
+        m_baseLod = XYSeriesLod::attach(series);
+        if (m_baseLod) {
+            connect(m_baseLod, &XYSeriesLod::dataChanged, this, &XYSeriesAdapter::baseDataChanged);
+        }
     }
 }
 
@@ -135,115 +117,149 @@ qreal XYSeriesAdapter::minValue() const
     return m_minValue;
 }
 
+QDateTime XYSeriesAdapter::viewStartTime() const
+{
+    return m_viewStartTime;
+}
+
+void XYSeriesAdapter::setViewStartTime(const QDateTime &viewStartTime)
+{
+    if (m_viewStartTime != viewStartTime) {
+        m_viewStartTime = viewStartTime;
+        emit viewStartTimeChanged();
+        updateViewport();
+    }
+}
+
+QDateTime XYSeriesAdapter::viewEndTime() const
+{
+    return m_viewEndTime;
+}
+
+void XYSeriesAdapter::setViewEndTime(const QDateTime &viewEndTime)
+{
+    if (m_viewEndTime != viewEndTime) {
+        m_viewEndTime = viewEndTime;
+        emit viewEndTimeChanged();
+        updateViewport();
+    }
+}
+
+int XYSeriesAdapter::viewWidth() const
+{
+    return m_viewWidth;
+}
+
+void XYSeriesAdapter::setViewWidth(int viewWidth)
+{
+    if (m_viewWidth != viewWidth) {
+        m_viewWidth = viewWidth;
+        emit viewWidthChanged();
+        updateViewport();
+    }
+}
+
 void XYSeriesAdapter::ensureSamples(const QDateTime &from, const QDateTime &to)
 {
-    if (!m_series) {
+    if (!m_lod) {
         return;
     }
 
-    if (m_samples.isEmpty()) {
-        Sample *sample = new Sample();
-        sample->timestamp = from.addSecs(m_sampleRate / 2);
-//        qWarning() << "Added first" << from << sample->timestamp;
-        m_newestSample = sample->timestamp;
-        m_oldestSample = m_newestSample;
-        m_samples.append(sample);
-        m_series->insert(0, QPointF(sample->timestamp.toMSecsSinceEpoch(), 0));
+    qint64 fromMSecs = from.toMSecsSinceEpoch();
+    qint64 toMSecs = to.toMSecsSinceEpoch();
+
+    if (m_samples.empty()) {
+        Sample sample;
+        sample.timestamp = from.addSecs(m_sampleRate / 2).toMSecsSinceEpoch();
+        m_samples.push_back(sample);
+        m_lod->append(QPointF(sample.timestamp, calculateSampleValue(0)));
     }
 
-    while (to > m_newestSample) {
-        Sample *sample = new Sample();
-        sample->timestamp = m_newestSample.addSecs(m_sampleRate);
-        Sample *oldNewest = m_samples.first();
-        if (oldNewest->entries.count() > 0) {
-            sample->startingPoint = oldNewest->entries.last();
-        } else if (oldNewest->startingPoint != nullptr) {
-            sample->startingPoint = oldNewest->startingPoint;
+    // Newer samples continue from the newest one
+    int oldCount = sampleCount();
+    while (toMSecs > m_samples.back().timestamp) {
+        Sample sample;
+        sample.timestamp = m_samples.back().timestamp + sampleMSecs();
+        m_samples.push_back(sample);
+        updateStartingPoint(sampleCount() - 1);
+    }
+    if (sampleCount() > oldCount) {
+        QVector<QPointF> points;
+        points.reserve(sampleCount() - oldCount);
+        for (int i = oldCount; i < sampleCount(); i++) {
+            points.append(QPointF(m_samples.at(i).timestamp, calculateSampleValue(i)));
         }
-        m_newestSample = sample->timestamp;
-        m_samples.prepend(sample);
-        m_series->insert(0, QPointF(sample->timestamp.toMSecsSinceEpoch(), m_series->at(0).y()));
+        m_lod->append(points);
     }
 
-    while (from < m_oldestSample.addSecs(-m_sampleRate)) {
-//        qWarning() << "Added one before" << from << m_oldestSample.addMSecs(-m_sampleRate) << m_oldestSample;
-        Sample *sample = new Sample();
-        sample->timestamp = m_oldestSample.addSecs(-m_sampleRate);
-        m_oldestSample = sample->timestamp;
-        m_samples.append(sample);
-        m_series->append(sample->timestamp.toMSecsSinceEpoch(), 0);
+    // Older samples are all added in one go
+    qint64 oldest = m_samples.front().timestamp;
+    int missing = 0;
+    while (fromMSecs < oldest - (missing + 1) * sampleMSecs()) {
+        missing++;
+    }
+    if (missing > 0) {
+        m_samples.insert(m_samples.begin(), missing, Sample());
+        QVector<QPointF> points;
+        points.reserve(missing);
+        for (int i = 0; i < missing; i++) {
+            m_samples[i].timestamp = oldest - (missing - i) * sampleMSecs();
+            points.append(QPointF(m_samples.at(i).timestamp, calculateSampleValue(i)));
+        }
+        m_lod->prepend(points);
     }
-//    qWarning() << "Ensuring samples:" << from.toString("yyyy-MM-dd hh:mm:ss") << to.toString("yyyy-MM-dd hh:mm:ss") << "Oldest:" << m_oldestSample.toString("yyyy-MM-dd hh:mm:ss") << "Newest:" << m_newestSample.toString("yyyy-MM-dd hh:mm:ss") ;
 }
 
 void XYSeriesAdapter::logEntryAdded(LogEntry *entry)
 {
-    if (!m_series) {
+    if (!m_lod) {
         return;
     }
 
     ensureSamples(entry->timestamp(), entry->timestamp());
 
-    int idx = entry->timestamp().secsTo(m_newestSample) / m_sampleRate;
-    if (idx > m_samples.count()) {
+    qint64 timestamp = entry->timestamp().toMSecsSinceEpoch();
+    int idx = sampleCount() - 1 - static_cast<int>((m_samples.back().timestamp - timestamp) / sampleMSecs());
+    if (idx < 0) {
         qCWarning(dcLogEngine) << objectName() << "Overflowing integer size for XYSeriesAdapter!";
         return;
     }
-//    qWarning() << objectName() << "Inserting sample at:" << idx << entry->timestamp().toString("yyyy-MM-dd hh:mm:ss");
-    Sample *sample = m_samples.at(idx);
-    LogEntry *oldLast = nullptr;
-    // In theory we'd need to insert sorted, but only the last one actually matters for subsequent samples
-    // For the current sample we're calculating the median anyways, so just append/prepend t be a bit faster
-    if (sample->entries.count() > 0 && sample->entries.last()->timestamp() < entry->timestamp()) {
-        oldLast = sample->entries.last();
-        sample->entries.append(entry);
-    } else {
-        sample->entries.prepend(entry);
-    }
-    LogEntry *newLast = sample->entries.last();
 
-    qreal value = calculateSampleValue(idx);
-    m_series->replace(idx, sample->timestamp.toMSecsSinceEpoch(), value);
-//    qWarning() << "sample value updated" << idx << sample->timestamp.toString("yyyy-MM-dd hh:mm:ss") << value;
-
-    if (value < m_minValue) {
-        m_minValue = value;
-//        qDebug() << "New min:" << m_minValue;
-        emit minValueChanged();
-    }
-    if (value > m_maxValue) {
-        m_maxValue = value;
-//        qDebug() << "New max:" << m_maxValue;
-        emit maxValueChanged();
+    Sample &sample = m_samples[idx];
+    double value = entry->value().toDouble();
+    sample.sum += value;
+    sample.min = sample.count == 0 ? value : qMin(sample.min, value);
+    sample.max = sample.count == 0 ? value : qMax(sample.max, value);
+    sample.count++;
+    // Only the newest entry matters for subsequent samples
+    bool lastChanged = sample.count == 1 || timestamp > sample.lastTimestamp;
+    if (lastChanged) {
+        sample.lastTimestamp = timestamp;
+        sample.lastValue = value;
     }
 
-    // check if we need to update more samples
-    for (int i = idx - 1; i >= 0; i--) {
-        Sample *nextSample = m_samples.at(i);
-        if (nextSample->startingPoint == oldLast) {
-            nextSample->startingPoint = newLast;
-            qreal value = calculateSampleValue(i);
-//            qWarning() << "Updating" << i << value;
-            m_series->replace(i, nextSample->timestamp.toMSecsSinceEpoch(), value);
-
-        } else {
-            break;
+    // Carry the new starting point over to the following samples. For the newest sample, which
+    // is the common case, there are none.
+    int last = idx;
+    if (lastChanged) {
+        while (last + 1 < sampleCount() && updateStartingPoint(last + 1)) {
+            last++;
+            if (m_samples.at(last).count > 0) {
+                break;
+            }
         }
     }
+
+    updateSamples(idx, last);
 }
 
-qreal XYSeriesAdapter::calculateSampleValue(int index)
+qreal XYSeriesAdapter::calculateSampleValue(int index) const
 {
-    Sample *sample = m_samples.at(index);
-    qreal value = 0;
-    int count = 0;
-    if (sample->startingPoint) {
-        value = sample->startingPoint->value().toDouble();
-        count++;
-    }
-
-    foreach (LogEntry *entry, sample->entries) {
-        value += entry->value().toDouble();
+    const Sample &sample = m_samples.at(index);
+    qreal value = sample.sum;
+    int count = sample.count;
+    if (sample.hasStartingPoint) {
+        value += sample.startingPointValue;
         count++;
     }
 
@@ -251,8 +267,8 @@ qreal XYSeriesAdapter::calculateSampleValue(int index)
         value /= count;
     }
 
-    if (m_baseSeries && m_baseSeries->count() > index) {
-        value += m_baseSeries->at(index).y();
+    if (m_baseLod && !m_baseLod->isEmpty()) {
+        value += m_baseLod->valueAt(sample.timestamp);
     }
 
     if (m_inverted) {
@@ -261,3 +277,82 @@ qreal XYSeriesAdapter::calculateSampleValue(int index)
 
     return value;
 }
+
+bool XYSeriesAdapter::updateStartingPoint(int index)
+{
+    const Sample &previous = m_samples.at(index - 1);
+    Sample &sample = m_samples[index];
+    bool hasStartingPoint = previous.count > 0 || previous.hasStartingPoint;
+    qint64 startingPointTimestamp = previous.count > 0 ? previous.lastTimestamp : previous.startingPointTimestamp;
+    double startingPointValue = previous.count > 0 ? previous.lastValue : previous.startingPointValue;
+    if (sample.hasStartingPoint == hasStartingPoint
+            && sample.startingPointTimestamp == startingPointTimestamp
+            && sample.startingPointValue == startingPointValue) {
+        return false;
+    }
+    sample.hasStartingPoint = hasStartingPoint;
+    sample.startingPointTimestamp = startingPointTimestamp;
+    sample.startingPointValue = startingPointValue;
+    return true;
+}
+
+void XYSeriesAdapter::updateSamples(int from, int to)
+{
+    QVector<QPointF> points;
+    points.reserve(to - from + 1);
+    for (int i = from; i <= to; i++) {
+        qreal value = calculateSampleValue(i);
+        points.append(QPointF(m_samples.at(i).timestamp, value));
+
+        if (value < m_minValue) {
+            m_minValue = value;
+            emit minValueChanged();
+        }
+        if (value > m_maxValue) {
+            m_maxValue = value;
+            emit maxValueChanged();
+        }
+    }
+    m_lod->replace(from, points);
+}
+
+void XYSeriesAdapter::baseDataChanged(qreal fromX, qreal toX)
+{
+    if (!m_lod || m_samples.empty()) {
+        return;
+    }
+    // Only the samples in the changed range need to be stacked again. Samples are stacked on
+    // the closest base point, so also look at the neighbours of the changed range.
+    qint64 oldest = m_samples.front().timestamp;
+    int first = qMax(0, static_cast<int>(std::floor((fromX - oldest) / sampleMSecs())) - 1);
+    int last = qMin(sampleCount() - 1, static_cast<int>(std::ceil((toX - oldest) / sampleMSecs())) + 1);
+    if (first > last) {
+        return;
+    }
+    updateSamples(first, last);
+}
+
+void XYSeriesAdapter::updateViewport()
+{
+    if (!m_lod) {
+        return;
+    }
+    if (m_viewStartTime.isValid() && m_viewEndTime.isValid()) {
+        m_lod->setViewport(m_viewStartTime.toMSecsSinceEpoch(), m_viewEndTime.toMSecsSinceEpoch());
+    } else {
+        m_lod->setViewport(0, 0);
+    }
+    if (m_viewWidth > 0) {
+        m_lod->setPixelWidth(m_viewWidth);
+    }
+}
+
+qint64 XYSeriesAdapter::sampleMSecs() const
+{
+    return static_cast<qint64>(m_sampleRate) * 1000;
+}
+
+int XYSeriesAdapter::sampleCount() const
+{
+    return static_cast<int>(m_samples.size());
+}
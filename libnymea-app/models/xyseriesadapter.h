@@ -2,10 +2,14 @@
 #define XYSERIESADAPTER_H
 
 #include "logsmodel.h"
+#include "xyserieslod.h"
 
 #include <QObject>
+#include <QPointer>
 #include <QXYSeries>
 
+#include <deque>
+
 class XYSeriesAdapter : public QObject
 {
     Q_OBJECT
@@ -20,6 +24,11 @@ class XYSeriesAdapter : public QObject
     Q_PROPERTY(qreal maxValue READ maxValue NOTIFY maxValueChanged)
     Q_PROPERTY(qreal minValue READ minValue NOTIFY minValueChanged)
 
+    Q_PROPERTY(QDateTime viewStartTime READ viewStartTime WRITE setViewStartTime NOTIFY viewStartTimeChanged)
+    Q_PROPERTY(QDateTime viewEndTime READ viewEndTime WRITE setViewEndTime NOTIFY viewEndTimeChanged)
+    // Width of the plot area in pixels, the series is reduced to about one bucket per pixel
+    Q_PROPERTY(int viewWidth READ viewWidth WRITE setViewWidth NOTIFY viewWidthChanged)
+
 public:
     enum SampleRate {
         SampleRateSecond = 1,
@@ -53,6 +62,15 @@ public:
     qreal maxValue() const;
     qreal minValue() const;
 
+    QDateTime viewStartTime() const;
+    void setViewStartTime(const QDateTime &viewStartTime);
+
+    QDateTime viewEndTime() const;
+    void setViewEndTime(const QDateTime &viewEndTime);
+
+    int viewWidth() const;
+    void setViewWidth(int viewWidth);
+
     Q_INVOKABLE void ensureSamples(const QDateTime &from, const QDateTime &to);
 
 signals:
@@ -64,33 +82,58 @@ signals:
     void invertedChanged();
     void maxValueChanged();
     void minValueChanged();
+    void viewStartTimeChanged();
+    void viewEndTimeChanged();
+    void viewWidthChanged();
 
 private slots:
     void logEntryAdded(LogEntry *entry);
 
 private:
-    qreal calculateSampleValue(int index);
+    // Running aggregate of all log entries in one sample, that is, from timestamp - sample rate to timestamp
+    struct Sample {
+        qint64 timestamp = 0; // msecs, where this sample *ends*
+        double sum = 0;
+        int count = 0;
+        double min = 0;
+        double max = 0;
+        // The newest entry in this sample, the starting point for the following samples
+        qint64 lastTimestamp = 0;
+        double lastValue = 0;
+        // The starting point for the sample. Normally the last entry of the previous sample
+        bool hasStartingPoint = false;
+        qint64 startingPointTimestamp = 0;
+        double startingPointValue = 0;
+    };
+
+    qreal calculateSampleValue(int index) const;
+    bool updateStartingPoint(int index);
+    // Pushes samples from..to to the series at once
+    void updateSamples(int from, int to);
+    void baseDataChanged(qreal fromX, qreal toX);
+    void updateViewport();
+    qint64 sampleMSecs() const;
+    int sampleCount() const;
 
 private:
-    class Sample {
-    public:
-        QDateTime timestamp; // The timestamp where this sample *ends*
-        QVector<LogEntry*> entries; // all log entries in this sample, that is, from timestamp - smaple size to timestamp
-        LogEntry *startingPoint = nullptr; // the starting point for the sample. Normally the last entry of the previous sample
-    };
     LogsModel* m_model = nullptr;
     QtCharts::QXYSeries* m_series = nullptr;
     QtCharts::QXYSeries* m_baseSeries = nullptr;
+    QPointer<XYSeriesLod> m_lod;
+    QPointer<XYSeriesLod> m_baseLod;
     SampleRate m_sampleRate = SampleRateSecond;
     bool m_smooth = true;
     bool m_inverted = false;
 
-    QVector<Sample*> m_samples;
-    QDateTime m_newestSample;
-    QDateTime m_oldestSample;
+    // Oldest first, like the points in the level of detail. Grows on both ends.
+    std::deque<Sample> m_samples;
 
     qreal m_maxValue = 0;
     qreal m_minValue = 0;
+
+    QDateTime m_viewStartTime;
+    QDateTime m_viewEndTime;
+    int m_viewWidth = 0;
 };
 
 #endif // XYSERIESADAPTER_H
@@ -0,0 +1,299 @@
+#include "xyserieslod.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+// Roughly one frame, all changes in between go to the series at once
+static const int updateInterval = 16;
+
+XYSeriesLod *XYSeriesLod::attach(QtCharts::QXYSeries *series)
+{
+    if (!series) {
+        return nullptr;
+    }
+    XYSeriesLod *lod = series->findChild<XYSeriesLod*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!lod) {
+        lod = new XYSeriesLod(series);
+    }
+    return lod;
+}
+
+XYSeriesLod::XYSeriesLod(QtCharts::QXYSeries *series):
+    QObject(series),
+    m_series(series)
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(updateInterval);
+    connect(&m_updateTimer, &QTimer::timeout, this, &XYSeriesLod::update);
+}
+
+QtCharts::QXYSeries *XYSeriesLod::series() const
+{
+    return m_series;
+}
+
+int XYSeriesLod::count() const
+{
+    return m_points.count();
+}
+
+bool XYSeriesLod::isEmpty() const
+{
+    return m_points.isEmpty();
+}
+
+const QPointF &XYSeriesLod::at(int index) const
+{
+    return m_points.at(index);
+}
+
+const QPointF &XYSeriesLod::first() const
+{
+    return m_points.first();
+}
+
+const QPointF &XYSeriesLod::last() const
+{
+    return m_points.last();
+}
+
+int XYSeriesLod::lowerBound(qreal x) const
+{
+    return std::lower_bound(m_points.constBegin(), m_points.constEnd(), x, [](const QPointF &point, qreal x) {
+        return point.x() < x;
+    }) - m_points.constBegin();
+}
+
+qreal XYSeriesLod::valueAt(qreal x, qreal defaultValue) const
+{
+    if (m_points.isEmpty()) {
+        return defaultValue;
+    }
+    int index = lowerBound(x);
+    if (index == m_points.count()) {
+        return m_points.last().y();
+    }
+    if (index > 0 && x - m_points.at(index - 1).x() < m_points.at(index).x() - x) {
+        return m_points.at(index - 1).y();
+    }
+    return m_points.at(index).y();
+}
+
+void XYSeriesLod::append(const QPointF &point)
+{
+    m_points.append(point);
+    invalidate(point.x(), point.x());
+}
+
+void XYSeriesLod::append(const QVector<QPointF> &points)
+{
+    if (points.isEmpty()) {
+        return;
+    }
+    m_points.append(points);
+    invalidate(points.first().x(), points.last().x());
+}
+
+void XYSeriesLod::prepend(const QPointF &point)
+{
+    m_points.prepend(point);
+    invalidate(point.x(), point.x());
+}
+
+void XYSeriesLod::prepend(const QVector<QPointF> &points)
+{
+    if (points.isEmpty()) {
+        return;
+    }
+    m_points.insert(0, points.count(), QPointF());
+    std::copy(points.constBegin(), points.constEnd(), m_points.begin());
+    invalidate(points.first().x(), points.last().x());
+}
+
+void XYSeriesLod::replace(int index, const QPointF &point)
+{
+    qreal oldX = m_points.at(index).x();
+    m_points[index] = point;
+    invalidate(qMin(oldX, point.x()), qMax(oldX, point.x()));
+}
+
+void XYSeriesLod::replace(int index, const QVector<QPointF> &points)
+{
+    if (points.isEmpty()) {
+        return;
+    }
+    qreal fromX = qMin(m_points.at(index).x(), points.first().x());
+    qreal toX = qMax(m_points.at(index + points.count() - 1).x(), points.last().x());
+    std::copy(points.constBegin(), points.constEnd(), m_points.begin() + index);
+    invalidate(fromX, toX);
+}
+
+void XYSeriesLod::removeFirst(int count)
+{
+    count = qMin(count, m_points.count());
+    if (count <= 0) {
+        return;
+    }
+    qreal fromX = m_points.first().x();
+    qreal toX = m_points.at(count - 1).x();
+    m_points.remove(0, count);
+    invalidate(fromX, toX);
+}
+
+void XYSeriesLod::removeLast(int count)
+{
+    count = qMin(count, m_points.count());
+    if (count <= 0) {
+        return;
+    }
+    qreal fromX = m_points.at(m_points.count() - count).x();
+    qreal toX = m_points.last().x();
+    m_points.remove(m_points.count() - count, count);
+    invalidate(fromX, toX);
+}
+
+void XYSeriesLod::clear()
+{
+    if (m_points.isEmpty()) {
+        return;
+    }
+    qreal fromX = m_points.first().x();
+    qreal toX = m_points.last().x();
+    m_points.clear();
+    m_buckets.clear();
+    invalidate(fromX, toX);
+}
+
+void XYSeriesLod::setViewport(qreal minX, qreal maxX)
+{
+    if (m_viewMinX != minX || m_viewMaxX != maxX) {
+        m_viewMinX = minX;
+        m_viewMaxX = maxX;
+        scheduleUpdate();
+    }
+}
+
+void XYSeriesLod::setPixelWidth(int pixelWidth)
+{
+    if (m_pixelWidth != pixelWidth) {
+        m_pixelWidth = pixelWidth;
+        scheduleUpdate();
+    }
+}
+
+void XYSeriesLod::invalidate(qreal fromX, qreal toX)
+{
+    if (m_bucketWidth > 0 && !m_buckets.isEmpty()) {
+        qint64 fromBucket = static_cast<qint64>(std::floor(fromX / m_bucketWidth));
+        qint64 toBucket = static_cast<qint64>(std::floor(toX / m_bucketWidth));
+        if (toBucket - fromBucket > m_buckets.count()) {
+            QMutableHashIterator<qint64, QVector<QPointF>> it(m_buckets);
+            while (it.hasNext()) {
+                it.next();
+                if (it.key() >= fromBucket && it.key() <= toBucket) {
+                    it.remove();
+                }
+            }
+        } else {
+            for (qint64 bucket = fromBucket; bucket <= toBucket; bucket++) {
+                m_buckets.remove(bucket);
+            }
+        }
+    }
+    emit dataChanged(fromX, toX);
+    scheduleUpdate();
+}
+
+void XYSeriesLod::scheduleUpdate()
+{
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void XYSeriesLod::update()
+{
+    if (!m_series) {
+        return;
+    }
+
+    QVector<QPointF> visiblePoints;
+    if (m_points.isEmpty()) {
+        m_series->replace(visiblePoints);
+        return;
+    }
+
+    qreal minX = m_viewMinX;
+    qreal maxX = m_viewMaxX;
+    if (maxX <= minX) {
+        minX = m_points.first().x();
+        maxX = m_points.last().x();
+    }
+
+    // Round the bucket width up to the next power of two, so panning keeps the level
+    qreal pixelWidth = (maxX - minX) / qMax(m_pixelWidth, 1);
+    qreal bucketWidth = qPow(2, qCeil(std::log2(qMax(pixelWidth, qreal(1)))));
+    if (bucketWidth != m_bucketWidth || m_buckets.count() > 8 * qMax(m_pixelWidth, 1)) {
+        m_bucketWidth = bucketWidth;
+        m_buckets.clear();
+    }
+
+    qint64 bucket = static_cast<qint64>(std::floor(minX / bucketWidth));
+    int index = lowerBound(bucket * bucketWidth);
+    // Keep the line going to the left edge of the viewport
+    if (index > 0) {
+        visiblePoints.append(m_points.at(index - 1));
+    }
+    while (index < m_points.count() && m_points.at(index).x() <= maxX) {
+        bucket = static_cast<qint64>(std::floor(m_points.at(index).x() / bucketWidth));
+        int end = lowerBound((bucket + 1) * bucketWidth);
+        QHash<qint64, QVector<QPointF>>::const_iterator it = m_buckets.constFind(bucket);
+        if (it == m_buckets.constEnd()) {
+            QVector<QPointF> reduced;
+            reduceBucket(index, end, &reduced);
+            it = m_buckets.insert(bucket, reduced);
+        }
+        visiblePoints.append(it.value());
+        index = end;
+    }
+    // ...and to the right edge
+    if (index < m_points.count()) {
+        visiblePoints.append(m_points.at(index));
+    }
+
+    m_series->replace(visiblePoints);
+}
+
+void XYSeriesLod::reduceBucket(int from, int to, QVector<QPointF> *result) const
+{
+    if (to - from <= 4) {
+        for (int i = from; i < to; i++) {
+            result->append(m_points.at(i));
+        }
+        return;
+    }
+
+    int minIndex = from;
+    int maxIndex = from;
+    for (int i = from + 1; i < to; i++) {
+        if (m_points.at(i).y() < m_points.at(minIndex).y()) {
+            minIndex = i;
+        }
+        if (m_points.at(i).y() > m_points.at(maxIndex).y()) {
+            maxIndex = i;
+        }
+    }
+
+    // First, min and max in their original order, last
+    QVector<int> indices;
+    indices << from << qMin(minIndex, maxIndex) << qMax(minIndex, maxIndex) << to - 1;
+    int previous = -1;
+    foreach (int i, indices) {
+        if (i != previous) {
+            result->append(m_points.at(i));
+            previous = i;
+        }
+    }
+}
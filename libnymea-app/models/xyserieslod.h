@@ -0,0 +1,84 @@
+#ifndef XYSERIESLOD_H
+#define XYSERIESLOD_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <QXYSeries>
+
+/*
+ * Level of detail for a QXYSeries. Keeps the full resolution points off-chart and feeds the
+ * series only with what can be seen: the points in the viewport are grouped in buckets about
+ * one pixel wide and each bucket is reduced to its first, min, max and last point.
+ *
+ * Bucket widths are powers of two (in x units), so panning reuses the buckets already reduced
+ * and zooming only starts over when crossing a level. Changes are collected and pushed to the
+ * series with a single replace() per frame.
+ *
+ * The instance is attached to the series (as a child object) so that whoever stacks on top of
+ * a series can get to its full resolution data too.
+ */
+class XYSeriesLod : public QObject
+{
+    Q_OBJECT
+public:
+    // Returns the level of detail attached to series, creating it if needed
+    static XYSeriesLod *attach(QtCharts::QXYSeries *series);
+
+    QtCharts::QXYSeries *series() const;
+
+    // Full resolution data, ascending in x
+    int count() const;
+    bool isEmpty() const;
+    const QPointF &at(int index) const;
+    const QPointF &first() const;
+    const QPointF &last() const;
+    // Returns the index of the first point with x not less than the given x, count() if there is none
+    int lowerBound(qreal x) const;
+    // Returns the y of the point closest to x, or defaultValue if there is no point
+    qreal valueAt(qreal x, qreal defaultValue = 0) const;
+
+    void append(const QPointF &point);
+    void append(const QVector<QPointF> &points);
+    void prepend(const QPointF &point);
+    void prepend(const QVector<QPointF> &points);
+    void replace(int index, const QPointF &point);
+    // Replaces points.count() points starting at index, emitting dataChanged() only once
+    void replace(int index, const QVector<QPointF> &points);
+    void removeFirst(int count = 1);
+    void removeLast(int count = 1);
+    void clear();
+
+    // An empty viewport (maxX <= minX) shows all data
+    void setViewport(qreal minX, qreal maxX);
+    void setPixelWidth(int pixelWidth);
+
+signals:
+    // Full resolution data between fromX and toX changed
+    void dataChanged(qreal fromX, qreal toX);
+
+private:
+    explicit XYSeriesLod(QtCharts::QXYSeries *series);
+
+    void invalidate(qreal fromX, qreal toX);
+    void scheduleUpdate();
+    void update();
+    void reduceBucket(int from, int to, QVector<QPointF> *result) const;
+
+    QPointer<QtCharts::QXYSeries> m_series;
+    QVector<QPointF> m_points;
+
+    qreal m_viewMinX = 0;
+    qreal m_viewMaxX = 0;
+    int m_pixelWidth = 1000;
+
+    // Reduced points per bucket index for the current bucket width
+    qreal m_bucketWidth = 0;
+    QHash<qint64, QVector<QPointF>> m_buckets;
+
+    QTimer m_updateTimer;
+};
+
+#endif // XYSERIESLOD_H
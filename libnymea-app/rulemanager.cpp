@@ -53,32 +53,106 @@ NYMEA_LOGGING_CATEGORY(dcRuleManager, "RuleManager")
 
 #include <QMetaEnum>
 #include <QJsonDocument>
+#include <QJsonObject>
+
+static QByteArray ruleData(QVariantMap ruleMap)
+{
+    ruleMap.remove("active");
+    return QJsonDocument::fromVariant(ruleMap).toJson(QJsonDocument::Compact);
+}
 
 RuleManager::RuleManager(JsonRpcClient* jsonClient, QObject *parent) :
     QObject(parent),
     m_jsonClient(jsonClient),
     m_rules(new Rules(this))
 {
-    m_jsonClient->registerNotificationHandler(this, "Rules", "handleRulesNotification");
+    m_jsonClient->registerNotificationCallback(this, "Rules.RuleAdded", &RuleManager::ruleAddedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Rules.RuleRemoved", &RuleManager::ruleRemovedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Rules.RuleConfigurationChanged", &RuleManager::ruleConfigurationChangedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Rules.RuleActiveChanged", &RuleManager::ruleActiveChangedNotification);
 }
 
 void RuleManager::clear()
 {
+    m_reconciling = false;
+    m_ruleData.clear();
+    m_snapshotRuleIds.clear();
+    // Replies still in flight are not ours anymore once their commandId is forgotten
+    m_ruleDetailsQueue.clear();
+    m_ruleDetailsInFlight.clear();
+    if (m_fetchingData) {
+        m_fetchingData = false;
+        emit fetchingDataChanged();
+    }
     m_rules->clear();
 }
 
 void RuleManager::init()
 {
-    m_fetchingData = true;
-    emit fetchingDataChanged();
+    if (!m_reconciling) {
+        m_fetchingData = true;
+        emit fetchingDataChanged();
+    }
     m_jsonClient->sendCommand("Rules.GetRules", this, "getRulesResponse");
 }
 
+void RuleManager::loadSnapshot(const QList<QByteArray> &rules, const QSet<QUuid> &activeRules)
+{
+    foreach (const QByteArray &data, rules) {
+        QVariantMap ruleMap = QJsonDocument::fromJson(data).object().toVariantMap();
+        QUuid ruleId = ruleMap.value("id").toUuid();
+        if (ruleId.isNull()) {
+            continue;
+        }
+        ruleMap.insert("active", activeRules.contains(ruleId));
+        m_ruleData.insert(ruleId, data);
+        m_snapshotRuleIds.insert(ruleId);
+        m_rules->insert(parseRule(ruleMap));
+    }
+    m_reconciling = true;
+}
+
+QList<QByteArray> RuleManager::snapshotRules() const
+{
+    QList<QByteArray> ret;
+    for (int i = 0; i < m_rules->rowCount(); i++) {
+        Rule *rule = m_rules->get(i);
+        if (!m_ruleData.contains(rule->id())) {
+            // Details not fetched yet
+            continue;
+        }
+        ret.append(m_ruleData.value(rule->id()));
+    }
+    return ret;
+}
+
+QSet<QUuid> RuleManager::snapshotActiveRules() const
+{
+    QSet<QUuid> ret;
+    for (int i = 0; i < m_rules->rowCount(); i++) {
+        Rule *rule = m_rules->get(i);
+        if (rule->active()) {
+            ret.insert(rule->id());
+        }
+    }
+    return ret;
+}
+
 bool RuleManager::fetchingData() const
 {
     return m_fetchingData;
 }
 
+int RuleManager::ruleDetailsWindowSize() const
+{
+    return m_ruleDetailsWindowSize;
+}
+
+void RuleManager::setRuleDetailsWindowSize(int ruleDetailsWindowSize)
+{
+    m_ruleDetailsWindowSize = qMax(0, ruleDetailsWindowSize);
+}
+
 Rules *RuleManager::rules() const
 {
     return m_rules;
@@ -122,88 +196,171 @@ int RuleManager::executeActions(const QString &ruleId)
     return m_jsonClient->sendCommand("Rules.ExecuteActions", params, this, "executeRuleActionsResponse");
 }
 
-void RuleManager::handleRulesNotification(const QVariantMap &params)
+void RuleManager::ruleAddedNotification(const QJsonObject &params)
 {
-    qCDebug(dcRuleManager) << "Rules notification received:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
-    if (params.value("notification").toString() == "Rules.RuleAdded") {
-        QVariantMap ruleMap = params.value("params").toMap().value("rule").toMap();
-        Rule *rule = parseRule(ruleMap);
-        qCDebug(dcRuleManager) << "Rule added:" << rule;
-        m_rules->insert(rule);
-    } else if (params.value("notification").toString() == "Rules.RuleRemoved") {
-        QUuid ruleId = params.value("params").toMap().value("ruleId").toUuid();
-        m_rules->remove(ruleId);
-    } else if (params.value("notification").toString() == "Rules.RuleConfigurationChanged") {
-        QVariantMap ruleMap = params.value("params").toMap().value("rule").toMap();
-        QUuid ruleId = ruleMap.value("id").toUuid();
-        Rule *rule = m_rules->getRule(ruleId);
-        if (!rule) {
-            qCWarning(dcRuleManager) << "Got a rule update notification for a rule we don't know" << ruleId;
-            return;
-        }
-        m_rules->remove(ruleId);
-        Rule *newRule = parseRule(ruleMap);
-        m_rules->insert(newRule);
-        qCDebug(dcRuleManager) << "Rule changed:" << newRule;
-    } else if (params.value("notification").toString() == "Rules.RuleActiveChanged") {
-        Rule *rule = m_rules->getRule(params.value("params").toMap().value("ruleId").toUuid());
-        if (!rule) {
-            qCWarning(dcRuleManager) << "Got a rule active notification for a rule we don't know";
-            return;
-        }
-        rule->setActive(params.value("params").toMap().value("active").toBool());
-    } else {
-        qCWarning(dcRuleManager) << "Unhandled rule notification" << params;
+    QVariantMap ruleMap = params.value("rule").toObject().toVariantMap();
+    Rule *rule = parseRule(ruleMap);
+    qCDebug(dcRuleManager) << "Rule added:" << rule;
+    m_ruleData.insert(rule->id(), ruleData(ruleMap));
+    m_rules->insert(rule);
+}
+
+void RuleManager::ruleRemovedNotification(const QJsonObject &params)
+{
+    QUuid ruleId = QUuid(params.value("ruleId").toString());
+    m_ruleData.remove(ruleId);
+    m_rules->remove(ruleId);
+}
+
+void RuleManager::ruleConfigurationChangedNotification(const QJsonObject &params)
+{
+    QVariantMap ruleMap = params.value("rule").toObject().toVariantMap();
+    QUuid ruleId = ruleMap.value("id").toUuid();
+    Rule *rule = m_rules->getRule(ruleId);
+    if (!rule) {
+        qCWarning(dcRuleManager) << "Got a rule update notification for a rule we don't know" << ruleId;
+        return;
     }
+    m_rules->remove(ruleId);
+    Rule *newRule = parseRule(ruleMap);
+    m_ruleData.insert(ruleId, ruleData(ruleMap));
+    m_rules->insert(newRule);
+    qCDebug(dcRuleManager) << "Rule changed:" << newRule;
+}
+
+void RuleManager::ruleActiveChangedNotification(const QJsonObject &params)
+{
+    Rule *rule = m_rules->getRule(QUuid(params.value("ruleId").toString()));
+    if (!rule) {
+        qCWarning(dcRuleManager) << "Got a rule active notification for a rule we don't know";
+        return;
+    }
+    rule->setActive(params.value("active").toBool());
 }
 
 void RuleManager::getRulesResponse(int /*commandId*/, const QVariantMap &params)
 {
     //    qDebug() << "Get Rules reply" << params;
+    if (JsonRpcClient::isTimeout(params)) {
+        // Keep whatever the snapshot provided and ask again
+        qCWarning(dcRuleManager()) << "Fetching rules timed out. Retrying.";
+        m_jsonClient->sendCommand("Rules.GetRules", this, "getRulesResponse");
+        return;
+    }
+    if (!params.contains("ruleDescriptions")) {
+        qCWarning(dcRuleManager()) << "Fetching rules failed:" << LogPayload(params);
+        m_reconciling = false;
+        m_fetchingData = false;
+        emit fetchingDataChanged();
+        return;
+    }
+
+    QSet<QUuid> liveRuleIds;
     foreach (const QVariant &ruleDescriptionVariant, params.value("ruleDescriptions").toList()) {
         QUuid ruleId = ruleDescriptionVariant.toMap().value("id").toUuid();
         QString name = ruleDescriptionVariant.toMap().value("name").toString();
         bool enabled = ruleDescriptionVariant.toMap().value("enabled").toBool();
         bool active = ruleDescriptionVariant.toMap().value("active").toBool();
         bool executable = ruleDescriptionVariant.toMap().value("executable").toBool();
+        liveRuleIds.insert(ruleId);
 
-        Rule *rule = new Rule(ruleId, m_rules);
+        // When reconciling a snapshot, keep the existing rule and compare the details once they arrive
+        Rule *rule = m_reconciling ? m_rules->getRule(ruleId) : nullptr;
+        if (!rule) {
+            rule = new Rule(ruleId, m_rules);
+            m_rules->insert(rule);
+        }
         rule->setName(name);
         rule->setEnabled(enabled);
         rule->setActive(active);
         rule->setExecutable(executable);
-        m_rules->insert(rule);
 
-        QVariantMap requestParams;
-        requestParams.insert("ruleId", rule->id());
-        m_jsonClient->sendCommand("Rules.GetRuleDetails", requestParams, this, "getRuleDetailsResponse");
+        m_ruleDetailsQueue.append(ruleId);
     }
-    m_fetchingData = false;
-    emit fetchingDataChanged();
+
+    if (m_reconciling) {
+        foreach (const QUuid &ruleId, m_snapshotRuleIds) {
+            if (!liveRuleIds.contains(ruleId)) {
+                m_ruleData.remove(ruleId);
+                m_snapshotRuleIds.remove(ruleId);
+                m_rules->remove(ruleId);
+            }
+        }
+        m_reconciling = false;
+    }
+
+    // fetchingData goes down once all the details are in
+    fetchNextRuleDetails();
 }
 
 void RuleManager::getRuleDetailsResponse(int commandId, const QVariantMap &params)
 {
-    Q_UNUSED(commandId)
-    QVariantMap ruleMap = params.value("rule").toMap();
+    if (!m_ruleDetailsInFlight.contains(commandId)) {
+        // Sent before the last clear()
+        return;
+    }
+    QUuid ruleId = m_ruleDetailsInFlight.take(commandId);
+    if (JsonRpcClient::isTimeout(params) || !params.contains("rule")) {
+        // Don't hold up the others. The rule keeps whatever details it had so far.
+        qCWarning(dcRuleManager()) << "Fetching details for rule" << ruleId << "failed:" << LogPayload(params);
+    } else {
+        updateRuleDetails(params.value("rule").toMap());
+    }
+    fetchNextRuleDetails();
+}
+
+void RuleManager::fetchNextRuleDetails()
+{
+    // The server doesn't offer a bulk call for rule details. Keep a window of requests in flight
+    // instead of flooding the connection with one request per rule at once.
+    while (!m_ruleDetailsQueue.isEmpty() && (m_ruleDetailsWindowSize == 0 || m_ruleDetailsInFlight.count() < m_ruleDetailsWindowSize)) {
+        QUuid ruleId = m_ruleDetailsQueue.takeFirst();
+        QVariantMap requestParams;
+        requestParams.insert("ruleId", ruleId);
+        int commandId = m_jsonClient->sendCommand("Rules.GetRuleDetails", requestParams, this, "getRuleDetailsResponse");
+        m_ruleDetailsInFlight.insert(commandId, ruleId);
+    }
+
+    if (m_fetchingData && m_ruleDetailsQueue.isEmpty() && m_ruleDetailsInFlight.isEmpty()) {
+        m_fetchingData = false;
+        emit fetchingDataChanged();
+    }
+}
+
+void RuleManager::updateRuleDetails(const QVariantMap &ruleMap)
+{
     Rule* rule = m_rules->getRule(ruleMap.value("id").toUuid());
     if (!rule) {
         qCWarning(dcRuleManager) << "Got rule details for a rule we don't know";
         return;
     }
-    parseEventDescriptors(ruleMap.value("eventDescriptors").toList(), rule);
-    parseRuleActions(ruleMap.value("actions").toList(), rule);
-    parseRuleExitActions(ruleMap.value("exitActions").toList(), rule);
-    parseTimeDescriptor(ruleMap.value("timeDescriptor").toMap(), rule);
-    rule->setStateEvaluator(parseStateEvaluator(ruleMap.value("stateEvaluator").toMap()));
-    qCDebug(dcRuleManager()) << "Rule details received:" << rule;
-    //    qDebug() << "Rule JSON:" << qUtf8Printable(QJsonDocument::fromVariant(ruleMap).toJson());
+
+    QByteArray data = ruleData(ruleMap);
+    if (m_snapshotRuleIds.remove(rule->id())) {
+        // The active flag is already up to date from the rule description
+        bool unchanged = m_ruleData.value(rule->id()) == data;
+        m_ruleData.insert(rule->id(), data);
+        if (unchanged) {
+            return;
+        }
+        qCDebug(dcRuleManager()) << "Rule" << rule->name() << "changed since snapshot";
+        m_rules->remove(rule->id());
+        m_rules->insert(parseRule(ruleMap));
+        return;
+    }
+
+    // Only the compact form is kept, parsing into the object tree happens on demand
+    m_ruleData.insert(rule->id(), data);
+    rule->setLazyDetails([this](Rule *rule) {
+        parseRuleDetails(rule);
+    });
+    //    qDebug() << "Rule JSON:" << LogPayload(ruleMap);
 }
 
 void RuleManager::addRuleResponse(int commandId, const QVariantMap &params)
 {
     if (params.value("ruleError").toString() != "RuleErrorNoError") {
-        qCWarning(dcRuleManager) << "Failed to add rule:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+        qCWarning(dcRuleManager) << "Failed to add rule:" << LogPayload(params);
     } else {
         qCDebug(dcRuleManager) << "Rule added successfully. Rule ID:" << params.value("ruleId").toString();
     }
@@ -247,12 +404,21 @@ Rule *RuleManager::parseRule(const QVariantMap &ruleMap)
     rule->setEnabled(enabled);
     rule->setActive(active);
     rule->setExecutable(executable);
+    rule->setLazyDetails([this](Rule *rule) {
+        parseRuleDetails(rule);
+    });
+    return rule;
+}
+
+void RuleManager::parseRuleDetails(Rule *rule)
+{
+    QVariantMap ruleMap = QJsonDocument::fromJson(m_ruleData.value(rule->id())).object().toVariantMap();
     parseEventDescriptors(ruleMap.value("eventDescriptors").toList(), rule);
     parseRuleActions(ruleMap.value("actions").toList(), rule);
     parseRuleExitActions(ruleMap.value("exitActions").toList(), rule);
     parseTimeDescriptor(ruleMap.value("timeDescriptor").toMap(), rule);
     rule->setStateEvaluator(parseStateEvaluator(ruleMap.value("stateEvaluator").toMap()));
-    return rule;
+    qCDebug(dcRuleManager()) << "Rule details parsed:" << rule;
 }
 
 void RuleManager::parseEventDescriptors(const QVariantList &eventDescriptorList, Rule *rule)
@@ -279,7 +445,7 @@ void RuleManager::parseEventDescriptors(const QVariantList &eventDescriptorList,
 
 StateEvaluator *RuleManager::parseStateEvaluator(const QVariantMap &stateEvaluatorMap)
 {
-    qDebug() << "Parsing state evaluator:" << qUtf8Printable(QJsonDocument::fromVariant(stateEvaluatorMap).toJson());
+    qDebug() << "Parsing state evaluator:" << LogPayload(stateEvaluatorMap);
     if (!stateEvaluatorMap.contains("stateDescriptor")) {
         return nullptr;
     }
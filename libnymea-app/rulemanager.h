@@ -32,10 +32,15 @@
 #define RULEMANAGER_H
 
 #include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QUuid>
+#include <QVariantMap>
 
 #include "types/rules.h"
 
 class JsonRpcClient;
+class QJsonObject;
 class EventDescriptors;
 class TimeDescriptor;
 class TimeEventItem;
@@ -85,6 +90,16 @@ public:
     void init();
     bool fetchingData() const;
 
+    // See ThingManager::loadSnapshot(). Rules are compact JSON without their active flag,
+    // which changes independently of the rest of the rule.
+    void loadSnapshot(const QList<QByteArray> &rules, const QSet<QUuid> &activeRules);
+    QList<QByteArray> snapshotRules() const;
+    QSet<QUuid> snapshotActiveRules() const;
+
+    // Max number of Rules.GetRuleDetails requests in flight at once, 0 for no limit
+    int ruleDetailsWindowSize() const;
+    void setRuleDetailsWindowSize(int ruleDetailsWindowSize);
+
     Rules* rules() const;
 
     Q_INVOKABLE Rule* createNewRule();
@@ -102,7 +117,6 @@ signals:
     void fetchingDataChanged();
 
 private slots:
-    void handleRulesNotification(const QVariantMap &params);
     void getRulesResponse(int commandId, const QVariantMap &params);
     void getRuleDetailsResponse(int commandId, const QVariantMap &params);
     void addRuleResponse(int commandId, const QVariantMap &params);
@@ -111,7 +125,16 @@ private slots:
     void executeRuleActionsResponse(int commandId, const QVariantMap &params);
 
 private:
+    void ruleAddedNotification(const QJsonObject &params);
+    void ruleRemovedNotification(const QJsonObject &params);
+    void ruleConfigurationChangedNotification(const QJsonObject &params);
+    void ruleActiveChangedNotification(const QJsonObject &params);
+
+    void fetchNextRuleDetails();
+    void updateRuleDetails(const QVariantMap &ruleMap);
+
     Rule *parseRule(const QVariantMap &ruleMap);
+    void parseRuleDetails(Rule *rule);
     void parseEventDescriptors(const QVariantList &eventDescriptorList, Rule *rule);
     StateEvaluator* parseStateEvaluator(const QVariantMap &stateEvaluatorMap);
     void parseRuleActions(const QVariantList &ruleActions, Rule *rule);
@@ -132,6 +155,16 @@ private:
     JsonRpcClient *m_jsonClient;
     Rules* m_rules;
     bool m_fetchingData = false;
+    bool m_reconciling = false;
+    // Rule details as received in compact JSON, without the active flag. Kept for snapshots
+    // and reconciliation and decoded again once a rule's details are accessed.
+    QHash<QUuid, QByteArray> m_ruleData;
+    QSet<QUuid> m_snapshotRuleIds;
+
+    int m_ruleDetailsWindowSize = 10;
+    QList<QUuid> m_ruleDetailsQueue;
+    // commandId => ruleId of GetRuleDetails requests in flight
+    QHash<int, QUuid> m_ruleDetailsInFlight;
 };
 
 #endif // RULEMANAGER_H
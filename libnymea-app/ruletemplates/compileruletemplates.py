@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+
+# Compiles the rule template json files into the static table of RuleTemplateCatalogue.
+# The output is checked in as ruletemplatecatalogue_data.cpp, regenerate it with
+# "make ruletemplates", see nymea-app.pro
+#
+# Usage: compileruletemplates.py <output.cpp> <templates.json>...
+
+import json
+import os
+import sys
+
+
+def c_string(text):
+    ret = '"'
+    for byte in text.encode('utf-8'):
+        char = chr(byte)
+        if char in '"\\?':
+            ret += '\\' + char
+        elif 0x20 <= byte < 0x7f:
+            ret += char
+        else:
+            ret += '\\%03o' % byte
+    return ret + '"'
+
+
+def unique(items):
+    ret = []
+    for item in items:
+        if item not in ret:
+            ret.append(item)
+    return ret
+
+
+# The same as StateEvaluatorTemplate::interfaces()
+def state_interfaces(evaluator):
+    ret = [evaluator.get('stateDescriptorTemplate', {}).get('interfaceName', '')]
+    for child in evaluator.get('childEvaluatorTemplates', []):
+        ret += state_interfaces(child.get('stateEvaluatorTemplate', {}))
+    return unique(ret)
+
+
+def state_names(evaluator):
+    ret = [evaluator.get('stateDescriptorTemplate', {}).get('interfaceState', '')]
+    for child in evaluator.get('childEvaluatorTemplates', []):
+        ret += state_names(child.get('stateEvaluatorTemplate', {}))
+    return ret
+
+
+# The same as RuleTemplate::interfaces()
+def interfaces(template):
+    ret = unique([event.get('interfaceName', '') for event in template.get('eventDescriptorTemplates', [])])
+    if 'stateEvaluatorTemplate' in template:
+        ret += state_interfaces(template['stateEvaluatorTemplate'])
+    ret += unique([action.get('interfaceName', '') for action in template.get('ruleActionTemplates', [])])
+    ret += unique([action.get('interfaceName', '') for action in template.get('ruleExitActionTemplates', [])])
+    return ret
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('Usage: %s <output.cpp> <templates.json>...' % sys.argv[0])
+
+    lists = []
+    entries = []
+    # In the order RuleTemplates used to load the resources in
+    for path in sorted(sys.argv[2:], key=os.path.basename):
+        fileName = os.path.basename(path).split('.')[0]
+        try:
+            with open(path, encoding='utf-8') as f:
+                templates = json.load(f)['templates']
+        except (OSError, ValueError, KeyError) as error:
+            sys.exit('%s: Error reading rule templates: %s' % (path, error))
+
+        for template in templates:
+            index = len(entries)
+
+            def add_list(name, items):
+                lists.append('const char *const t%d_%s[] = { %s };' % (index, name, ', '.join([c_string(item) for item in items] + ['nullptr'])))
+                return 't%d_%s' % (index, name)
+
+            stateNames = state_names(template['stateEvaluatorTemplate']) if 'stateEvaluatorTemplate' in template else []
+            actionNames = [action.get('interfaceAction', '') for action in template.get('ruleActionTemplates', []) + template.get('ruleExitActionTemplates', [])]
+            fields = [
+                c_string(fileName),
+                c_string(template.get('description', '')),
+                c_string(template.get('ruleNameTemplate', '')),
+                c_string(template.get('interfaceName', '')),
+                add_list('interfaces', interfaces(template)),
+                add_list('eventNames', [event.get('interfaceEvent', '') for event in template.get('eventDescriptorTemplates', [])]),
+                add_list('stateNames', stateNames),
+                add_list('actionNames', actionNames),
+                c_string(json.dumps(template, ensure_ascii=False, separators=(',', ':')))
+            ]
+            entries.append('    {\n        ' + ',\n        '.join(fields) + '\n    }')
+
+    if not entries:
+        sys.exit('No rule templates found')
+
+    with open(sys.argv[1], 'w', encoding='utf-8') as out:
+        out.write('// This file is generated by compileruletemplates.py from the rule template json files.\n')
+        out.write('// Don\'t edit it, run "make ruletemplates" after changing the templates instead.\n\n')
+        out.write('#include "ruletemplates/ruletemplatecatalogue.h"\n\n')
+        out.write('namespace {\n\n')
+        out.write('\n'.join(lists))
+        out.write('\n\n}\n\n')
+        out.write('const RuleTemplateCatalogue::Entry RuleTemplateCatalogue::s_entries[] = {\n')
+        out.write(',\n'.join(entries))
+        out.write('\n};\n\n')
+        out.write('const int RuleTemplateCatalogue::s_count = %d;\n' % len(entries))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,266 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ruletemplatecatalogue.h"
+
+#include "ruletemplate.h"
+#include "eventdescriptortemplate.h"
+#include "timedescriptortemplate.h"
+#include "calendaritemtemplate.h"
+#include "timeeventitemtemplate.h"
+#include "ruleactiontemplate.h"
+#include "stateevaluatortemplate.h"
+#include "ruleactionparamtemplate.h"
+
+#include "types/ruleactionparam.h"
+#include "types/ruleactionparams.h"
+#include "types/repeatingoption.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QMetaEnum>
+#include <QCoreApplication>
+
+Q_DECLARE_LOGGING_CATEGORY(dcRuleManager)
+
+int RuleTemplateCatalogue::count()
+{
+    return s_count;
+}
+
+const RuleTemplateCatalogue::Entry &RuleTemplateCatalogue::entry(int index)
+{
+    Q_ASSERT(index >= 0 && index < s_count);
+    return s_entries[index];
+}
+
+QString RuleTemplateCatalogue::description(int index)
+{
+    QString context = QString("description for %0").arg(entry(index).fileName);
+    return qApp->translate(context.toUtf8().constData(), entry(index).description);
+}
+
+QString RuleTemplateCatalogue::ruleNameTemplate(int index)
+{
+    QString context = QString("ruleNameTemplate for %0").arg(entry(index).fileName);
+    return qApp->translate(context.toUtf8().constData(), entry(index).ruleNameTemplate);
+}
+
+QStringList RuleTemplateCatalogue::interfaces(int index)
+{
+    return toStringList(entry(index).interfaces);
+}
+
+RuleTemplate *RuleTemplateCatalogue::createRuleTemplate(int index, QObject *parent)
+{
+    RuleTemplate* t;
+    EventDescriptorTemplate* evt;
+    ParamDescriptor* evpt;
+    RuleActionTemplate* rat;
+    RuleActionParamTemplates* rapts;
+
+    const Entry &e = entry(index);
+    QVariantMap ruleTemplate = QJsonDocument::fromJson(e.json).toVariant().toMap();
+
+    // RuleTemplate base
+    t = new RuleTemplate(e.interfaceName, description(index), ruleNameTemplate(index), parent);
+    qCDebug(dcRuleManager()) << "Loading rule template" << e.description << "from" << e.fileName;
+
+    // EventDescriptorTemplate
+    foreach (const QVariant &eventDescriptorVariant, ruleTemplate.value("eventDescriptorTemplates").toList()) {
+        QVariantMap eventDescriptorTemplate = eventDescriptorVariant.toMap();
+        evt = new EventDescriptorTemplate(
+                    eventDescriptorTemplate.value("interfaceName").toString(),
+                    eventDescriptorTemplate.value("interfaceEvent").toString(),
+                    eventDescriptorTemplate.value("selectionId").toInt(),
+                    EventDescriptorTemplate::SelectionModeDevice);
+        foreach (const QVariant &eventDescriptorParamVariant, eventDescriptorTemplate.value("params").toList()) {
+            QVariantMap eventDescriptorParamTemplate = eventDescriptorParamVariant.toMap();
+            evpt = new ParamDescriptor();
+            evpt->setParamName(eventDescriptorParamTemplate.value("name").toString());
+            if (eventDescriptorParamTemplate.contains("value")) {
+                evpt->setValue(eventDescriptorParamTemplate.value("value"));
+                if (!eventDescriptorParamTemplate.contains("operator")) {
+                    qWarning() << "BROKEN Template: Operator missing for event descriptor template" << qUtf8Printable(QJsonDocument::fromVariant(eventDescriptorParamTemplate).toJson(QJsonDocument::Indented));
+                } else {
+                    QMetaEnum operatorEnum = QMetaEnum::fromType<ParamDescriptor::ValueOperator>();
+                    evpt->setOperatorType(static_cast<ParamDescriptor::ValueOperator>(operatorEnum.keyToValue(eventDescriptorParamTemplate.value("operator").toByteArray().data())));
+                }
+            }
+            evt->paramDescriptors()->addParamDescriptor(evpt);
+        }
+        t->eventDescriptorTemplates()->addEventDescriptorTemplate(evt);
+    }
+
+    // StateEvaluatorTemplate
+    if (ruleTemplate.contains("stateEvaluatorTemplate")) {
+        t->setStateEvaluatorTemplate(loadStateEvaluatorTemplate(ruleTemplate.value("stateEvaluatorTemplate").toMap()));
+    }
+
+    // TimeDescriptorTemplate
+    if (ruleTemplate.contains("timeDescriptorTemplate")) {
+
+        t->setTimeDescriptorTemplate(loadTimeDescriptorTemplate(ruleTemplate.value("timeDescriptorTemplate").toMap()));
+    }
+
+    // RuleActionTemplates
+    foreach (const QVariant &ruleActionVariant, ruleTemplate.value("ruleActionTemplates").toList()) {
+        QVariantMap ruleActionTemplate = ruleActionVariant.toMap();
+        rapts = new RuleActionParamTemplates();
+        foreach (const QVariant &ruleActionParamVariant, ruleActionTemplate.value("params").toList()) {
+            QVariantMap ruleActionParamTemplate = ruleActionParamVariant.toMap();
+            QString paramName = ruleActionParamTemplate.value("name").toString();
+            if (ruleActionParamTemplate.contains("value")) {
+                QVariant paramValue = ruleActionParamTemplate.value("value");
+                rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, paramValue));
+            } else if (ruleActionParamTemplate.contains("eventInterface") && ruleActionParamTemplate.contains("eventName") && ruleActionParamTemplate.contains("eventParamName")) {
+                QString eventInterface = ruleActionParamTemplate.value("eventInterface").toString();
+                QString eventName = ruleActionParamTemplate.value("eventName").toString();
+                QString eventParamName = ruleActionParamTemplate.value("eventParamName").toString();
+                rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, eventInterface, eventName, eventParamName));
+            } else {
+                qCWarning(dcRuleManager()) << "Invalid rule action param name on rule template:" << paramName;
+            }
+        }
+        QMetaEnum selectionModeEnum = QMetaEnum::fromType<RuleActionTemplate::SelectionMode>();
+        rat = new RuleActionTemplate(
+                    ruleActionTemplate.value("interfaceName").toString(),
+                    ruleActionTemplate.value("interfaceAction").toString(),
+                    ruleActionTemplate.value("selectionId").toInt(),
+                    static_cast<RuleActionTemplate::SelectionMode>(selectionModeEnum.keyToValue(ruleActionTemplate.value("selectionMode", "SelectionModeDevice").toByteArray().data())),
+                    rapts);
+        t->ruleActionTemplates()->addRuleActionTemplate(rat);
+    }
+
+    // RuleExitActionTemplates
+    foreach (const QVariant &ruleActionVariant, ruleTemplate.value("ruleExitActionTemplates").toList()) {
+        QVariantMap ruleActionTemplate = ruleActionVariant.toMap();
+        rapts = new RuleActionParamTemplates();
+        foreach (const QVariant &ruleActionParamVariant, ruleActionTemplate.value("params").toList()) {
+            QVariantMap ruleActionParamTemplate = ruleActionParamVariant.toMap();
+            QString paramName = ruleActionParamTemplate.value("name").toString();
+            if (ruleActionParamTemplate.contains("value")) {
+                QVariant paramValue = ruleActionParamTemplate.value("value");
+                rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, paramValue));
+            } else if (ruleActionParamTemplate.contains("eventInterface") && ruleActionParamTemplate.contains("eventName") && ruleActionParamTemplate.contains("eventParamName")) {
+                QString eventInterface = ruleActionParamTemplate.value("eventInterface").toString();
+                QString eventName = ruleActionParamTemplate.value("eventName").toString();
+                QString eventParamName = ruleActionParamTemplate.value("eventParamName").toString();
+                rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, eventInterface, eventName, eventParamName));
+            } else {
+                qCWarning(dcRuleManager()) << "Invalid rule exit action param name on rule template:" << paramName;
+            }
+        }
+        QMetaEnum selectionModeEnum = QMetaEnum::fromType<RuleActionTemplate::SelectionMode>();
+        rat = new RuleActionTemplate(
+                    ruleActionTemplate.value("interfaceName").toString(),
+                    ruleActionTemplate.value("interfaceAction").toString(),
+                    ruleActionTemplate.value("selectionId").toInt(),
+                    static_cast<RuleActionTemplate::SelectionMode>(selectionModeEnum.keyToValue(ruleActionTemplate.value("selectionMode", "SelectionModeDevice").toByteArray().data())),
+                    rapts);
+        t->ruleExitActionTemplates()->addRuleActionTemplate(rat);
+    }
+
+    return t;
+}
+
+StateEvaluatorTemplate *RuleTemplateCatalogue::loadStateEvaluatorTemplate(const QVariantMap &stateEvaluatorTemplate)
+{
+    QVariantMap stateDescriptorTemplate = stateEvaluatorTemplate.value("stateDescriptorTemplate").toMap();
+    QMetaEnum selectionModeEnum = QMetaEnum::fromType<StateDescriptorTemplate::SelectionMode>();
+    QMetaEnum stateOperatorEnum = QMetaEnum::fromType<StateEvaluatorTemplate::StateOperator>();
+    QMetaEnum valueOperatorEnum = QMetaEnum::fromType<StateDescriptorTemplate::ValueOperator>();
+    StateEvaluatorTemplate::StateOperator stateOperator = StateEvaluatorTemplate::StateOperatorAnd;
+    if (stateEvaluatorTemplate.contains("stateOperatorTemplate")) {
+        stateOperator = static_cast<StateEvaluatorTemplate::StateOperator>(stateOperatorEnum.keyToValue(stateEvaluatorTemplate.value("stateOperatorTemplate").toByteArray().data()));
+    }
+
+    StateEvaluatorTemplate *set = new StateEvaluatorTemplate(
+                new StateDescriptorTemplate(
+                    stateDescriptorTemplate.value("interfaceName").toString(),
+                    stateDescriptorTemplate.value("interfaceState").toString(),
+                    stateDescriptorTemplate.value("selectionId").toInt(),
+                    static_cast<StateDescriptorTemplate::SelectionMode>(selectionModeEnum.keyToValue(stateDescriptorTemplate.value("selectionMode", "SelectionModeAny").toByteArray().data())),
+                    static_cast<StateDescriptorTemplate::ValueOperator>(valueOperatorEnum.keyToValue(stateDescriptorTemplate.value("operator").toByteArray().data())),
+                    stateDescriptorTemplate.value("value")),
+                stateOperator
+                );
+    foreach (const QVariant &childVariant, stateEvaluatorTemplate.value("childEvaluatorTemplates").toList()) {
+        QVariantMap childMap = childVariant.toMap();
+        set->childEvaluatorTemplates()->addStateEvaluatorTemplate(loadStateEvaluatorTemplate(childMap.value("stateEvaluatorTemplate").toMap()));
+    }
+
+    return set;
+}
+
+TimeDescriptorTemplate *RuleTemplateCatalogue::loadTimeDescriptorTemplate(const QVariantMap &timeDescriptorTemplate)
+{
+    TimeDescriptorTemplate *tdt = new TimeDescriptorTemplate();
+    foreach (const QVariant &childVariant, timeDescriptorTemplate.value("calendarItemTemplates").toList()) {
+        QVariantMap childMap = childVariant.toMap();
+
+        int duration = childMap.value("duration").toInt();
+        QDateTime dateTime = childMap.value("dateTime").toDateTime();
+        QTime startTime = childMap.value("startTime").toTime();
+        bool editable = childMap.value("editable", true).toBool();
+        RepeatingOption *repeatingOption = loadRepeatingOption(childMap.value("repeatingOption").toMap());
+        CalendarItemTemplate *cit = new CalendarItemTemplate(duration, dateTime, startTime, repeatingOption, editable, tdt);
+        tdt->calendarItemTemplates()->addCalendarItemTemplate(cit);
+    }
+    foreach (const QVariant &childVariant, timeDescriptorTemplate.value("timeEventItemTemplates").toList()) {
+        QVariantMap childMap = childVariant.toMap();
+        QDateTime dateTime = childMap.value("dateTime").toDateTime();
+        QTime time = childMap.value("time").toTime();
+        bool editable = childMap.value("editable", true).toBool();
+        RepeatingOption *repeatingOption = loadRepeatingOption(childMap.value("repeatingOption").toMap());
+        TimeEventItemTemplate *teit = new TimeEventItemTemplate(dateTime, time, repeatingOption, editable, tdt);
+        tdt->timeEventItemTemplates()->addTimeEventItemTemplate(teit);
+    }
+    return tdt;
+}
+
+RepeatingOption *RuleTemplateCatalogue::loadRepeatingOption(const QVariantMap &repeatingOptionMap)
+{
+    RepeatingOption *repeatingOption = new RepeatingOption();
+    repeatingOption->setWeekDays(repeatingOptionMap.value("weekDays").toList());
+    repeatingOption->setMonthDays(repeatingOptionMap.value("monthDays").toList());
+    QMetaEnum repeatingModeEnum = QMetaEnum::fromType<RepeatingOption::RepeatingMode>();
+    repeatingOption->setRepeatingMode(static_cast<RepeatingOption::RepeatingMode>(repeatingModeEnum.keyToValue(repeatingOptionMap.value("repeatingMode").toString().toUtf8().data())));
+    return repeatingOption;
+}
+
+QStringList RuleTemplateCatalogue::toStringList(const char *const *list)
+{
+    QStringList ret;
+    for (; *list; list++) {
+        ret.append(QString::fromUtf8(*list));
+    }
+    return ret;
+}
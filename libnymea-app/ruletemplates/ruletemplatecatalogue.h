@@ -0,0 +1,89 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef RULETEMPLATECATALOGUE_H
+#define RULETEMPLATECATALOGUE_H
+
+#include <QStringList>
+#include <QVariantMap>
+
+class QObject;
+class RuleTemplate;
+class StateEvaluatorTemplate;
+class TimeDescriptorTemplate;
+class RepeatingOption;
+
+/*
+ * The rule templates shipped with the app. The template json files are compiled into a static
+ * table at build time (see compileruletemplates.py) which holds what is needed to list and filter
+ * the templates. The table is shared by all RuleTemplates models and template objects are only
+ * built from an entry's json when a template is used.
+ */
+class RuleTemplateCatalogue
+{
+public:
+    struct Entry {
+        // Base name of the json file, part of the translation contexts
+        const char *fileName;
+        const char *description;
+        const char *ruleNameTemplate;
+        const char *interfaceName;
+        // Lists are terminated by a nullptr
+        const char *const *interfaces;
+        const char *const *eventNames;
+        const char *const *stateNames;
+        // Actions and exit actions
+        const char *const *actionNames;
+        // The whole template as compact json
+        const char *json;
+    };
+
+    static int count();
+    static const Entry &entry(int index);
+
+    static QString description(int index);
+    static QString ruleNameTemplate(int index);
+    static QStringList interfaces(int index);
+
+    static RuleTemplate *createRuleTemplate(int index, QObject *parent = nullptr);
+
+    static QStringList toStringList(const char *const *list);
+
+private:
+    static StateEvaluatorTemplate* loadStateEvaluatorTemplate(const QVariantMap &stateEvaluatorTemplate);
+    static TimeDescriptorTemplate* loadTimeDescriptorTemplate(const QVariantMap &timeDescriptorTemplate);
+    static RepeatingOption* loadRepeatingOption(const QVariantMap &repeatingOptionMap);
+
+    // Generated by compileruletemplates.py
+    static const Entry s_entries[];
+    static const int s_count;
+};
+
+#endif // RULETEMPLATECATALOGUE_H
@@ -0,0 +1,479 @@
+// This file is generated by compileruletemplates.py from the rule template json files.
+// Don't edit it, run "make ruletemplates" after changing the templates instead.
+
+#include "ruletemplates/ruletemplatecatalogue.h"
+
+namespace {
+
+const char *const t0_interfaces[] = { "accesscontrol", "notifications", nullptr };
+const char *const t0_eventNames[] = { "accessDenied", nullptr };
+const char *const t0_stateNames[] = { nullptr };
+const char *const t0_actionNames[] = { "notify", nullptr };
+const char *const t1_interfaces[] = { "accesscontrol", "notifications", nullptr };
+const char *const t1_eventNames[] = { "accessGranted", nullptr };
+const char *const t1_stateNames[] = { nullptr };
+const char *const t1_actionNames[] = { "notify", nullptr };
+const char *const t2_interfaces[] = { "useraccesscontrol", "notifications", nullptr };
+const char *const t2_eventNames[] = { "accessGranted", nullptr };
+const char *const t2_stateNames[] = { nullptr };
+const char *const t2_actionNames[] = { "notify", nullptr };
+const char *const t3_interfaces[] = { "button", "light", nullptr };
+const char *const t3_eventNames[] = { "pressed", nullptr };
+const char *const t3_stateNames[] = { nullptr };
+const char *const t3_actionNames[] = { "power", nullptr };
+const char *const t4_interfaces[] = { "button", "light", nullptr };
+const char *const t4_eventNames[] = { "pressed", nullptr };
+const char *const t4_stateNames[] = { nullptr };
+const char *const t4_actionNames[] = { "power", nullptr };
+const char *const t5_interfaces[] = { "button", "light", "light", "light", nullptr };
+const char *const t5_eventNames[] = { "pressed", nullptr };
+const char *const t5_stateNames[] = { "power", nullptr };
+const char *const t5_actionNames[] = { "power", "power", nullptr };
+const char *const t6_interfaces[] = { "button", "light", nullptr };
+const char *const t6_eventNames[] = { "pressed", nullptr };
+const char *const t6_stateNames[] = { nullptr };
+const char *const t6_actionNames[] = { "power", nullptr };
+const char *const t7_interfaces[] = { "daylightsensor", "light", "light", nullptr };
+const char *const t7_eventNames[] = { nullptr };
+const char *const t7_stateNames[] = { "daylight", nullptr };
+const char *const t7_actionNames[] = { "power", "power", nullptr };
+const char *const t8_interfaces[] = { "daylightsensor", "light", nullptr };
+const char *const t8_eventNames[] = { "daylight", nullptr };
+const char *const t8_stateNames[] = { nullptr };
+const char *const t8_actionNames[] = { "power", nullptr };
+const char *const t9_interfaces[] = { "daylightsensor", "light", nullptr };
+const char *const t9_eventNames[] = { "daylight", nullptr };
+const char *const t9_stateNames[] = { nullptr };
+const char *const t9_actionNames[] = { "power", nullptr };
+const char *const t10_interfaces[] = { "doorbell", "alert", nullptr };
+const char *const t10_eventNames[] = { "doorbellPressed", nullptr };
+const char *const t10_stateNames[] = { nullptr };
+const char *const t10_actionNames[] = { "alert", nullptr };
+const char *const t11_interfaces[] = { "irrigation", "irrigation", nullptr };
+const char *const t11_eventNames[] = { nullptr };
+const char *const t11_stateNames[] = { nullptr };
+const char *const t11_actionNames[] = { "power", "power", nullptr };
+const char *const t12_interfaces[] = { "dimmablelight", nullptr };
+const char *const t12_eventNames[] = { nullptr };
+const char *const t12_stateNames[] = { nullptr };
+const char *const t12_actionNames[] = { "power", "brightness", nullptr };
+const char *const t13_interfaces[] = { "mediaplayer", "dimmablelight", "dimmablelight", nullptr };
+const char *const t13_eventNames[] = { nullptr };
+const char *const t13_stateNames[] = { "playbackStatus", "playerType", nullptr };
+const char *const t13_actionNames[] = { "power", "power", "brightness", nullptr };
+const char *const t14_interfaces[] = { "mediacontroller", "mediacontroller", nullptr };
+const char *const t14_eventNames[] = { nullptr };
+const char *const t14_stateNames[] = { nullptr };
+const char *const t14_actionNames[] = { "nightMode", "nightMode", nullptr };
+const char *const t15_interfaces[] = { "button", "mediaplayer", "mediacontroller", "mediacontroller", nullptr };
+const char *const t15_eventNames[] = { "pressed", nullptr };
+const char *const t15_stateNames[] = { "playbackStatus", nullptr };
+const char *const t15_actionNames[] = { "pause", "play", nullptr };
+const char *const t16_interfaces[] = { "button", "volumecontroller", "volumecontroller", "volumecontroller", nullptr };
+const char *const t16_eventNames[] = { "pressed", nullptr };
+const char *const t16_stateNames[] = { "mute", nullptr };
+const char *const t16_actionNames[] = { "mute", "mute", nullptr };
+const char *const t17_interfaces[] = { "button", "volumecontroller", nullptr };
+const char *const t17_eventNames[] = { "pressed", nullptr };
+const char *const t17_stateNames[] = { nullptr };
+const char *const t17_actionNames[] = { "increaseVolume", nullptr };
+const char *const t18_interfaces[] = { "button", "volumecontroller", nullptr };
+const char *const t18_eventNames[] = { "pressed", nullptr };
+const char *const t18_stateNames[] = { nullptr };
+const char *const t18_actionNames[] = { "decreaseVolume", nullptr };
+const char *const t19_interfaces[] = { "battery", "notifications", nullptr };
+const char *const t19_eventNames[] = { nullptr };
+const char *const t19_stateNames[] = { "batteryCritical", nullptr };
+const char *const t19_actionNames[] = { "notify", nullptr };
+const char *const t20_interfaces[] = { "moisturesensor", "notifications", nullptr };
+const char *const t20_eventNames[] = { nullptr };
+const char *const t20_stateNames[] = { "moisture", nullptr };
+const char *const t20_actionNames[] = { "notify", nullptr };
+const char *const t21_interfaces[] = { "connectable", "notifications", nullptr };
+const char *const t21_eventNames[] = { nullptr };
+const char *const t21_stateNames[] = { "connected", nullptr };
+const char *const t21_actionNames[] = { "notify", nullptr };
+const char *const t22_interfaces[] = { "connectable", "notifications", nullptr };
+const char *const t22_eventNames[] = { nullptr };
+const char *const t22_stateNames[] = { "connected", nullptr };
+const char *const t22_actionNames[] = { "notify", nullptr };
+const char *const t23_interfaces[] = { "presencesensor", "power", "power", nullptr };
+const char *const t23_eventNames[] = { nullptr };
+const char *const t23_stateNames[] = { "isPresent", nullptr };
+const char *const t23_actionNames[] = { "power", "power", nullptr };
+const char *const t24_interfaces[] = { "presencesensor", "power", nullptr };
+const char *const t24_eventNames[] = { "isPresent", nullptr };
+const char *const t24_stateNames[] = { nullptr };
+const char *const t24_actionNames[] = { "power", nullptr };
+const char *const t25_interfaces[] = { "presencesensor", "power", nullptr };
+const char *const t25_eventNames[] = { "isPresent", nullptr };
+const char *const t25_stateNames[] = { nullptr };
+const char *const t25_actionNames[] = { "power", nullptr };
+const char *const t26_interfaces[] = { "presencesensor", "light", nullptr };
+const char *const t26_eventNames[] = { "isPresent", nullptr };
+const char *const t26_stateNames[] = { nullptr };
+const char *const t26_actionNames[] = { "power", nullptr };
+const char *const t27_interfaces[] = { "presencesensor", "power", nullptr };
+const char *const t27_eventNames[] = { "isPresent", nullptr };
+const char *const t27_stateNames[] = { nullptr };
+const char *const t27_actionNames[] = { "power", nullptr };
+const char *const t28_interfaces[] = { "extendedsmartmeterproducer", "evcharger", "evcharger", nullptr };
+const char *const t28_eventNames[] = { nullptr };
+const char *const t28_stateNames[] = { "currentPower", nullptr };
+const char *const t28_actionNames[] = { "power", "power", nullptr };
+const char *const t29_interfaces[] = { "extendedsmartmeterproducer", "heating", "heating", nullptr };
+const char *const t29_eventNames[] = { nullptr };
+const char *const t29_stateNames[] = { "currentPower", nullptr };
+const char *const t29_actionNames[] = { "power", "power", nullptr };
+const char *const t30_interfaces[] = { "presencesensor", "thermostat", "thermostat", nullptr };
+const char *const t30_eventNames[] = { nullptr };
+const char *const t30_stateNames[] = { "isPresent", nullptr };
+const char *const t30_actionNames[] = { "targetTemperature", "targetTemperature", nullptr };
+
+}
+
+const RuleTemplateCatalogue::Entry RuleTemplateCatalogue::s_entries[] = {
+    {
+        "accesscontroltemplates",
+        "Alert me on denied access attempts",
+        "Denied access attempt on %0",
+        "",
+        t0_interfaces,
+        t0_eventNames,
+        t0_stateNames,
+        t0_actionNames,
+        "{\"description\":\"Alert me on denied access attempts\",\"ruleNameTemplate\":\"Denied access attempt on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"accesscontrol\",\"interfaceEvent\":\"accessDenied\",\"selectionId\":0}],\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"params\":[{\"name\":\"title\",\"value\":\"Denied access attempt!\"},{\"name\":\"body\",\"value\":\"Someone tried to enter %0.\"}]}]}"
+    },
+    {
+        "accesscontroltemplates",
+        "Notify my about access",
+        "Access granted on %0",
+        "",
+        t1_interfaces,
+        t1_eventNames,
+        t1_stateNames,
+        t1_actionNames,
+        "{\"description\":\"Notify my about access\",\"ruleNameTemplate\":\"Access granted on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"accesscontrol\",\"interfaceEvent\":\"accessGranted\",\"selectionId\":0}],\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"params\":[{\"name\":\"title\",\"value\":\"User access\"},{\"name\":\"body\",\"value\":\"Someone entered %0.\"}]}]}"
+    },
+    {
+        "accesscontroltemplates",
+        "Notify my about user access",
+        "Access granted to user on %0",
+        "",
+        t2_interfaces,
+        t2_eventNames,
+        t2_stateNames,
+        t2_actionNames,
+        "{\"description\":\"Notify my about user access\",\"ruleNameTemplate\":\"Access granted to user on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"useraccesscontrol\",\"interfaceEvent\":\"accessGranted\",\"selectionId\":0,\"params\":[{\"name\":\"userId\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"params\":[{\"name\":\"title\",\"value\":\"User access\"},{\"name\":\"body\",\"eventInterface\":\"useraccesscontrol\",\"eventName\":\"accessGranted\",\"eventParamName\":\"userId\"}]}]}"
+    },
+    {
+        "buttontemplates",
+        "Turn on lights",
+        "%0 turns on %1",
+        "",
+        t3_interfaces,
+        t3_eventNames,
+        t3_stateNames,
+        t3_actionNames,
+        "{\"description\":\"Turn on lights\",\"ruleNameTemplate\":\"%0 turns on %1\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":0}],\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevices\",\"params\":[{\"name\":\"power\",\"value\":true}]}]}"
+    },
+    {
+        "buttontemplates",
+        "Turn off lights",
+        "%0 turns off %1",
+        "",
+        t4_interfaces,
+        t4_eventNames,
+        t4_stateNames,
+        t4_actionNames,
+        "{\"description\":\"Turn off lights\",\"ruleNameTemplate\":\"%0 turns off %1\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":0}],\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevices\",\"params\":[{\"name\":\"power\",\"value\":false}]}]}"
+    },
+    {
+        "buttontemplates",
+        "Switch a light",
+        "%0 switches %1",
+        "",
+        t5_interfaces,
+        t5_eventNames,
+        t5_stateNames,
+        t5_actionNames,
+        "{\"description\":\"Switch a light\",\"ruleNameTemplate\":\"%0 switches %1\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":0}],\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"light\",\"interfaceState\":\"power\",\"operator\":\"ValueOperatorEquals\",\"value\":false,\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\"}},\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"power\",\"value\":true}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"power\",\"value\":false}]}]}"
+    },
+    {
+        "buttontemplates",
+        "Turn off all lights",
+        "Turn off everything with %0",
+        "",
+        t6_interfaces,
+        t6_eventNames,
+        t6_stateNames,
+        t6_actionNames,
+        "{\"description\":\"Turn off all lights\",\"ruleNameTemplate\":\"Turn off everything with %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\"}],\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeInterface\",\"params\":[{\"name\":\"power\",\"value\":false}]}]}"
+    },
+    {
+        "daylightsensor",
+        "Turn on a light while it's dark outside",
+        "Turn on %1 while it's dark outside",
+        "",
+        t7_interfaces,
+        t7_eventNames,
+        t7_stateNames,
+        t7_actionNames,
+        "{\"description\":\"Turn on a light while it's dark outside\",\"ruleNameTemplate\":\"Turn on %1 while it's dark outside\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"daylightsensor\",\"interfaceState\":\"daylight\",\"selectionId\":0,\"operator\":\"ValueOperatorEquals\",\"value\":false}},\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"true\"}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"false\"}]}]}"
+    },
+    {
+        "daylightsensor",
+        "Turn on a light when it gets dark outside",
+        "Turn on %1 when it gets dark outside (%0)",
+        "",
+        t8_interfaces,
+        t8_eventNames,
+        t8_stateNames,
+        t8_actionNames,
+        "{\"description\":\"Turn on a light when it gets dark outside\",\"ruleNameTemplate\":\"Turn on %1 when it gets dark outside (%0)\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"daylightsensor\",\"interfaceEvent\":\"daylight\",\"selectionId\":0,\"params\":[{\"name\":\"daylight\",\"value\":false,\"operator\":\"ValueOperatorEquals\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"true\"}]}]}"
+    },
+    {
+        "daylightsensor",
+        "Turn on all lights when it gets dark outside",
+        "Turn on all lights when it gets dark outside",
+        "",
+        t9_interfaces,
+        t9_eventNames,
+        t9_stateNames,
+        t9_actionNames,
+        "{\"description\":\"Turn on all lights when it gets dark outside\",\"ruleNameTemplate\":\"Turn on all lights when it gets dark outside\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"daylightsensor\",\"interfaceEvent\":\"daylight\",\"selectionId\":0,\"params\":[{\"name\":\"daylight\",\"value\":false,\"operator\":\"ValueOperatorEquals\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeInterface\",\"params\":[{\"name\":\"power\",\"value\":\"true\"}]}]}"
+    },
+    {
+        "doorbellruletemplates",
+        "Alert on doorbell ring",
+        "Alert %1 when someone is at %0",
+        "",
+        t10_interfaces,
+        t10_eventNames,
+        t10_stateNames,
+        t10_actionNames,
+        "{\"description\":\"Alert on doorbell ring\",\"ruleNameTemplate\":\"Alert %1 when someone is at %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"doorbell\",\"interfaceEvent\":\"doorbellPressed\",\"selectionId\":0}],\"ruleActionTemplates\":[{\"interfaceName\":\"alert\",\"interfaceAction\":\"alert\",\"selectionId\":1}]}"
+    },
+    {
+        "irrigationtemplates",
+        "Schedule an irrigation",
+        "Schedule for %0",
+        "",
+        t11_interfaces,
+        t11_eventNames,
+        t11_stateNames,
+        t11_actionNames,
+        "{\"description\":\"Schedule an irrigation\",\"ruleNameTemplate\":\"Schedule for %0\",\"timeDescriptorTemplate\":{\"calendarItemTemplates\":[{\"startTime\":\"07:00\",\"duration\":20,\"repeatingOption\":{\"repeatingMode\":\"RepeatingModeDaily\"},\"editable\":true}]},\"ruleActionTemplates\":[{\"interfaceName\":\"irrigation\",\"interfaceAction\":\"power\",\"selectionId\":0,\"params\":[{\"name\":\"power\",\"value\":true}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"irrigation\",\"interfaceAction\":\"power\",\"selectionId\":0,\"params\":[{\"name\":\"power\",\"value\":false}]}]}"
+    },
+    {
+        "lighttemplates",
+        "Wake up with light",
+        "Wake up with %0",
+        "",
+        t12_interfaces,
+        t12_eventNames,
+        t12_stateNames,
+        t12_actionNames,
+        "{\"description\":\"Wake up with light\",\"ruleNameTemplate\":\"Wake up with %0\",\"timeDescriptorTemplate\":{\"timeEventItemTemplates\":[{\"time\":\"07:00\",\"repeatingOption\":{\"repeatingMode\":\"RepeatingModeWeekly\",\"weekDays\":[1,2,3,4,5]},\"editable\":true}]},\"ruleActionTemplates\":[{\"interfaceName\":\"dimmablelight\",\"interfaceAction\":\"power\",\"selectionId\":0,\"params\":[{\"name\":\"power\",\"value\":true}]},{\"interfaceName\":\"dimmablelight\",\"interfaceAction\":\"brightness\",\"selectionId\":0}]}"
+    },
+    {
+        "mediatemplates",
+        "Dim light while watching TV",
+        "%0 dims %1 for movie time",
+        "",
+        t13_interfaces,
+        t13_eventNames,
+        t13_stateNames,
+        t13_actionNames,
+        "{\"description\":\"Dim light while watching TV\",\"ruleNameTemplate\":\"%0 dims %1 for movie time\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"mediaplayer\",\"interfaceState\":\"playbackStatus\",\"selectionId\":0,\"operator\":\"ValueOperatorEquals\",\"value\":\"Playing\"},\"stateOperatorTemplate\":\"StateOperatorAnd\",\"childEvaluatorTemplates\":[{\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"mediaplayer\",\"interfaceState\":\"playerType\",\"selectionId\":0,\"operator\":\"ValueOperatorEquals\",\"value\":\"video\"}}}]},\"ruleActionTemplates\":[{\"interfaceName\":\"dimmablelight\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":false}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"dimmablelight\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":true}]},{\"interfaceName\":\"dimmablelight\",\"interfaceAction\":\"brightness\",\"selectionId\":1,\"params\":[{\"name\":\"brightness\",\"value\":\"50\"}]}]}"
+    },
+    {
+        "mediatemplates",
+        "Automatic night mode",
+        "Automatic night mode on %0",
+        "",
+        t14_interfaces,
+        t14_eventNames,
+        t14_stateNames,
+        t14_actionNames,
+        "{\"description\":\"Automatic night mode\",\"ruleNameTemplate\":\"Automatic night mode on %0\",\"timeDescriptorTemplate\":{\"calendarItemTemplates\":[{\"startTime\":\"22:00\",\"duration\":600,\"repeatingOption\":{\"repeatingMode\":\"RepeatingModeDaily\"},\"editable\":true}]},\"ruleActionTemplates\":[{\"interfaceName\":\"mediacontroller\",\"interfaceAction\":\"nightMode\",\"selectionId\":0,\"params\":[{\"name\":\"nightMode\",\"value\":true}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"mediacontroller\",\"interfaceAction\":\"nightMode\",\"selectionId\":0,\"params\":[{\"name\":\"nightMode\",\"value\":false}]}]}"
+    },
+    {
+        "mediatemplates",
+        "Play/pause music by button press",
+        "%1 toggles play/pause on %0",
+        "",
+        t15_interfaces,
+        t15_eventNames,
+        t15_stateNames,
+        t15_actionNames,
+        "{\"description\":\"Play/pause music by button press\",\"ruleNameTemplate\":\"%1 toggles play/pause on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\"}],\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"mediaplayer\",\"interfaceState\":\"playbackStatus\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\",\"operator\":\"ValueOperatorEquals\",\"value\":\"Playing\"}},\"ruleActionTemplates\":[{\"interfaceName\":\"mediacontroller\",\"interfaceAction\":\"pause\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\"}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"mediacontroller\",\"interfaceAction\":\"play\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\"}]}"
+    },
+    {
+        "mediatemplates",
+        "Toggle mute by button press",
+        "%1 toggles mute on %0",
+        "",
+        t16_interfaces,
+        t16_eventNames,
+        t16_stateNames,
+        t16_actionNames,
+        "{\"description\":\"Toggle mute by button press\",\"ruleNameTemplate\":\"%1 toggles mute on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\"}],\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"volumecontroller\",\"interfaceState\":\"mute\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\",\"operator\":\"ValueOperatorEquals\",\"value\":false}},\"ruleActionTemplates\":[{\"interfaceName\":\"volumecontroller\",\"interfaceAction\":\"mute\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"mute\",\"value\":true}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"volumecontroller\",\"interfaceAction\":\"mute\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"mute\",\"value\":false}]}]}"
+    },
+    {
+        "mediatemplates",
+        "Increase volume by button press",
+        "%1 increases volume on %0",
+        "",
+        t17_interfaces,
+        t17_eventNames,
+        t17_stateNames,
+        t17_actionNames,
+        "{\"description\":\"Increase volume by button press\",\"ruleNameTemplate\":\"%1 increases volume on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\"}],\"ruleActionTemplates\":[{\"interfaceName\":\"volumecontroller\",\"interfaceAction\":\"increaseVolume\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\"}]}"
+    },
+    {
+        "mediatemplates",
+        "Decrease volume by button press",
+        "%1 decreases volume on %0",
+        "",
+        t18_interfaces,
+        t18_eventNames,
+        t18_stateNames,
+        t18_actionNames,
+        "{\"description\":\"Decrease volume by button press\",\"ruleNameTemplate\":\"%1 decreases volume on %0\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"button\",\"interfaceEvent\":\"pressed\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\"}],\"ruleActionTemplates\":[{\"interfaceName\":\"volumecontroller\",\"interfaceAction\":\"decreaseVolume\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\"}]}"
+    },
+    {
+        "notificationtemplates",
+        "Notify me when a device runs out of battery",
+        "Low battery alert for %0",
+        "",
+        t19_interfaces,
+        t19_eventNames,
+        t19_stateNames,
+        t19_actionNames,
+        "{\"description\":\"Notify me when a device runs out of battery\",\"ruleNameTemplate\":\"Low battery alert for %0\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"battery\",\"interfaceState\":\"batteryCritical\",\"operator\":\"ValueOperatorEquals\",\"value\":true,\"selectionId\":0}},\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"title\",\"value\":\"Low battery alert\"},{\"name\":\"body\",\"value\":\"%0 runs out of battery\"},{\"name\":\"data\",\"value\":\"open=$0\"}]}]}"
+    },
+    {
+        "notificationtemplates",
+        "Notify me when something dries out",
+        "Notify %1 when %0 dries out",
+        "",
+        t20_interfaces,
+        t20_eventNames,
+        t20_stateNames,
+        t20_actionNames,
+        "{\"description\":\"Notify me when something dries out\",\"ruleNameTemplate\":\"Notify %1 when %0 dries out\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"moisturesensor\",\"interfaceState\":\"moisture\",\"operator\":\"ValueOperatorLess\",\"selectionMode\":\"SelectionModeDevice\",\"selectionId\":0,\"value\":20}},\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"title\",\"value\":\"Water alert\"},{\"name\":\"body\",\"value\":\"%0 runs dry\"},{\"name\":\"data\",\"value\":\"open=$0\"}]}]}"
+    },
+    {
+        "notificationtemplates",
+        "Notify me when a thing gets disconnected",
+        "Disconnect alert for %0",
+        "",
+        t21_interfaces,
+        t21_eventNames,
+        t21_stateNames,
+        t21_actionNames,
+        "{\"description\":\"Notify me when a thing gets disconnected\",\"ruleNameTemplate\":\"Disconnect alert for %0\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"connectable\",\"interfaceState\":\"connected\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\",\"operator\":\"ValueOperatorEquals\",\"value\":false}},\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"title\",\"value\":\"Disconnect alert\"},{\"name\":\"body\",\"value\":\"%0 has disconnected\"},{\"name\":\"data\",\"value\":\"open=$0\"}]}]}"
+    },
+    {
+        "notificationtemplates",
+        "Notify me when a thing connects",
+        "Connection notification for %0",
+        "",
+        t22_interfaces,
+        t22_eventNames,
+        t22_stateNames,
+        t22_actionNames,
+        "{\"description\":\"Notify me when a thing connects\",\"ruleNameTemplate\":\"Connection notification for %0\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"connectable\",\"interfaceState\":\"connected\",\"selectionId\":0,\"selectionMode\":\"SelectionModeDevice\",\"operator\":\"ValueOperatorEquals\",\"value\":true}},\"ruleActionTemplates\":[{\"interfaceName\":\"notifications\",\"interfaceAction\":\"notify\",\"selectionId\":1,\"selectionMode\":\"SelectionModeDevice\",\"params\":[{\"name\":\"title\",\"value\":\"Thing connected\"},{\"name\":\"body\",\"value\":\"%0 has connected\"},{\"name\":\"data\",\"value\":\"open=$0\"}]}]}"
+    },
+    {
+        "presencesensortemplates",
+        "Turn on something while being present",
+        "Turn on %1 while %0 reports presence",
+        "",
+        t23_interfaces,
+        t23_eventNames,
+        t23_stateNames,
+        t23_actionNames,
+        "{\"description\":\"Turn on something while being present\",\"ruleNameTemplate\":\"Turn on %1 while %0 reports presence\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"presencesensor\",\"interfaceState\":\"isPresent\",\"selectionId\":0,\"operator\":\"ValueOperatorEquals\",\"value\":true}},\"ruleActionTemplates\":[{\"interfaceName\":\"power\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"true\"}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"power\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"false\"}]}]}"
+    },
+    {
+        "presencesensortemplates",
+        "Turn off something when leaving",
+        "Turn off %1 when %0 reports leaving",
+        "",
+        t24_interfaces,
+        t24_eventNames,
+        t24_stateNames,
+        t24_actionNames,
+        "{\"description\":\"Turn off something when leaving\",\"ruleNameTemplate\":\"Turn off %1 when %0 reports leaving\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"presencesensor\",\"interfaceEvent\":\"isPresent\",\"selectionId\":0,\"params\":[{\"name\":\"isPresent\",\"value\":false,\"operator\":\"ValueOperatorEquals\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"power\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"false\"}]}]}"
+    },
+    {
+        "presencesensortemplates",
+        "Turn off everything when leaving",
+        "Turn off everything when %0 reports leaving",
+        "",
+        t25_interfaces,
+        t25_eventNames,
+        t25_stateNames,
+        t25_actionNames,
+        "{\"description\":\"Turn off everything when leaving\",\"ruleNameTemplate\":\"Turn off everything when %0 reports leaving\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"presencesensor\",\"interfaceEvent\":\"isPresent\",\"selectionId\":0,\"params\":[{\"name\":\"isPresent\",\"value\":false,\"operator\":\"ValueOperatorEquals\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"power\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeInterface\",\"params\":[{\"name\":\"power\",\"value\":\"false\"}]}]}"
+    },
+    {
+        "presencesensortemplates",
+        "Turn off all lights when leaving",
+        "Turn off all lights when %0 reports leaving",
+        "",
+        t26_interfaces,
+        t26_eventNames,
+        t26_stateNames,
+        t26_actionNames,
+        "{\"description\":\"Turn off all lights when leaving\",\"ruleNameTemplate\":\"Turn off all lights when %0 reports leaving\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"presencesensor\",\"interfaceEvent\":\"isPresent\",\"selectionId\":0,\"params\":[{\"name\":\"isPresent\",\"value\":false,\"operator\":\"ValueOperatorEquals\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"light\",\"interfaceAction\":\"power\",\"selectionId\":1,\"selectionMode\":\"SelectionModeInterface\",\"params\":[{\"name\":\"power\",\"value\":\"false\"}]}]}"
+    },
+    {
+        "presencesensortemplates",
+        "Turn on something when arriving",
+        "Turn on %1 when %0 reports arriving",
+        "",
+        t27_interfaces,
+        t27_eventNames,
+        t27_stateNames,
+        t27_actionNames,
+        "{\"description\":\"Turn on something when arriving\",\"ruleNameTemplate\":\"Turn on %1 when %0 reports arriving\",\"eventDescriptorTemplates\":[{\"interfaceName\":\"presencesensor\",\"interfaceEvent\":\"isPresent\",\"selectionId\":0,\"params\":[{\"name\":\"isPresent\",\"value\":true,\"operator\":\"ValueOperatorEquals\"}]}],\"ruleActionTemplates\":[{\"interfaceName\":\"power\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":\"true\"}]}]}"
+    },
+    {
+        "smartmetertemplates",
+        "Charge my car while producing energy",
+        "Smart car charging",
+        "",
+        t28_interfaces,
+        t28_eventNames,
+        t28_stateNames,
+        t28_actionNames,
+        "{\"description\":\"Charge my car while producing energy\",\"ruleNameTemplate\":\"Smart car charging\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"extendedsmartmeterproducer\",\"interfaceState\":\"currentPower\",\"operator\":\"ValueOperatorGreater\",\"value\":0,\"selectionId\":0}},\"ruleActionTemplates\":[{\"interfaceName\":\"evcharger\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":true}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"evcharger\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":false}]}]}"
+    },
+    {
+        "smartmetertemplates",
+        "Turn on heating while producing energy",
+        "Smart heating",
+        "",
+        t29_interfaces,
+        t29_eventNames,
+        t29_stateNames,
+        t29_actionNames,
+        "{\"description\":\"Turn on heating while producing energy\",\"ruleNameTemplate\":\"Smart heating\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"extendedsmartmeterproducer\",\"interfaceState\":\"currentPower\",\"operator\":\"ValueOperatorGreater\",\"value\":0,\"selectionId\":0}},\"ruleActionTemplates\":[{\"interfaceName\":\"heating\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":true}]}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"heating\",\"interfaceAction\":\"power\",\"selectionId\":1,\"params\":[{\"name\":\"power\",\"value\":false}]}]}"
+    },
+    {
+        "thermostattemplates",
+        "Set temperature while I'm home",
+        "Set temperature while I'm home",
+        "",
+        t30_interfaces,
+        t30_eventNames,
+        t30_stateNames,
+        t30_actionNames,
+        "{\"description\":\"Set temperature while I'm home\",\"ruleNameTemplate\":\"Set temperature while I'm home\",\"stateEvaluatorTemplate\":{\"stateDescriptorTemplate\":{\"interfaceName\":\"presencesensor\",\"interfaceState\":\"isPresent\",\"selectionId\":0,\"operator\":\"ValueOperatorEquals\",\"value\":true}},\"ruleActionTemplates\":[{\"interfaceName\":\"thermostat\",\"interfaceAction\":\"targetTemperature\",\"selectionId\":1}],\"ruleExitActionTemplates\":[{\"interfaceName\":\"thermostat\",\"interfaceAction\":\"targetTemperature\",\"selectionId\":1,\"params\":[{\"name\":\"targetTemperature\",\"value\":\"16\"}]}]}"
+    }
+};
+
+const int RuleTemplateCatalogue::s_count = 31;
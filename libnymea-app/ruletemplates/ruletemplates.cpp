@@ -31,178 +31,34 @@
 #include "ruletemplates.h"
 
 #include "ruletemplate.h"
-#include "eventdescriptortemplate.h"
-#include "timedescriptortemplate.h"
-#include "calendaritemtemplate.h"
-#include "timeeventitemtemplate.h"
-#include "ruleactiontemplate.h"
 #include "stateevaluatortemplate.h"
-#include "ruleactionparamtemplate.h"
-
-#include "types/ruleactionparam.h"
-#include "types/ruleactionparams.h"
-#include "types/repeatingoption.h"
+#include "statedescriptortemplate.h"
 #include "thingsproxy.h"
+#include "types/thing.h"
+#include "types/thingclass.h"
 
 #include <QDebug>
-#include <QDir>
-#include <QJsonDocument>
-#include <QMetaEnum>
-#include <QCoreApplication>
 
 Q_DECLARE_LOGGING_CATEGORY(dcRuleManager)
 
 RuleTemplates::RuleTemplates(QObject *parent) : QAbstractListModel(parent)
 {
-
-    RuleTemplate* t;
-    EventDescriptorTemplate* evt;
-    ParamDescriptor* evpt;
-    RuleActionTemplate* rat;
-    RuleActionParamTemplates* rapts;
-
-    QDir ruleTemplatesDir(":/ruletemplates");
-
-    foreach (const QString &templateFile, ruleTemplatesDir.entryList({"*.json"})) {
-        qCDebug(dcRuleManager()) << "Loading rule template:" << ruleTemplatesDir.absoluteFilePath(templateFile);
-        QFile f(ruleTemplatesDir.absoluteFilePath(templateFile));
-        if (!f.open(QFile::ReadOnly)) {
-            qCWarning(dcRuleManager()) << "Cannot open rule template file for reading:" << ruleTemplatesDir.absoluteFilePath(templateFile);
-            continue;
-        }
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(f.readAll(), &error);
-        f.close();
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcRuleManager()) << "Error reading rule template json from file:" << ruleTemplatesDir.absoluteFilePath(templateFile) << error.offset << error.errorString();
-            continue;
-        }
-        foreach (const QVariant &ruleTemplateVariant, jsonDoc.toVariant().toMap().value("templates").toList()) {
-            QVariantMap ruleTemplate = ruleTemplateVariant.toMap();
-
-            // RuleTemplate base
-            QString descriptionContext = QString("description for %0").arg(QFileInfo(templateFile).baseName());
-            QString nameTemplateContext = QString("ruleNameTemplate for %0").arg(QFileInfo(templateFile).baseName());
-            t = new RuleTemplate(ruleTemplate.value("interfaceName").toString(),
-                                 qApp->translate(descriptionContext.toUtf8(), ruleTemplate.value("description").toByteArray()),
-                                 qApp->translate(nameTemplateContext.toUtf8(), ruleTemplate.value("ruleNameTemplate").toByteArray()),
-                                 this);
-            qCDebug(dcRuleManager()) << "Loading rule template" << ruleTemplate.value("description").toString() << tr(ruleTemplate.value("description").toByteArray());
-
-            // EventDescriptorTemplate
-            foreach (const QVariant &eventDescriptorVariant, ruleTemplate.value("eventDescriptorTemplates").toList()) {
-                QVariantMap eventDescriptorTemplate = eventDescriptorVariant.toMap();
-                evt = new EventDescriptorTemplate(
-                            eventDescriptorTemplate.value("interfaceName").toString(),
-                            eventDescriptorTemplate.value("interfaceEvent").toString(),
-                            eventDescriptorTemplate.value("selectionId").toInt(),
-                            EventDescriptorTemplate::SelectionModeDevice);
-                foreach (const QVariant &eventDescriptorParamVariant, eventDescriptorTemplate.value("params").toList()) {
-                    QVariantMap eventDescriptorParamTemplate = eventDescriptorParamVariant.toMap();
-                    evpt = new ParamDescriptor();
-                    evpt->setParamName(eventDescriptorParamTemplate.value("name").toString());
-                    if (eventDescriptorParamTemplate.contains("value")) {
-                        evpt->setValue(eventDescriptorParamTemplate.value("value"));
-                        if (!eventDescriptorParamTemplate.contains("operator")) {
-                            qWarning() << "BROKEN Template: Operator missing for event descriptor template" << qUtf8Printable(QJsonDocument::fromVariant(eventDescriptorParamTemplate).toJson(QJsonDocument::Indented));
-                        } else {
-                            QMetaEnum operatorEnum = QMetaEnum::fromType<ParamDescriptor::ValueOperator>();
-                            evpt->setOperatorType(static_cast<ParamDescriptor::ValueOperator>(operatorEnum.keyToValue(eventDescriptorParamTemplate.value("operator").toByteArray().data())));
-                        }
-                    }
-                    evt->paramDescriptors()->addParamDescriptor(evpt);
-                }
-                t->eventDescriptorTemplates()->addEventDescriptorTemplate(evt);
-            }
-
-            // StateEvaluatorTemplate
-            if (ruleTemplate.contains("stateEvaluatorTemplate")) {
-                t->setStateEvaluatorTemplate(loadStateEvaluatorTemplate(ruleTemplate.value("stateEvaluatorTemplate").toMap()));
-            }
-
-            // TimeDescriptorTemplate
-            if (ruleTemplate.contains("timeDescriptorTemplate")) {
-
-                t->setTimeDescriptorTemplate(loadTimeDescriptorTemplate(ruleTemplate.value("timeDescriptorTemplate").toMap()));
-            }
-
-            // RuleActionTemplates
-            foreach (const QVariant &ruleActionVariant, ruleTemplate.value("ruleActionTemplates").toList()) {
-                QVariantMap ruleActionTemplate = ruleActionVariant.toMap();
-                rapts = new RuleActionParamTemplates();
-                foreach (const QVariant &ruleActionParamVariant, ruleActionTemplate.value("params").toList()) {
-                    QVariantMap ruleActionParamTemplate = ruleActionParamVariant.toMap();
-                    QString paramName = ruleActionParamTemplate.value("name").toString();
-                    if (ruleActionParamTemplate.contains("value")) {
-                        QVariant paramValue = ruleActionParamTemplate.value("value");
-                        rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, paramValue));
-                    } else if (ruleActionParamTemplate.contains("eventInterface") && ruleActionParamTemplate.contains("eventName") && ruleActionParamTemplate.contains("eventParamName")) {
-                        QString eventInterface = ruleActionParamTemplate.value("eventInterface").toString();
-                        QString eventName = ruleActionParamTemplate.value("eventName").toString();
-                        QString eventParamName = ruleActionParamTemplate.value("eventParamName").toString();
-                        rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, eventInterface, eventName, eventParamName));
-                    } else {
-                        qCWarning(dcRuleManager()) << "Invalid rule action param name on rule template:" << paramName;
-                    }
-                }
-                QMetaEnum selectionModeEnum = QMetaEnum::fromType<RuleActionTemplate::SelectionMode>();
-                rat = new RuleActionTemplate(
-                            ruleActionTemplate.value("interfaceName").toString(),
-                            ruleActionTemplate.value("interfaceAction").toString(),
-                            ruleActionTemplate.value("selectionId").toInt(),
-                            static_cast<RuleActionTemplate::SelectionMode>(selectionModeEnum.keyToValue(ruleActionTemplate.value("selectionMode", "SelectionModeDevice").toByteArray().data())),
-                            rapts);
-                t->ruleActionTemplates()->addRuleActionTemplate(rat);
-            }
-
-            // RuleExitActionTemplates
-            foreach (const QVariant &ruleActionVariant, ruleTemplate.value("ruleExitActionTemplates").toList()) {
-                QVariantMap ruleActionTemplate = ruleActionVariant.toMap();
-                rapts = new RuleActionParamTemplates();
-                foreach (const QVariant &ruleActionParamVariant, ruleActionTemplate.value("params").toList()) {
-                    QVariantMap ruleActionParamTemplate = ruleActionParamVariant.toMap();
-                    QString paramName = ruleActionParamTemplate.value("name").toString();
-                    if (ruleActionParamTemplate.contains("value")) {
-                        QVariant paramValue = ruleActionParamTemplate.value("value");
-                        rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, paramValue));
-                    } else if (ruleActionParamTemplate.contains("eventInterface") && ruleActionParamTemplate.contains("eventName") && ruleActionParamTemplate.contains("eventParamName")) {
-                        QString eventInterface = ruleActionParamTemplate.value("eventInterface").toString();
-                        QString eventName = ruleActionParamTemplate.value("eventName").toString();
-                        QString eventParamName = ruleActionParamTemplate.value("eventParamName").toString();
-                        rapts->addRuleActionParamTemplate(new RuleActionParamTemplate(paramName, eventInterface, eventName, eventParamName));
-                    } else {
-                        qCWarning(dcRuleManager()) << "Invalid rule exit action param name on rule template:" << paramName;
-                    }
-                }
-                QMetaEnum selectionModeEnum = QMetaEnum::fromType<RuleActionTemplate::SelectionMode>();
-                rat = new RuleActionTemplate(
-                            ruleActionTemplate.value("interfaceName").toString(),
-                            ruleActionTemplate.value("interfaceAction").toString(),
-                            ruleActionTemplate.value("selectionId").toInt(),
-                            static_cast<RuleActionTemplate::SelectionMode>(selectionModeEnum.keyToValue(ruleActionTemplate.value("selectionMode", "SelectionModeDevice").toByteArray().data())),
-                            rapts);
-                t->ruleExitActionTemplates()->addRuleActionTemplate(rat);
-            }
-
-            m_list.append(t);
-        }
-        qCDebug(dcRuleManager()) << "Loaded" << m_list.count() << "rule templates";
-    }
+    m_list.resize(RuleTemplateCatalogue::count());
 }
 
 int RuleTemplates::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_list.count();
+    return RuleTemplateCatalogue::count();
 }
 
 QVariant RuleTemplates::data(const QModelIndex &index, int role) const
 {
     switch (role) {
     case RoleDescription:
-        return m_list.at(index.row())->description();
+        return RuleTemplateCatalogue::description(index.row());
     case RoleInterfaces:
-        return m_list.at(index.row())->interfaces();
+        return RuleTemplateCatalogue::interfaces(index.row());
     }
     return QVariant();
 }
@@ -220,72 +76,11 @@ RuleTemplate *RuleTemplates::get(int index) const
     if (index < 0 || index >= m_list.count()) {
         return nullptr;
     }
-    return m_list.at(index);
-}
-
-StateEvaluatorTemplate *RuleTemplates::loadStateEvaluatorTemplate(const QVariantMap &stateEvaluatorTemplate) const
-{
-    QVariantMap stateDescriptorTemplate = stateEvaluatorTemplate.value("stateDescriptorTemplate").toMap();
-    QMetaEnum selectionModeEnum = QMetaEnum::fromType<StateDescriptorTemplate::SelectionMode>();
-    QMetaEnum stateOperatorEnum = QMetaEnum::fromType<StateEvaluatorTemplate::StateOperator>();
-    QMetaEnum valueOperatorEnum = QMetaEnum::fromType<StateDescriptorTemplate::ValueOperator>();
-    StateEvaluatorTemplate::StateOperator stateOperator = StateEvaluatorTemplate::StateOperatorAnd;
-    if (stateEvaluatorTemplate.contains("stateOperatorTemplate")) {
-        stateOperator = static_cast<StateEvaluatorTemplate::StateOperator>(stateOperatorEnum.keyToValue(stateEvaluatorTemplate.value("stateOperatorTemplate").toByteArray().data()));
-    }
-
-    StateEvaluatorTemplate *set = new StateEvaluatorTemplate(
-                new StateDescriptorTemplate(
-                    stateDescriptorTemplate.value("interfaceName").toString(),
-                    stateDescriptorTemplate.value("interfaceState").toString(),
-                    stateDescriptorTemplate.value("selectionId").toInt(),
-                    static_cast<StateDescriptorTemplate::SelectionMode>(selectionModeEnum.keyToValue(stateDescriptorTemplate.value("selectionMode", "SelectionModeAny").toByteArray().data())),
-                    static_cast<StateDescriptorTemplate::ValueOperator>(valueOperatorEnum.keyToValue(stateDescriptorTemplate.value("operator").toByteArray().data())),
-                    stateDescriptorTemplate.value("value")),
-                stateOperator
-                );
-    foreach (const QVariant &childVariant, stateEvaluatorTemplate.value("childEvaluatorTemplates").toList()) {
-        QVariantMap childMap = childVariant.toMap();
-        set->childEvaluatorTemplates()->addStateEvaluatorTemplate(loadStateEvaluatorTemplate(childMap.value("stateEvaluatorTemplate").toMap()));
+    // Template objects are only built once a template is used
+    if (!m_list.at(index)) {
+        m_list[index] = RuleTemplateCatalogue::createRuleTemplate(index, const_cast<RuleTemplates*>(this));
     }
-
-    return set;
-}
-
-TimeDescriptorTemplate *RuleTemplates::loadTimeDescriptorTemplate(const QVariantMap &timeDescriptorTemplate) const
-{
-    TimeDescriptorTemplate *tdt = new TimeDescriptorTemplate();
-    foreach (const QVariant &childVariant, timeDescriptorTemplate.value("calendarItemTemplates").toList()) {
-        QVariantMap childMap = childVariant.toMap();
-
-        int duration = childMap.value("duration").toInt();
-        QDateTime dateTime = childMap.value("dateTime").toDateTime();
-        QTime startTime = childMap.value("startTime").toTime();
-        bool editable = childMap.value("editable", true).toBool();
-        RepeatingOption *repeatingOption = loadRepeatingOption(childMap.value("repeatingOption").toMap());
-        CalendarItemTemplate *cit = new CalendarItemTemplate(duration, dateTime, startTime, repeatingOption, editable, tdt);
-        tdt->calendarItemTemplates()->addCalendarItemTemplate(cit);
-    }
-    foreach (const QVariant &childVariant, timeDescriptorTemplate.value("timeEventItemTemplates").toList()) {
-        QVariantMap childMap = childVariant.toMap();
-        QDateTime dateTime = childMap.value("dateTime").toDateTime();
-        QTime time = childMap.value("time").toTime();
-        bool editable = childMap.value("editable", true).toBool();
-        RepeatingOption *repeatingOption = loadRepeatingOption(childMap.value("repeatingOption").toMap());
-        TimeEventItemTemplate *teit = new TimeEventItemTemplate(dateTime, time, repeatingOption, editable, tdt);
-        tdt->timeEventItemTemplates()->addTimeEventItemTemplate(teit);
-    }
-    return tdt;
-}
-
-RepeatingOption *RuleTemplates::loadRepeatingOption(const QVariantMap &repeatingOptionMap) const
-{
-    RepeatingOption *repeatingOption = new RepeatingOption();
-    repeatingOption->setWeekDays(repeatingOptionMap.value("weekDays").toList());
-    repeatingOption->setMonthDays(repeatingOptionMap.value("monthDays").toList());
-    QMetaEnum repeatingModeEnum = QMetaEnum::fromType<RepeatingOption::RepeatingMode>();
-    repeatingOption->setRepeatingMode(static_cast<RepeatingOption::RepeatingMode>(repeatingModeEnum.keyToValue(repeatingOptionMap.value("repeatingMode").toString().toUtf8().data())));
-    return repeatingOption;
+    return m_list.at(index);
 }
 
 void RuleTemplatesFilterModel::setFilterByThings(ThingsProxy *filterThingsProxy)
@@ -308,20 +103,22 @@ bool RuleTemplatesFilterModel::filterAcceptsRow(int source_row, const QModelInde
     if (!m_ruleTemplates) {
         return false;
     }
-    RuleTemplate *t = m_ruleTemplates->get(source_row);
-//    qDebug() << "Checking interface" << t->description() << t->interfaces() << "for usage with:" << m_filterInterfaceNames;
+    // Filtering works on the catalogue, so that template objects are only built for the selected one
+    const RuleTemplateCatalogue::Entry &entry = RuleTemplateCatalogue::entry(source_row);
+    QStringList interfaces = RuleTemplateCatalogue::toStringList(entry.interfaces);
+//    qDebug() << "Checking interface" << entry.description << interfaces << "for usage with:" << m_filterInterfaceNames;
 
 
     // Make sure we have all the things to satisfy all of the templates events/states/actions
-    if (m_filterThingsProxy && !thingsSatisfyRuleTemplate(t, m_filterThingsProxy)) {
-        qDebug() << "Filtering out" << t->description() << "because required no thing in the provided filter proxy satisfies definitions";
+    if (m_filterThingsProxy && !thingsSatisfyRuleTemplate(entry, m_filterThingsProxy)) {
+        qDebug() << "Filtering out" << entry.description << "because required no thing in the provided filter proxy satisfies definitions";
         return false;
     }
 
     if (!m_filterInterfaceNames.isEmpty()) {
         bool found = false;
         foreach (const QString toBeFound, m_filterInterfaceNames) {
-            if (t->interfaces().contains(toBeFound)) {
+            if (interfaces.contains(toBeFound)) {
                 found = true;
                 break;
             }
@@ -346,14 +143,14 @@ bool RuleTemplatesFilterModel::stateEvaluatorTemplateContainsInterface(StateEval
     return false;
 }
 
-bool RuleTemplatesFilterModel::thingsSatisfyRuleTemplate(RuleTemplate *ruleTemplate, ThingsProxy *things) const
+bool RuleTemplatesFilterModel::thingsSatisfyRuleTemplate(const RuleTemplateCatalogue::Entry &entry, ThingsProxy *things) const
 {
     // For improved performance it would be better to just cycle things once and flag satisfied states/events/actions
     // instead of looping over all things for every entry, but for the amount of templates we have right now
     // this is good enough. If needed, here's low hanging fruit to collect...
 
     // First check if all interfaces are around
-    foreach (const QString &interfaceName, ruleTemplate->interfaces()) {
+    foreach (const QString &interfaceName, RuleTemplateCatalogue::toStringList(entry.interfaces)) {
         bool haveThing = false;
         for (int i = 0; i < things->rowCount(); i++) {
             Thing *thing = things->get(i);
@@ -369,83 +166,50 @@ bool RuleTemplatesFilterModel::thingsSatisfyRuleTemplate(RuleTemplate *ruleTempl
     }
 
     // Given optional states/actions/events in interfaces, we also need to check for them
-    for (int i = 0; i < ruleTemplate->eventDescriptorTemplates()->rowCount(); i++) {
-        EventDescriptorTemplate *eventDescriptorTemplate = ruleTemplate->eventDescriptorTemplates()->get(i);
+    foreach (const QString &eventName, RuleTemplateCatalogue::toStringList(entry.eventNames)) {
         bool haveThing = false;
         for (int j = 0; j < things->rowCount(); j++) {
             Thing *thing = things->get(j);
-            if (thing->thingClass()->eventTypes()->findByName(eventDescriptorTemplate->eventName())) {
+            if (thing->thingClass()->eventTypes()->findByName(eventName)) {
                 haveThing = true;
                 break;
             }
         }
         if (!haveThing) {
-            qCDebug(dcRuleManager()) << "No thing to satisfy event" << eventDescriptorTemplate->eventName();
+            qCDebug(dcRuleManager()) << "No thing to satisfy event" << eventName;
             return false;
         }
     }
 
-    if (ruleTemplate->stateEvaluatorTemplate() && !thingsSatisfyStateEvaluatorTemplate(ruleTemplate->stateEvaluatorTemplate(), things)) {
-        qCDebug(dcRuleManager()) << "No thing to satisfy state evaluator template";
-        return false;
-    }
-
-    for (int i = 0; i < ruleTemplate->ruleActionTemplates()->rowCount(); i++) {
-        RuleActionTemplate *ruleActionTemplate = ruleTemplate->ruleActionTemplates()->get(i);
+    foreach (const QString &stateName, RuleTemplateCatalogue::toStringList(entry.stateNames)) {
         bool haveThing = false;
         for (int j = 0; j < things->rowCount(); j++) {
             Thing *thing = things->get(j);
-            if (thing->thingClass()->actionTypes()->findByName(ruleActionTemplate->actionName())) {
+            if (thing->thingClass()->stateTypes()->findByName(stateName)) {
                 haveThing = true;
                 break;
             }
         }
         if (!haveThing) {
-            qCDebug(dcRuleManager()) << "No thing to satisfy action" << ruleActionTemplate->actionName();
+            qCDebug(dcRuleManager()) << "No thing to satisfy state" << stateName;
             return false;
         }
     }
 
-    for (int i = 0; i < ruleTemplate->ruleExitActionTemplates()->rowCount(); i++) {
-        RuleActionTemplate *ruleExitActionTemplate = ruleTemplate->ruleExitActionTemplates()->get(i);
+    foreach (const QString &actionName, RuleTemplateCatalogue::toStringList(entry.actionNames)) {
         bool haveThing = false;
         for (int j = 0; j < things->rowCount(); j++) {
             Thing *thing = things->get(j);
-            if (thing->thingClass()->actionTypes()->findByName(ruleExitActionTemplate->actionName())) {
-                haveThing = true;
-                break;
-            }
-        }
-        if (!haveThing) {
-            qCDebug(dcRuleManager()) << "No thing to satisfy exit action" << ruleExitActionTemplate->actionName();
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool RuleTemplatesFilterModel::thingsSatisfyStateEvaluatorTemplate(StateEvaluatorTemplate *stateEvaluatorTemplate, ThingsProxy *things) const
-{
-    if (stateEvaluatorTemplate->stateDescriptorTemplate()) {
-        bool haveThing = false;
-        for (int i = 0; i < things->rowCount(); i++) {
-            Thing *thing = things->get(i);
-            if (thing->thingClass()->stateTypes()->findByName(stateEvaluatorTemplate->stateDescriptorTemplate()->stateName())) {
+            if (thing->thingClass()->actionTypes()->findByName(actionName)) {
                 haveThing = true;
                 break;
             }
         }
         if (!haveThing) {
+            qCDebug(dcRuleManager()) << "No thing to satisfy action" << actionName;
             return false;
         }
     }
 
-    for (int i = 0; i < stateEvaluatorTemplate->childEvaluatorTemplates()->rowCount(); i++) {
-        StateEvaluatorTemplate *childEvaluatorTemplate = stateEvaluatorTemplate->childEvaluatorTemplates()->get(i);
-        if (!thingsSatisfyStateEvaluatorTemplate(childEvaluatorTemplate, things)) {
-            return false;
-        }
-    }
     return true;
 }
@@ -33,10 +33,10 @@
 
 #include <QAbstractListModel>
 
+#include "ruletemplatecatalogue.h"
+
 class RuleTemplate;
 class StateEvaluatorTemplate;
-class TimeDescriptorTemplate;
-class RepeatingOption;
 class ThingsProxy;
 class Thing;
 
@@ -62,12 +62,8 @@ signals:
     void countChanged();
 
 private:
-    StateEvaluatorTemplate* loadStateEvaluatorTemplate(const QVariantMap &stateEvaluatorTemplate) const;
-    TimeDescriptorTemplate* loadTimeDescriptorTemplate(const QVariantMap &timeDescriptorTemplate) const;
-    RepeatingOption* loadRepeatingOption(const QVariantMap &repeatingOptionMap) const;
-
-private:
-    QList<RuleTemplate*> m_list;
+    // Built on demand from RuleTemplateCatalogue
+    mutable QVector<RuleTemplate*> m_list;
 
 };
 
@@ -106,8 +102,7 @@ signals:
 
 
 private:
-    bool thingsSatisfyRuleTemplate(RuleTemplate *ruleTemplate, ThingsProxy *things) const;
-    bool thingsSatisfyStateEvaluatorTemplate(StateEvaluatorTemplate *stateEvaluatorTemplate, ThingsProxy *things) const;
+    bool thingsSatisfyRuleTemplate(const RuleTemplateCatalogue::Entry &entry, ThingsProxy *things) const;
 
 private:
     RuleTemplates* m_ruleTemplates = nullptr;
@@ -110,6 +110,7 @@ CodeCompletion::CodeCompletion(QObject *parent):
 
     m_model = new CompletionModel(this);
     m_proxy = new CompletionProxyModel(m_model, this);
+    m_outline = new ScriptOutline(this);
     connect(m_proxy, &CompletionProxyModel::filterChanged, this, &CodeCompletion::currentWordChanged);
 }
 
@@ -135,6 +136,7 @@ void CodeCompletion::setDocument(QQuickTextDocument *document)
 {
     if (m_document != document) {
         m_document = document;
+        m_outline->setDocument(m_document ? m_document->textDocument() : nullptr);
         emit documentChanged();
         m_cursor = QTextCursor(m_document->textDocument());
         emit cursorPositionChanged();
@@ -469,8 +471,7 @@ void CodeCompletion::update()
         QString id = blockText;
         id.remove(QRegExp(".* ")).remove(QRegExp("\\.[a-zA-Z0-9]*"));
         QString type = getIdTypes().value(id);
-        int blockPosition = getBlockPosition(id);
-        BlockInfo blockInfo = getBlockInfo(blockPosition);
+        BlockInfo blockInfo = getBlockInfoByIndex(m_outline->blockForId(id));
 
         qDebug() << "dot expression:" << id << type;
         qDebug() << "lvalue info:" << blockInfo.properties.keys() << blockInfo.properties.value("actionName") << blockInfo.properties.value("actionTypeId");
@@ -495,28 +496,25 @@ void CodeCompletion::update()
             QString paramString;
             // If it's an execute() call, also autocomplete the params
             if (method == "execute") {
-                qDebug() << "Blockposition:" << blockPosition;
-                if (blockPosition >= 0) {
-                    if (blockInfo.valid) {
-                        QString thingId = blockInfo.properties.value("thingId");
-                        Thing *d = m_engine->thingManager()->things()->getThing(QUuid(thingId));
-                        if (d) {
-                            ActionType *at = nullptr;
-                            if (blockInfo.properties.contains("actionTypeId")) {
-                                at = d->thingClass()->actionTypes()->getActionType(blockInfo.properties.value("actionTypeId"));
-                            } else if (blockInfo.properties.contains("actionName")) {
-                                at = d->thingClass()->actionTypes()->findByName(blockInfo.properties.value("actionName"));
-                            }
-                            if (at) {
-                                QStringList params;
-                                QStringList nonEscapeTypes = {"Int", "Bool", "Double"};
-                                for (int i = 0; i < at->paramTypes()->rowCount(); i++) {
-                                    ParamType *pt = at->paramTypes()->get(i);
-                                    QString escapeChar = nonEscapeTypes.contains(pt->type()) ? "" : "\"";
-                                    params.append("\"" + pt->name() + "\": " + escapeChar + pt->defaultValue().toString() + escapeChar);
-                                }
-                                paramString = "{" + params.join(", ") + "}";
+                if (blockInfo.valid) {
+                    QString thingId = blockInfo.properties.value("thingId");
+                    Thing *d = m_engine->thingManager()->things()->getThing(QUuid(thingId));
+                    if (d) {
+                        ActionType *at = nullptr;
+                        if (blockInfo.properties.contains("actionTypeId")) {
+                            at = d->thingClass()->actionTypes()->getActionType(blockInfo.properties.value("actionTypeId"));
+                        } else if (blockInfo.properties.contains("actionName")) {
+                            at = d->thingClass()->actionTypes()->findByName(blockInfo.properties.value("actionName"));
+                        }
+                        if (at) {
+                            QStringList params;
+                            QStringList nonEscapeTypes = {"Int", "Bool", "Double"};
+                            for (int i = 0; i < at->paramTypes()->rowCount(); i++) {
+                                ParamType *pt = at->paramTypes()->get(i);
+                                QString escapeChar = nonEscapeTypes.contains(pt->type()) ? "" : "\"";
+                                params.append("\"" + pt->name() + "\": " + escapeChar + pt->defaultValue().toString() + escapeChar);
                             }
+                            paramString = "{" + params.join(", ") + "}";
                         }
                     }
                 }
@@ -559,7 +557,7 @@ void CodeCompletion::update()
     bool atStart = false;
     while (!isImperative && jsBlock.valid && !atStart) {
 //        qDebug() << "is imperative block?" << isImperative << jsBlock.name << "blockText" << blockText;
-        BlockInfo tmp = getBlockInfo(jsBlock.start - 1);
+        BlockInfo tmp = getBlockInfoByIndex(jsBlock.parent);
         if (tmp.valid) {
             jsBlock = tmp;
             isImperative = jsBlock.name.endsWith(":") || jsBlock.name.endsWith("()");
@@ -636,103 +634,32 @@ void CodeCompletion::update()
 
 CodeCompletion::BlockInfo CodeCompletion::getBlockInfo(int position) const
 {
-    BlockInfo info;
-
-    // Find start of block
-    QTextCursor blockStart = m_document->textDocument()->find("{", position, QTextDocument::FindBackward);
-    QTextCursor blockEnd = m_document->textDocument()->find("}", position, QTextDocument::FindBackward);
-    while (blockEnd.position() > blockStart.position() && !blockStart.isNull()) {
-        blockStart = m_document->textDocument()->find("{", blockStart, QTextDocument::FindBackward);
-        blockEnd = m_document->textDocument()->find("}", blockEnd, QTextDocument::FindBackward);
-    }
+    return getBlockInfoByIndex(m_outline->blockAt(position));
+}
 
-    if (blockStart.isNull()) {
+CodeCompletion::BlockInfo CodeCompletion::getBlockInfoByIndex(int index) const
+{
+    BlockInfo info;
+    if (index < 0) {
         return info;
     }
 
-    // Find end of block
-    QTextCursor tmp = blockStart;
-    blockEnd = blockStart;
-    while (!tmp.isNull() && blockEnd >= tmp) {
-        tmp = m_document->textDocument()->find("{", tmp.position());
-        blockEnd = m_document->textDocument()->find("}", blockEnd.position());
-    }
-
-    info.start = blockStart.position();
-    info.end = blockEnd.position();
+    const ScriptOutline::Block &block = m_outline->block(index);
     info.valid = true;
-//    qDebug() << "Block start:" << info.start << "end:" << info.end;
-
-    info.name = blockStart.block().text();
-    info.name.remove(QRegExp(" *\\{ *"));
-    while (info.name.contains(" ")) {
-        info.name.remove(QRegExp(".* "));
-    }
-
-    int childBlocks = 0;
-    while (!blockStart.isNull() && blockStart.position() < info.end) {
-        QString line = blockStart.block().text();
-//        qDebug() << "line:" << line;
-        if (line.contains("{") && !line.contains("}")) {
-            childBlocks++;
-        }
-        if (line.contains("}") && !line.contains("{")) {
-            childBlocks--;
-            if (!blockStart.movePosition(QTextCursor::NextBlock)) {
-                break;
-            }
-            continue;
-        }
-        // \n
-        if (childBlocks > 1 && !(childBlocks == 2 && line.trimmed().startsWith("function"))) { // Skip all stuff in child blocks
-//            qDebug() << "skipping line in child block" << childBlocks;
-            blockStart.movePosition(QTextCursor::NextBlock);
-            continue;
-        }
-        foreach (const QString &statement, blockStart.block().text().split(";")) {
-//            qDebug() << "analysing statement:" << statement;
-            QStringList parts = statement.split(":");
-            if (parts.length() == 2) { // Properties must be "foo: bar"
-                QString propName = parts.first().trimmed();
-                if (propName.split(" ").count() > 1) { // trim modifiers e.g. "property bool foo: bar"
-                    propName = propName.split(" ").last();
-                }
-                if (propName.contains(".")) { // skip attached properties e.g. "Component.onCompleted: ..."
-                    continue;
-                }
-                QString propValue = parts.last().split("//").first().trimmed().remove("\"");
-                info.properties.insert(propName, propValue);
-            }
-            parts = statement.trimmed().split(" ");
-            if (parts.count() >= 2 && parts.first().trimmed() == "function") {
-                QString functionHeader = parts.at(1).trimmed();
-                info.functions.append(functionHeader.split("(").first());
-            }
-        }
-        if (!blockStart.movePosition(QTextCursor::NextBlock)) {
-            break;
-        }
-    }
-
+    info.parent = block.parent;
+    info.name = block.name;
+    info.properties = block.properties;
+    info.functions = block.functions;
+    info.start = m_outline->position(block.startLine, block.startColumn);
+    info.end = block.endLine >= 0 ? m_outline->position(block.endLine, block.endColumn) : -1;
     return info;
 }
 
 QList<CompletionModel::Entry> CodeCompletion::getIds() const
 {
-    // Find all ids in the doc
     QList<CompletionModel::Entry> entries;
-    QTextCursor tmp = QTextCursor(m_document->textDocument());
-    while (!tmp.atEnd()) {
-        tmp.movePosition(QTextCursor::StartOfWord, QTextCursor::MoveAnchor);
-        tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-        QString word = tmp.selectedText();
-        if (word == "id") {
-            tmp.movePosition(QTextCursor::NextWord, QTextCursor::MoveAnchor);
-            tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-            QString idName = tmp.selectedText();
-            entries.append(CompletionModel::Entry(idName, idName, "id", ""));
-        }
-        tmp.movePosition(QTextCursor::NextWord);
+    foreach (const QString &id, m_outline->ids()) {
+        entries.append(CompletionModel::Entry(id, id, "id", ""));
     }
     return entries;
 }
@@ -740,57 +667,24 @@ QList<CompletionModel::Entry> CodeCompletion::getIds() const
 QHash<QString, QString> CodeCompletion::getIdTypes() const
 {
     QHash<QString, QString> ret;
-    QTextCursor tmp = QTextCursor(m_document->textDocument());
-    while (!tmp.atEnd()) {
-        tmp.movePosition(QTextCursor::StartOfWord, QTextCursor::MoveAnchor);
-        tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-        QString word = tmp.selectedText();
-        if (word == "id") {
-            tmp.movePosition(QTextCursor::NextWord, QTextCursor::MoveAnchor);
-            tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-            QString idName = tmp.selectedText();
-            BlockInfo info = getBlockInfo(tmp.position());
-            if (!info.name.isEmpty()) {
-                ret.insert(idName, info.name);
-            }
+    foreach (const QString &id, m_outline->ids()) {
+        int index = m_outline->blockForId(id);
+        if (index >= 0 && !m_outline->block(index).name.isEmpty()) {
+            ret.insert(id, m_outline->block(index).name);
         }
-        tmp.movePosition(QTextCursor::NextWord);
     }
     return ret;
 }
 
 int CodeCompletion::openingBlocksBefore(int position) const
 {
-    int opening = 0;
-    int closing = 0;
-    QTextCursor tmp = m_cursor;
-    tmp.setPosition(position);
-    do {
-        tmp = m_document->textDocument()->find(QRegExp("[{}]"), tmp, QTextDocument::FindBackward);
-        if (tmp.selectedText() == "{")
-            opening++;
-        if (tmp.selectedText() == "}")
-            closing++;
-    } while (!tmp.isNull());
-
-    return opening - closing;
+    return m_outline->depthAt(position);
 }
 
 int CodeCompletion::closingBlocksAfter(int position) const
 {
-    int opening = 0;
-    int closing = 0;
-    QTextCursor tmp = m_cursor;
-    tmp.setPosition(position);
-    do {
-        tmp = m_document->textDocument()->find(QRegExp("[{}]"), tmp);
-        if (tmp.selectedText() == "{")
-            opening++;
-        if (tmp.selectedText() == "}")
-            closing++;
-    } while (!tmp.isNull());
-
-    return closing - opening;
+    // Whatever is open at position and hasn't been closed by the end of the document isn't closed after it either
+    return m_outline->depthAt(position) - m_outline->balance();
 }
 
 void CodeCompletion::complete(int index)
@@ -996,24 +890,3 @@ void CodeCompletion::moveCursor(CodeCompletion::MoveOperation moveOperation, int
         break;
     }
 }
-
-int CodeCompletion::getBlockPosition(const QString &id) const
-{
-    // Find block with id "id" in the doc
-    QTextCursor tmp = QTextCursor(m_document->textDocument());
-    while (!tmp.atEnd()) {
-        tmp.movePosition(QTextCursor::StartOfWord, QTextCursor::MoveAnchor);
-        tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-        QString word = tmp.selectedText();
-        if (word == "id") {
-            tmp.movePosition(QTextCursor::NextWord, QTextCursor::MoveAnchor);
-            tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-            QString idName = tmp.selectedText();
-            if (idName == id) {
-                return tmp.position();
-            }
-        }
-        tmp.movePosition(QTextCursor::NextWord);
-    }
-    return -1;
-}
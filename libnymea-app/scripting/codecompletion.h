@@ -37,6 +37,7 @@
 #include <QHash>
 
 #include "completionmodel.h"
+#include "scriptoutline.h"
 
 class Engine;
 
@@ -100,6 +101,7 @@ private:
     class BlockInfo {
     public:
         bool valid = false;
+        int parent = -1;
         QString name;
         QHash<QString, QString> properties;
         QStringList functions;
@@ -118,8 +120,8 @@ private:
         QStringList events;
     };
 
-    int getBlockPosition(const QString &id) const;
     BlockInfo getBlockInfo(int postition) const;
+    BlockInfo getBlockInfoByIndex(int index) const;
     QList<CompletionModel::Entry> getIds() const;
     QHash<QString, QString> getIdTypes() const;
 
@@ -131,6 +133,7 @@ private:
     QQuickTextDocument* m_document = nullptr;
     CompletionModel *m_model = nullptr;
     CompletionProxyModel *m_proxy = nullptr;
+    ScriptOutline *m_outline = nullptr;
 
     QTextCursor m_cursor;
 
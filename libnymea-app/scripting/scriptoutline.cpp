@@ -0,0 +1,365 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "scriptoutline.h"
+
+#include <QRegExp>
+#include <QTextBlock>
+
+#include <algorithm>
+
+ScriptOutline::ScriptOutline(QObject *parent):
+    QObject(parent)
+{
+}
+
+QTextDocument *ScriptOutline::document() const
+{
+    return m_document;
+}
+
+void ScriptOutline::setDocument(QTextDocument *document)
+{
+    if (m_document == document) {
+        return;
+    }
+    if (m_document) {
+        disconnect(m_document, &QTextDocument::contentsChange, this, &ScriptOutline::onContentsChange);
+    }
+    m_document = document;
+    if (m_document) {
+        connect(m_document, &QTextDocument::contentsChange, this, &ScriptOutline::onContentsChange);
+    }
+    reparse();
+}
+
+int ScriptOutline::blockCount()
+{
+    rebuild();
+    return m_blocks.count();
+}
+
+const ScriptOutline::Block &ScriptOutline::block(int index)
+{
+    rebuild();
+    return m_blocks.at(index);
+}
+
+int ScriptOutline::blockAt(int position)
+{
+    int blockIndex;
+    int depth;
+    locate(position, &blockIndex, &depth);
+    return blockIndex;
+}
+
+QStringList ScriptOutline::ids()
+{
+    rebuild();
+    return m_ids;
+}
+
+int ScriptOutline::blockForId(const QString &id)
+{
+    rebuild();
+    return m_idBlocks.value(id, -1);
+}
+
+int ScriptOutline::depthAt(int position)
+{
+    int blockIndex;
+    int depth;
+    locate(position, &blockIndex, &depth);
+    return depth;
+}
+
+int ScriptOutline::balance()
+{
+    rebuild();
+    return m_balance;
+}
+
+int ScriptOutline::position(int line, int column) const
+{
+    if (!m_document) {
+        return -1;
+    }
+    QTextBlock textBlock = m_document->findBlockByNumber(line);
+    if (!textBlock.isValid()) {
+        return -1;
+    }
+    return textBlock.position() + column;
+}
+
+bool ScriptOutline::Line::operator==(const Line &other) const
+{
+    return braces == other.braces
+            && blockName == other.blockName
+            && properties == other.properties
+            && functions == other.functions
+            && startsWithFunction == other.startsWithFunction;
+}
+
+ScriptOutline::Line ScriptOutline::parseLine(const QString &text)
+{
+    Line line;
+
+    // Braces in strings and comments don't count
+    QChar quote;
+    bool escaped = false;
+    for (int i = 0; i < text.length(); i++) {
+        const QChar c = text.at(i);
+        if (!quote.isNull()) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == quote) {
+                quote = QChar();
+            }
+            continue;
+        }
+        if (c == '"' || c == '\'' || c == '`') {
+            quote = c;
+        } else if (c == '/' && i + 1 < text.length() && text.at(i + 1) == '/') {
+            break;
+        } else if (c == '{' || c == '}') {
+            Brace brace;
+            brace.column = i;
+            brace.opening = c == '{';
+            line.braces.append(brace);
+            line.opens |= brace.opening;
+            line.closes |= !brace.opening;
+        }
+    }
+
+    line.startsWithFunction = text.trimmed().startsWith("function");
+
+    if (line.opens) {
+        line.blockName = text;
+        line.blockName.remove(QRegExp(" *\\{ *"));
+        while (line.blockName.contains(" ")) {
+            line.blockName.remove(QRegExp(".* "));
+        }
+    }
+
+    foreach (const QString &statement, text.split(";")) {
+        QStringList parts = statement.split(":");
+        if (parts.length() == 2) { // Properties must be "foo: bar"
+            QString propName = parts.first().trimmed();
+            if (propName.split(" ").count() > 1) { // trim modifiers e.g. "property bool foo: bar"
+                propName = propName.split(" ").last();
+            }
+            if (propName.contains(".")) { // skip attached properties e.g. "Component.onCompleted: ..."
+                continue;
+            }
+            QString propValue = parts.last().split("//").first().trimmed().remove("\"");
+            line.properties.append(qMakePair(propName, propValue));
+        }
+        parts = statement.trimmed().split(" ");
+        if (parts.count() >= 2 && parts.first().trimmed() == "function") {
+            QString functionHeader = parts.at(1).trimmed();
+            line.functions.append(functionHeader.split("(").first());
+        }
+    }
+
+    return line;
+}
+
+void ScriptOutline::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved)
+
+    QTextBlock first = m_document->findBlock(position);
+    QTextBlock last = m_document->findBlock(position + charsAdded);
+    if (!last.isValid()) {
+        last = m_document->lastBlock();
+    }
+    int firstLine = first.blockNumber();
+    int newCount = last.blockNumber() - firstLine + 1;
+    int oldCount = newCount - (m_document->blockCount() - m_lines.count());
+    if (!first.isValid() || oldCount < 1 || firstLine + oldCount > m_lines.count()) {
+        // Shouldn't happen, but better safe than out of sync
+        reparse();
+        return;
+    }
+
+    QVector<Line> lines;
+    lines.reserve(newCount);
+    for (QTextBlock textBlock = first; lines.count() < newCount; textBlock = textBlock.next()) {
+        lines.append(parseLine(textBlock.text()));
+    }
+
+    // Formatting changes (e.g. by the syntax highlighter) end up here too and usually change nothing
+    if (oldCount == newCount) {
+        bool changed = false;
+        for (int i = 0; i < newCount; i++) {
+            if (m_lines.at(firstLine + i) != lines.at(i)) {
+                m_lines[firstLine + i] = lines.at(i);
+                changed = true;
+            }
+        }
+        m_dirty |= changed;
+        return;
+    }
+
+    m_lines.remove(firstLine, oldCount);
+    m_lines.insert(firstLine, newCount, Line());
+    std::copy(lines.constBegin(), lines.constEnd(), m_lines.begin() + firstLine);
+    m_dirty = true;
+}
+
+void ScriptOutline::reparse()
+{
+    m_lines.clear();
+    if (m_document) {
+        m_lines.reserve(m_document->blockCount());
+        for (QTextBlock textBlock = m_document->begin(); textBlock.isValid(); textBlock = textBlock.next()) {
+            m_lines.append(parseLine(textBlock.text()));
+        }
+    }
+    m_dirty = true;
+}
+
+void ScriptOutline::rebuild()
+{
+    if (!m_dirty) {
+        return;
+    }
+    m_dirty = false;
+
+    m_blocks.clear();
+    m_ids.clear();
+    m_idBlocks.clear();
+    m_balance = 0;
+    m_lineOwners.resize(m_lines.count());
+    m_lineDepths.resize(m_lines.count());
+    m_lineFirstBlocks.resize(m_lines.count());
+
+    QVector<int> stack;
+    for (int i = 0; i < m_lines.count(); i++) {
+        const Line &line = m_lines.at(i);
+        int owner = stack.isEmpty() ? -1 : stack.last();
+        m_lineOwners[i] = owner;
+        m_lineDepths[i] = stack.count();
+        m_lineFirstBlocks[i] = m_blocks.count();
+
+        int opened = -1;
+        foreach (const Brace &brace, line.braces) {
+            if (brace.opening) {
+                Block block;
+                block.name = line.blockName;
+                block.parent = stack.isEmpty() ? -1 : stack.last();
+                block.startLine = i;
+                block.startColumn = brace.column;
+                opened = m_blocks.count();
+                m_blocks.append(block);
+                stack.append(opened);
+                m_balance++;
+            } else {
+                m_balance--;
+                if (!stack.isEmpty()) {
+                    Block &block = m_blocks[stack.takeLast()];
+                    block.endLine = i;
+                    block.endColumn = brace.column;
+                }
+            }
+        }
+
+        if (line.opens && !line.closes) {
+            // The head of a child block belongs to the child, except that functions are members of the parent too
+            attribute(line, opened);
+            if (line.startsWithFunction && owner >= 0) {
+                m_blocks[owner].functions.append(line.functions);
+            }
+        } else if (line.closes && !line.opens) {
+            continue;
+        } else {
+            attribute(line, owner);
+        }
+    }
+}
+
+void ScriptOutline::attribute(const Line &line, int blockIndex)
+{
+    for (int i = 0; i < line.properties.count(); i++) {
+        const QPair<QString, QString> &property = line.properties.at(i);
+        if (blockIndex >= 0) {
+            m_blocks[blockIndex].properties.insert(property.first, property.second);
+        }
+        if (property.first == "id" && !property.second.isEmpty()) {
+            if (!m_idBlocks.contains(property.second)) {
+                m_ids.append(property.second);
+            }
+            m_idBlocks.insert(property.second, blockIndex);
+        }
+    }
+    if (blockIndex >= 0) {
+        m_blocks[blockIndex].functions.append(line.functions);
+    }
+}
+
+void ScriptOutline::locate(int position, int *blockIndex, int *depth)
+{
+    rebuild();
+    *blockIndex = -1;
+    *depth = 0;
+    if (!m_document || m_lines.isEmpty()) {
+        return;
+    }
+
+    QTextBlock textBlock = m_document->findBlock(position);
+    if (!textBlock.isValid()) {
+        textBlock = m_document->lastBlock();
+    }
+    int line = textBlock.blockNumber();
+    if (line < 0 || line >= m_lines.count()) {
+        return;
+    }
+    int column = position - textBlock.position();
+
+    int current = m_lineOwners.at(line);
+    int currentDepth = m_lineDepths.at(line);
+    int next = m_lineFirstBlocks.at(line);
+    foreach (const Brace &brace, m_lines.at(line).braces) {
+        if (brace.column >= column) {
+            break;
+        }
+        if (brace.opening) {
+            current = next++;
+            currentDepth++;
+        } else if (currentDepth > 0) {
+            current = m_blocks.at(current).parent;
+            currentDepth--;
+        }
+    }
+    *blockIndex = current;
+    *depth = currentDepth;
+}
@@ -0,0 +1,133 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SCRIPTOUTLINE_H
+#define SCRIPTOUTLINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QStringList>
+#include <QTextDocument>
+#include <QVector>
+
+/*
+ * Outline of a script document for code completion: the tree of {} blocks, the properties and
+ * functions declared in each of them and the ids along with the block declaring them.
+ *
+ * Every line is scanned once when it changes (QTextDocument::contentsChange) and the result is
+ * kept per line. The tree is assembled from those line summaries, and only when a query comes in
+ * after the summaries have changed. Typing within a statement which doesn't declare anything
+ * won't touch the tree at all.
+ *
+ * Locations are kept as line and column, so that edits don't shift anything in other lines.
+ */
+class ScriptOutline : public QObject
+{
+    Q_OBJECT
+public:
+    class Block {
+    public:
+        // The last word before the opening brace, e.g. "ThingAction", "onTriggered:" or "foo()"
+        QString name;
+        int parent = -1;
+        int startLine = -1;
+        int startColumn = -1;
+        // -1 if the block isn't closed
+        int endLine = -1;
+        int endColumn = -1;
+        QHash<QString, QString> properties;
+        QStringList functions;
+    };
+
+    explicit ScriptOutline(QObject *parent = nullptr);
+
+    QTextDocument *document() const;
+    void setDocument(QTextDocument *document);
+
+    int blockCount();
+    const Block &block(int index);
+    // Returns the innermost block containing position, -1 if there is none
+    int blockAt(int position);
+
+    // Ids in document order
+    QStringList ids();
+    // Returns the block declaring id, -1 if there is none
+    int blockForId(const QString &id);
+
+    // Number of blocks opened before position and still open there
+    int depthAt(int position);
+    // Opening minus closing braces in the whole document
+    int balance();
+
+    int position(int line, int column) const;
+
+private:
+    struct Brace {
+        int column;
+        bool opening;
+        bool operator==(const Brace &other) const { return column == other.column && opening == other.opening; }
+    };
+
+    struct Line {
+        QVector<Brace> braces;
+        bool opens = false;
+        bool closes = false;
+        bool startsWithFunction = false;
+        QString blockName;
+        QVector<QPair<QString, QString>> properties;
+        QStringList functions;
+        bool operator==(const Line &other) const;
+        bool operator!=(const Line &other) const { return !(*this == other); }
+    };
+
+    static Line parseLine(const QString &text);
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void reparse();
+    void rebuild();
+    void attribute(const Line &line, int blockIndex);
+    // Innermost block open at line:column, and the depth there
+    void locate(int position, int *blockIndex, int *depth);
+
+    QPointer<QTextDocument> m_document;
+    QVector<Line> m_lines;
+    bool m_dirty = true;
+
+    // Assembled from m_lines in rebuild()
+    QVector<Block> m_blocks;
+    QVector<int> m_lineOwners;
+    QVector<int> m_lineDepths;
+    QVector<int> m_lineFirstBlocks;
+    QStringList m_ids;
+    QHash<QString, int> m_idBlocks;
+    int m_balance = 0;
+};
+
+#endif // SCRIPTOUTLINE_H
@@ -38,7 +38,7 @@
 #include <QMetaObject>
 #include <QTextDocumentFragment>
 #include <QQuickItem>
-#include <QRegularExpression>
+#include <QSet>
 
 class ScriptSyntaxHighlighterPrivate: public QSyntaxHighlighter
 {
@@ -54,19 +54,27 @@ signals:
     void contentChanged(const QString &text);
 
 private:
+    // Lexer state at the end of a block. QSyntaxHighlighter only moves on to the next block if
+    // this changed, so a keystroke re-tokenises the edited line only, unless it opens or closes
+    // a comment or a string spanning multiple lines.
     enum BlockState {
         BlockStateInvalid = -1,
         BlockStateNone = 0,
-        BlockStateImport = 1,
-        BlockStateAction,
-        BlockstateThingId,
+        BlockStateComment,
+        BlockStateTemplateString,
+        // Strings continued with a backslash at the end of the line
+        BlockStateDoubleQuoteString,
+        BlockStateSingleQuoteString
     };
-    struct HighlightingRule
-    {
-        QRegularExpression pattern;
-        QTextCharFormat format;
-    };
-    QVector<HighlightingRule> highlightingRules;
+
+    int highlightString(const QString &text, int from, QChar quote, int *state);
+    void highlightWord(const QString &text, int from, int to, bool import);
+
+    QTextCharFormat m_classNameFormat;
+    QTextCharFormat m_propertyBindingFormat;
+    QTextCharFormat m_keywordFormat;
+    QTextCharFormat m_stringFormat;
+    QTextCharFormat m_commentFormat;
 };
 
 ScriptSyntaxHighlighter::ScriptSyntaxHighlighter(QObject *parent) : QObject(parent)
@@ -89,6 +97,11 @@ void ScriptSyntaxHighlighter::setDocument(QQuickTextDocument *document)
     }
 }
 
+void ScriptSyntaxHighlighter::setTextDocument(QTextDocument *document)
+{
+    m_highlighter->setDocument(document);
+}
+
 QColor ScriptSyntaxHighlighter::backgroundColor() const
 {
     return m_backgroundColor;
@@ -114,102 +127,142 @@ ScriptSyntaxHighlighterPrivate::ScriptSyntaxHighlighterPrivate(QObject *parent):
 
 void ScriptSyntaxHighlighterPrivate::update(bool dark)
 {
-    HighlightingRule rule;
-    QTextCharFormat format;
-
-    // ClassNames
-    format.setForeground(dark ? QColor("#55fc49") : QColor("#800080"));
-    rule.pattern =  QRegularExpression("\\b[A-Z][a-zA-Z0-9_]+\\b");
-    rule.format = format;
-    highlightingRules.append(rule);
-
-    // Property bindings
-    format.setForeground(dark ? QColor("#ff5555") : QColor("#800000"));
-    rule.pattern = QRegularExpression("[a-zA-Z][a-zA-Z0-9_.]+:");
-    rule.format = format;
-    highlightingRules.append(rule);
-
-    // imports
-    format.clearForeground();
-    rule.pattern = QRegularExpression("import .*$");
-    rule.format = format;
-    highlightingRules.append(rule);
-
-    // keywords
-    QStringList keywordPatterns {
-        "\\bif\\b",
-        "\\belse\\b" ,
-        "\\breturn\\b",
-        "\\bimport\\b",
-        "\\bsignal\\b",
-        "\\bproperty\\b",
-        "\\bfunction\\b",
-        "\\breadonly\\b",
-        "\\balias\\b",
-        "\\bfor\\b",
-        "\\bwhile\\b",
-        "\\bbreak\\b",
-        "\\bswitch\\b",
-        "\\bcase\\b",
-        "\\bdefault\\b",
-        "\\bvar\\b",
-        "\\bnull\\b",
-        "\\bundefined\\b",
-        "\\bstring\\b",
-        "\\bbool\\b",
-        "\\bint\\b",
-        "\\breal\\b",
-        "\\bdouble\\b",
-        "\\bdate\\b",
-        "\\btrue\\b",
-        "\\bfalse\\b",
-    };
-    format.setForeground(dark ? Qt::yellow : QColor("#80831a"));
-    foreach (const QString &pattern, keywordPatterns) {
-        rule.pattern = QRegularExpression(pattern);
-        rule.format = format;
-        highlightingRules.append(rule);
-    }
+    m_classNameFormat.setForeground(dark ? QColor("#55fc49") : QColor("#800080"));
+    m_propertyBindingFormat.setForeground(dark ? QColor("#ff5555") : QColor("#800000"));
+    m_keywordFormat.setForeground(dark ? QColor(Qt::yellow) : QColor("#80831a"));
+    m_stringFormat.setForeground(dark ? QColor("#e64ad7") : QColor(Qt::darkGreen));
+    m_commentFormat.setForeground(dark ? QColor(Qt::cyan) : QColor(Qt::darkGray));
 
-    // String literals
-    format.setForeground(dark ? QColor("#e64ad7") : Qt::darkGreen);
-    rule.format = format;
-    rule.pattern = QRegularExpression(R"**((?<!\\)([\"'])(.*?)(?<!\\)\1)**", QRegularExpression::DotMatchesEverythingOption | QRegularExpression::MultilineOption);
-    highlightingRules.append(rule);
-
-    // comments
-    format.setForeground(dark ? Qt::cyan : Qt::darkGray);
-    rule.format = format;
-    rule.pattern = QRegularExpression("//.*$");
-    highlightingRules.append(rule);
-    rule.pattern = QRegularExpression("/*.*\\*/");
-    highlightingRules.append(rule);
+    if (document()) {
+        rehighlight();
+    }
 }
 
 void ScriptSyntaxHighlighterPrivate::highlightBlock(const QString &text)
 {
 //    qDebug() << "hightlightBlock called for" << text << previousBlockState() << currentBlock().text();
 
-    foreach(const HighlightingRule &rule, highlightingRules){
-        QRegularExpression expression(rule.pattern);
-        QRegularExpressionMatchIterator matches = expression.globalMatch(text);
-        while (matches.hasNext()) {
-            QRegularExpressionMatch match = matches.next();
-            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
-        }
+    int state = previousBlockState();
+    if (state == BlockStateInvalid) {
+        state = BlockStateNone;
     }
-    if (text.trimmed().startsWith("import")) {
-        setCurrentBlockState(BlockStateImport);
-    } else if (text.trimmed().startsWith("Action")) {
-        setCurrentBlockState(BlockStateAction);
-    } else if (text.trimmed().startsWith("thingId:")) {
-        setCurrentBlockState(BlockstateThingId);
-    } else {
-        setCurrentBlockState(0);
+
+    const QChar *data = text.constData();
+    int length = text.length();
+    // Only keywords, strings and comments are highlighted in the rest of an import line
+    bool import = false;
+    int i = 0;
+    while (i < length) {
+        if (state == BlockStateComment) {
+            int end = text.indexOf(QLatin1String("*/"), i);
+            if (end < 0) {
+                setFormat(i, length - i, m_commentFormat);
+                break;
+            }
+            setFormat(i, end + 2 - i, m_commentFormat);
+            state = BlockStateNone;
+            i = end + 2;
+        } else if (state == BlockStateTemplateString) {
+            i = highlightString(text, i, '`', &state);
+        } else if (state == BlockStateDoubleQuoteString) {
+            i = highlightString(text, i, '"', &state);
+        } else if (state == BlockStateSingleQuoteString) {
+            i = highlightString(text, i, '\'', &state);
+        } else {
+            QChar c = data[i];
+            if (c == '/' && i + 1 < length && data[i + 1] == '/') {
+                setFormat(i, length - i, m_commentFormat);
+                break;
+            } else if (c == '/' && i + 1 < length && data[i + 1] == '*') {
+                state = BlockStateComment;
+                setFormat(i, 2, m_commentFormat);
+                i += 2;
+            } else if (c == '"' || c == '\'' || c == '`') {
+                setFormat(i, 1, m_stringFormat);
+                i = highlightString(text, i + 1, c, &state);
+            } else if (c.isLetter() || c == '_' || c == '$') {
+                int end = i + 1;
+                while (end < length && (data[end].isLetterOrNumber() || data[end] == '_' || data[end] == '$' || data[end] == '.')) {
+                    end++;
+                }
+                if (!import && i + 6 == end && text.midRef(i, 6) == QLatin1String("import")) {
+                    import = true;
+                }
+                highlightWord(text, i, end, import);
+                i = end;
+            } else if (c.isDigit()) {
+                // Skip the whole number so e.g. the x in 0x1F isn't taken for an identifier
+                i++;
+                while (i < length && (data[i].isLetterOrNumber() || data[i] == '.')) {
+                    i++;
+                }
+            } else {
+                i++;
+            }
+        }
     }
 
+    setCurrentBlockState(state);
+
     emit contentChanged(text);
 }
 
+int ScriptSyntaxHighlighterPrivate::highlightString(const QString &text, int from, QChar quote, int *state)
+{
+    const QChar *data = text.constData();
+    int length = text.length();
+    for (int i = from; i < length; i++) {
+        if (data[i] == '\\') {
+            if (i == length - 1) {
+                // Line continuation
+                setFormat(from, length - from, m_stringFormat);
+                *state = quote == '`' ? BlockStateTemplateString : quote == '"' ? BlockStateDoubleQuoteString : BlockStateSingleQuoteString;
+                return length;
+            }
+            i++;
+        } else if (data[i] == quote) {
+            setFormat(from, i + 1 - from, m_stringFormat);
+            *state = BlockStateNone;
+            return i + 1;
+        }
+    }
+
+    // Unterminated. Only template strings may span lines without a continuation.
+    setFormat(from, length - from, m_stringFormat);
+    *state = quote == '`' ? BlockStateTemplateString : BlockStateNone;
+    return length;
+}
+
+void ScriptSyntaxHighlighterPrivate::highlightWord(const QString &text, int from, int to, bool import)
+{
+    static const QSet<QString> keywords {
+        "if", "else", "return", "import", "signal", "property", "function", "readonly", "alias",
+        "for", "while", "break", "switch", "case", "default", "var", "null", "undefined",
+        "string", "bool", "int", "real", "double", "date", "true", "false"
+    };
+
+    bool propertyBinding = !import && to - from > 1 && to < text.length() && text.at(to) == ':';
+    if (propertyBinding) {
+        setFormat(from, to + 1 - from, m_propertyBindingFormat);
+    }
+
+    // Keywords and class names are matched per component of a.b.c
+    int start = from;
+    while (start < to) {
+        int end = start;
+        while (end < to && text.at(end) != '.') {
+            end++;
+        }
+        if (end > start) {
+            // Looked up without copying the word
+            if (keywords.contains(QString::fromRawData(text.constData() + start, end - start))) {
+                setFormat(start, end - start, m_keywordFormat);
+            } else if (!import && !propertyBinding && end - start > 1 && text.at(start).isUpper()) {
+                setFormat(start, end - start, m_classNameFormat);
+            }
+        }
+        start = end + 1;
+    }
+}
 
 #include "scriptsyntaxhighlighter.moc"
@@ -50,6 +50,8 @@ public:
 
     QQuickTextDocument* document() const;
     void setDocument(QQuickTextDocument *document);
+    // Highlights a plain QTextDocument, for use without a QML TextEdit
+    void setTextDocument(QTextDocument *document);
 
     QColor backgroundColor() const;
     void setBackgroundColor(const QColor &backgroundColor);
@@ -0,0 +1,181 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "startupscheduler.h"
+
+#include "logging.h"
+NYMEA_LOGGING_CATEGORY(dcStartup, "Startup")
+
+StartupScheduler::StartupScheduler(QObject *parent) : QObject(parent)
+{
+
+}
+
+void StartupScheduler::addPhase(const QString &name, const QStringList &dependencies, StartFunction start)
+{
+    Q_ASSERT_X(indexOf(name) < 0, "StartupScheduler", "Duplicate phase name");
+    Phase phase;
+    phase.name = name;
+    phase.dependencies = dependencies;
+    phase.start = start;
+    m_phases.append(phase);
+}
+
+void StartupScheduler::start()
+{
+    reset();
+    m_running = true;
+    emit runningChanged();
+    m_timer.start();
+    qCDebug(dcStartup()) << "Starting initial fetch";
+    startReadyPhases();
+}
+
+void StartupScheduler::finishPhase(const QString &name)
+{
+    int idx = indexOf(name);
+    if (idx < 0) {
+        qCWarning(dcStartup()) << "No such startup phase" << name;
+        return;
+    }
+    Phase &phase = m_phases[idx];
+    if (phase.status != PhaseStatusRunning) {
+        return;
+    }
+    phase.status = PhaseStatusFinished;
+    phase.finishedAt = m_timer.elapsed();
+    int duration = static_cast<int>(phase.finishedAt - phase.startedAt);
+    qCInfo(dcStartup()) << "Phase" << name << "finished after" << phase.finishedAt << "ms (took" << duration << "ms)";
+    emit phaseFinished(name, duration);
+    emit phaseTimingsChanged();
+
+    startReadyPhases();
+}
+
+void StartupScheduler::reset()
+{
+    for (int i = 0; i < m_phases.count(); i++) {
+        m_phases[i].status = PhaseStatusPending;
+        m_phases[i].startedAt = -1;
+        m_phases[i].finishedAt = -1;
+    }
+    if (m_running) {
+        m_running = false;
+        emit runningChanged();
+    }
+    emit phaseTimingsChanged();
+}
+
+bool StartupScheduler::running() const
+{
+    return m_running;
+}
+
+QVariantList StartupScheduler::phaseTimings() const
+{
+    QVariantList ret;
+    foreach (const Phase &phase, m_phases) {
+        QVariantMap timing;
+        timing.insert("name", phase.name);
+        timing.insert("started", phase.startedAt);
+        timing.insert("finished", phase.finishedAt);
+        timing.insert("duration", phase.finishedAt >= 0 ? phase.finishedAt - phase.startedAt : -1);
+        ret.append(timing);
+    }
+    return ret;
+}
+
+int StartupScheduler::phaseFinishedAt(const QString &name) const
+{
+    int idx = indexOf(name);
+    return idx >= 0 ? static_cast<int>(m_phases.at(idx).finishedAt) : -1;
+}
+
+int StartupScheduler::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_phases.count(); i++) {
+        if (m_phases.at(i).name == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool StartupScheduler::dependenciesFinished(const Phase &phase) const
+{
+    foreach (const QString &dependency, phase.dependencies) {
+        int idx = indexOf(dependency);
+        if (idx >= 0 && m_phases.at(idx).status != PhaseStatusFinished) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StartupScheduler::startReadyPhases()
+{
+    // Milestones finish right away and may unblock further phases, so loop until nothing changes.
+    bool changed = true;
+    while (m_running && changed) {
+        changed = false;
+        for (int i = 0; i < m_phases.count(); i++) {
+            if (m_phases.at(i).status != PhaseStatusPending || !dependenciesFinished(m_phases.at(i))) {
+                continue;
+            }
+            m_phases[i].status = PhaseStatusRunning;
+            m_phases[i].startedAt = m_timer.elapsed();
+            changed = true;
+            if (m_phases.at(i).start) {
+                qCDebug(dcStartup()) << "Starting phase" << m_phases.at(i).name;
+                // Copy, the start function may finish phases synchronously
+                StartFunction start = m_phases.at(i).start;
+                start();
+            } else {
+                finishPhase(m_phases.at(i).name);
+                // finishPhase() already started whatever became ready
+                return;
+            }
+        }
+    }
+
+    if (!m_running) {
+        return;
+    }
+    foreach (const Phase &phase, m_phases) {
+        if (phase.status != PhaseStatusFinished) {
+            return;
+        }
+    }
+    m_running = false;
+    qCInfo(dcStartup()) << "Initial fetch finished after" << m_timer.elapsed() << "ms";
+    emit runningChanged();
+    emit finished();
+}
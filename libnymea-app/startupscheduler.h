@@ -0,0 +1,104 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef STARTUPSCHEDULER_H
+#define STARTUPSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVariantList>
+
+#include <functional>
+
+/*
+ * Runs the initial fetch after connecting. A phase is started as soon as all its dependencies
+ * are finished, so every independent phase is started in the same event loop turn and their
+ * requests go out to the server as one pipelined burst.
+ *
+ * Phases without a start function are milestones, e.g. "interactive" which finishes as soon as
+ * everything needed to render the main view is there.
+ */
+class StartupScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    Q_PROPERTY(QVariantList phaseTimings READ phaseTimings NOTIFY phaseTimingsChanged)
+
+public:
+    typedef std::function<void()> StartFunction;
+
+    explicit StartupScheduler(QObject *parent = nullptr);
+
+    void addPhase(const QString &name, const QStringList &dependencies, StartFunction start = StartFunction());
+
+    void start();
+    // Phases which are not running are ignored
+    void finishPhase(const QString &name);
+    void reset();
+
+    bool running() const;
+    // [{ name, started, finished, duration }], times in ms since start()
+    QVariantList phaseTimings() const;
+    // -1 until the phase has finished
+    Q_INVOKABLE int phaseFinishedAt(const QString &name) const;
+
+signals:
+    void runningChanged();
+    void phaseTimingsChanged();
+    void phaseFinished(const QString &name, int duration);
+    void finished();
+
+private:
+    enum PhaseStatus {
+        PhaseStatusPending,
+        PhaseStatusRunning,
+        PhaseStatusFinished
+    };
+    struct Phase {
+        QString name;
+        QStringList dependencies;
+        StartFunction start;
+        PhaseStatus status = PhaseStatusPending;
+        qint64 startedAt = -1;
+        qint64 finishedAt = -1;
+    };
+
+    int indexOf(const QString &name) const;
+    bool dependenciesFinished(const Phase &phase) const;
+    void startReadyPhases();
+
+    QList<Phase> m_phases;
+    QElapsedTimer m_timer;
+    bool m_running = false;
+};
+
+#endif // STARTUPSCHEDULER_H
@@ -33,29 +33,69 @@
 #include "engine.h"
 
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QMetaEnum>
+#include <QSet>
 
 TagsManager::TagsManager(JsonRpcClient *jsonClient, QObject *parent):
     QObject(parent),
     m_jsonClient(jsonClient),
     m_tags(new Tags(this))
 {
-    jsonClient->registerNotificationHandler(this, "Tags", "handleTagsNotification");
+    jsonClient->registerNotificationCallback(this, "Tags.TagAdded", &TagsManager::tagAddedNotification);
+    jsonClient->registerNotificationCallback(this, "Tags.TagRemoved", &TagsManager::tagRemovedNotification);
+    jsonClient->registerNotificationCallback(this, "Tags.TagValueChanged", &TagsManager::tagValueChangedNotification);
 }
 
 void TagsManager::init()
 {
-    m_busy = true;
-    emit busyChanged();
-    m_tags->clear();
+    if (!m_reconciling) {
+        m_busy = true;
+        emit busyChanged();
+        m_tags->clear();
+    }
     m_jsonClient->sendCommand("Tags.GetTags", this, "getTagsResponse");
 }
 
 void TagsManager::clear()
 {
+    m_reconciling = false;
     m_tags->clear();
 }
 
+void TagsManager::loadSnapshot(const QVariantList &tags)
+{
+    QList<Tag*> snapshotTags;
+    foreach (const QVariant &tagVariant, tags) {
+        Tag *tag = unpackTag(tagVariant.toMap());
+        if (tag) {
+            snapshotTags.append(tag);
+        }
+    }
+    m_tags->addTags(snapshotTags);
+    m_reconciling = true;
+    m_busy = false;
+    emit busyChanged();
+}
+
+QVariantList TagsManager::snapshotTags() const
+{
+    QVariantList ret;
+    for (int i = 0; i < m_tags->rowCount(); i++) {
+        Tag *tag = m_tags->get(i);
+        QVariantMap tagMap;
+        if (!tag->thingId().isNull()) {
+            tagMap.insert("thingId", tag->thingId());
+        } else {
+            tagMap.insert("ruleId", tag->ruleId());
+        }
+        tagMap.insert("tagId", tag->tagId());
+        tagMap.insert("value", tag->value());
+        ret.append(tagMap);
+    }
+    return ret;
+}
+
 bool TagsManager::busy() const
 {
     return m_busy;
@@ -112,43 +152,48 @@ int TagsManager::untagRule(const QString &ruleId, const QString &tagId)
     return m_jsonClient->sendCommand("Tags.RemoveTag", params, this, "removeTagResponse");
 }
 
-void TagsManager::handleTagsNotification(const QVariantMap &params)
+void TagsManager::tagAddedNotification(const QJsonObject &params)
 {
-    qCDebug(dcTags()) << "Tags notification:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
-
-    QVariantMap tagMap = params.value("params").toMap().value("tag").toMap();
+    QVariantMap tagMap = params.value("tag").toObject().toVariantMap();
+    qCDebug(dcTags()) << "Tag added:" << tagMap;
     if (tagMap.value("appId").toString() != "nymea:app") {
         return; // not for us
     }
+    Tag *tag = unpackTag(tagMap);
+    if (tag) {
+        m_tags->addTag(tag);
+    }
+}
 
-    QString notification = params.value("notification").toString();
-    if (notification == "Tags.TagAdded") {
-        Tag *tag = unpackTag(tagMap);
-        if (tag) {
-            m_tags->addTag(tag);
-        }
+void TagsManager::tagRemovedNotification(const QJsonObject &params)
+{
+    QJsonObject tagObject = params.value("tag").toObject();
+    qCDebug(dcTags()) << "Tag removed:" << tagObject;
+    if (tagObject.value("appId").toString() != "nymea:app") {
+        return; // not for us
+    }
+    QUuid thingId = QUuid(tagObject.value("thingId").toString());
+    QUuid ruleId = QUuid(tagObject.value("ruleId").toString());
+    QString tagId = tagObject.value("tagId").toString();
+    Tag *tag = m_tags->findTag(thingId, ruleId, tagId);
+    if (tag) {
+        m_tags->removeTag(tag);
+    }
+}
 
-    } else if (notification == "Tags.TagRemoved") {
-        for (int i = 0; i < m_tags->rowCount(); i++) {
-            Tag* tag = m_tags->get(i);
-            QUuid thingId = tagMap.value("thingId").toUuid();
-            QUuid ruleId = tagMap.value("ruleId").toUuid();
-            QString tagId = tagMap.value("tagId").toString();
-            if (thingId == tag->thingId() && ruleId == tag->ruleId() && tagId == tag->tagId()) {
-                m_tags->removeTag(tag);
-                return;
-            }
-        }
-    } else if (notification == "Tags.TagValueChanged") {
-        for (int i = 0; i < m_tags->rowCount(); i++) {
-            Tag* tag = m_tags->get(i);
-            QUuid thingId = tagMap.value("thingId").toUuid();
-            QUuid ruleId = tagMap.value("ruleId").toUuid();
-            QString tagId = tagMap.value("tagId").toString();
-            if (thingId == tag->thingId() && ruleId == tag->ruleId() && tagId == tag->tagId()) {
-                tag->setValue(tagMap.value("value").toString());
-            }
-        }
+void TagsManager::tagValueChangedNotification(const QJsonObject &params)
+{
+    QJsonObject tagObject = params.value("tag").toObject();
+    qCDebug(dcTags()) << "Tag value changed:" << tagObject;
+    if (tagObject.value("appId").toString() != "nymea:app") {
+        return; // not for us
+    }
+    QUuid thingId = QUuid(tagObject.value("thingId").toString());
+    QUuid ruleId = QUuid(tagObject.value("ruleId").toString());
+    QString tagId = tagObject.value("tagId").toString();
+    Tag *tag = m_tags->findTag(thingId, ruleId, tagId);
+    if (tag) {
+        tag->setValue(tagObject.value("value").toString());
     }
 }
 
@@ -161,12 +206,47 @@ void TagsManager::getTagsResponse(int /*commandId*/, const QVariantMap &params)
             tags.append(tag);
         }
     }
+    if (m_reconciling) {
+        reconcileTags(tags);
+        m_reconciling = false;
+        // busy never went up, but let whoever waits for the initial fetch know it's done
+        emit busyChanged();
+        return;
+    }
     m_tags->addTags(tags);
 
     m_busy = false;
     emit busyChanged();
 }
 
+void TagsManager::reconcileTags(const QList<Tag *> &liveTags)
+{
+    QList<Tag*> addedTags;
+    QSet<Tag*> seenTags;
+    foreach (Tag *liveTag, liveTags) {
+        Tag *existingTag = m_tags->findTag(liveTag->thingId(), liveTag->ruleId(), liveTag->tagId());
+        if (existingTag) {
+            existingTag->setValue(liveTag->value());
+            seenTags.insert(existingTag);
+            delete liveTag;
+        } else {
+            addedTags.append(liveTag);
+        }
+    }
+
+    QList<Tag*> removedTags;
+    for (int i = 0; i < m_tags->rowCount(); i++) {
+        if (!seenTags.contains(m_tags->get(i))) {
+            removedTags.append(m_tags->get(i));
+        }
+    }
+    foreach (Tag *tag, removedTags) {
+        m_tags->removeTag(tag);
+    }
+    m_tags->addTags(addedTags);
+    qCDebug(dcTags()) << "Reconciled tags with server:" << addedTags.count() << "added," << removedTags.count() << "removed";
+}
+
 void TagsManager::addTagResponse(int commandId, const QVariantMap &params)
 {
     qCDebug(dcTags()) << "AddTag reply" << commandId << params;
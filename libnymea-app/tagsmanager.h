@@ -56,6 +56,10 @@ public:
     void clear();
     bool busy() const;
 
+    // See ThingManager::loadSnapshot()
+    void loadSnapshot(const QVariantList &tags);
+    QVariantList snapshotTags() const;
+
     Tags* tags() const;
 
     Q_INVOKABLE int tagThing(const QString &thingId, const QString &tagId, const QString &value);
@@ -69,18 +73,23 @@ signals:
     void removeTagReply(int commandId, TagError error);
 
 private slots:
-    void handleTagsNotification(const QVariantMap &params);
     void getTagsResponse(int commandId, const QVariantMap &params);
     void addTagResponse(int commandId, const QVariantMap &params);
     void removeTagResponse(int commandId, const QVariantMap &params);
 
 private:
+    void tagAddedNotification(const QJsonObject &params);
+    void tagRemovedNotification(const QJsonObject &params);
+    void tagValueChangedNotification(const QJsonObject &params);
+
     Tag *unpackTag(const QVariantMap &tagMap);
+    void reconcileTags(const QList<Tag*> &liveTags);
 
     JsonRpcClient *m_jsonClient = nullptr;
 
     Tags *m_tags = nullptr;
     bool m_busy = true;
+    bool m_reconciling = false;
 };
 
 #endif // TAGSMANAGER_H
@@ -15,14 +15,12 @@ void TagWatcher::setTags(Tags *tags)
 {
     if (m_tags != tags) {
         if (m_tags) {
-            disconnect(m_tags, &Tags::countChanged, this, &TagWatcher::update);
+            m_tags->unsubscribe(this);
         }
         m_tags = tags;
         emit tagsChanged();
 
-        if (m_tags) {
-            connect(m_tags, &Tags::countChanged, this, &TagWatcher::update);
-        }
+        subscribe();
         update();
     }
 }
@@ -65,6 +63,7 @@ void TagWatcher::setTagId(const QString &tagId)
     if (m_tagId != tagId) {
         m_tagId = tagId;
         emit tagIdChanged();
+        subscribe();
         update();
     }
 }
@@ -92,23 +91,19 @@ void TagWatcher::update()
         return;
     }
 
-    Tag *tag = nullptr;
-    for (int i = 0; i < m_tags->rowCount(); i++) {
-        Tag *t = m_tags->get(i);
-        if (t->tagId() != m_tagId) {
-            continue;
-        }
-        if (!m_thingId.isNull() && t->thingId() != m_thingId) {
-            continue;
-        }
-        if (!m_ruleId.isNull() && t->ruleId() != m_ruleId) {
-            continue;
-        }
-        tag = t;
-        break;
-    }
+    updateTag(m_tags->findTag(m_thingId, m_ruleId, m_tagId));
+}
 
-    updateTag(tag);
+void TagWatcher::subscribe()
+{
+    if (!m_tags) {
+        return;
+    }
+    // Only wake up for our own tag id instead of every change in the whole tags list
+    m_tags->unsubscribe(this);
+    if (!m_tagId.isEmpty()) {
+        m_tags->subscribe(m_tagId, this, [this](Tag *) { update(); });
+    }
 }
 
 void TagWatcher::updateTag(Tag *tag)
@@ -43,6 +43,8 @@ private slots:
     void updateTag(Tag *tag);
 
 private:
+    void subscribe();
+
     Tags* m_tags = nullptr;
     QUuid m_thingId;
     QUuid m_ruleId;
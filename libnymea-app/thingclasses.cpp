@@ -105,6 +105,36 @@ void ThingClasses::addThingClass(ThingClass *thingClass)
     emit countChanged();
 }
 
+void ThingClasses::updateThingClasses(const QList<ThingClass *> &thingClasses)
+{
+    QHash<QUuid, ThingClass*> updated;
+    foreach (ThingClass *thingClass, thingClasses) {
+        updated.insert(thingClass->id(), thingClass);
+    }
+
+    // Things may still point to the old objects, so they are only deleted later
+    for (int i = m_thingClasses.count() - 1; i >= 0; i--) {
+        if (!updated.contains(m_thingClasses.at(i)->id())) {
+            beginRemoveRows(QModelIndex(), i, i);
+            m_thingClasses.takeAt(i)->deleteLater();
+            endRemoveRows();
+        }
+    }
+    for (int i = 0; i < m_thingClasses.count(); i++) {
+        ThingClass *thingClass = updated.take(m_thingClasses.at(i)->id());
+        thingClass->setParent(this);
+        m_thingClasses.at(i)->deleteLater();
+        m_thingClasses[i] = thingClass;
+        emit dataChanged(index(i), index(i));
+    }
+    foreach (ThingClass *thingClass, thingClasses) {
+        if (updated.contains(thingClass->id())) {
+            addThingClass(thingClass);
+        }
+    }
+    emit countChanged();
+}
+
 void ThingClasses::clearModel()
 {
     beginResetModel();
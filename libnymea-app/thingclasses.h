@@ -62,6 +62,8 @@ public:
     Q_INVOKABLE ThingClass *getThingClass(QUuid thingClassId) const;
 
     void addThingClass(ThingClass *thingClass);
+    // Replaces classes with the same id, removes vanished ones and appends new ones
+    void updateThingClasses(const QList<ThingClass*> &thingClasses);
 
     void clearModel();
 
@@ -31,6 +31,7 @@
 #include "thingdiscovery.h"
 
 #include "engine.h"
+#include "logging.h"
 
 #include <QMetaEnum>
 #include <QJsonDocument>
@@ -181,7 +182,7 @@ int ThingDiscovery::discoverThingsInternal(const QUuid &thingClassId, const QVar
 void ThingDiscovery::discoverThingsResponse(int commandId, const QVariantMap &params)
 {
     qCInfo(dcThingManager) << "Discovery response received for command" << commandId;
-    qCDebug(dcThingManager()) << "Discovery response data:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcThingManager()) << "Discovery response data:" << LogPayload(params);
     QVariantList descriptors = params.value("thingDescriptors").toList();
     foreach (const QVariant &descriptorVariant, descriptors) {
         if (!contains(descriptorVariant.toMap().value("id").toUuid())) {
@@ -46,27 +46,33 @@ ThingGroup::ThingGroup(ThingManager *thingManager, ThingClass *thingClass, Thing
         State *state = new State(id(), st->id(), QVariant(), this);
         qDebug() << "Adding state" << st->name() << st->minValue() << st->maxValue();
         states->addState(state);
+
+        Aggregate aggregate;
+        aggregate.state = state;
+        QString type = st->type().toLower();
+        aggregate.integral = type == "int" || type == "uint";
+        if (type == "bool") {
+            aggregate.aggregation = AggregationAny;
+        } else if (type == "int") {
+            aggregate.aggregation = AggregationAverage;
+        } else if (type == "qcolor") {
+            aggregate.aggregation = AggregationFirst;
+        }
+        m_aggregates.append(aggregate);
     }
     setStates(states);
-    syncStates();
     setName(thingClass->displayName());
 
-    connect(things, &ThingsProxy::dataChanged, this, [this](const QModelIndex &/*topLeft*/, const QModelIndex &/*bottomRight*/, const QVector<int> &/*roles*/){
-        syncStates();
-    });
+    // Aggregates are updated from the member states that change. Only a change in members needs a full sync.
+    syncMembers();
+    connect(things, &ThingsProxy::rowsInserted, this, &ThingGroup::syncMembers);
+    connect(things, &ThingsProxy::rowsRemoved, this, &ThingGroup::syncMembers);
+    connect(things, &ThingsProxy::modelReset, this, &ThingGroup::syncMembers);
+    connect(things, &ThingsProxy::layoutChanged, this, &ThingGroup::syncMembers);
 
-    connect(m_thingManager, &ThingManager::executeActionReply, this, [this](int commandId, Thing::ThingError error, const QString &displayMessage){
-        // This should maybe check the params and create a sensible group result instead of just forwarding the result of the last reply
-        qDebug() << "action reply:" << commandId;
-        foreach (int id, m_pendingGroupActions.keys()) {
-            if (m_pendingGroupActions.value(id).contains(commandId)) {
-                m_pendingGroupActions[id].removeAll(commandId);
-                if (m_pendingGroupActions[id].isEmpty()) {
-                    m_pendingGroupActions.remove(id);
-                    emit executeActionReply(id, error, displayMessage);
-                }
-                return;
-            }
+    connect(m_thingManager, &ThingManager::executeActionsReply, this, [this](int batchId, Thing::ThingError error, const QString &displayMessage){
+        if (m_pendingGroupActions.remove(batchId)) {
+            emit executeActionReply(batchId, error, displayMessage);
         }
     });
 
@@ -74,100 +80,310 @@ ThingGroup::ThingGroup(ThingManager *thingManager, ThingClass *thingClass, Thing
 
 int ThingGroup::executeAction(const QString &actionName, const QVariantList &params)
 {
-    QList<int> pendingIds;
-
     ActionType *groupActionType = m_thingClass->actionTypes()->findByName(actionName);
     if (!groupActionType) {
         qWarning() << "Group has no action" << actionName;
         return -1;
     }
 
-    qDebug() << "Execute action for group:" << this;
+    qCDebug(dcThingManager()) << "Execute action for group:" << this << params;
+
+    // Members mostly share a few thing classes, so the action and params are mapped once per class
+    QHash<ThingClass*, ThingManager::BatchAction> mappedActions;
+    QList<ThingManager::BatchAction> actions;
     for (int i = 0; i < m_things->rowCount(); i++) {
         Thing *thing = m_things->get(i);
         if (thing->setupStatus() != Thing::ThingSetupStatusComplete) {
             continue;
         }
-        ActionType *actionType = thing->thingClass()->actionTypes()->findByName(actionName);
-        if (!actionType) {
+
+        QHash<ThingClass*, ThingManager::BatchAction>::iterator it = mappedActions.find(thing->thingClass());
+        if (it == mappedActions.end()) {
+            it = mappedActions.insert(thing->thingClass(), mapAction(thing->thingClass(), groupActionType, params));
+        }
+        if (it->actionTypeId.isNull()) {
             qWarning() << "Cannot send action to thing" << thing->name() << "because according action can't be found";
             continue;
         }
 
+        ThingManager::BatchAction action = it.value();
+        action.thingId = thing->id();
+        actions.append(action);
+    }
 
-        QVariantList finalParams;
-        foreach (const QVariant &paramVariant, params) {
-            QString paramName = paramVariant.toMap().value("paramName").toString();
-            ParamType *groupParamType = groupActionType->paramTypes()->findByName(paramName);
-            if (!groupParamType) {
-                qWarning() << "Not adding param" << paramName << "to action" << actionName << "because group action param can't be found";
-                continue;
-            }
-            ParamType *paramType = actionType->paramTypes()->findByName(paramName);
-            if (!paramType) {
-                qWarning() << "Not adding param" << paramName << "to action" << actionName << "because according action params can't be found";
-                continue;
-            }
+    int batchId = m_thingManager->executeActions(actions);
+    m_pendingGroupActions.insert(batchId);
+    return batchId;
+}
 
-            QVariantMap finalParam;
-            finalParam.insert("paramTypeId", paramType->id());
-            finalParam.insert("value", mapValue(paramVariant.toMap().value("value"), groupParamType, paramType));
-            finalParams.append(finalParam);
+ThingGroup::Aggregation ThingGroup::aggregation(const QString &stateName) const
+{
+    int index = aggregateIndex(stateName);
+    return index < 0 ? AggregationNone : m_aggregates.at(index).aggregation;
+}
+
+bool ThingGroup::setAggregation(const QString &stateName, ThingGroup::Aggregation aggregation)
+{
+    int index = aggregateIndex(stateName);
+    if (index < 0) {
+        qWarning() << "Group has no state" << stateName;
+        return false;
+    }
+
+    QString type = m_thingClass->stateTypes()->get(index)->type().toLower();
+    bool numeric = type == "int" || type == "uint" || type == "double";
+    bool supported = aggregation == AggregationNone || aggregation == AggregationFirst;
+    supported |= type == "bool" && (aggregation == AggregationAny || aggregation == AggregationAll);
+    supported |= numeric && (aggregation == AggregationAverage || aggregation == AggregationMin || aggregation == AggregationMax);
+    if (!supported) {
+        qWarning() << "Aggregation" << aggregation << "not supported for" << type << "state" << stateName;
+        return false;
+    }
+
+    Aggregate &aggregate = m_aggregates[index];
+    if (aggregate.aggregation == aggregation) {
+        return true;
+    }
+    aggregate.aggregation = aggregation;
+    aggregate.count = 0;
+    aggregate.trueCount = 0;
+    aggregate.sum = 0;
+    aggregate.values.clear();
+    foreach (const Member &member, m_members) {
+        if (member.states.at(index)) {
+            contribute(index, member.active.at(index), member.values.at(index), 1);
         }
+    }
+    updateAggregate(index);
+    return true;
+}
 
-        qDebug() << "Initial params" << params;
-        qDebug() << "Executing" << thing->id() << actionType->name() << finalParams;
-        int id = m_thingManager->executeAction(thing->id(), actionType->id(), finalParams);
-        pendingIds.append(id);
+int ThingGroup::aggregateIndex(const QString &stateName) const
+{
+    for (int i = 0; i < m_aggregates.count(); i++) {
+        if (m_thingClass->stateTypes()->get(i)->name() == stateName) {
+            return i;
+        }
     }
-    m_pendingGroupActions.insert(++m_idCounter, pendingIds);
-    return m_idCounter;
+    return -1;
 }
 
-void ThingGroup::syncStates()
+ThingManager::BatchAction ThingGroup::mapAction(ThingClass *thingClass, ActionType *groupActionType, const QVariantList &params) const
 {
-    for (int i = 0; i < thingClass()->stateTypes()->rowCount(); i++) {
-        StateType *stateType = thingClass()->stateTypes()->get(i);
-        State *state = states()->getState(stateType->id());
-
-        qDebug() << "syncing state" << stateType->name() << stateType->type();
-
-        QVariant value;
-        int count = 0;
-        for (int j = 0; j < m_things->rowCount(); j++) {
-            Thing *d = m_things->get(j);
-            // Skip things that don't have the required state
-            StateType *ds = d->thingClass()->stateTypes()->findByName(stateType->name());
-            if (!ds) {
-                continue;
-            }
+    ThingManager::BatchAction action;
+    ActionType *actionType = thingClass->actionTypes()->findByName(groupActionType->name());
+    if (!actionType) {
+        return action;
+    }
+    action.actionTypeId = actionType->id();
 
-            // Skip disconnected things
-            StateType *connectedStateType = d->thingClass()->stateTypes()->findByName("connected");
-            if (connectedStateType) {
-                if (!d->stateValue(connectedStateType->id()).toBool()) {
-                    continue;
-                }
-            }
+    foreach (const QVariant &paramVariant, params) {
+        QString paramName = paramVariant.toMap().value("paramName").toString();
+        ParamType *groupParamType = groupActionType->paramTypes()->findByName(paramName);
+        if (!groupParamType) {
+            qWarning() << "Not adding param" << paramName << "to action" << actionType->name() << "because group action param can't be found";
+            continue;
+        }
+        ParamType *paramType = actionType->paramTypes()->findByName(paramName);
+        if (!paramType) {
+            qWarning() << "Not adding param" << paramName << "to action" << actionType->name() << "because according action params can't be found";
+            continue;
+        }
 
-            if (stateType->type().toLower() == "bool") {
-                if (d->stateValue(ds->id()).toBool()) {
-                    value = true;
-                    break;
-                }
-            } else if (stateType->type().toLower() == "int") {
-                value = value.toInt() + d->stateValue(ds->id()).toInt();
-                count++;
-            } else if (stateType->type().toLower() == "qcolor") {
-                value = d->stateValue(ds->id());
-                break;
-            }
+        QVariantMap finalParam;
+        finalParam.insert("paramTypeId", paramType->id());
+        finalParam.insert("value", mapValue(paramVariant.toMap().value("value"), groupParamType, paramType));
+        action.params.append(finalParam);
+    }
+    return action;
+}
+
+void ThingGroup::syncMembers()
+{
+    QSet<Thing*> things;
+    for (int i = 0; i < m_things->rowCount(); i++) {
+        things.insert(m_things->get(i));
+    }
+
+    foreach (Thing *thing, m_members.keys()) {
+        if (!things.contains(thing)) {
+            removeMember(thing);
         }
+    }
+    foreach (Thing *thing, things) {
+        if (!m_members.contains(thing)) {
+            addMember(thing);
+        }
+    }
+
+    for (int i = 0; i < m_aggregates.count(); i++) {
+        updateAggregate(i);
+    }
+}
+
+void ThingGroup::addMember(Thing *thing)
+{
+    Member &member = m_members[thing];
+
+    StateType *connectedStateType = thing->thingClass()->stateTypes()->findByName("connected");
+    if (connectedStateType) {
+        member.connectedState = thing->states()->getState(connectedStateType->id());
+    }
+    if (member.connectedState) {
+        member.connections.append(connect(member.connectedState, &State::valueChanged, this, [this, thing](){
+            updateMember(thing);
+        }));
+    }
+
+    member.states.resize(m_aggregates.count());
+    member.active.resize(m_aggregates.count());
+    member.values.resize(m_aggregates.count());
+    for (int i = 0; i < m_aggregates.count(); i++) {
+        StateType *groupStateType = m_thingClass->stateTypes()->get(i);
+        StateType *stateType = thing->thingClass()->stateTypes()->findByName(groupStateType->name());
+        if (!stateType) {
+            continue;
+        }
+        State *state = thing->states()->getState(stateType->id());
+        if (!state) {
+            continue;
+        }
+        member.states[i] = state;
+        member.connections.append(connect(state, &State::valueChanged, this, [this, thing, i](){
+            updateMember(thing, i);
+        }));
+
+        member.active[i] = !member.connectedState || member.connectedState->value().toBool();
+        member.values[i] = member.active[i] ? state->value() : QVariant();
+        contribute(i, member.active[i], member.values[i], 1);
+    }
+
+    // The states objects of a thing may be replaced
+    member.connections.append(connect(thing, &Thing::statesChanged, this, [this, thing](){
+        removeMember(thing);
+        addMember(thing);
+        for (int i = 0; i < m_aggregates.count(); i++) {
+            updateAggregate(i);
+        }
+    }));
+}
+
+void ThingGroup::removeMember(Thing *thing)
+{
+    // Only uses what was stored for the member, the thing might be gone already
+    Member member = m_members.take(thing);
+    foreach (const QMetaObject::Connection &connection, member.connections) {
+        disconnect(connection);
+    }
+    for (int i = 0; i < member.states.count(); i++) {
+        contribute(i, member.active.at(i), member.values.at(i), -1);
+    }
+}
+
+void ThingGroup::updateMember(Thing *thing, int index)
+{
+    QHash<Thing*, Member>::iterator it = m_members.find(thing);
+    if (it == m_members.end()) {
+        return;
+    }
+    Member &member = it.value();
+
+    int from = index < 0 ? 0 : index;
+    int to = index < 0 ? m_aggregates.count() : index + 1;
+    for (int i = from; i < to; i++) {
+        if (!member.states.at(i)) {
+            continue;
+        }
+        // Skip disconnected things
+        bool active = !member.connectedState || member.connectedState->value().toBool();
+        QVariant value = active ? member.states.at(i)->value() : QVariant();
+        if (active == member.active.at(i) && value == member.values.at(i)) {
+            continue;
+        }
+        contribute(i, member.active.at(i), member.values.at(i), -1);
+        contribute(i, active, value, 1);
+        member.active[i] = active;
+        member.values[i] = value;
+        updateAggregate(i);
+    }
+}
+
+void ThingGroup::contribute(int index, bool active, const QVariant &value, int sign)
+{
+    if (!active || !value.isValid()) {
+        return;
+    }
+    Aggregate &aggregate = m_aggregates[index];
+    aggregate.count += sign;
+    switch (aggregate.aggregation) {
+    case AggregationAny:
+    case AggregationAll:
+        if (value.toBool()) {
+            aggregate.trueCount += sign;
+        }
+        break;
+    case AggregationAverage:
+        aggregate.sum += sign * value.toDouble();
+        break;
+    case AggregationMin:
+    case AggregationMax: {
+        double key = value.toDouble();
+        int count = aggregate.values.value(key) + sign;
         if (count > 0) {
-            value = value.toDouble() / count;
+            aggregate.values.insert(key, count);
+        } else {
+            aggregate.values.remove(key);
+        }
+        break;
+    }
+    case AggregationFirst:
+    case AggregationNone:
+        break;
+    }
+}
+
+void ThingGroup::updateAggregate(int index)
+{
+    const Aggregate &aggregate = m_aggregates.at(index);
+    QVariant value;
+    switch (aggregate.aggregation) {
+    case AggregationAny:
+        if (aggregate.trueCount > 0) {
+            value = true;
+        }
+        break;
+    case AggregationAll:
+        if (aggregate.count > 0) {
+            value = aggregate.trueCount == aggregate.count;
+        }
+        break;
+    case AggregationAverage:
+        if (aggregate.count > 0) {
+            value = aggregate.sum / aggregate.count;
+        }
+        break;
+    case AggregationMin:
+    case AggregationMax:
+        if (!aggregate.values.isEmpty()) {
+            double extreme = aggregate.aggregation == AggregationMin ? aggregate.values.firstKey() : aggregate.values.lastKey();
+            value = aggregate.integral ? QVariant(qRound64(extreme)) : QVariant(extreme);
+        }
+        break;
+    case AggregationFirst:
+        // Depends on the order of the members, look it up in the proxy
+        for (int i = 0; i < m_things->rowCount(); i++) {
+            QHash<Thing*, Member>::const_iterator it = m_members.constFind(m_things->get(i));
+            if (it != m_members.constEnd() && it->states.at(index) && it->active.at(index)) {
+                value = it->values.at(index);
+                break;
+            }
         }
-        state->setValue(value);
+        break;
+    case AggregationNone:
+        break;
     }
+    // Only emits if the value actually changed
+    aggregate.state->setValue(value);
 }
 
 QVariant ThingGroup::mapValue(const QVariant &value, ParamType *fromParamType, ParamType *toParamType) const
@@ -32,31 +32,85 @@
 #define THINGGROUP_H
 
 #include <QObject>
+#include <QMap>
+#include <QSet>
 
 #include "types/thing.h"
+#include "thingmanager.h"
 
 class ThingsProxy;
-class ThingManager;
 class ParamType;
+class ActionType;
 
 class ThingGroup : public Thing
 {
     Q_OBJECT
 public:
+    // How the member values make up a group state. Disconnected members and members without a
+    // value for the state are left out.
+    enum Aggregation {
+        AggregationNone,
+        AggregationAny,     // bool: true if any member is true, unset otherwise
+        AggregationAll,     // bool: true if all members are true, false otherwise
+        AggregationAverage, // int, double: average of all members
+        AggregationMin,     // int, double: smallest value of all members
+        AggregationMax,     // int, double: largest value of all members
+        AggregationFirst    // value of the first member
+    };
+    Q_ENUM(Aggregation)
+
     explicit ThingGroup(ThingManager *thingManager, ThingClass *thingClass, ThingsProxy *things, QObject *parent = nullptr);
 
     Q_INVOKABLE int executeAction(const QString &actionName, const QVariantList &params) override;
 
+    // Defaults to AggregationAny for bool states, AggregationAverage for int states and
+    // AggregationFirst for colors
+    Q_INVOKABLE ThingGroup::Aggregation aggregation(const QString &stateName) const;
+    Q_INVOKABLE bool setAggregation(const QString &stateName, ThingGroup::Aggregation aggregation);
+
 private:
-    void syncStates();
+    struct Aggregate {
+        State *state = nullptr;
+        Aggregation aggregation = AggregationNone;
+        bool integral = false;
+        // Members contributing a value
+        int count = 0;
+        int trueCount = 0;
+        double sum = 0;
+        // Min and max keep all values, counted by value, as a delta can't undo a removed extreme
+        QMap<double, int> values;
+    };
+    // The states of a member, resolved once when it joins the group, and what it contributes to each aggregate
+    struct Member {
+        State *connectedState = nullptr;
+        QVector<State*> states;
+        QVector<bool> active;
+        QVector<QVariant> values;
+        QList<QMetaObject::Connection> connections;
+    };
 
+    void syncMembers();
+    void addMember(Thing *thing);
+    void removeMember(Thing *thing);
+    // Updates what the member contributes to the aggregate at index, or to all of them for -1
+    void updateMember(Thing *thing, int index = -1);
+    void contribute(int index, bool active, const QVariant &value, int sign);
+    void updateAggregate(int index);
+    int aggregateIndex(const QString &stateName) const;
+
+    // Maps the group action and its params to the according action of the given thing class.
+    // The actionTypeId is null if the thing class doesn't have it.
+    ThingManager::BatchAction mapAction(ThingClass *thingClass, ActionType *groupActionType, const QVariantList &params) const;
     QVariant mapValue(const QVariant &value, ParamType *fromParamType, ParamType *toParamType) const;
 
 private:    
     ThingsProxy* m_things = nullptr;
 
-    int m_idCounter = 0;
-    QHash<int, QList<int>> m_pendingGroupActions;
+    QVector<Aggregate> m_aggregates;
+    QHash<Thing*, Member> m_members;
+
+    // Batch ids of the actions executed on the members
+    QSet<int> m_pendingGroupActions;
 };
 
 #endif // THINGGROUP_H
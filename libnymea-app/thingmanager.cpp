@@ -40,10 +40,24 @@
 #include <QFile>
 #include <QStandardPaths>
 #include <QJsonDocument>
+#include <QJsonArray>
+#include <QSet>
 
 #include "logging.h"
 NYMEA_LOGGING_CATEGORY(dcThingManager, "ThingManager")
 
+static QByteArray thingData(QJsonObject thingObject)
+{
+    thingObject.remove("states");
+    return QJsonDocument(thingObject).toJson(QJsonDocument::Compact);
+}
+
+static QByteArray thingData(QVariantMap thingMap)
+{
+    thingMap.remove("states");
+    return QJsonDocument::fromVariant(thingMap).toJson(QJsonDocument::Compact);
+}
+
 ThingManager::ThingManager(JsonRpcClient* jsonclient, QObject *parent) :
     QObject(parent),
     m_vendors(new Vendors(this)),
@@ -53,11 +67,37 @@ ThingManager::ThingManager(JsonRpcClient* jsonclient, QObject *parent) :
     m_ioConnections(new IOConnections(this)),
     m_jsonClient(jsonclient)
 {
-    m_jsonClient->registerNotificationHandler(this, "Integrations", "notificationReceived");
+    m_jsonClient->registerNotificationCallback(this, "Integrations.StateChanged", &ThingManager::stateChangedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.ThingAdded", &ThingManager::thingAddedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.ThingRemoved", &ThingManager::thingRemovedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.ThingChanged", &ThingManager::thingChangedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.ThingSettingChanged", &ThingManager::thingSettingChangedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.EventTriggered", &ThingManager::eventTriggeredNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.IOConnectionAdded", &ThingManager::ioConnectionAddedNotification);
+    m_jsonClient->registerNotificationCallback(this, "Integrations.IOConnectionRemoved", &ThingManager::ioConnectionRemovedNotification);
+
+    m_stateChangeTimer.setSingleShot(true);
+    connect(&m_stateChangeTimer, &QTimer::timeout, this, &ThingManager::flushStateChanges);
 }
 
 void ThingManager::clear()
 {
+    m_stateChangeTimer.stop();
+    m_pendingStateChanges.clear();
+    m_pendingStateChangeIndex.clear();
+    m_reconciling = false;
+    m_thingClassesReceived = false;
+    m_thingsResponsePending = false;
+    m_pendingThingsResponse.clear();
+    // Nothing will answer those anymore
+    QList<int> droppedBatches = m_actionBatches.keys();
+    m_actionBatches.clear();
+    m_batchedActions.clear();
+    foreach (int batchId, droppedBatches) {
+        emit executeActionsReply(batchId, Thing::ThingErrorHardwareNotAvailable, QString());
+    }
+    m_thingClassesData.clear();
+    m_thingData.clear();
     m_things->clearModel();
     m_thingClasses->clearModel();
     m_vendors->clearModel();
@@ -69,10 +109,83 @@ void ThingManager::init()
 {
     m_connectionBenchmark = QDateTime::currentDateTime();
 
-    m_fetchingData = true;
-    emit fetchingDataChanged();
+    if (!m_reconciling) {
+        m_fetchingData = true;
+        emit fetchingDataChanged();
+    }
 
+    // All requests are sent in one go. Unpacking things requires the thing classes, so a
+    // GetThings response arriving before the GetThingClasses one is held back until then.
+    m_thingClassesReceived = false;
+    m_thingsResponsePending = false;
+    m_pendingThingsResponse.clear();
     m_jsonClient->sendCommand("Integrations.GetThingClasses", this, "getThingClassesResponse");
+    m_jsonClient->sendCommand("Integrations.GetThings", this, "getThingsResponse");
+    m_jsonClient->sendCommand("Integrations.GetIOConnections", this, "getIOConnectionsResponse");
+    m_jsonClient->sendCommand("Integrations.GetPlugins", this, "getPluginsResponse");
+    m_jsonClient->sendCommand("Integrations.GetVendors", this, "getVendorsResponse");
+}
+
+void ThingManager::loadSnapshot(const QByteArray &thingClasses, const QList<QByteArray> &things, const QHash<QUuid, QVariantList> &thingStates)
+{
+    QDateTime start = QDateTime::currentDateTime();
+    foreach (const QJsonValue &thingClassValue, QJsonDocument::fromJson(thingClasses).array()) {
+        m_thingClasses->addThingClass(unpackThingClass(thingClassValue.toObject().toVariantMap()));
+    }
+    m_thingClassesData = thingClasses;
+
+    QList<Thing*> newThings;
+    foreach (const QByteArray &data, things) {
+        Thing *thing = unpackThing(this, QJsonDocument::fromJson(data).object().toVariantMap(), m_thingClasses);
+        if (!thing) {
+            continue;
+        }
+        unpackStateValues(thing, thingStates.value(thing->id()));
+        m_thingData.insert(thing->id(), data);
+        newThings.append(thing);
+    }
+    m_things->addThings(newThings);
+    qCInfo(dcThingManager()) << "Loaded" << newThings.count() << "things from snapshot in" << start.msecsTo(QDateTime::currentDateTime()) << "ms";
+
+    m_reconciling = true;
+    m_fetchingData = false;
+    emit fetchingDataChanged();
+}
+
+QByteArray ThingManager::snapshotThingClasses() const
+{
+    return m_thingClassesData;
+}
+
+QList<QByteArray> ThingManager::snapshotThings() const
+{
+    QList<QByteArray> ret;
+    foreach (Thing *thing, m_things->devices()) {
+        if (m_thingData.contains(thing->id())) {
+            ret.append(m_thingData.value(thing->id()));
+        }
+    }
+    return ret;
+}
+
+QHash<QUuid, QVariantList> ThingManager::snapshotThingStates() const
+{
+    QHash<QUuid, QVariantList> ret;
+    foreach (Thing *thing, m_things->devices()) {
+        if (!m_thingData.contains(thing->id())) {
+            continue;
+        }
+        QVariantList states;
+        for (int i = 0; i < thing->states()->rowCount(); i++) {
+            State *state = thing->states()->get(i);
+            QVariantMap stateMap;
+            stateMap.insert("stateTypeId", state->stateTypeId().toString());
+            stateMap.insert("value", state->value());
+            states.append(stateMap);
+        }
+        ret.insert(thing->id(), states);
+    }
+    return ret;
 }
 
 Vendors *ThingManager::vendors() const
@@ -105,6 +218,39 @@ bool ThingManager::fetchingData() const
     return m_fetchingData;
 }
 
+int ThingManager::stateChangeCoalescingInterval() const
+{
+    return m_stateChangeCoalescingInterval;
+}
+
+void ThingManager::setStateChangeCoalescingInterval(int stateChangeCoalescingInterval)
+{
+    stateChangeCoalescingInterval = qMax(-1, stateChangeCoalescingInterval);
+    if (m_stateChangeCoalescingInterval == stateChangeCoalescingInterval) {
+        return;
+    }
+    m_stateChangeCoalescingInterval = stateChangeCoalescingInterval;
+    emit stateChangeCoalescingIntervalChanged();
+
+    if (m_stateChangeCoalescingInterval < 0) {
+        // Don't leave anything behind when switching back to immediate delivery
+        m_stateChangeTimer.stop();
+        flushStateChanges();
+    } else {
+        m_stateChangeTimer.setInterval(m_stateChangeCoalescingInterval);
+    }
+}
+
+int ThingManager::receivedStateChanges() const
+{
+    return m_receivedStateChanges;
+}
+
+int ThingManager::mergedStateChanges() const
+{
+    return m_mergedStateChanges;
+}
+
 int ThingManager::addThing(const QUuid &thingClassId, const QString &name, const QVariantList &thingParams)
 {
     QVariantMap params;
@@ -114,121 +260,194 @@ int ThingManager::addThing(const QUuid &thingClassId, const QString &name, const
     return m_jsonClient->sendCommand("Integrations.AddThing", params, this, "addThingResponse");
 }
 
-void ThingManager::notificationReceived(const QVariantMap &data)
+void ThingManager::stateChangedNotification(const QJsonObject &params)
 {
-    qCDebug(dcThingManager()) << "ThingManager notifications received:" << qUtf8Printable(QJsonDocument::fromVariant(data).toJson());
-    QString notification = data.value("notification").toString();
-    QVariantMap params = data.value("params").toMap();
-    if (notification == "Integrations.StateChanged") {
-        Thing *thing = m_things->getThing(params.value("thingId").toUuid());
-        if (!thing) {
-            if (!m_fetchingData) {
-                qCWarning(dcThingManager()) << "Thing state change notification received for an unknown thing";
-            }
-            return;
-        }
-        QUuid stateTypeId = params.value("stateTypeId").toUuid();
-        QVariant value = params.value("value");
-        State *state = thing->state(stateTypeId);
-        state->setValue(value);
-        if (params.contains("minValue")) {
-            state->setMinValue(params.value("minValue"));
-        }
-        if (params.contains("maxValue")) {
-            state->setMaxValue(params.value("maxValue"));
-        }
-        if (params.contains("possibleValues")) {
-            state->setPossibleValues(params.value("possibleValues").toList());
-        }
-        emit thingStateChanged(thing->id(), stateTypeId, value);
-    } else if (notification == "Integrations.ThingAdded") {
-        Thing *thing = unpackThing(this, data.value("params").toMap().value("thing").toMap(), m_thingClasses);
-        if (!thing) {
-            qWarning() << "Cannot parse thing json:" << data;
-            return;
+    if (m_stateChangeCoalescingInterval < 0) {
+        applyStateChange(params);
+        return;
+    }
+
+    m_receivedStateChanges++;
+    QPair<QString, QString> key(params.value("thingId").toString(), params.value("stateTypeId").toString());
+    int pendingIndex = m_pendingStateChangeIndex.value(key, -1);
+    if (pendingIndex >= 0) {
+        // Merge instead of replacing so a minValue/maxValue/possibleValues update
+        // from an earlier notification isn't lost if the later one doesn't carry it.
+        QJsonObject &pending = m_pendingStateChanges[pendingIndex];
+        for (QJsonObject::const_iterator it = params.constBegin(); it != params.constEnd(); ++it) {
+            pending.insert(it.key(), it.value());
         }
-        ThingClass *thingClass = thingClasses()->getThingClass(thing->thingClassId());
-        if (!thingClass) {
-            qCWarning(dcThingManager()) << "Skipping invalid thing. Don't have a thing class for it";
-            delete thing;
-            return;
+        m_mergedStateChanges++;
+    } else {
+        m_pendingStateChangeIndex.insert(key, m_pendingStateChanges.count());
+        m_pendingStateChanges.append(params);
+    }
+
+    if (!m_stateChangeTimer.isActive()) {
+        m_stateChangeTimer.start();
+    }
+}
+
+void ThingManager::flushStateChanges()
+{
+    if (m_pendingStateChanges.isEmpty()) {
+        return;
+    }
+    QVector<QJsonObject> pendingStateChanges = m_pendingStateChanges;
+    m_pendingStateChanges.clear();
+    m_pendingStateChangeIndex.clear();
+
+    m_things->beginStateChangeBatch();
+    foreach (const QJsonObject &params, pendingStateChanges) {
+        applyStateChange(params);
+    }
+    m_things->endStateChangeBatch();
+
+    qCDebug(dcThingManager()) << "Delivered" << pendingStateChanges.count() << "coalesced state changes. Total received:" << m_receivedStateChanges << "merged:" << m_mergedStateChanges;
+    emit stateChangeStatisticsChanged();
+}
+
+void ThingManager::applyStateChange(const QJsonObject &params)
+{
+    // This is by far the most frequent notification. Only convert what's needed, straight from the json object.
+    QUuid thingId = QUuid(params.value("thingId").toString());
+    Thing *thing = m_things->getThing(thingId);
+    if (!thing) {
+        if (!m_fetchingData) {
+            qCWarning(dcThingManager()) << "Thing state change notification received for an unknown thing";
         }
-        qCInfo(dcThingManager()) << "A new thing has been added" << thing->name() << thing->id().toString();
-        m_things->addThing(thing);
-        emit thingAdded(thing);
-    } else if (notification == "Integrations.ThingRemoved") {
-        QUuid thingId = data.value("params").toMap().value("thingId").toUuid();
+        return;
+    }
+    QUuid stateTypeId = QUuid(params.value("stateTypeId").toString());
+    QVariant value = params.value("value").toVariant();
+    qCDebug(dcThingManager()) << "State changed:" << thing->name() << stateTypeId.toString() << value;
+    State *state = thing->state(stateTypeId);
+    if (!state) {
+        qCWarning(dcThingManager()) << "Thing" << thing->name() << "does not have a state" << stateTypeId.toString();
+        return;
+    }
+    state->setValue(value);
+    if (params.contains("minValue")) {
+        state->setMinValue(params.value("minValue").toVariant());
+    }
+    if (params.contains("maxValue")) {
+        state->setMaxValue(params.value("maxValue").toVariant());
+    }
+    if (params.contains("possibleValues")) {
+        state->setPossibleValues(params.value("possibleValues").toArray().toVariantList());
+    }
+    emit thingStateChanged(thing->id(), stateTypeId, value);
+}
+
+void ThingManager::thingAddedNotification(const QJsonObject &params)
+{
+    QVariantMap thingMap = params.value("thing").toObject().toVariantMap();
+    Thing *thing = unpackThing(this, thingMap, m_thingClasses);
+    if (!thing) {
+        qWarning() << "Cannot parse thing json:" << thingMap;
+        return;
+    }
+    ThingClass *thingClass = thingClasses()->getThingClass(thing->thingClassId());
+    if (!thingClass) {
+        qCWarning(dcThingManager()) << "Skipping invalid thing. Don't have a thing class for it";
+        delete thing;
+        return;
+    }
+    qCInfo(dcThingManager()) << "A new thing has been added" << thing->name() << thing->id().toString();
+    m_thingData.insert(thing->id(), thingData(params.value("thing").toObject()));
+    m_things->addThing(thing);
+    emit thingAdded(thing);
+}
+
+void ThingManager::thingRemovedNotification(const QJsonObject &params)
+{
+    QUuid thingId = QUuid(params.value("thingId").toString());
 //        qDebug() << "JsonRpc: Notification: Thing removed" << thingId.toString();
-        Thing *thing = m_things->getThing(thingId);
-        if (!thing) {
-            qWarning() << "Received a ThingRemoved notification for a thing we don't know!";
-            return;
-        }
-        m_things->removeThing(thing);
-        emit thingRemoved(thing);
-        thing->deleteLater();
-    } else if (notification == "Integrations.ThingChanged") {
-        QUuid thingId = data.value("params").toMap().value("thing").toMap().value("id").toUuid();
-        qCDebug(dcThingManager()) << "Thing changed notification" << thingId << data.value("params").toMap();
-        Thing *oldThing = m_things->getThing(thingId);
-        if (!oldThing) {
-            qWarning() << "Received a thing changed notification for a thing we don't know";
-            return;
-        }
-        if (!unpackThing(this, data.value("params").toMap().value("thing").toMap(), m_thingClasses, oldThing)) {
-            qWarning() << "Error parsing thing changed notification" << data;
-            return;
-        }
-    } else if (notification == "Integrations.ThingSettingChanged") {
-        QUuid thingId = data.value("params").toMap().value("thingId").toUuid();
-        QString paramTypeId = data.value("params").toMap().value("paramTypeId").toString();
-        QVariant value = data.value("params").toMap().value("value");
+    Thing *thing = m_things->getThing(thingId);
+    if (!thing) {
+        qWarning() << "Received a ThingRemoved notification for a thing we don't know!";
+        return;
+    }
+    m_thingData.remove(thingId);
+    m_things->removeThing(thing);
+    emit thingRemoved(thing);
+    thing->deleteLater();
+}
+
+void ThingManager::thingChangedNotification(const QJsonObject &params)
+{
+    QVariantMap thingMap = params.value("thing").toObject().toVariantMap();
+    QUuid thingId = thingMap.value("id").toUuid();
+    qCDebug(dcThingManager()) << "Thing changed notification" << thingId << thingMap;
+    Thing *oldThing = m_things->getThing(thingId);
+    if (!oldThing) {
+        qWarning() << "Received a thing changed notification for a thing we don't know";
+        return;
+    }
+    if (!unpackThing(this, thingMap, m_thingClasses, oldThing)) {
+        qWarning() << "Error parsing thing changed notification" << thingMap;
+        return;
+    }
+    m_thingData.insert(thingId, thingData(params.value("thing").toObject()));
+}
+
+void ThingManager::thingSettingChangedNotification(const QJsonObject &params)
+{
+    QUuid thingId = QUuid(params.value("thingId").toString());
+    QString paramTypeId = params.value("paramTypeId").toString();
+    QVariant value = params.value("value").toVariant();
 //        qDebug() << "Thing settings changed notification for thing" << thingId << data.value("params").toMap().value("settings").toList();
-        Thing *thing = m_things->getThing(thingId);
-        if (!thing) {
-            qWarning() << "Thing settings changed notification for a thing we don't know" << thingId.toString();
-            return;
-        }
-        Param *p = thing->settings()->getParam(paramTypeId);
-        if (!p) {
-            qWarning() << "Thing" << thing->name() << thing->id().toString() << "does not have a setting of id" << paramTypeId;
-            return;
-        }
-        p->setValue(value);
-    } else if (notification == "Integrations.EventTriggered") {
-        QVariantMap event = data.value("params").toMap().value("event").toMap();
-        QUuid thingId = event.value("thingId").toUuid();
-        QUuid eventTypeId = event.value("eventTypeId").toUuid();
+    Thing *thing = m_things->getThing(thingId);
+    if (!thing) {
+        qWarning() << "Thing settings changed notification for a thing we don't know" << thingId.toString();
+        return;
+    }
+    Param *p = thing->settings()->getParam(paramTypeId);
+    if (!p) {
+        qWarning() << "Thing" << thing->name() << thing->id().toString() << "does not have a setting of id" << paramTypeId;
+        return;
+    }
+    p->setValue(value);
+}
 
-        Thing *thing = m_things->getThing(thingId);
-        if (!thing) {
-            if (!m_fetchingData) {
-                qCWarning(dcThingManager()) << "received an event from a thing we don't know..." << thingId << qUtf8Printable(QJsonDocument::fromVariant(data).toJson());
-            }
-            return;
-        }
-        qCDebug(dcThingManager) << "Event received" << thingId.toString() << eventTypeId.toString() << qUtf8Printable(QJsonDocument::fromVariant(event).toJson());
-        thing->eventTriggered(eventTypeId.toString(), event.value("params").toList());
-    } else if (notification == "Integrations.IOConnectionAdded") {
-        QVariantMap connectionMap = data.value("params").toMap().value("ioConnection").toMap();
-        QUuid id = connectionMap.value("id").toUuid();
-        QUuid inputThingId = connectionMap.value("inputThingId").toUuid();
-        QUuid inputStateTypeId = connectionMap.value("inputStateTypeId").toUuid();
-        QUuid outputThingId = connectionMap.value("outputThingId").toUuid();
-        QUuid outputStateTypeId = connectionMap.value("outputStateTypeId").toUuid();
-        bool inverted = connectionMap.value("inverted").toBool();
-        IOConnection *ioConnection = new IOConnection(id, inputThingId, inputStateTypeId, outputThingId, outputStateTypeId, inverted);
-        m_ioConnections->addIOConnection(ioConnection);
-    } else if (notification == "Integrations.IOConnectionRemoved") {
-        QUuid connectionId = data.value("params").toMap().value("ioConnectionId").toUuid();
-        if (!m_ioConnections->getIOConnection(connectionId)) {
-            qWarning() << "Received an IO connection removed event for an IO connection we don't know.";
-            return;
+void ThingManager::eventTriggeredNotification(const QJsonObject &params)
+{
+    QJsonObject event = params.value("event").toObject();
+    QUuid thingId = QUuid(event.value("thingId").toString());
+    QUuid eventTypeId = QUuid(event.value("eventTypeId").toString());
+
+    Thing *thing = m_things->getThing(thingId);
+    if (!thing) {
+        if (!m_fetchingData) {
+            qCWarning(dcThingManager()) << "received an event from a thing we don't know..." << thingId << LogPayload(params);
         }
-        m_ioConnections->removeIOConnection(connectionId);
-    } else {
-        qWarning() << "ThingManager unhandled thing notification received" << notification;
+        return;
     }
+    qCDebug(dcThingManager) << "Event received" << thingId.toString() << eventTypeId.toString() << LogPayload(event);
+    thing->eventTriggered(eventTypeId.toString(), event.value("params").toArray().toVariantList());
+}
+
+void ThingManager::ioConnectionAddedNotification(const QJsonObject &params)
+{
+    QVariantMap connectionMap = params.value("ioConnection").toObject().toVariantMap();
+    QUuid id = connectionMap.value("id").toUuid();
+    QUuid inputThingId = connectionMap.value("inputThingId").toUuid();
+    QUuid inputStateTypeId = connectionMap.value("inputStateTypeId").toUuid();
+    QUuid outputThingId = connectionMap.value("outputThingId").toUuid();
+    QUuid outputStateTypeId = connectionMap.value("outputStateTypeId").toUuid();
+    bool inverted = connectionMap.value("inverted").toBool();
+    IOConnection *ioConnection = new IOConnection(id, inputThingId, inputStateTypeId, outputThingId, outputStateTypeId, inverted);
+    m_ioConnections->addIOConnection(ioConnection);
+}
+
+void ThingManager::ioConnectionRemovedNotification(const QJsonObject &params)
+{
+    QUuid connectionId = QUuid(params.value("ioConnectionId").toString());
+    if (!m_ioConnections->getIOConnection(connectionId)) {
+        qWarning() << "Received an IO connection removed event for an IO connection we don't know.";
+        return;
+    }
+    m_ioConnections->removeIOConnection(connectionId);
 }
 
 void ThingManager::getVendorsResponse(int /*commandId*/, const QVariantMap &params)
@@ -246,15 +465,44 @@ void ThingManager::getVendorsResponse(int /*commandId*/, const QVariantMap &para
 
 void ThingManager::getThingClassesResponse(int /*commandId*/, const QVariantMap &params)
 {
-    qCDebug(dcThingManager) << "GetThingClasses response:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcThingManager) << "GetThingClasses response:" << LogPayload(params);
+    if (JsonRpcClient::isTimeout(params)) {
+        // Keep whatever the snapshot provided and ask again
+        qCWarning(dcThingManager()) << "Fetching thing classes timed out. Retrying.";
+        m_jsonClient->sendCommand("Integrations.GetThingClasses", this, "getThingClassesResponse");
+        return;
+    }
     if (params.keys().contains("thingClasses")) {
         QVariantList thingClassList = params.value("thingClasses").toList();
-        foreach (QVariant thingClassVariant, thingClassList) {
-            ThingClass *thingClass = unpackThingClass(thingClassVariant.toMap());
-            m_thingClasses->addThingClass(thingClass);
+        QByteArray thingClassesData = QJsonDocument::fromVariant(thingClassList).toJson(QJsonDocument::Compact);
+        if (m_reconciling && thingClassesData == m_thingClassesData) {
+            qCDebug(dcThingManager()) << "Thing classes unchanged since snapshot";
+        } else {
+            QList<ThingClass*> thingClasses;
+            foreach (QVariant thingClassVariant, thingClassList) {
+                thingClasses.append(unpackThingClass(thingClassVariant.toMap()));
+            }
+            if (m_reconciling) {
+                qCInfo(dcThingManager()) << "Thing classes changed since snapshot. Updating things.";
+                m_thingClasses->updateThingClasses(thingClasses);
+                updateThingClassesOfThings();
+            } else {
+                foreach (ThingClass *thingClass, thingClasses) {
+                    m_thingClasses->addThingClass(thingClass);
+                }
+            }
+            m_thingClassesData = thingClassesData;
         }
     }
-    m_jsonClient->sendCommand("Integrations.GetThings", this, "getThingsResponse");
+    qCDebug(dcThingManager()) << "Thing classes received after" << m_connectionBenchmark.msecsTo(QDateTime::currentDateTime()) << "ms";
+
+    m_thingClassesReceived = true;
+    if (m_thingsResponsePending) {
+        QVariantMap thingsParams = m_pendingThingsResponse;
+        m_thingsResponsePending = false;
+        m_pendingThingsResponse.clear();
+        getThingsResponse(-1, thingsParams);
+    }
 }
 
 void ThingManager::getPluginsResponse(int /*commandId*/, const QVariantMap &params)
@@ -267,12 +515,39 @@ void ThingManager::getPluginsResponse(int /*commandId*/, const QVariantMap &para
             m_plugins->addPlugin(plugin);
         }
     }
-    m_jsonClient->sendCommand("Integrations.GetVendors", this, "getVendorsResponse");
 }
 
 void ThingManager::getThingsResponse(int /*commandId*/, const QVariantMap &params)
 {
 //    qCritical() << "Things received:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    if (JsonRpcClient::isTimeout(params)) {
+        qCWarning(dcThingManager()) << "Fetching things timed out. Retrying.";
+        m_jsonClient->sendCommand("Integrations.GetThings", this, "getThingsResponse");
+        return;
+    }
+    if (!m_thingClassesReceived) {
+        m_thingsResponsePending = true;
+        m_pendingThingsResponse = params;
+        return;
+    }
+
+    if (m_reconciling && !params.contains("things")) {
+        // An empty list would remove all the things, keep the snapshot instead
+        qCWarning(dcThingManager()) << "Fetching things failed. Keeping the snapshot:" << LogPayload(params);
+        m_reconciling = false;
+        emit fetchingDataChanged();
+        return;
+    }
+
+    if (m_reconciling) {
+        reconcileThings(params.value("things").toList());
+        m_reconciling = false;
+        qDebug() << "Reconciling thing manager took" << m_connectionBenchmark.msecsTo(QDateTime::currentDateTime()) << "ms";
+        // fetchingData never went up, but let whoever waits for the initial fetch know it's done
+        emit fetchingDataChanged();
+        return;
+    }
+
     if (params.keys().contains("things")) {
         QVariantList thingsList = params.value("things").toList();
         QList<Thing*> newThings;
@@ -284,25 +559,8 @@ void ThingManager::getThingsResponse(int /*commandId*/, const QVariantMap &param
             }
 
             // set initial state values
-            QVariantList stateVariantList = thingVariant.toMap().value("states").toList();
-            foreach (const QVariant &stateMap, stateVariantList) {
-                QString stateTypeId = stateMap.toMap().value("stateTypeId").toString();
-                StateType *st = thing->thingClass()->stateTypes()->getStateType(stateTypeId);
-                if (!st) {
-                    qWarning() << "Can't find a statetype for this state";
-                    continue;
-                }
-                QVariant value = stateMap.toMap().value("value");
-                if (st->type() == "Bool") {
-                    value.convert(QVariant::Bool);
-                } else if (st->type() == "Double") {
-                    value.convert(QVariant::Double);
-                } else if (st->type() == "Int") {
-                    value.convert(QVariant::Int);
-                }
-                thing->setStateValue(stateTypeId, value);
-//                qDebug() << "Set thing state value:" << thing->stateValue(stateTypeId) << value;
-            }
+            unpackStateValues(thing, thingVariant.toMap().value("states").toList());
+            m_thingData.insert(thing->id(), thingData(thingVariant.toMap()));
             newThings.append(thing);
         }
         things()->addThings(newThings);
@@ -310,16 +568,84 @@ void ThingManager::getThingsResponse(int /*commandId*/, const QVariantMap &param
     qDebug() << "Initializing thing manager took" << m_connectionBenchmark.msecsTo(QDateTime::currentDateTime()) << "ms";
     m_fetchingData = false;
     emit fetchingDataChanged();
+}
 
-    m_jsonClient->sendCommand("Integrations.GetIOConnections", this, "getIOConnectionsResponse");
+void ThingManager::updateThingClassesOfThings()
+{
+    QList<Thing*> removedThings;
+    foreach (Thing *thing, m_things->devices()) {
+        ThingClass *thingClass = m_thingClasses->getThingClass(thing->thingClassId());
+        if (!thingClass) {
+            removedThings.append(thing);
+            continue;
+        }
+        thing->setThingClass(thingClass);
+        // Forces reconcileThings() to unpack the thing again against its new class
+        m_thingData.remove(thing->id());
+    }
+    foreach (Thing *thing, removedThings) {
+        qCInfo(dcThingManager()) << "Thing class of" << thing->name() << "is gone. Removing thing.";
+        m_thingData.remove(thing->id());
+        m_things->removeThing(thing);
+        emit thingRemoved(thing);
+        thing->deleteLater();
+    }
+}
 
-    m_jsonClient->sendCommand("Integrations.GetPlugins", this, "getPluginsResponse");
+void ThingManager::reconcileThings(const QVariantList &thingsList)
+{
+    QSet<QUuid> liveThingIds;
+    QList<Thing*> newThings;
+    int changed = 0;
+    foreach (const QVariant &thingVariant, thingsList) {
+        QVariantMap thingMap = thingVariant.toMap();
+        QUuid thingId = thingMap.value("id").toUuid();
+        liveThingIds.insert(thingId);
+
+        Thing *thing = m_things->getThing(thingId);
+        if (!thing) {
+            thing = unpackThing(this, thingMap, m_thingClasses);
+            if (!thing) {
+                qWarning() << "Error unpacking thing" << thingMap.value("name").toString();
+                continue;
+            }
+            unpackStateValues(thing, thingMap.value("states").toList());
+            m_thingData.insert(thingId, thingData(thingMap));
+            newThings.append(thing);
+            continue;
+        }
+
+        // State values are expected to differ, everything else rarely does
+        QByteArray data = thingData(thingMap);
+        if (m_thingData.value(thingId) != data) {
+            unpackThing(this, thingMap, m_thingClasses, thing);
+            m_thingData.insert(thingId, data);
+            changed++;
+        }
+        unpackStateValues(thing, thingMap.value("states").toList());
+    }
+
+    QList<Thing*> removedThings;
+    foreach (Thing *thing, m_things->devices()) {
+        if (!liveThingIds.contains(thing->id())) {
+            removedThings.append(thing);
+        }
+    }
+    foreach (Thing *thing, removedThings) {
+        m_thingData.remove(thing->id());
+        m_things->removeThing(thing);
+        emit thingRemoved(thing);
+        thing->deleteLater();
+    }
+
+    m_things->addThings(newThings);
+    qCInfo(dcThingManager()) << "Reconciled snapshot with server:" << newThings.count() << "added," << changed << "changed," << removedThings.count() << "removed";
 }
 
 void ThingManager::addThingResponse(int commandId, const QVariantMap &params)
 {
-    qDebug() << "Error from string:" << errorFromString(params.value("thingError").toByteArray()) << params.value("thingError");
-    emit addThingReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("thingId").toUuid(), params.value("displayMessage").toString());
+    qDebug() << "Error from string:" << errorFromReply(params) << params.value("thingError");
+    emit addThingReply(commandId, errorFromReply(params), params.value("thingId").toUuid(), params.value("displayMessage").toString());
 
     if (params.value("thingError").toString() != "ThingErrorNoError") {
         qWarning() << "Failed to add thing:" << params.value("thingError").toString();
@@ -339,13 +665,13 @@ void ThingManager::addThingResponse(int commandId, const QVariantMap &params)
 void ThingManager::removeThingResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "Thing removed response" << params;
-    emit removeThingReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("ruleIds").toStringList());
+    emit removeThingReply(commandId, errorFromReply(params), params.value("ruleIds").toStringList());
 }
 
 void ThingManager::pairThingResponse(int commandId, const QVariantMap &params)
 {
     emit pairThingReply(commandId,
-                        errorFromString(params.value("thingError").toByteArray()),
+                        errorFromReply(params),
                         params.value("pairingTransactionId").toUuid(),
                         params.value("setupMethod").toString(),
                         params.value("displayMessage").toString(),
@@ -355,31 +681,51 @@ void ThingManager::pairThingResponse(int commandId, const QVariantMap &params)
 void ThingManager::confirmPairingResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "ConfirmPairingResponse" << params;
-    emit confirmPairingReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("thingId").toUuid(), params.value("displayMessage").toString());
+    emit confirmPairingReply(commandId, errorFromReply(params), params.value("thingId").toUuid(), params.value("displayMessage").toString());
 }
 
 void ThingManager::setPluginConfigResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "set plugin config response" << params;
-    emit savePluginConfigReply(commandId, errorFromString(params.value("thingError").toByteArray()));
+    emit savePluginConfigReply(commandId, errorFromReply(params));
 }
 
 void ThingManager::editThingResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "Edit thing response" << params;
-    emit editThingReply(commandId, errorFromString(params.value("thingError").toByteArray()));
+    emit editThingReply(commandId, errorFromReply(params));
 }
 
 void ThingManager::executeActionResponse(int commandId, const QVariantMap &params)
 {
     qCDebug(dcThingManager()) << "Execute Action response" << params;
-    emit executeActionReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("displayMessage").toString());
+    emit executeActionReply(commandId, errorFromReply(params), params.value("displayMessage").toString());
+}
+
+void ThingManager::executeBatchActionResponse(int commandId, const QJsonObject &params)
+{
+    int batchId = m_batchedActions.take(commandId);
+    QHash<int, ActionBatch>::iterator it = m_actionBatches.find(batchId);
+    if (it == m_actionBatches.end()) {
+        return;
+    }
+    Thing::ThingError thingError = errorFromReply(params);
+    if (thingError != Thing::ThingErrorNoError && it->thingError == Thing::ThingErrorNoError) {
+        it->thingError = thingError;
+        it->displayMessage = params.value("displayMessage").toString();
+    }
+    if (--it->pending > 0) {
+        return;
+    }
+    ActionBatch batch = m_actionBatches.take(batchId);
+    qCDebug(dcThingManager()) << "Action batch" << batchId << "finished" << batch.thingError;
+    emit executeActionsReply(batchId, batch.thingError, batch.displayMessage);
 }
 
 void ThingManager::reconfigureThingResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "Reconfigure device response" << params;
-    emit reconfigureThingReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("displayMessage").toString());
+    emit reconfigureThingReply(commandId, errorFromReply(params), params.value("displayMessage").toString());
 }
 
 ThingGroup *ThingManager::createGroup(Interface *interface, ThingsProxy *things)
@@ -501,6 +847,33 @@ int ThingManager::executeAction(const QUuid &thingId, const QUuid &actionTypeId,
     return m_jsonClient->sendCommand("Integrations.ExecuteAction", p, this, "executeActionResponse");
 }
 
+int ThingManager::executeActions(const QList<BatchAction> &actions)
+{
+    int batchId = ++m_batchIdCounter;
+    if (actions.isEmpty()) {
+        QTimer::singleShot(0, this, [this, batchId](){
+            emit executeActionsReply(batchId, Thing::ThingErrorNoError, QString());
+        });
+        return batchId;
+    }
+
+    // The core has no batch call for actions, but as they don't wait for each other they
+    // all go out in the same write
+    qCDebug(dcThingManager()) << "Executing" << actions.count() << "actions in batch" << batchId;
+    m_actionBatches[batchId].pending = actions.count();
+    foreach (const BatchAction &action, actions) {
+        QVariantMap p;
+        p.insert("thingId", action.thingId.toString());
+        p.insert("actionTypeId", action.actionTypeId.toString());
+        if (!action.params.isEmpty()) {
+            p.insert("params", action.params);
+        }
+        int commandId = m_jsonClient->sendCommand("Integrations.ExecuteAction", p, this, &ThingManager::executeBatchActionResponse);
+        m_batchedActions.insert(commandId, batchId);
+    }
+    return batchId;
+}
+
 BrowserItems *ThingManager::browseThing(const QUuid &thingId, const QString &itemId)
 {
     QVariantMap params;
@@ -631,7 +1004,7 @@ int ThingManager::executeBrowserItem(const QUuid &thingId, const QString &itemId
 void ThingManager::executeBrowserItemResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "Execute Browser Item finished" << params;
-    emit executeBrowserItemReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("displayMessage").toString());
+    emit executeBrowserItemReply(commandId, errorFromReply(params), params.value("displayMessage").toString());
 }
 
 int ThingManager::executeBrowserItemAction(const QUuid &thingId, const QString &itemId, const QUuid &actionTypeId, const QVariantList &params)
@@ -681,12 +1054,12 @@ int ThingManager::disconnectIO(const QUuid &ioConnectionId)
 void ThingManager::executeBrowserItemActionResponse(int commandId, const QVariantMap &params)
 {
     qDebug() << "Execute Browser Item Action finished" << params;
-    emit executeBrowserItemActionReply(commandId, errorFromString(params.value("thingError").toByteArray()), params.value("displayMessage").toString());
+    emit executeBrowserItemActionReply(commandId, errorFromReply(params), params.value("displayMessage").toString());
 }
 
 void ThingManager::getIOConnectionsResponse(int /*commandId*/, const QVariantMap &params)
 {
-//    qDebug() << "Get IO connections response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+//    qDebug() << "Get IO connections response" << LogPayload(params);
 
     foreach (const QVariant &connectionVariant, params.value("ioConnections").toList()) {
         QVariantMap connectionMap = connectionVariant.toMap();
@@ -703,30 +1076,30 @@ void ThingManager::getIOConnectionsResponse(int /*commandId*/, const QVariantMap
 
 void ThingManager::connectIOResponse(int commandId, const QVariantMap &params)
 {
-    qDebug() << "ConnectIO response" << commandId << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qDebug() << "ConnectIO response" << commandId << LogPayload(params);
 }
 
 void ThingManager::disconnectIOResponse(int commandId, const QVariantMap &params)
 {
-    qDebug() << "DisconnectIO response" << commandId << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qDebug() << "DisconnectIO response" << commandId << LogPayload(params);
 }
 
 void ThingManager::setStateLoggingResponse(int commandId, const QVariantMap &params)
 {
     Q_UNUSED(commandId)
-    qCDebug(dcThingManager()) << "Set state logging response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcThingManager()) << "Set state logging response" << LogPayload(params);
 }
 
 void ThingManager::setActionLoggingResponse(int commandId, const QVariantMap &params)
 {
     Q_UNUSED(commandId)
-    qCDebug(dcThingManager()) << "Set action logging response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcThingManager()) << "Set action logging response" << LogPayload(params);
 }
 
 void ThingManager::setEventLoggingResponse(int commandId, const QVariantMap &params)
 {
     Q_UNUSED(commandId)
-    qCDebug(dcThingManager()) << "Set event logging response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcThingManager()) << "Set event logging response" << LogPayload(params);
 }
 
 Vendor *ThingManager::unpackVendor(const QVariantMap &vendorMap)
@@ -916,6 +1289,7 @@ Thing* ThingManager::unpackThing(ThingManager *thingManager, const QVariantMap &
     Thing *thing = nullptr;
     if (oldThing) {
         thing = oldThing;
+        thing->setThingClass(thingClass);
     } else {
         thing = new Thing(thingManager, thingClass, parentId);
     }
@@ -1017,6 +1391,27 @@ Thing* ThingManager::unpackThing(ThingManager *thingManager, const QVariantMap &
     return thing;
 }
 
+void ThingManager::unpackStateValues(Thing *thing, const QVariantList &stateList)
+{
+    foreach (const QVariant &stateMap, stateList) {
+        QString stateTypeId = stateMap.toMap().value("stateTypeId").toString();
+        StateType *st = thing->thingClass()->stateTypes()->getStateType(stateTypeId);
+        if (!st) {
+            qWarning() << "Can't find a statetype for this state";
+            continue;
+        }
+        QVariant value = stateMap.toMap().value("value");
+        if (st->type() == "Bool") {
+            value.convert(QVariant::Bool);
+        } else if (st->type() == "Double") {
+            value.convert(QVariant::Double);
+        } else if (st->type() == "Int") {
+            value.convert(QVariant::Int);
+        }
+        thing->setStateValue(stateTypeId, value);
+    }
+}
+
 QVariantMap ThingManager::packParam(Param *param)
 {
     QVariantMap ret;
@@ -1031,6 +1426,28 @@ Thing::ThingError ThingManager::errorFromString(const QByteArray &thingErrorStri
     return static_cast<Thing::ThingError>(metaEnum.keyToValue(thingErrorString));
 }
 
+Thing::ThingError ThingManager::errorFromReply(const QVariantMap &params)
+{
+    if (JsonRpcClient::isTimeout(params)) {
+        return Thing::ThingErrorTimeout;
+    }
+    QMetaEnum metaEnum = QMetaEnum::fromType<Thing::ThingError>();
+    bool ok = false;
+    int thingError = metaEnum.keyToValue(params.value("thingError").toByteArray(), &ok);
+    return ok ? static_cast<Thing::ThingError>(thingError) : Thing::ThingErrorHardwareNotAvailable;
+}
+
+Thing::ThingError ThingManager::errorFromReply(const QJsonObject &params)
+{
+    if (JsonRpcClient::isTimeout(params)) {
+        return Thing::ThingErrorTimeout;
+    }
+    QMetaEnum metaEnum = QMetaEnum::fromType<Thing::ThingError>();
+    bool ok = false;
+    int thingError = metaEnum.keyToValue(params.value("thingError").toString().toUtf8(), &ok);
+    return ok ? static_cast<Thing::ThingError>(thingError) : Thing::ThingErrorHardwareNotAvailable;
+}
+
 ThingClass::SetupMethod ThingManager::stringToSetupMethod(const QString &setupMethodString)
 {
     if (setupMethodString == "SetupMethodJustAdd") {
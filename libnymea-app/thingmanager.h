@@ -32,6 +32,7 @@
 #define THINGMANAGER_H
 
 #include <QObject>
+#include <QTimer>
 
 #include "types/vendors.h"
 #include "things.h"
@@ -58,6 +59,13 @@ class ThingManager : public QObject
 
     Q_PROPERTY(bool fetchingData READ fetchingData NOTIFY fetchingDataChanged)
 
+    // -1: deliver every state change immediately (default)
+    //  0: coalesce state changes arriving within the same event loop turn
+    // >0: coalesce state changes for the given interval in ms, e.g. 16 for one frame
+    Q_PROPERTY(int stateChangeCoalescingInterval READ stateChangeCoalescingInterval WRITE setStateChangeCoalescingInterval NOTIFY stateChangeCoalescingIntervalChanged)
+    Q_PROPERTY(int receivedStateChanges READ receivedStateChanges NOTIFY stateChangeStatisticsChanged)
+    Q_PROPERTY(int mergedStateChanges READ mergedStateChanges NOTIFY stateChangeStatisticsChanged)
+
     Q_ENUMS(RemovePolicy)
 public:
     enum RemovePolicy {
@@ -67,11 +75,27 @@ public:
     };
     Q_ENUM(RemovePolicy)
 
+    // An action for executeActions()
+    struct BatchAction {
+        QUuid thingId;
+        QUuid actionTypeId;
+        QVariantList params;
+    };
+
     explicit ThingManager(JsonRpcClient *jsonclient, QObject *parent = nullptr);
 
     void clear();
     void init();
 
+    // Populates the models from a snapshot. init() will then reconcile them with the live
+    // data instead of fetching from scratch and fetchingData stays false in the meantime.
+    // Thing classes and things are compact JSON as received, things without their states.
+    // Those are passed separately as lists of stateTypeId/value maps per thing.
+    void loadSnapshot(const QByteArray &thingClasses, const QList<QByteArray> &things, const QHash<QUuid, QVariantList> &thingStates);
+    QByteArray snapshotThingClasses() const;
+    QList<QByteArray> snapshotThings() const;
+    QHash<QUuid, QVariantList> snapshotThingStates() const;
+
     Vendors* vendors() const;
     Plugins* plugins() const;
     Things* things() const;
@@ -80,6 +104,12 @@ public:
 
     bool fetchingData() const;
 
+    int stateChangeCoalescingInterval() const;
+    void setStateChangeCoalescingInterval(int stateChangeCoalescingInterval);
+    // Only counted while coalescing is enabled
+    int receivedStateChanges() const;
+    int mergedStateChanges() const;
+
     Q_INVOKABLE int addThing(const QUuid &thingClassId, const QString &name, const QVariantList &thingParams);
     // Param thingClassId is deprecated as of jsonrpc 5.4
     Q_INVOKABLE int addDiscoveredThing(const QUuid &thingClassId, const QUuid &thingDescriptorId, const QString &name, const QVariantList &thingParams);
@@ -93,6 +123,9 @@ public:
     Q_INVOKABLE int reconfigureThing(const QUuid &thingId, const QVariantList &thingParams);
     Q_INVOKABLE int reconfigureDiscoveredThing(const QUuid &thingDescriptorId, const QVariantList &paramOverride);
     Q_INVOKABLE int executeAction(const QUuid &thingId, const QUuid &actionTypeId, const QVariantList &params = QVariantList());
+    // Sends all actions back to back without waiting for replies in between. Returns a batch id,
+    // executeActionsReply() is emitted with it once all of them finished.
+    int executeActions(const QList<BatchAction> &actions);
     Q_INVOKABLE BrowserItems* browseThing(const QUuid &thingId, const QString &itemId = QString());
     Q_INVOKABLE void refreshBrowserItems(BrowserItems *browserItems);
     Q_INVOKABLE BrowserItem* browserItem(const QUuid &thingId, const QString &itemId);
@@ -106,7 +139,19 @@ public:
     Q_INVOKABLE int disconnectIO(const QUuid &ioConnectionId);
 
 private:
-    Q_INVOKABLE void notificationReceived(const QVariantMap &data);
+    void stateChangedNotification(const QJsonObject &params);
+    void applyStateChange(const QJsonObject &params);
+    void flushStateChanges();
+    void updateThingClassesOfThings();
+    void reconcileThings(const QVariantList &thingsList);
+    void thingAddedNotification(const QJsonObject &params);
+    void thingRemovedNotification(const QJsonObject &params);
+    void thingChangedNotification(const QJsonObject &params);
+    void thingSettingChangedNotification(const QJsonObject &params);
+    void eventTriggeredNotification(const QJsonObject &params);
+    void ioConnectionAddedNotification(const QJsonObject &params);
+    void ioConnectionRemovedNotification(const QJsonObject &params);
+
     Q_INVOKABLE void getVendorsResponse(int commandId, const QVariantMap &params);
     Q_INVOKABLE void getThingClassesResponse(int commandId, const QVariantMap &params);
     Q_INVOKABLE void getPluginsResponse(int commandId, const QVariantMap &params);
@@ -118,6 +163,7 @@ private:
     Q_INVOKABLE void setPluginConfigResponse(int commandId, const QVariantMap &params);
     Q_INVOKABLE void editThingResponse(int commandId, const QVariantMap &params);
     Q_INVOKABLE void executeActionResponse(int commandId, const QVariantMap &params);
+    void executeBatchActionResponse(int commandId, const QJsonObject &params);
     Q_INVOKABLE void reconfigureThingResponse(int commandId, const QVariantMap &params);
     Q_INVOKABLE void browseThingResponse(int commandId, const QVariantMap &params);
     Q_INVOKABLE void browserItemResponse(int commandId, const QVariantMap &params);
@@ -142,9 +188,13 @@ signals:
     void editThingReply(int commandId, Thing::ThingError thingError);
     void reconfigureThingReply(int commandId, Thing::ThingError thingError, const QString &displayMessage);
     void executeActionReply(int commandId, Thing::ThingError thingError, const QString &displayMessage);
+    // thingError and displayMessage are those of the first action that failed, if any
+    void executeActionsReply(int batchId, Thing::ThingError thingError, const QString &displayMessage);
     void executeBrowserItemReply(int commandId, Thing::ThingError thingError, const QString &displayMessage);
     void executeBrowserItemActionReply(int commandId, Thing::ThingError thingError, const QString &displayMessage);
     void fetchingDataChanged();
+    void stateChangeCoalescingIntervalChanged();
+    void stateChangeStatisticsChanged();
     void notificationReceived(const QString &thingId, const QString &eventTypeId, const QVariantList &params);
 
     void eventTriggered(const QUuid &thingId, const QUuid &eventTypeId, const QVariantMap params);
@@ -163,10 +213,15 @@ private:
     static EventType *unpackEventType(const QVariantMap &eventTypeMap, QObject *parent);
     static ActionType *unpackActionType(const QVariantMap &actionTypeMap, QObject *parent);
     static Thing *unpackThing(ThingManager *thingManager, const QVariantMap &thingMap, ThingClasses *thingClasses, Thing *oldThing = nullptr);
+    static void unpackStateValues(Thing *thing, const QVariantList &stateList);
 
     static QVariantMap packParam(Param *param);
 
     static Thing::ThingError errorFromString(const QByteArray &thingErrorString);
+    // The thingError of a reply. ThingErrorTimeout if the request timed out, replies without a
+    // valid thingError, e.g. after an error on the JSONRPC layer, give ThingErrorHardwareNotAvailable.
+    static Thing::ThingError errorFromReply(const QVariantMap &params);
+    static Thing::ThingError errorFromReply(const QJsonObject &params);
     static ThingClass::SetupMethod stringToSetupMethod(const QString &setupMethodString);
     static Types::Unit stringToUnit(const QString &unitString);
     static Types::InputType stringToInputType(const QString &inputTypeString);
@@ -179,12 +234,38 @@ private:
     IOConnections *m_ioConnections;
 
     bool m_fetchingData = true;
+    bool m_reconciling = false;
+    bool m_thingClassesReceived = false;
+    bool m_thingsResponsePending = false;
+    QVariantMap m_pendingThingsResponse;
+    // Thing classes and things (without states) as received in compact JSON, kept for
+    // snapshots and to tell whether anything changed on reconciliation
+    QByteArray m_thingClassesData;
+    QHash<QUuid, QByteArray> m_thingData;
+
+    int m_stateChangeCoalescingInterval = -1;
+    QTimer m_stateChangeTimer;
+    // Latest params per (thingId, stateTypeId), kept in arrival order
+    QVector<QJsonObject> m_pendingStateChanges;
+    QHash<QPair<QString, QString>, int> m_pendingStateChangeIndex;
+    int m_receivedStateChanges = 0;
+    int m_mergedStateChanges = 0;
 
     JsonRpcClient *m_jsonClient = nullptr;
 
     QHash<int, QPointer<BrowserItems> > m_browsingRequests;
     QHash<int, QPointer<BrowserItem> > m_browserDetailsRequests;
 
+    struct ActionBatch {
+        int pending = 0;
+        Thing::ThingError thingError = Thing::ThingErrorNoError;
+        QString displayMessage;
+    };
+    int m_batchIdCounter = 0;
+    QHash<int, ActionBatch> m_actionBatches;
+    // Command id to batch id
+    QHash<int, int> m_batchedActions;
+
     QDateTime m_connectionBenchmark;
 };
 
@@ -32,6 +32,7 @@
 #include "engine.h"
 
 #include <QDebug>
+#include <algorithm>
 
 Things::Things(QObject *parent) :
     QAbstractListModel(parent)
@@ -53,17 +54,12 @@ Thing *Things::get(int index) const
 
 Thing *Things::getThing(const QUuid &thingId) const
 {
-    foreach (Thing *thing, m_things) {
-        if (thing->id() == thingId) {
-            return thing;
-        }
-    }
-    return nullptr;
+    return m_thingsById.value(thingId);
 }
 
 int Things::indexOf(Thing *thing) const
 {
-    return m_things.indexOf(thing);
+    return m_rows.value(thing, -1);
 }
 
 int Things::rowCount(const QModelIndex &parent) const
@@ -112,23 +108,31 @@ void Things::addThings(const QList<Thing *> things)
         return;
     }
     beginInsertRows(QModelIndex(), m_things.count(), m_things.count() + things.count() - 1);
-    m_things.append(things);
+    foreach (Thing *thing, things) {
+        m_rows.insert(thing, m_things.count());
+        m_thingsById.insert(thing->id(), thing);
+        m_things.append(thing);
+    }
 
     foreach (Thing *thing, things) {
         thing->setParent(this);
         connect(thing, &Thing::nameChanged, this, [thing, this]() {
-            int idx = m_things.indexOf(thing);
+            int idx = indexOf(thing);
             if (idx < 0) return;
             emit dataChanged(index(idx), index(idx), {RoleName});
         });
         connect(thing, &Thing::setupStatusChanged, this, [thing, this]() {
-            int idx = m_things.indexOf(thing);
+            int idx = indexOf(thing);
             if (idx < 0) return;
             emit dataChanged(index(idx), index(idx), {RoleSetupStatus, RoleSetupDisplayMessage});
         });
         connect(thing->states(), &States::dataChanged, this, [thing, this]() {
-            int idx = m_things.indexOf(thing);
+            int idx = indexOf(thing);
             if (idx < 0) return;
+            if (m_stateChangeBatchDepth > 0) {
+                m_batchChangedThings.insert(thing);
+                return;
+            }
             emit dataChanged(index(idx), index(idx));
         });
         emit thingAdded(thing);
@@ -140,10 +144,18 @@ void Things::addThings(const QList<Thing *> things)
 
 void Things::removeThing(Thing *thing)
 {
-    int index = m_things.indexOf(thing);
+    int index = indexOf(thing);
+    if (index < 0) {
+        qCWarning(dcThingManager()) << "Cannot remove thing" << thing->name() << "as it is not in this model";
+        return;
+    }
     beginRemoveRows(QModelIndex(), index, index);
     qDebug() << "Removed thing" << thing->name();
     m_things.takeAt(index)->deleteLater();
+    m_thingsById.remove(thing->id());
+    m_rows.remove(thing);
+    m_batchChangedThings.remove(thing);
+    updateRows(index);
     endRemoveRows();
     emit countChanged();
     emit thingRemoved(thing);
@@ -154,10 +166,54 @@ void Things::clearModel()
     beginResetModel();
     qDeleteAll(m_things);
     m_things.clear();
+    m_thingsById.clear();
+    m_rows.clear();
+    m_batchChangedThings.clear();
     endResetModel();
     emit countChanged();
 }
 
+void Things::beginStateChangeBatch()
+{
+    m_stateChangeBatchDepth++;
+}
+
+void Things::endStateChangeBatch()
+{
+    if (m_stateChangeBatchDepth == 0) {
+        qCWarning(dcThingManager()) << "endStateChangeBatch() called without a matching beginStateChangeBatch()";
+        return;
+    }
+    if (--m_stateChangeBatchDepth > 0) {
+        return;
+    }
+    // Rows may have moved since the changes were recorded, so they are looked up only now
+    QList<int> rows;
+    rows.reserve(m_batchChangedThings.count());
+    foreach (Thing *thing, m_batchChangedThings) {
+        rows.append(m_rows.value(thing));
+    }
+    m_batchChangedThings.clear();
+    std::sort(rows.begin(), rows.end());
+
+    int i = 0;
+    while (i < rows.count()) {
+        int first = rows.at(i);
+        int last = first;
+        while (++i < rows.count() && rows.at(i) == last + 1) {
+            last++;
+        }
+        emit dataChanged(index(first), index(last));
+    }
+}
+
+void Things::updateRows(int from)
+{
+    for (int i = from; i < m_things.count(); i++) {
+        m_rows[m_things.at(i)] = i;
+    }
+}
+
 QHash<int, QByteArray> Things::roleNames() const
 {
     QHash<int, QByteArray> roles;
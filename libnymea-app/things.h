@@ -36,6 +36,7 @@
 
 #include <QAbstractListModel>
 #include <QLoggingCategory>
+#include <QSet>
 
 Q_DECLARE_LOGGING_CATEGORY(dcThingManager)
 
@@ -74,6 +75,11 @@ public:
 
     void clearModel();
 
+    // While a batch is open, state changes are not forwarded per row but collected
+    // and emitted once per contiguous range of changed rows when the outermost batch ends.
+    void beginStateChangeBatch();
+    void endStateChangeBatch();
+
 protected:
     QHash<int, QByteArray> roleNames() const override;
 
@@ -83,7 +89,15 @@ signals:
     void thingRemoved(Thing *device);
 
 private:
+    void updateRows(int from);
+
     QList<Thing *> m_things;
+    // Lookup indexes, kept in sync by addThings()/removeThing()/clearModel()
+    QHash<QUuid, Thing*> m_thingsById;
+    QHash<Thing*, int> m_rows;
+
+    int m_stateChangeBatchDepth = 0;
+    QSet<Thing*> m_batchChangedThings;
 
 };
 
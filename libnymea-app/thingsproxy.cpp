@@ -40,6 +40,15 @@ ThingsProxy::ThingsProxy(QObject *parent) :
     connect(this, &ThingsProxy::countChanged, this, [=](){
         m_oldCount = rowCount();
     });
+
+    // Rows are also filtered incrementally when the source data changes, not only through invalidateFilterInternal()
+    auto updateCount = [this](){
+        if (m_oldCount != rowCount()) {
+            emit countChanged();
+        }
+    };
+    connect(this, &QAbstractItemModel::rowsInserted, this, updateCount);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, updateCount);
 }
 
 Engine *ThingsProxy::engine() const
@@ -51,7 +60,7 @@ void ThingsProxy::setEngine(Engine *engine)
 {
     if (m_engine != engine) {
         if (m_engine) {
-            disconnect(m_engine->tagsManager()->tags(), &Tags::countChanged, this, &ThingsProxy::invalidateFilter);
+            m_engine->tagsManager()->tags()->unsubscribe(this);
         }
         m_engine = engine;
         emit engineChanged();
@@ -60,7 +69,8 @@ void ThingsProxy::setEngine(Engine *engine)
             return;
         }
 
-        connect(m_engine->tagsManager()->tags(), &Tags::countChanged, this, &ThingsProxy::invalidateFilterInternal);
+        subscribeTags();
+        invalidateFilterInternal();
 
         if (!sourceModel()) {
             setSourceModel(m_engine->thingManager()->things());
@@ -69,12 +79,6 @@ void ThingsProxy::setEngine(Engine *engine)
             sort(0, sortOrder());
             emit countChanged();
             connect(sourceModel(), SIGNAL(countChanged()), this, SIGNAL(countChanged()));
-            connect(sourceModel(), &QAbstractItemModel::dataChanged, this, [this]() {
-                // Only invalidate the filter if we're actually interested in state changes
-                if (!m_sortStateName.isEmpty() || m_filterBatteryCritical || m_filterDisconnected || m_filterUpdates || m_filterSetupFailed || !m_stateFilter.isEmpty()) {
-                    invalidateFilterInternal();
-                }
-            });
         }
     }
 }
@@ -95,16 +99,8 @@ void ThingsProxy::setParentProxy(ThingsProxy *parentProxy)
         }
         connect(m_parentProxy, SIGNAL(countChanged()), this, SIGNAL(countChanged()));
 
-        connect(m_parentProxy, &QAbstractItemModel::dataChanged, this, [this]() {
-            if (m_engine &&
-                    // Only invalidate the filter if we're actually interested in state changes
-                    (!m_sortStateName.isEmpty() || m_filterBatteryCritical || m_filterDisconnected || m_filterUpdates || m_filterSetupFailed)) {
-                invalidateFilterInternal();
-            }
-        });
-
         if (m_engine) {
-            invalidateFilter();
+            invalidateFilterInternal();
         }
 
         emit parentProxyChanged();
@@ -122,6 +118,7 @@ void ThingsProxy::setFilterTagId(const QString &filterTag)
     if (m_filterTagId != filterTag) {
         m_filterTagId = filterTag;
         emit filterTagIdChanged();
+        subscribeTags();
         invalidateFilterInternal();
     }
 }
@@ -150,6 +147,7 @@ void ThingsProxy::setHideTagId(const QString &tagId)
     if (m_hideTagId != tagId) {
         m_hideTagId = tagId;
         emit hideTagIdChanged();
+        subscribeTags();
         invalidateFilterInternal();
     }
 }
@@ -565,14 +563,80 @@ int ThingsProxy::indexOf(Thing *thing) const
     return mapFromSource(sourceIndex).row();
 }
 
+void ThingsProxy::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    foreach (const QMetaObject::Connection &connection, m_sourceConnections) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+    m_predicate.valid = false;
+    m_acceptCache.clear();
+
+    // Connected before QSortFilterProxyModel connects its own handlers, so stale filter results are
+    // dropped before it re-filters the changed rows
+    if (sourceModel) {
+        m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::dataChanged, this, &ThingsProxy::onSourceDataChanged));
+        m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, [this](){
+            m_acceptCache.clear();
+        }));
+    }
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
 void ThingsProxy::invalidateFilterInternal()
 {
+    m_predicate.valid = false;
+    m_acceptCache.clear();
     invalidateFilter();
     if (m_oldCount != rowCount()) {
         emit countChanged();
     }
 }
 
+void ThingsProxy::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    // QSortFilterProxyModel re-filters the changed rows by itself. Only rows for which the change
+    // is relevant to the filter need to be evaluated again, the others are answered from the cache.
+    for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+        Thing *thing = getInternal(row);
+        if (thing && filterAffectedBy(thing, roles)) {
+            m_acceptCache.remove(thing->id());
+        }
+    }
+}
+
+void ThingsProxy::onTagChanged(Tag *tag)
+{
+    if (!tag) {
+        invalidateFilterInternal();
+        return;
+    }
+    if (tag->thingId().isNull()) {
+        return;
+    }
+    // Only the tagged thing can change its verdict, everything else is answered from the cache
+    m_acceptCache.remove(tag->thingId());
+    invalidateFilter();
+    if (m_oldCount != rowCount()) {
+        emit countChanged();
+    }
+}
+
+void ThingsProxy::subscribeTags()
+{
+    if (!m_engine) {
+        return;
+    }
+    Tags *tags = m_engine->tagsManager()->tags();
+    tags->unsubscribe(this);
+    if (!m_filterTagId.isEmpty()) {
+        tags->subscribe(m_filterTagId, this, [this](Tag *tag) { onTagChanged(tag); });
+    }
+    if (!m_hideTagId.isEmpty() && m_hideTagId != m_filterTagId) {
+        tags->subscribe(m_hideTagId, this, [this](Tag *tag) { onTagChanged(tag); });
+    }
+}
+
 Thing *ThingsProxy::getInternal(int source_index) const
 {
     Things* d = qobject_cast<Things*>(sourceModel());
@@ -636,75 +700,68 @@ bool ThingsProxy::lessThan(const QModelIndex &left, const QModelIndex &right) co
 bool ThingsProxy::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
     Thing *thing = getInternal(source_row);
-    if (!m_filterTagId.isEmpty()) {
-        Tag *tag = m_engine->tagsManager()->tags()->findThingTag(thing->id().toString(), m_filterTagId);
-        if (!tag) {
-            return false;
-        }
-        if (!m_filterTagValue.isEmpty() && tag->value() != m_filterTagValue) {
-            return false;
-        }
-    }
-    if (!m_hideTagId.isEmpty()) {
-        Tag *tag = m_engine->tagsManager()->tags()->findThingTag(thing->id().toString(), m_hideTagId);
-        if (tag && m_hideTagValue.isEmpty()) {
-            return false;
-        }
-        if (tag && tag->value() == m_hideTagValue) {
-            return false;
-        }
+    if (!thing) {
+        return false;
     }
 
-    if (!m_filterThingId.isEmpty()) {
-        if (thing->id() != QUuid(m_filterThingId)) {
-            return false;
-        }
+    QHash<QUuid, bool>::const_iterator it = m_acceptCache.constFind(thing->id());
+    bool accepted;
+    if (it != m_acceptCache.constEnd()) {
+        accepted = it.value();
+    } else {
+        accepted = acceptsThing(thing);
+        m_acceptCache.insert(thing->id(), accepted);
     }
-
-    ThingClass *thingClass = thing->thingClass();
-    if (!m_shownInterfaces.isEmpty()) {
-        bool foundMatch = false;
-        foreach (const QString &filterInterface, m_shownInterfaces) {
-            if (thingClass->interfaces().contains(filterInterface)) {
-                foundMatch = true;
-                break;
-            }
-        }
-        if (!foundMatch) {
-            return false;
-        }
+    if (!accepted) {
+        return false;
     }
 
-    if (!m_hiddenInterfaces.isEmpty()) {
-        foreach (const QString &filterInterface, m_hiddenInterfaces) {
-            if (thingClass->interfaces().contains(filterInterface)) {
-                return false;
-            }
-        }
-    }
+    return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
+}
 
+void ThingsProxy::compilePredicate() const
+{
+    m_predicate = FilterPredicate();
 
-    if (!m_shownThingClassIds.isEmpty()) {
-        if (!m_shownThingClassIds.contains(thing->thingClassId())) {
-            return false;
-        }
+    if (m_engine) {
+        m_predicate.tags = m_engine->tagsManager()->tags();
     }
 
-    if (m_hiddenThingClassIds.contains(thing->thingClassId())) {
-        return false;
+    m_predicate.shownInterfaces = interfaceBits(m_shownInterfaces);
+    m_predicate.hiddenInterfaces = interfaceBits(m_hiddenInterfaces);
+    m_predicate.shownThingClassIds = QSet<QUuid>::fromList(m_shownThingClassIds);
+    m_predicate.hiddenThingClassIds = QSet<QUuid>::fromList(m_hiddenThingClassIds);
+    m_predicate.shownThingIds = QSet<QUuid>::fromList(m_shownThingIds);
+    m_predicate.hiddenThingIds = QSet<QUuid>::fromList(m_hiddenThingIds);
+    m_predicate.filterThingId = QUuid(m_filterThingId);
+    m_predicate.nameFilter = m_nameFilter.trimmed();
+    m_predicate.valid = true;
+}
+
+const ThingsProxy::ClassFilter &ThingsProxy::classFilter(ThingClass *thingClass) const
+{
+    QHash<QUuid, ClassFilter>::const_iterator it = m_predicate.classes.constFind(thingClass->id());
+    if (it != m_predicate.classes.constEnd()) {
+        return it.value();
     }
 
-    if (!m_shownThingIds.isEmpty()) {
-        if (!m_shownThingIds.contains(thing->id())) {
+    ClassFilter filter;
+    filter.accepted = [&](){
+        QBitArray interfaces = interfaceBits(thingClass->interfaces());
+        if (!m_shownInterfaces.isEmpty() && !intersects(interfaces, m_predicate.shownInterfaces)) {
+            return false;
+        }
+        if (intersects(interfaces, m_predicate.hiddenInterfaces)) {
             return false;
         }
-    }
 
-    if (m_hiddenThingIds.contains(thing->id())) {
-        return false;
-    }
+        if (!m_predicate.shownThingClassIds.isEmpty() && !m_predicate.shownThingClassIds.contains(thingClass->id())) {
+            return false;
+        }
+        if (m_predicate.hiddenThingClassIds.contains(thingClass->id())) {
+            return false;
+        }
 
-    if (m_showDigitalInputs || m_showDigitalOutputs || m_showAnalogInputs || m_showAnalogOutputs) {
         if (m_showDigitalInputs && thingClass->stateTypes()->ioStateTypes(Types::IOTypeDigitalInput).isEmpty()) {
             return false;
         }
@@ -717,57 +774,116 @@ bool ThingsProxy::filterAcceptsRow(int source_row, const QModelIndex &source_par
         if (m_showAnalogOutputs && thingClass->stateTypes()->ioStateTypes(Types::IOTypeAnalogOutput).isEmpty()) {
             return false;
         }
-    }
 
-    if (m_filterBatteryCritical) {
-        if (!thingClass->interfaces().contains("battery") || thing->stateValue(thingClass->stateTypes()->findByName("batteryCritical")->id()).toBool() == false) {
-            return false;
+        if (m_filterBatteryCritical) {
+            StateType *stateType = thingClass->stateTypes()->findByName("batteryCritical");
+            if (!thingClass->interfaces().contains("battery") || !stateType) {
+                return false;
+            }
+            filter.batteryCriticalStateTypeId = stateType->id();
         }
-    }
-
-    if (m_filterDisconnected) {
-        if (!thingClass->interfaces().contains("connectable") || thing->stateValue(thingClass->stateTypes()->findByName("connected")->id()).toBool() == true) {
-            return false;
+        if (m_filterDisconnected) {
+            StateType *stateType = thingClass->stateTypes()->findByName("connected");
+            if (!thingClass->interfaces().contains("connectable") || !stateType) {
+                return false;
+            }
+            filter.connectedStateTypeId = stateType->id();
+        }
+        if (m_filterUpdates) {
+            StateType *stateType = thingClass->stateTypes()->findByName("updateStatus");
+            if (!thingClass->interfaces().contains("update") || !stateType) {
+                return false;
+            }
+            filter.updateStatusStateTypeId = stateType->id();
         }
-    }
 
-    if (m_filterSetupFailed) {
-        if (thing->setupStatus() != Thing::ThingSetupStatusFailed) {
+        if (!m_requiredEventName.isEmpty() && !thingClass->eventTypes()->findByName(m_requiredEventName)) {
             return false;
         }
-    }
-
-    if (m_filterUpdates) {
-        if (!thingClass->interfaces().contains("update")) {
+        if (!m_requiredStateName.isEmpty() && !thingClass->stateTypes()->findByName(m_requiredStateName)) {
             return false;
         }
-        if (thing->stateValue(thingClass->stateTypes()->findByName("updateStatus")->id()).toString() == "idle") {
+        if (!m_requiredActionName.isEmpty() && !thingClass->actionTypes()->findByName(m_requiredActionName)) {
             return false;
         }
-    }
 
-    if (!m_nameFilter.isEmpty()) {
-        if (!thing->name().toLower().contains(m_nameFilter.toLower().trimmed())) {
-            return false;
+        foreach (const QString &stateName, m_stateFilter.keys()) {
+            StateType *stateType = thingClass->stateTypes()->findByName(stateName);
+            if (!stateType) {
+                return false;
+            }
+            filter.stateFilter.append(qMakePair(stateType->id(), m_stateFilter.value(stateName)));
         }
+        return true;
+    }();
+    filter.dependsOnStates = filter.accepted && (m_filterBatteryCritical || m_filterDisconnected || m_filterUpdates || !filter.stateFilter.isEmpty());
+
+    return *m_predicate.classes.insert(thingClass->id(), filter);
+}
+
+bool ThingsProxy::acceptsThing(Thing *thing) const
+{
+    if (!m_predicate.valid) {
+        compilePredicate();
     }
 
-    if (!m_requiredEventName.isEmpty()) {
-        if (!thing->thingClass()->eventTypes()->findByName(m_requiredEventName)) {
+    if (!m_filterTagId.isEmpty()) {
+        Tag *tag = m_predicate.tags ? m_predicate.tags->findThingTag(thing->id(), m_filterTagId) : nullptr;
+        if (!tag) {
+            return false;
+        }
+        if (!m_filterTagValue.isEmpty() && tag->value() != m_filterTagValue) {
             return false;
         }
     }
-    if (!m_requiredStateName.isEmpty()) {
-        if (!thing->thingClass()->stateTypes()->findByName(m_requiredStateName)) {
+    if (!m_hideTagId.isEmpty() && m_predicate.tags) {
+        Tag *tag = m_predicate.tags->findThingTag(thing->id(), m_hideTagId);
+        if (tag && (m_hideTagValue.isEmpty() || tag->value() == m_hideTagValue)) {
             return false;
         }
     }
-    if (!m_requiredActionName.isEmpty()) {
-        if (!thing->thingClass()->actionTypes()->findByName(m_requiredActionName)) {
+
+    if (!m_filterThingId.isEmpty() && thing->id() != m_predicate.filterThingId) {
+        return false;
+    }
+
+    if (!m_predicate.shownThingIds.isEmpty() && !m_predicate.shownThingIds.contains(thing->id())) {
+        return false;
+    }
+    if (m_predicate.hiddenThingIds.contains(thing->id())) {
+        return false;
+    }
+
+    const ClassFilter &filter = classFilter(thing->thingClass());
+    if (!filter.accepted) {
+        return false;
+    }
+
+    if (m_filterBatteryCritical && thing->stateValue(filter.batteryCriticalStateTypeId).toBool() == false) {
+        return false;
+    }
+    if (m_filterDisconnected && thing->stateValue(filter.connectedStateTypeId).toBool() == true) {
+        return false;
+    }
+    if (m_filterUpdates && thing->stateValue(filter.updateStatusStateTypeId).toString() == "idle") {
+        return false;
+    }
+    for (int i = 0; i < filter.stateFilter.count(); i++) {
+        const QPair<QUuid, QVariant> &stateFilter = filter.stateFilter.at(i);
+        State *state = thing->state(stateFilter.first);
+        if (!state || state->value() != stateFilter.second) {
             return false;
         }
     }
 
+    if (m_filterSetupFailed && thing->setupStatus() != Thing::ThingSetupStatusFailed) {
+        return false;
+    }
+
+    if (!m_predicate.nameFilter.isEmpty() && !thing->name().contains(m_predicate.nameFilter, Qt::CaseInsensitive)) {
+        return false;
+    }
+
     if (!m_paramsFilter.isEmpty()) {
         foreach (const QString &paramName, m_paramsFilter.keys()) {
             Param *param = thing->paramByName(paramName);
@@ -777,14 +893,61 @@ bool ThingsProxy::filterAcceptsRow(int source_row, const QModelIndex &source_par
         }
     }
 
-    if (!m_stateFilter.isEmpty()) {
-        foreach (const QString &stateName, m_stateFilter.keys()) {
-            State *state = thing->stateByName(stateName);
-            if (!state || state->value() != m_stateFilter.value(stateName)) {
-                return false;
-            }
+    return true;
+}
+
+bool ThingsProxy::filterAffectedBy(Thing *thing, const QVector<int> &roles) const
+{
+    // State changes come without roles
+    bool allRoles = roles.isEmpty();
+    if (!m_nameFilter.isEmpty() && (allRoles || roles.contains(Things::RoleName))) {
+        return true;
+    }
+    if (m_filterSetupFailed && (allRoles || roles.contains(Things::RoleSetupStatus))) {
+        return true;
+    }
+    if (allRoles) {
+        if (!m_predicate.valid) {
+            compilePredicate();
         }
+        return classFilter(thing->thingClass()).dependsOnStates;
+    }
+    return false;
+}
+
+int ThingsProxy::interfaceBit(const QString &interface)
+{
+    // Interface names are interned once for all proxies
+    static QHash<QString, int> bits;
+    QHash<QString, int>::const_iterator it = bits.constFind(interface);
+    if (it != bits.constEnd()) {
+        return it.value();
     }
+    int bit = bits.count();
+    bits.insert(interface, bit);
+    return bit;
+}
 
-    return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
+QBitArray ThingsProxy::interfaceBits(const QStringList &interfaces)
+{
+    QBitArray ret;
+    foreach (const QString &interface, interfaces) {
+        int bit = interfaceBit(interface);
+        if (bit >= ret.size()) {
+            ret.resize(bit + 1);
+        }
+        ret.setBit(bit);
+    }
+    return ret;
+}
+
+bool ThingsProxy::intersects(const QBitArray &a, const QBitArray &b)
+{
+    int size = qMin(a.size(), b.size());
+    for (int i = 0; i < size; i++) {
+        if (a.testBit(i) && b.testBit(i)) {
+            return true;
+        }
+    }
+    return false;
 }
@@ -34,10 +34,15 @@
 #include <QUuid>
 #include <QObject>
 #include <QSortFilterProxyModel>
+#include <QBitArray>
+#include <QSet>
 
 #include "things.h"
 
 class Engine;
+class ThingClass;
+class Tag;
+class Tags;
 
 class ThingsProxy : public QSortFilterProxyModel
 {
@@ -189,6 +194,8 @@ public:
     Q_INVOKABLE Thing *getThing(const QUuid &thingId) const;
     Q_INVOKABLE int indexOf(Thing *thing) const;
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
 signals:
     void engineChanged();
     void parentProxyChanged();
@@ -224,10 +231,53 @@ signals:
 
 private slots:
     void invalidateFilterInternal();
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
 
 private:
+    void onTagChanged(Tag *tag);
+    void subscribeTags();
+
+    // Everything in the filter which only depends on the thing class, evaluated once per class
+    struct ClassFilter {
+        bool accepted = false;
+        QUuid batteryCriticalStateTypeId;
+        QUuid connectedStateTypeId;
+        QUuid updateStatusStateTypeId;
+        QList<QPair<QUuid, QVariant>> stateFilter;
+        bool dependsOnStates = false;
+    };
+
+    // The filter properties compiled into lookups, rebuilt lazily after the filter changed
+    struct FilterPredicate {
+        bool valid = false;
+        Tags *tags = nullptr;
+        QBitArray shownInterfaces;
+        QBitArray hiddenInterfaces;
+        QSet<QUuid> shownThingClassIds;
+        QSet<QUuid> hiddenThingClassIds;
+        QSet<QUuid> shownThingIds;
+        QSet<QUuid> hiddenThingIds;
+        QUuid filterThingId;
+        QString nameFilter;
+        QHash<QUuid, ClassFilter> classes;
+    };
+
     Thing *getInternal(int source_index) const;
 
+    void compilePredicate() const;
+    const ClassFilter &classFilter(ThingClass *thingClass) const;
+    bool acceptsThing(Thing *thing) const;
+    bool filterAffectedBy(Thing *thing, const QVector<int> &roles) const;
+
+    static int interfaceBit(const QString &interface);
+    static QBitArray interfaceBits(const QStringList &interfaces);
+    static bool intersects(const QBitArray &a, const QBitArray &b);
+
+    mutable FilterPredicate m_predicate;
+    // Filter results by thing id, dropped for things whose data changes in a way relevant to the filter
+    mutable QHash<QUuid, bool> m_acceptCache;
+    QList<QMetaObject::Connection> m_sourceConnections;
+
     Engine *m_engine = nullptr;
     ThingsProxy *m_parentProxy = nullptr;
     QString m_filterTagId;
@@ -53,6 +53,8 @@ class LogEntry : public QObject
 
 public:
     enum LoggingSource {
+        // Sources not known to this version of the app
+        LoggingSourceUnknown = 0x00,
         LoggingSourceSystem = 0x01,
         LoggingSourceEvents = 0x02,
         LoggingSourceActions = 0x04,
@@ -67,7 +69,9 @@ public:
         LoggingEventTypeActiveChange,
         LoggingEventTypeEnabledChange,
         LoggingEventTypeActionsExecuted,
-        LoggingEventTypeExitActionsExecuted
+        LoggingEventTypeExitActionsExecuted,
+        // Event types not known to this version of the app
+        LoggingEventTypeUnknown
     };
     Q_ENUM(LoggingEventType)
 
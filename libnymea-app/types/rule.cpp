@@ -63,6 +63,33 @@ Rule::~Rule()
 {
 }
 
+void Rule::setLazyDetails(DetailsParser parser)
+{
+    if (m_detailsAccessed) {
+        // Someone is already looking at the (so far empty) details, don't keep them waiting
+        parser(this);
+        return;
+    }
+    m_detailsParser = parser;
+}
+
+bool Rule::detailsLoaded() const
+{
+    return !m_detailsParser;
+}
+
+void Rule::ensureDetails() const
+{
+    m_detailsAccessed = true;
+    if (!m_detailsParser) {
+        return;
+    }
+    // Reset first, the parser fills in the details through the very getters calling this
+    DetailsParser parser = m_detailsParser;
+    m_detailsParser = nullptr;
+    parser(const_cast<Rule*>(this));
+}
+
 QUuid Rule::id() const
 {
     return m_id;
@@ -122,31 +149,37 @@ void Rule::setExecutable(bool executable)
 
 EventDescriptors *Rule::eventDescriptors() const
 {
+    ensureDetails();
     return m_eventDescriptors;
 }
 
 StateEvaluator *Rule::stateEvaluator() const
 {
+    ensureDetails();
     return m_stateEvaluator;
 }
 
 RuleActions *Rule::actions() const
 {
+    ensureDetails();
     return m_actions;
 }
 
 RuleActions *Rule::exitActions() const
 {
+    ensureDetails();
     return m_exitActions;
 }
 
 TimeDescriptor *Rule::timeDescriptor() const
 {
+    ensureDetails();
     return m_timeDescriptor;
 }
 
 void Rule::setStateEvaluator(StateEvaluator *stateEvaluator)
 {
+    ensureDetails();
     if (m_stateEvaluator) {
         m_stateEvaluator->deleteLater();
     }
@@ -199,6 +232,7 @@ bool Rule::compare(Rule *other) const
 #define COMPARE_PTR(a, b) if (!a && !b) return true; if (!a || !b) return false; if (!a->operator==(b)) { qDebug() << a << "!=" << b; return false; }
 bool Rule::operator==(Rule *other) const
 {
+    ensureDetails();
     COMPARE(m_id, other->id());
     COMPARE(m_name, other->name());
     COMPARE(m_enabled, other->enabled());
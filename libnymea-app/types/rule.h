@@ -34,6 +34,8 @@
 #include <QObject>
 #include <QUuid>
 
+#include <functional>
+
 class EventDescriptors;
 class RuleActions;
 class StateEvaluator;
@@ -53,9 +55,19 @@ class Rule : public QObject
     Q_PROPERTY(RuleActions* exitActions READ exitActions CONSTANT)
     Q_PROPERTY(TimeDescriptor* timeDescriptor READ timeDescriptor CONSTANT)
 public:
+    typedef std::function<void(Rule *rule)> DetailsParser;
+
     explicit Rule(const QUuid &id = QUuid(), QObject *parent = nullptr);
     ~Rule();
 
+    // Defers filling in the rule details using the given parser until eventDescriptors,
+    // stateEvaluator, actions, exitActions or timeDescriptor are accessed. The parser is
+    // expected to fetch the details itself, the rule doesn't hold on to them in the meantime.
+    // If any of those has been accessed already, the details are parsed right away.
+    // Must only be called once, on a rule which has no details yet.
+    void setLazyDetails(DetailsParser parser);
+    bool detailsLoaded() const;
+
     QUuid id() const;
 
     QString name() const;
@@ -93,6 +105,8 @@ signals:
     void stateEvaluatorChanged();
 
 private:
+    void ensureDetails() const;
+
     QUuid m_id;
     QString m_name;
     bool m_enabled = true;
@@ -103,6 +117,9 @@ private:
     RuleActions *m_actions = nullptr;
     RuleActions *m_exitActions = nullptr;
     TimeDescriptor *m_timeDescriptor = nullptr;
+
+    mutable DetailsParser m_detailsParser;
+    mutable bool m_detailsAccessed = false;
 };
 
 QDebug operator<<(QDebug &dbg, Rule *rule);
@@ -49,12 +49,7 @@ State *States::get(int index) const
 
 State *States::getState(const QUuid &stateTypeId) const
 {
-    foreach (State *state, m_states) {
-        if (state->stateTypeId() == stateTypeId) {
-            return state;
-        }
-    }
-    return nullptr;
+    return m_statesByTypeId.value(stateTypeId);
 }
 
 int States::rowCount(const QModelIndex &parent) const
@@ -80,12 +75,13 @@ QVariant States::data(const QModelIndex &index, int role) const
 void States::addState(State *state)
 {
     state->setParent(this);
-    beginInsertRows(QModelIndex(), m_states.count(), m_states.count());
+    // States are never removed, so the row of a state never changes
+    int idx = m_states.count();
+    beginInsertRows(QModelIndex(), idx, idx);
     //qDebug() << "States: loaded state" << state->stateTypeId();
     m_states.append(state);
-    connect(state, &State::valueChanged, this, [state, this]() {
-        int idx = m_states.indexOf(state);
-        if (idx < 0) return;
+    m_statesByTypeId.insert(state->stateTypeId(), state);
+    connect(state, &State::valueChanged, this, [idx, this]() {
         emit dataChanged(index(idx), index(idx), {ValueRole});
     });
     endInsertRows();
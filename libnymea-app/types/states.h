@@ -67,6 +67,7 @@ protected:
 
 private:
     QList<State *> m_states;
+    QHash<QUuid, State *> m_statesByTypeId;
 };
 
 #endif // STATES_H
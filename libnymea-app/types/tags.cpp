@@ -79,9 +79,11 @@ void Tags::addTag(Tag *tag)
     connect(tag, &Tag::valueChanged, this, &Tags::tagValueChanged);
     beginInsertRows(QModelIndex(), m_list.count(), m_list.count());
     m_list.append(tag);
+    indexTag(tag);
     endInsertRows();
     qDebug() << "tags count changed";
     emit countChanged();
+    notifySubscribers(tag->tagId(), tag);
 }
 
 void Tags::addTags(QList<Tag *> tags)
@@ -93,10 +95,14 @@ void Tags::addTags(QList<Tag *> tags)
     foreach (Tag *tag, tags) {
         tag->setParent(this);
         connect(tag, &Tag::valueChanged, this, &Tags::tagValueChanged);
+        indexTag(tag);
     }
     m_list.append(tags);
     endInsertRows();
     emit countChanged();
+    foreach (Tag *tag, tags) {
+        notifySubscribers(tag->tagId(), tag);
+    }
 }
 
 void Tags::removeTag(Tag *tag)
@@ -108,9 +114,11 @@ void Tags::removeTag(Tag *tag)
     }
     beginRemoveRows(QModelIndex(), idx, idx);
     m_list.removeAt(idx);
+    unindexTag(tag);
     endRemoveRows();
-    tag->deleteLater();
     emit countChanged();
+    notifySubscribers(tag->tagId(), tag);
+    tag->deleteLater();
 }
 
 Tag *Tags::get(int index) const
@@ -123,22 +131,50 @@ Tag *Tags::get(int index) const
 
 Tag *Tags::findThingTag(const QUuid &thingId, const QString &tagId) const
 {
-    foreach (Tag *tag, m_list) {
-        if (tag->thingId() == thingId && tag->tagId() == tagId) {
-            return tag;
-        }
-    }
-    return nullptr;
+    return m_thingTags.value(TagKey(thingId, tagId));
 }
 
 Tag *Tags::findRuleTag(const QString &ruleId, const QString &tagId) const
 {
-    foreach (Tag *tag, m_list) {
-        if (tag->ruleId() == ruleId && tag->tagId() == tagId) {
-            return tag;
+    return m_ruleTags.value(TagKey(QUuid(ruleId), tagId));
+}
+
+Tag *Tags::findTag(const QUuid &thingId, const QUuid &ruleId, const QString &tagId) const
+{
+    if (!thingId.isNull()) {
+        return m_thingTags.value(TagKey(thingId, tagId));
+    }
+    return m_ruleTags.value(TagKey(ruleId, tagId));
+}
+
+QSet<QUuid> Tags::thingsWithTag(const QString &tagId) const
+{
+    return m_thingsByTagId.value(tagId);
+}
+
+void Tags::subscribe(const QString &tagId, QObject *receiver, TagCallback callback)
+{
+    Subscription subscription;
+    subscription.receiver = receiver;
+    subscription.callback = callback;
+    m_subscriptions[tagId].append(subscription);
+}
+
+void Tags::unsubscribe(QObject *receiver)
+{
+    QMutableHashIterator<QString, QList<Subscription>> it(m_subscriptions);
+    while (it.hasNext()) {
+        it.next();
+        QList<Subscription> &subscriptions = it.value();
+        for (int i = subscriptions.count() - 1; i >= 0; i--) {
+            if (subscriptions.at(i).receiver.isNull() || subscriptions.at(i).receiver == receiver) {
+                subscriptions.removeAt(i);
+            }
+        }
+        if (subscriptions.isEmpty()) {
+            it.remove();
         }
     }
-    return nullptr;
 }
 
 void Tags::clear()
@@ -146,8 +182,14 @@ void Tags::clear()
     beginResetModel();
     qDeleteAll(m_list);
     m_list.clear();
+    m_thingTags.clear();
+    m_ruleTags.clear();
+    m_thingsByTagId.clear();
     endResetModel();
     emit countChanged();
+    foreach (const QString &tagId, m_subscriptions.keys()) {
+        notifySubscribers(tagId, nullptr);
+    }
 }
 
 void Tags::tagValueChanged()
@@ -156,4 +198,49 @@ void Tags::tagValueChanged()
     Tag *tag = static_cast<Tag*>(sender());
     int idx = m_list.indexOf(tag);
     emit dataChanged(index(idx, 0), index(idx, 0), {RoleValue});
+    notifySubscribers(tag->tagId(), tag);
+}
+
+void Tags::indexTag(Tag *tag)
+{
+    if (!tag->thingId().isNull()) {
+        m_thingTags.insert(TagKey(tag->thingId(), tag->tagId()), tag);
+        m_thingsByTagId[tag->tagId()].insert(tag->thingId());
+    } else {
+        m_ruleTags.insert(TagKey(tag->ruleId(), tag->tagId()), tag);
+    }
+}
+
+void Tags::unindexTag(Tag *tag)
+{
+    TagKey key(!tag->thingId().isNull() ? tag->thingId() : tag->ruleId(), tag->tagId());
+    QHash<TagKey, Tag*> &index = !tag->thingId().isNull() ? m_thingTags : m_ruleTags;
+    // Only if it's not been replaced by a duplicate in the meantime
+    if (index.value(key) != tag) {
+        return;
+    }
+    index.remove(key);
+    if (!tag->thingId().isNull()) {
+        QHash<QString, QSet<QUuid>>::iterator it = m_thingsByTagId.find(tag->tagId());
+        if (it != m_thingsByTagId.end()) {
+            it->remove(tag->thingId());
+            if (it->isEmpty()) {
+                m_thingsByTagId.erase(it);
+            }
+        }
+    }
+}
+
+void Tags::notifySubscribers(const QString &tagId, Tag *tag)
+{
+    if (!m_subscriptions.contains(tagId)) {
+        return;
+    }
+    // Callbacks may subscribe or unsubscribe, work on a copy
+    QList<Subscription> subscriptions = m_subscriptions.value(tagId);
+    foreach (const Subscription &subscription, subscriptions) {
+        if (!subscription.receiver.isNull()) {
+            subscription.callback(tag);
+        }
+    }
 }
@@ -32,6 +32,11 @@
 #define TAGS_H
 
 #include <QAbstractListModel>
+#include <QPointer>
+#include <QUuid>
+#include <QSet>
+
+#include <functional>
 
 class Tag;
 
@@ -40,6 +45,9 @@ class Tags: public QAbstractListModel
     Q_OBJECT
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
 public:
+    // tag is nullptr if all tags were reset at once
+    typedef std::function<void(Tag *tag)> TagCallback;
+
     enum Roles {
         RoleThingId,
         RoleRuleId,
@@ -62,6 +70,13 @@ public:
 
     Q_INVOKABLE Tag* findThingTag(const QUuid &thingId, const QString &tagId) const;
     Q_INVOKABLE Tag* findRuleTag(const QString &ruleId, const QString &tagId) const;
+    Tag* findTag(const QUuid &thingId, const QUuid &ruleId, const QString &tagId) const;
+    QSet<QUuid> thingsWithTag(const QString &tagId) const;
+
+    // Calls callback whenever a tag with the given tagId is added, removed or changes its value.
+    // Removed tags are passed in before they are deleted.
+    void subscribe(const QString &tagId, QObject *receiver, TagCallback callback);
+    void unsubscribe(QObject *receiver);
 
     void clear();
 
@@ -72,7 +87,22 @@ private slots:
     void tagValueChanged();
 
 private:
+    struct Subscription {
+        QPointer<QObject> receiver;
+        TagCallback callback;
+    };
+
+    typedef QPair<QUuid, QString> TagKey;
+
+    void indexTag(Tag *tag);
+    void unindexTag(Tag *tag);
+    void notifySubscribers(const QString &tagId, Tag *tag);
+
     QList<Tag*> m_list;
+    QHash<TagKey, Tag*> m_thingTags;
+    QHash<TagKey, Tag*> m_ruleTags;
+    QHash<QString, QSet<QUuid>> m_thingsByTagId;
+    QHash<QString, QList<Subscription>> m_subscriptions;
 };
 
 #endif // TAGS_H
@@ -188,33 +188,33 @@ ThingClass *Thing::thingClass() const
     return m_thingClass;
 }
 
-bool Thing::hasState(const QUuid &stateTypeId) const
+void Thing::setThingClass(ThingClass *thingClass)
 {
-    foreach (State *state, states()->states()) {
-        if (state->stateTypeId() == stateTypeId) {
-            return true;
-        }
+    if (m_thingClass != thingClass) {
+        m_thingClass = thingClass;
+        emit thingClassChanged();
     }
-    return false;
+}
+
+bool Thing::hasState(const QUuid &stateTypeId) const
+{
+    return m_states->getState(stateTypeId) != nullptr;
 }
 
 QVariant Thing::stateValue(const QUuid &stateTypeId) const
 {
-    foreach (State *state, states()->states()) {
-        if (state->stateTypeId() == stateTypeId) {
-            return state->value();
-        }
+    State *state = m_states->getState(stateTypeId);
+    if (!state) {
+        return QVariant();
     }
-    return QVariant();
+    return state->value();
 }
 
 void Thing::setStateValue(const QUuid &stateTypeId, const QVariant &value)
 {
-    foreach (State *state, states()->states()) {
-        if (state->stateTypeId() == stateTypeId) {
-            state->setValue(value);
-            return;
-        }
+    State *state = m_states->getState(stateTypeId);
+    if (state) {
+        state->setValue(value);
     }
 }
 
@@ -54,7 +54,7 @@ class Thing : public QObject
     Q_PROPERTY(Params *params READ params NOTIFY paramsChanged)
     Q_PROPERTY(Params *settings READ settings NOTIFY settingsChanged)
     Q_PROPERTY(States *states READ states NOTIFY statesChanged)
-    Q_PROPERTY(ThingClass *thingClass READ thingClass CONSTANT)
+    Q_PROPERTY(ThingClass *thingClass READ thingClass NOTIFY thingClassChanged)
     Q_PROPERTY(QList<QUuid> loggedStateTypeIds READ loggedStateTypeIds NOTIFY loggedStateTypeIdsChanged)
     Q_PROPERTY(QList<QUuid> loggedEventTypeIds READ loggedEventTypeIds NOTIFY loggedEventTypeIdsChanged)
     Q_PROPERTY(QList<QUuid> loggedActionTypeIds READ loggedActionTypeIds NOTIFY loggedActionTypeIdsChanged)
@@ -135,6 +135,7 @@ public:
     void setLoggedActionTypeIds(const QList<QUuid> &loggedActionTypeIds);
 
     ThingClass *thingClass() const;
+    void setThingClass(ThingClass *thingClass);
 
     Q_INVOKABLE bool hasState(const QUuid &stateTypeId) const;
     Q_INVOKABLE State *state(const QUuid &stateTypeId) const;
@@ -152,6 +153,7 @@ signals:
     void paramsChanged();
     void settingsChanged();
     void statesChanged();
+    void thingClassChanged();
     void loggedStateTypeIdsChanged();
     void loggedEventTypeIdsChanged();
     void loggedActionTypeIdsChanged();
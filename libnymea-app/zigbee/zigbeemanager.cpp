@@ -166,7 +166,7 @@ int ZigbeeManager::createBinding(const QUuid &networkUuid, const QString &source
         {"destinationAddress", destinationAddress},
         {"destinationEndpointId", destinationEndpointId}
     };
-    qCDebug(dcZigbee()) << "Creating binding for:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZigbee()) << "Creating binding for:" << LogPayload(params);
     return m_engine->jsonRpcClient()->sendCommand("Zigbee.CreateBinding", params, this, "createBindingResponse");
 }
 
@@ -179,7 +179,7 @@ int ZigbeeManager::createGroupBinding(const QUuid &networkUuid, const QString &s
         {"clusterId", clusterId},
         {"destinationGroupAddress", destinationGroupAddress}
     };
-    qCDebug(dcZigbee()) << "Creating binding for:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZigbee()) << "Creating binding for:" << LogPayload(params);
     return m_engine->jsonRpcClient()->sendCommand("Zigbee.CreateBinding", params, this, "createBindingResponse");
 }
 
@@ -197,7 +197,7 @@ int ZigbeeManager::removeBinding(const QUuid &networkUuid, ZigbeeNodeBinding *bi
     } else {
         params.insert("destinationGroupAddress", binding->groupAddress());
     }
-    qCDebug(dcZigbee()) << "Removing binding for:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZigbee()) << "Removing binding for:" << LogPayload(params);
     return m_engine->jsonRpcClient()->sendCommand("Zigbee.RemoveBinding", params, this, "removeBindingResponse");
 }
 
@@ -289,7 +289,7 @@ void ZigbeeManager::factoryResetNetworkResponse(int commandId, const QVariantMap
 
 void ZigbeeManager::getNodesResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcZigbee()) << "Zigbee get nodes response" << commandId << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZigbee()) << "Zigbee get nodes response" << commandId << LogPayload(params);
 
     foreach (const QVariant &nodeVariant, params.value("zigbeeNodes").toList()) {
         QVariantMap nodeMap = nodeVariant.toMap();
@@ -314,7 +314,7 @@ void ZigbeeManager::removeNodeResponse(int commandId, const QVariantMap &params)
 
 void ZigbeeManager::createBindingResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcZigbee()) << "Create binding response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZigbee()) << "Create binding response" << LogPayload(params);
     QMetaEnum errorEnum = QMetaEnum::fromType<ZigbeeError>();
     ZigbeeError error = static_cast<ZigbeeError>(errorEnum.keyToValue(params.value("zigbeeError").toByteArray()));
     emit createBindingReply(commandId, error);
@@ -322,7 +322,7 @@ void ZigbeeManager::createBindingResponse(int commandId, const QVariantMap &para
 
 void ZigbeeManager::removeBindingResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcZigbee()) << "Remove binding response" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZigbee()) << "Remove binding response" << LogPayload(params);
     QMetaEnum errorEnum = QMetaEnum::fromType<ZigbeeError>();
     ZigbeeError error = static_cast<ZigbeeError>(errorEnum.keyToValue(params.value("zigbeeError").toByteArray()));
     emit removeBindingReply(commandId, error);
@@ -330,7 +330,7 @@ void ZigbeeManager::removeBindingResponse(int commandId, const QVariantMap &para
 
 void ZigbeeManager::notificationReceived(const QVariantMap &notification)
 {
-//    qCDebug(dcZigbee()) << "Zigbee notification" << qUtf8Printable(QJsonDocument::fromVariant(notification).toJson());
+//    qCDebug(dcZigbee()) << "Zigbee notification" << LogPayload(notification);
     QString notificationString = notification.value("notification").toString();
     if (notificationString == "Zigbee.AdapterAdded") {
         QVariantMap adapterMap = notification.value("params").toMap().value("adapter").toMap();
@@ -133,7 +133,7 @@ void ZWaveManager::isZWaveAvailableResponse(int commandId, const QVariantMap &pa
 
 void ZWaveManager::getSerialPortsResponse(int commandId, const QVariantMap &params)
 {
-    qCDebug(dcZWave()) << "Serial ports response:" << commandId << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZWave()) << "Serial ports response:" << commandId << LogPayload(params);
     foreach (const QVariant &entryVariant, params.value("serialPorts").toList()) {
         SerialPort *serialPort = SerialPort::unpackSerialPort(entryVariant.toMap(), this);
         m_serialPorts->addSerialPort(serialPort);
@@ -213,7 +213,7 @@ void ZWaveManager::getNodesResponse(int commandId, const QVariantMap &params)
         return;
     }
 
-    qCDebug(dcZWave()) << "GetNodes response:" << qUtf8Printable(QJsonDocument::fromVariant(params).toJson());
+    qCDebug(dcZWave()) << "GetNodes response:" << LogPayload(params);
 
     foreach (const QVariant &entry, params.value("nodes").toList()) {
         QVariantMap nodeMap = entry.toMap();
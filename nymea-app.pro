@@ -120,3 +120,13 @@ TRANSLATIONS += $$files($$absolute_path(nymea-app)/translations/*.ts, true)
 system("lrelease $$TRANSLATIONS")
 lrelease.commands = lrelease $$TRANSLATIONS
 QMAKE_EXTRA_TARGETS += lrelease
+
+# The rule templates are compiled into the static table of RuleTemplateCatalogue. The generated
+# libnymea-app/ruletemplates/ruletemplatecatalogue_data.cpp is checked in, so building doesn't
+# require python. Run "make ruletemplates" after changing nymea-app/ruletemplates/*.json.
+# Pass e.g. PYTHON=python to qmake where there is no python3 executable.
+isEmpty(PYTHON): PYTHON = python3
+RULE_TEMPLATES = $$files($${top_srcdir}/nymea-app/ruletemplates/*.json)
+RULE_TEMPLATES -= $${top_srcdir}/nymea-app/ruletemplates/template.json
+ruletemplates.commands = $${PYTHON} $${top_srcdir}/libnymea-app/ruletemplates/compileruletemplates.py $${top_srcdir}/libnymea-app/ruletemplates/ruletemplatecatalogue_data.cpp $${RULE_TEMPLATES}
+QMAKE_EXTRA_TARGETS += ruletemplates
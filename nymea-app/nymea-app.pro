@@ -61,7 +61,6 @@ SOURCES += main.cpp \
     utils/qhashqml.cpp
 
 RESOURCES += resources.qrc \
-    ruletemplates.qrc \
     images.qrc \
     translations.qrc \
 
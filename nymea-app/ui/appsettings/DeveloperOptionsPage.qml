@@ -61,4 +61,53 @@ SettingsPageBase {
         text: qsTr("Configure logging categories")
         onClicked: pageStack.push(Qt.resolvedUrl("../appsettings/LoggingCategories.qml"))
     }
+
+    SettingsPageSectionHeader {
+        text: qsTr("JSON-RPC requests")
+    }
+
+    NymeaItemDelegate {
+        Layout.fillWidth: true
+        text: qsTr("Wire encoding")
+        subText: engine.jsonRpcClient.wireEncoding
+        progressive: false
+    }
+
+    ItemDelegate {
+        Layout.fillWidth: true
+        topPadding: 0
+        contentItem: RowLayout {
+            Label {
+                Layout.fillWidth: true
+                text: qsTr("Maximum requests in flight")
+            }
+            SpinBox {
+                from: 1
+                to: 256
+                value: engine.jsonRpcClient.maxInFlight
+                onValueModified: engine.jsonRpcClient.maxInFlight = value
+            }
+        }
+    }
+
+    NymeaItemDelegate {
+        Layout.fillWidth: true
+        text: qsTr("In flight / queued")
+        subText: engine.jsonRpcClient.inFlight + " / " + engine.jsonRpcClient.queueDepth
+        progressive: false
+    }
+
+    NymeaItemDelegate {
+        Layout.fillWidth: true
+        text: qsTr("Wait time (average / maximum)")
+        subText: qsTr("%1 ms / %2 ms").arg(engine.jsonRpcClient.averageWaitTime).arg(engine.jsonRpcClient.maxWaitTime)
+        progressive: false
+    }
+
+    NymeaItemDelegate {
+        Layout.fillWidth: true
+        text: qsTr("Coalesced / timed out requests")
+        subText: engine.jsonRpcClient.coalescedRequests + " / " + engine.jsonRpcClient.timedOutRequests
+        progressive: false
+    }
 }
@@ -63,6 +63,8 @@ Item {
         live: true
         graphSeries: lineSeries1
         viewStartTime: xAxis.min
+        viewEndTime: xAxis.max
+        viewWidth: chartView.plotArea.width
     }
 
     LogsModelNg {
@@ -73,6 +75,8 @@ Item {
         live: true
         graphSeries: connectedLineSeries
         viewStartTime: xAxis.min
+        viewEndTime: xAxis.max
+        viewWidth: chartView.plotArea.width
     }
 
     ChartView {
@@ -251,11 +255,6 @@ Item {
 
             lowerSeries: LineSeries {
                 id: connectedLineSeries
-                onPointAdded: {
-                    var newPoint = connectedLineSeries.at(index)
-                    //                        print("pointadded", newPoint.x, newPoint.y)
-                }
-
             }
             color: "#55ff0000"
             borderWidth: 0
@@ -276,17 +275,29 @@ Item {
 
             upperSeries: LineSeries {
                 id: lineSeries1
-                onPointAdded: {
-                    var newPoint = lineSeries1.at(index)
-                    //                        print("pointadded", newPoint.x, newPoint.y)
+                // The level of detail refills the series with replace(), ascending in x. It holds
+                // the visible points only, so the newest point seen so far tells new data apart
+                // from panning.
+                property real newestX: 0
+                onPointsReplaced: {
+                    if (count == 0) {
+                        return;
+                    }
+                    var firstPoint = lineSeries1.at(0)
+                    var newPoint = lineSeries1.at(count - 1)
 
                     if (newPoint.x > lineSeries0.at(0).x) {
                         lineSeries0.replace(0, newPoint.x, 0)
                     }
-                    if (newPoint.x < lineSeries0.at(1).x) {
-                        lineSeries0.replace(1, newPoint.x, 0)
+                    if (firstPoint.x < lineSeries0.at(1).x) {
+                        lineSeries0.replace(1, firstPoint.x, 0)
                     }
 
+                    if (newPoint.x <= newestX) {
+                        return;
+                    }
+                    newestX = newPoint.x
+
                     if (newPoint.x <= xAxis.max.getTime() || logsModelNg.busy) {
                         return;
                     }
@@ -314,21 +325,26 @@ Item {
 
                 if (lineSeries1.count == 1) {
                     selectedHighlights.removePoints(0, selectedHighlights.count)
-                    selectedHighlights.append(lineSeries1.at(0).x, lineSeries1.at(1).y)
+                    selectedHighlights.append(lineSeries1.at(0).x, lineSeries1.at(0).y)
                     return;
                 }
 
-                var searchIndex = Math.floor(lineSeries1.count / 2)
+                // Points are ascending in x
                 var previousIndex = 0;
                 var nextIndex = lineSeries1.count - 1;
+                if (point.x <= lineSeries1.at(previousIndex).x) {
+                    nextIndex = previousIndex;
+                } else if (point.x >= lineSeries1.at(nextIndex).x) {
+                    previousIndex = nextIndex;
+                }
 
-                while (previousIndex + 1 != nextIndex) {
-                    if (point.x < lineSeries1.at(searchIndex).x) {
+                while (previousIndex + 1 < nextIndex) {
+                    var searchIndex = previousIndex + Math.floor((nextIndex - previousIndex) / 2);
+                    if (lineSeries1.at(searchIndex).x <= point.x) {
                         previousIndex = searchIndex;
-                    } else if (point.x > lineSeries1.at(searchIndex).x) {
+                    } else {
                         nextIndex = searchIndex;
                     }
-                    searchIndex = previousIndex + Math.floor((nextIndex - previousIndex) / 2);
                 }
                 var diffToPrevious = Math.abs(point.x - lineSeries1.at(previousIndex).x)
                 var diffToNext = Math.abs(point.x - lineSeries1.at(nextIndex).x)
@@ -224,6 +224,9 @@ Page {
                     logsModel: thermostatDelegate.logsModel
                     xySeries: series
                     sampleRate: XYSeriesAdapter.SampleRate10Minutes
+                    viewStartTime: dateTimeAxis.min
+                    viewEndTime: dateTimeAxis.max
+                    viewWidth: chartView.plotArea.width
                 }
 
                 Component.onCompleted: {
@@ -273,6 +276,9 @@ Page {
                     logsModel: tempDelegate.logsModel
                     xySeries: series
                     sampleRate: XYSeriesAdapter.SampleRate10Minutes
+                    viewStartTime: dateTimeAxis.min
+                    viewEndTime: dateTimeAxis.max
+                    viewWidth: chartView.plotArea.width
                 }
 
                 Component.onCompleted: {
@@ -321,6 +327,9 @@ Page {
                     logsModel: humidityDelegate.logsModel
                     xySeries: series
                     sampleRate: XYSeriesAdapter.SampleRate10Minutes
+                    viewStartTime: dateTimeAxis.min
+                    viewEndTime: dateTimeAxis.max
+                    viewWidth: chartView.plotArea.width
                 }
 
                 Component.onCompleted: {
@@ -367,6 +376,9 @@ Page {
                     logsModel: vocDelegate.logsModel
                     xySeries: series
                     sampleRate: XYSeriesAdapter.SampleRate10Minutes
+                    viewStartTime: dateTimeAxis.min
+                    viewEndTime: dateTimeAxis.max
+                    viewWidth: chartView.plotArea.width
                 }
 
                 Component.onCompleted: {
@@ -0,0 +1,14 @@
+include(../../shared.pri)
+
+QT += core network testlib bluetooth websockets charts quick
+CONFIG += testcase
+
+INCLUDEPATH += $$top_srcdir/libnymea-app
+
+LIBS += -L$$top_builddir/libnymea-app/ -lnymea-app
+win32:Debug:LIBS += -L$$top_builddir/libnymea-app/debug
+win32:Release:LIBS += -L$$top_builddir/libnymea-app/release
+linux:!android:!nozeroconf:LIBS += -lavahi-client -lavahi-common
+LIBS += -lssl -lcrypto
+
+linux:!android:PRE_TARGETDEPS += $$top_builddir/libnymea-app/libnymea-app.a
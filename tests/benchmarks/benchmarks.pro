@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    energylogs \
+    jsonrpcencoding \
+    jsonrpcframer \
+    logpayload \
+    scripthighlighter \
+    scriptoutline \
+    things \
+    thingsproxy
@@ -0,0 +1,6 @@
+TARGET = tst_energylogs
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_energylogs.cpp
@@ -0,0 +1,222 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "energy/powerbalancelogs.h"
+
+#include <QtTest>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// A year of 15 minute samples
+static const int sampleCount = 35040;
+static const int sampleSecs = 15 * 60;
+
+class TestEnergyLogs: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void load();
+    void loadLegacy();
+
+    void memory();
+    void memoryLegacy();
+
+    void prependDays();
+
+    void indexOf();
+
+private:
+    QVariantMap makeResponse(qint64 from, int count) const;
+    QList<EnergyLogEntry*> unpackLegacy(const QVariantMap &params, QObject *parent) const;
+    static qint64 heapInUse();
+
+    qint64 m_start = 0;
+    QVariantMap m_response;
+};
+
+void TestEnergyLogs::initTestCase()
+{
+    QLoggingCategory::setFilterRules("EnergyLogs.debug=false");
+    m_start = QDateTime(QDate(2022, 1, 1), QTime(0, 0)).toSecsSinceEpoch();
+    m_response = makeResponse(m_start, sampleCount);
+}
+
+void TestEnergyLogs::load()
+{
+    QBENCHMARK {
+        PowerBalanceLogs logs;
+        QMetaObject::invokeMethod(&logs, "getLogsResponse", Qt::DirectConnection, Q_ARG(int, 0), Q_ARG(QVariantMap, m_response));
+        QCOMPARE(logs.rowCount(), sampleCount);
+    }
+}
+
+void TestEnergyLogs::loadLegacy()
+{
+    // One PowerBalanceLogEntry QObject per sample, the way EnergyLogs stored samples before the columnar store
+    QBENCHMARK {
+        QObject parent;
+        QList<EnergyLogEntry*> entries = unpackLegacy(m_response, &parent);
+        QCOMPARE(entries.count(), sampleCount);
+    }
+}
+
+void TestEnergyLogs::memory()
+{
+    qint64 before = heapInUse();
+    PowerBalanceLogs *logs = new PowerBalanceLogs();
+    QMetaObject::invokeMethod(logs, "getLogsResponse", Qt::DirectConnection, Q_ARG(int, 0), Q_ARG(QVariantMap, m_response));
+    qint64 after = heapInUse();
+    QCOMPARE(logs->rowCount(), sampleCount);
+    if (before < 0) {
+        delete logs;
+        QSKIP("Heap statistics not available on this platform");
+    }
+    qDebug() << "Columnar store:" << (after - before) << "bytes for" << sampleCount << "samples," << logs->series().capacityBytes() << "bytes in arrays";
+    QTest::setBenchmarkResult(after - before, QTest::BytesAllocated);
+    delete logs;
+}
+
+void TestEnergyLogs::memoryLegacy()
+{
+    qint64 before = heapInUse();
+    QObject *parent = new QObject();
+    QList<EnergyLogEntry*> entries = unpackLegacy(m_response, parent);
+    qint64 after = heapInUse();
+    QCOMPARE(entries.count(), sampleCount);
+    if (before < 0) {
+        delete parent;
+        QSKIP("Heap statistics not available on this platform");
+    }
+    qDebug() << "QObject per sample:" << (after - before) << "bytes for" << sampleCount << "samples";
+    QTest::setBenchmarkResult(after - before, QTest::BytesAllocated);
+    delete parent;
+}
+
+void TestEnergyLogs::prependDays()
+{
+    // Scrolling back in a chart fetches one day at a time, each one prepended to what's loaded already
+    const int samplesPerDay = 24 * 3600 / sampleSecs;
+    const int days = sampleCount / samplesPerDay;
+    QList<QVariantMap> responses;
+    for (int i = days - 1; i >= 0; i--) {
+        responses.append(makeResponse(m_start + i * samplesPerDay * sampleSecs, samplesPerDay));
+    }
+
+    QBENCHMARK {
+        PowerBalanceLogs logs;
+        foreach (const QVariantMap &response, responses) {
+            QMetaObject::invokeMethod(&logs, "getLogsResponse", Qt::DirectConnection, Q_ARG(int, 0), Q_ARG(QVariantMap, response));
+        }
+        QCOMPARE(logs.rowCount(), days * samplesPerDay);
+    }
+}
+
+void TestEnergyLogs::indexOf()
+{
+    PowerBalanceLogs logs;
+    QMetaObject::invokeMethod(&logs, "getLogsResponse", Qt::DirectConnection, Q_ARG(int, 0), Q_ARG(QVariantMap, m_response));
+
+    QList<QDateTime> timestamps;
+    for (int i = 0; i < 10000; i++) {
+        // Slightly off the sample grid, like a chart position
+        timestamps.append(QDateTime::fromSecsSinceEpoch(m_start + (i * 7919 % sampleCount) * sampleSecs + 120));
+    }
+
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        foreach (const QDateTime &timestamp, timestamps) {
+            if (logs.indexOf(timestamp) >= 0) {
+                found++;
+            }
+        }
+    }
+    QCOMPARE(found, timestamps.count());
+}
+
+QVariantMap TestEnergyLogs::makeResponse(qint64 from, int count) const
+{
+    QVariantList entries;
+    for (int i = 0; i < count; i++) {
+        QVariantMap entry;
+        entry.insert("timestamp", from + i * sampleSecs);
+        entry.insert("consumption", 400.0 + i % 96);
+        entry.insert("production", 1000.0 * qMax(0, 48 - qAbs(i % 96 - 48)) / 48);
+        entry.insert("acquisition", 100.0);
+        entry.insert("storage", -50.0);
+        entry.insert("totalConsumption", 0.1 * i);
+        entry.insert("totalProduction", 0.2 * i);
+        entry.insert("totalAcquisition", 0.05 * i);
+        entry.insert("totalReturn", 0.15 * i);
+        entries.append(entry);
+    }
+    QVariantMap params;
+    params.insert("powerBalanceLogEntries", entries);
+    return params;
+}
+
+QList<EnergyLogEntry *> TestEnergyLogs::unpackLegacy(const QVariantMap &params, QObject *parent) const
+{
+    QList<EnergyLogEntry*> ret;
+    foreach (const QVariant &variant, params.value("powerBalanceLogEntries").toList()) {
+        QVariantMap map = variant.toMap();
+        ret.append(new PowerBalanceLogEntry(QDateTime::fromSecsSinceEpoch(map.value("timestamp").toLongLong()),
+                                            map.value("consumption").toDouble(),
+                                            map.value("production").toDouble(),
+                                            map.value("acquisition").toDouble(),
+                                            map.value("storage").toDouble(),
+                                            map.value("totalConsumption").toDouble(),
+                                            map.value("totalProduction").toDouble(),
+                                            map.value("totalAcquisition").toDouble(),
+                                            map.value("totalReturn").toDouble(),
+                                            parent));
+    }
+    return ret;
+}
+
+qint64 TestEnergyLogs::heapInUse()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    return mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+    return mallinfo().uordblks;
+#else
+    return -1;
+#endif
+}
+
+QTEST_MAIN(TestEnergyLogs)
+#include "tst_energylogs.moc"
@@ -0,0 +1,9 @@
+TARGET = tst_jsonrpcencoding
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+HEADERS += testcore.h
+
+SOURCES += tst_jsonrpcencoding.cpp \
+    testcore.cpp
@@ -0,0 +1,228 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "testcore.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtEndian>
+
+TestCore::TestCore(const QStringList &encodings, QObject *parent):
+    QObject(parent),
+    m_encodings(encodings),
+    m_uuid(QUuid::createUuid())
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &TestCore::onNewConnection);
+}
+
+bool TestCore::listen()
+{
+    return m_server.listen(QHostAddress::LocalHost);
+}
+
+QUrl TestCore::url() const
+{
+    return QUrl(QString("nymea://127.0.0.1:%1").arg(m_server.serverPort()));
+}
+
+QUuid TestCore::uuid() const
+{
+    return m_uuid;
+}
+
+void TestCore::setReply(const QString &method, const QJsonObject &params)
+{
+    m_replies.insert(method, params);
+}
+
+QString TestCore::encoding() const
+{
+    return m_codec.name();
+}
+
+int TestCore::helloCount() const
+{
+    return m_helloCount;
+}
+
+qint64 TestCore::bytesSent() const
+{
+    return m_bytesSent;
+}
+
+qint64 TestCore::bytesReceived() const
+{
+    return m_bytesReceived;
+}
+
+void TestCore::resetCounters()
+{
+    m_bytesSent = 0;
+    m_bytesReceived = 0;
+}
+
+void TestCore::onNewConnection()
+{
+    QTcpSocket *socket = m_server.nextPendingConnection();
+    if (m_client) {
+        m_client->deleteLater();
+    }
+    m_client = socket;
+    m_buffer.clear();
+    m_codec = JsonRpcCodec();
+    connect(socket, &QTcpSocket::readyRead, this, &TestCore::onReadyRead);
+}
+
+void TestCore::onReadyRead()
+{
+    QByteArray data = m_client->readAll();
+    m_bytesReceived += data.size();
+    m_buffer.append(data);
+
+    while (true) {
+        int start = 0;
+        while (start < m_buffer.size() && QByteArray(" \r\n\t").contains(m_buffer.at(start))) {
+            start++;
+        }
+        m_buffer.remove(0, start);
+        if (m_buffer.isEmpty()) {
+            return;
+        }
+
+        // Requests sent before the client got the Hello reply are still JSON text
+        QByteArray frame;
+        JsonRpcCodec codec;
+        if (m_buffer.at(0) == '{') {
+            int end = m_buffer.indexOf('\n');
+            if (end < 0) {
+                return;
+            }
+            frame = m_buffer.left(end);
+            m_buffer.remove(0, end + 1);
+        } else {
+            if (m_buffer.size() < 4) {
+                return;
+            }
+            quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(m_buffer.constData()));
+            if (static_cast<quint32>(m_buffer.size() - 4) < length) {
+                return;
+            }
+            frame = m_buffer.mid(4, length);
+            m_buffer.remove(0, 4 + length);
+            codec = m_codec;
+        }
+
+        QJsonObject request;
+        QString errorString;
+        if (!codec.decode(frame, &request, &errorString)) {
+            qWarning() << "TestCore: Could not decode request:" << errorString;
+            continue;
+        }
+        handleRequest(request);
+    }
+}
+
+void TestCore::handleRequest(const QJsonObject &request)
+{
+    int id = request.value("id").toInt();
+    QString method = request.value("method").toString();
+    QJsonObject params = request.value("params").toObject();
+
+    if (method == "JSONRPC.Hello") {
+        m_helloCount++;
+        QString encoding;
+        if (params.contains("encodings")) {
+            if (m_encodings.isEmpty()) {
+                sendError(id, "Invalid params: Unexpected parameter encodings");
+                return;
+            }
+            foreach (const QJsonValue &offered, params.value("encodings").toArray()) {
+                if (m_encodings.contains(offered.toString())) {
+                    encoding = offered.toString();
+                    break;
+                }
+            }
+        }
+
+        QJsonObject hello;
+        hello.insert("uuid", m_uuid.toString());
+        hello.insert("name", "Test core");
+        hello.insert("version", "1.0.0");
+        hello.insert("protocol version", "6.0");
+        hello.insert("initialSetupRequired", false);
+        hello.insert("authenticationRequired", false);
+        hello.insert("pushButtonAuthAvailable", false);
+        if (!encoding.isEmpty()) {
+            hello.insert("encoding", encoding);
+        }
+        sendReply(id, hello);
+
+        // Switching right after the reply has been sent
+        if (!encoding.isEmpty()) {
+            JsonRpcCodec::Encoding picked;
+            JsonRpcCodec::encodingFromName(encoding, &picked);
+            m_codec = JsonRpcCodec(picked);
+        }
+        return;
+    }
+
+    if (method == "JSONRPC.SetNotificationStatus") {
+        sendReply(id, params);
+        return;
+    }
+
+    sendReply(id, m_replies.value(method));
+}
+
+void TestCore::sendReply(int id, const QJsonObject &params)
+{
+    QJsonObject reply;
+    reply.insert("id", id);
+    reply.insert("status", "success");
+    reply.insert("params", params);
+    send(reply);
+}
+
+void TestCore::sendError(int id, const QString &error)
+{
+    QJsonObject reply;
+    reply.insert("id", id);
+    reply.insert("status", "error");
+    reply.insert("error", error);
+    send(reply);
+}
+
+void TestCore::send(const QJsonObject &message)
+{
+    QByteArray data = m_codec.encode(message);
+    m_bytesSent += data.size();
+    m_client->write(data);
+}
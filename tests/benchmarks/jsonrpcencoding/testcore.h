@@ -0,0 +1,94 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TESTCORE_H
+#define TESTCORE_H
+
+#include "jsonrpc/jsonrpccodec.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUuid>
+
+/*
+ * Local stand-in for nymea core. Speaks just enough JSON-RPC over plain TCP for JsonRpcClient
+ * to complete the handshake and answers every other method with a canned reply.
+ *
+ * The wire encoding is negotiated in JSONRPC.Hello like a real core would. A core without any
+ * encodings behaves like an older core and rejects the unknown "encodings" param.
+ */
+class TestCore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestCore(const QStringList &encodings, QObject *parent = nullptr);
+
+    bool listen();
+    QUrl url() const;
+    QUuid uuid() const;
+
+    void setReply(const QString &method, const QJsonObject &params);
+
+    // Encoding picked for the current client
+    QString encoding() const;
+    int helloCount() const;
+    qint64 bytesSent() const;
+    qint64 bytesReceived() const;
+    void resetCounters();
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+
+private:
+    void handleRequest(const QJsonObject &request);
+    void sendReply(int id, const QJsonObject &params);
+    void sendError(int id, const QString &error);
+    void send(const QJsonObject &message);
+
+    QTcpServer m_server;
+    QPointer<QTcpSocket> m_client;
+    QStringList m_encodings;
+    QUuid m_uuid;
+    QHash<QString, QJsonObject> m_replies;
+
+    QByteArray m_buffer;
+    JsonRpcCodec m_codec;
+    int m_helloCount = 0;
+    qint64 m_bytesSent = 0;
+    qint64 m_bytesReceived = 0;
+};
+
+#endif // TESTCORE_H
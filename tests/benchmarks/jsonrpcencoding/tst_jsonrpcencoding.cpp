@@ -0,0 +1,297 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "testcore.h"
+
+#include "connection/nymeahost.h"
+#include "jsonrpc/jsonrpccodec.h"
+#include "jsonrpc/jsonrpcframer.h"
+#include "jsonrpc/jsonrpcclient.h"
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QUuid>
+
+class TestJsonRpcEncoding: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void negotiation_data();
+    void negotiation();
+
+    void decode_data();
+    void decode();
+
+    void startupFetch_data();
+    void startupFetch();
+
+private:
+    QJsonObject createGetThingClassesReply(int thingClassCount) const;
+    QJsonObject createGetThingsReply(int thingCount, int stateCount) const;
+    void addEncodingRows();
+
+    QHash<QString, QJsonObject> m_payloads;
+};
+
+void TestJsonRpcEncoding::initTestCase()
+{
+    // What a well equipped installation sends during startup
+    m_payloads.insert("Integrations.GetThingClasses", createGetThingClassesReply(600));
+    m_payloads.insert("Integrations.GetThings", createGetThingsReply(200, 30));
+}
+
+void TestJsonRpcEncoding::negotiation_data()
+{
+    QTest::addColumn<QStringList>("coreEncodings");
+    QTest::addColumn<QString>("expectedEncoding");
+    QTest::addColumn<int>("expectedHellos");
+
+    QTest::newRow("older core") << QStringList() << "json" << 2;
+    QTest::newRow("qcompress only") << QStringList({"json+qcompress"}) << "json+qcompress" << 1;
+    QTest::newRow("all") << QStringList({"json+qcompress", "cbor+qcompress", "cbor"}) << JsonRpcCodec::supportedEncodings(false).first() << 1;
+}
+
+void TestJsonRpcEncoding::negotiation()
+{
+    QFETCH(QStringList, coreEncodings);
+    QFETCH(QString, expectedEncoding);
+    QFETCH(int, expectedHellos);
+
+    TestCore core(coreEncodings);
+    QVERIFY(core.listen());
+    core.setReply("Integrations.GetThings", m_payloads.value("Integrations.GetThings"));
+
+    NymeaHost host;
+    host.setUuid(core.uuid());
+    host.connections()->addConnection(core.url(), Connection::BearerTypeLoopback, false, "Test core");
+
+    JsonRpcClient client;
+    QSignalSpy handshakeSpy(&client, &JsonRpcClient::handshakeReceived);
+    client.connectToHost(&host, host.connections()->get(0));
+    QVERIFY(handshakeSpy.wait());
+
+    QCOMPARE(client.wireEncoding(), expectedEncoding);
+    QCOMPARE(core.encoding(), expectedEncoding);
+    QCOMPARE(core.helloCount(), expectedHellos);
+
+    // The session must work in whatever has been negotiated, in both directions
+    QJsonObject received;
+    client.sendCommand("Integrations.GetThings", QVariantMap(), this, [&received](int, const QJsonObject &params) {
+        received = params;
+    });
+    QTRY_VERIFY(!received.isEmpty());
+    QCOMPARE(received.value("things").toArray().count(), m_payloads.value("Integrations.GetThings").value("things").toArray().count());
+}
+
+void TestJsonRpcEncoding::decode_data()
+{
+    addEncodingRows();
+}
+
+void TestJsonRpcEncoding::decode()
+{
+    QFETCH(QString, encodingName);
+    QFETCH(QString, method);
+
+    JsonRpcCodec::Encoding encoding;
+    QVERIFY(JsonRpcCodec::encodingFromName(encodingName, &encoding));
+    JsonRpcCodec codec(encoding);
+
+    QJsonObject reply;
+    reply.insert("id", 1);
+    reply.insert("status", "success");
+    reply.insert("params", m_payloads.value(method));
+    QByteArray data = codec.encode(reply);
+
+    JsonRpcFramer framer;
+    framer.setMode(codec.isBinary() ? JsonRpcFramer::FramingModeLengthPrefixed : JsonRpcFramer::FramingModeJson);
+    framer.append(data);
+    QByteArray frame;
+    QCOMPARE(framer.takeFrame(&frame), JsonRpcFramer::FrameStatusComplete);
+    qDebug() << method << encodingName << "bytes on the wire:" << data.size();
+
+    QJsonObject message;
+    QBENCHMARK {
+        QVERIFY(codec.decode(frame, &message));
+    }
+    QCOMPARE(message.value("params").toObject().count(), m_payloads.value(method).count());
+}
+
+void TestJsonRpcEncoding::startupFetch_data()
+{
+    addEncodingRows();
+}
+
+void TestJsonRpcEncoding::startupFetch()
+{
+    QFETCH(QString, encodingName);
+    QFETCH(QString, method);
+
+    TestCore core(encodingName == "json" ? QStringList() : QStringList({encodingName}));
+    QVERIFY(core.listen());
+    core.setReply(method, m_payloads.value(method));
+
+    NymeaHost host;
+    host.setUuid(core.uuid());
+    host.connections()->addConnection(core.url(), Connection::BearerTypeLoopback, false, "Test core");
+
+    JsonRpcClient client;
+    QSignalSpy handshakeSpy(&client, &JsonRpcClient::handshakeReceived);
+    client.connectToHost(&host, host.connections()->get(0));
+    QVERIFY(handshakeSpy.wait());
+    QCOMPARE(client.wireEncoding(), encodingName);
+    // Let the notification setup go by
+    QTest::qWait(100);
+
+    // From sending the request until the reply has been decoded, including the transfer over loopback
+    QSignalSpy responseSpy(&client, &JsonRpcClient::responseReceived);
+    core.resetCounters();
+    int fetches = 0;
+    QBENCHMARK {
+        client.sendCommand(method, QVariantMap(), this, [](int, const QJsonObject &) {});
+        QVERIFY(responseSpy.wait());
+        fetches++;
+    }
+    qDebug() << method << encodingName << "bytes on the wire per fetch:" << core.bytesSent() / fetches << "sent," << core.bytesReceived() / fetches << "received";
+}
+
+QJsonObject TestJsonRpcEncoding::createGetThingClassesReply(int thingClassCount) const
+{
+    QJsonArray thingClasses;
+    for (int i = 0; i < thingClassCount; i++) {
+        QJsonObject thingClass;
+        thingClass.insert("id", QUuid::createUuid().toString());
+        thingClass.insert("vendorId", QUuid::createUuid().toString());
+        thingClass.insert("pluginId", QUuid::createUuid().toString());
+        thingClass.insert("name", QString("thingClass%1").arg(i));
+        thingClass.insert("displayName", QString("Thing class %1").arg(i));
+        thingClass.insert("setupMethod", "SetupMethodJustAdd");
+        thingClass.insert("createMethods", QJsonArray({"CreateMethodUser", "CreateMethodDiscovery"}));
+        thingClass.insert("interfaces", QJsonArray({"power", "connectable", "smartmeterconsumer"}));
+        QJsonArray paramTypes;
+        for (int j = 0; j < 4; j++) {
+            QJsonObject paramType;
+            paramType.insert("id", QUuid::createUuid().toString());
+            paramType.insert("name", QString("param%1").arg(j));
+            paramType.insert("displayName", QString("Parameter %1").arg(j));
+            paramType.insert("type", "String");
+            paramType.insert("index", j);
+            paramType.insert("defaultValue", "");
+            paramTypes.append(paramType);
+        }
+        thingClass.insert("paramTypes", paramTypes);
+        QJsonArray stateTypes;
+        QJsonArray actionTypes;
+        QJsonArray eventTypes;
+        for (int j = 0; j < 12; j++) {
+            QUuid stateTypeId = QUuid::createUuid();
+            QJsonObject stateType;
+            stateType.insert("id", stateTypeId.toString());
+            stateType.insert("name", QString("state%1").arg(j));
+            stateType.insert("displayName", QString("State %1").arg(j));
+            stateType.insert("type", j % 2 == 0 ? "Double" : "Bool");
+            stateType.insert("defaultValue", j % 2 == 0 ? QJsonValue(0) : QJsonValue(false));
+            stateType.insert("unit", j % 2 == 0 ? "UnitWatt" : "UnitNone");
+            stateType.insert("index", j);
+            stateTypes.append(stateType);
+
+            QJsonObject eventType;
+            eventType.insert("id", stateTypeId.toString());
+            eventType.insert("name", QString("state%1").arg(j));
+            eventType.insert("displayName", QString("State %1 changed").arg(j));
+            eventType.insert("index", j);
+            eventTypes.append(eventType);
+
+            if (j % 3 == 0) {
+                QJsonObject actionType;
+                actionType.insert("id", stateTypeId.toString());
+                actionType.insert("name", QString("state%1").arg(j));
+                actionType.insert("displayName", QString("Set state %1").arg(j));
+                actionType.insert("index", j);
+                actionTypes.append(actionType);
+            }
+        }
+        thingClass.insert("stateTypes", stateTypes);
+        thingClass.insert("eventTypes", eventTypes);
+        thingClass.insert("actionTypes", actionTypes);
+        thingClasses.append(thingClass);
+    }
+    QJsonObject params;
+    params.insert("thingClasses", thingClasses);
+    params.insert("thingError", "ThingErrorNoError");
+    return params;
+}
+
+QJsonObject TestJsonRpcEncoding::createGetThingsReply(int thingCount, int stateCount) const
+{
+    QJsonArray things;
+    for (int i = 0; i < thingCount; i++) {
+        QJsonObject thing;
+        thing.insert("id", QUuid::createUuid().toString());
+        thing.insert("thingClassId", QUuid::createUuid().toString());
+        thing.insert("name", QString("Thing %1").arg(i));
+        thing.insert("setupStatus", "ThingSetupStatusComplete");
+        QJsonArray states;
+        for (int j = 0; j < stateCount; j++) {
+            QJsonObject state;
+            state.insert("stateTypeId", QUuid::createUuid().toString());
+            state.insert("value", j % 2 == 0 ? QJsonValue(j * 1.5) : QJsonValue(QString("value %1").arg(j)));
+            states.append(state);
+        }
+        thing.insert("states", states);
+        things.append(thing);
+    }
+    QJsonObject params;
+    params.insert("things", things);
+    params.insert("thingError", "ThingErrorNoError");
+    return params;
+}
+
+void TestJsonRpcEncoding::addEncodingRows()
+{
+    QTest::addColumn<QString>("encodingName");
+    QTest::addColumn<QString>("method");
+
+    QStringList encodings = JsonRpcCodec::supportedEncodings(true);
+    encodings.prepend("json");
+    foreach (const QString &method, m_payloads.keys()) {
+        foreach (const QString &encoding, encodings) {
+            QTest::newRow(qPrintable(QString("%1, %2").arg(method, encoding))) << encoding << method;
+        }
+    }
+}
+
+QTEST_MAIN(TestJsonRpcEncoding)
+#include "tst_jsonrpcencoding.moc"
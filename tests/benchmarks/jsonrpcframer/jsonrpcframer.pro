@@ -0,0 +1,6 @@
+TARGET = tst_jsonrpcframer
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_jsonrpcframer.cpp
@@ -0,0 +1,259 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "jsonrpc/jsonrpcframer.h"
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QUuid>
+
+#include <climits>
+
+class TestJsonRpcFramer: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void framing_data();
+    void framing();
+
+    void largeReply_data();
+    void largeReply();
+
+    void largeReplyLegacy_data();
+    void largeReplyLegacy();
+
+private:
+    QByteArray createGetThingsReply(int thingCount, int stateCount, QJsonDocument::JsonFormat format) const;
+    QByteArray createNotificationBurst(int count) const;
+    void addStreamRows(int maxStreamSize = INT_MAX);
+
+    QHash<QString, QByteArray> m_streams;
+    QHash<QString, int> m_messageCounts;
+};
+
+void TestJsonRpcFramer::initTestCase()
+{
+    // A big Integrations.GetThings reply, followed by a burst of StateChanged notifications as seen after an Android resume.
+    m_streams.insert("400 things, compact", createGetThingsReply(400, 40, QJsonDocument::Compact) + createNotificationBurst(2000));
+    m_messageCounts.insert("400 things, compact", 2001);
+    m_streams.insert("400 things, indented", createGetThingsReply(400, 40, QJsonDocument::Indented) + createNotificationBurst(2000));
+    m_messageCounts.insert("400 things, indented", 2001);
+    m_streams.insert("1000 things, compact", createGetThingsReply(1000, 50, QJsonDocument::Compact));
+    m_messageCounts.insert("1000 things, compact", 1);
+
+    foreach (const QString &name, m_streams.keys()) {
+        qDebug() << name << "stream size:" << m_streams.value(name).size() / 1024 << "KiB";
+    }
+}
+
+void TestJsonRpcFramer::framing_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<int>("chunkSize");
+    QTest::addColumn<QStringList>("expectedFrames");
+    QTest::addColumn<int>("expectedErrors");
+
+    QByteArray escaped = "{\"id\":1,\"params\":{\"name\":\"}\\\"{\\n\"}}\n";
+    QByteArray indented = "{\n    \"id\": 2,\n    \"params\": [\n        {\n        }\n    ]\n}\n";
+    for (int chunkSize: {1, 3, 1460}) {
+        QTest::newRow(qPrintable(QString("strings, chunk %1").arg(chunkSize))) << escaped << chunkSize << QStringList({QString::fromUtf8(escaped.trimmed())}) << 0;
+        QTest::newRow(qPrintable(QString("indented, chunk %1").arg(chunkSize))) << indented << chunkSize << QStringList({QString::fromUtf8(indented.trimmed())}) << 0;
+        QTest::newRow(qPrintable(QString("no delimiter, chunk %1").arg(chunkSize))) << QByteArray("{\"id\":3}{\"id\":4}") << chunkSize << QStringList({"{\"id\":3}", "{\"id\":4}"}) << 0;
+        QTest::newRow(qPrintable(QString("garbage, chunk %1").arg(chunkSize))) << QByteArray("foo bar\n{\"id\":5}\n") << chunkSize << QStringList({"{\"id\":5}"}) << 1;
+        QTest::newRow(qPrintable(QString("truncated, chunk %1").arg(chunkSize))) << QByteArray("{\"id\":6,\"params\":{\n{\"id\":7}\n") << chunkSize << QStringList({"{\"id\":7}"}) << 1;
+    }
+}
+
+void TestJsonRpcFramer::framing()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(int, chunkSize);
+    QFETCH(QStringList, expectedFrames);
+    QFETCH(int, expectedErrors);
+
+    JsonRpcFramer framer;
+    QStringList frames;
+    int errors = 0;
+    QByteArray frame;
+    for (int i = 0; i < input.size(); i += chunkSize) {
+        framer.append(input.mid(i, chunkSize));
+        JsonRpcFramer::FrameStatus status;
+        while ((status = framer.takeFrame(&frame)) != JsonRpcFramer::FrameStatusIncomplete) {
+            if (status == JsonRpcFramer::FrameStatusError) {
+                errors++;
+                continue;
+            }
+            frames.append(QString::fromUtf8(frame));
+        }
+    }
+
+    QCOMPARE(frames, expectedFrames);
+    QCOMPARE(errors, expectedErrors);
+    QCOMPARE(framer.bufferedBytes(), 0);
+}
+
+void TestJsonRpcFramer::largeReply_data()
+{
+    addStreamRows();
+}
+
+void TestJsonRpcFramer::largeReply()
+{
+    QFETCH(QByteArray, stream);
+    QFETCH(int, chunkSize);
+    QFETCH(int, messageCount);
+
+    int frames = 0;
+    QBENCHMARK {
+        JsonRpcFramer framer;
+        QByteArray frame;
+        frames = 0;
+        for (int i = 0; i < stream.size(); i += chunkSize) {
+            framer.append(QByteArray::fromRawData(stream.constData() + i, qMin(chunkSize, stream.size() - i)));
+            while (framer.takeFrame(&frame) == JsonRpcFramer::FrameStatusComplete) {
+                frames++;
+            }
+        }
+    }
+    QCOMPARE(frames, messageCount);
+}
+
+void TestJsonRpcFramer::largeReplyLegacy_data()
+{
+    // The legacy approach is quadratic, the larger streams would take minutes.
+    addStreamRows(4 * 1024 * 1024);
+}
+
+void TestJsonRpcFramer::largeReplyLegacy()
+{
+    QFETCH(QByteArray, stream);
+    QFETCH(int, chunkSize);
+    QFETCH(int, messageCount);
+
+    // The buffer handling JsonRpcClient::dataReceived used before the framer, for comparison.
+    // The JSON parse attempt on every incomplete chunk is what made it quadratic, so it's part of the measurement.
+    int frames = 0;
+    QBENCHMARK {
+        QByteArray buffer;
+        frames = 0;
+        for (int i = 0; i < stream.size(); i += chunkSize) {
+            buffer.append(stream.mid(i, chunkSize));
+            while (true) {
+                int splitIndex = buffer.indexOf("}\n{") + 1;
+                if (splitIndex <= 0) {
+                    splitIndex = buffer.length();
+                }
+                QJsonParseError error;
+                QJsonDocument::fromJson(buffer.left(splitIndex), &error);
+                if (error.error != QJsonParseError::NoError) {
+                    break;
+                }
+                frames++;
+                buffer = buffer.right(buffer.length() - splitIndex - 1);
+                if (buffer.isEmpty()) {
+                    break;
+                }
+            }
+        }
+    }
+    QCOMPARE(frames, messageCount);
+}
+
+void TestJsonRpcFramer::addStreamRows(int maxStreamSize)
+{
+    QTest::addColumn<QByteArray>("stream");
+    QTest::addColumn<int>("chunkSize");
+    QTest::addColumn<int>("messageCount");
+
+    foreach (const QString &name, m_streams.keys()) {
+        if (m_streams.value(name).size() > maxStreamSize) {
+            continue;
+        }
+        // Typical TCP segment size and a typical websocket/tunnel frame size
+        foreach (int chunkSize, QList<int>({1460, 16384})) {
+            QTest::newRow(qPrintable(QString("%1, chunk %2").arg(name).arg(chunkSize))) << m_streams.value(name) << chunkSize << m_messageCounts.value(name);
+        }
+    }
+}
+
+QByteArray TestJsonRpcFramer::createGetThingsReply(int thingCount, int stateCount, QJsonDocument::JsonFormat format) const
+{
+    QVariantList things;
+    for (int i = 0; i < thingCount; i++) {
+        QVariantMap thing;
+        thing.insert("id", QUuid::createUuid());
+        thing.insert("thingClassId", QUuid::createUuid());
+        thing.insert("name", QString("Thing %1 with a \"quoted\" {name}").arg(i));
+        thing.insert("setupStatus", "ThingSetupStatusComplete");
+        QVariantList states;
+        for (int j = 0; j < stateCount; j++) {
+            QVariantMap state;
+            state.insert("stateTypeId", QUuid::createUuid());
+            state.insert("value", j % 2 == 0 ? QVariant(j * 1.5) : QVariant(QString("value %1").arg(j)));
+            states.append(state);
+        }
+        thing.insert("states", states);
+        things.append(thing);
+    }
+    QVariantMap params;
+    params.insert("things", things);
+    params.insert("thingError", "ThingErrorNoError");
+    QVariantMap reply;
+    reply.insert("id", 1);
+    reply.insert("status", "success");
+    reply.insert("params", params);
+    return QJsonDocument::fromVariant(reply).toJson(format) + "\n";
+}
+
+QByteArray TestJsonRpcFramer::createNotificationBurst(int count) const
+{
+    QByteArray ret;
+    QUuid thingId = QUuid::createUuid();
+    QUuid stateTypeId = QUuid::createUuid();
+    for (int i = 0; i < count; i++) {
+        QVariantMap params;
+        params.insert("thingId", thingId);
+        params.insert("stateTypeId", stateTypeId);
+        params.insert("value", i);
+        QVariantMap notification;
+        notification.insert("id", i);
+        notification.insert("notification", "Integrations.StateChanged");
+        notification.insert("params", params);
+        ret.append(QJsonDocument::fromVariant(notification).toJson(QJsonDocument::Compact) + "\n");
+    }
+    return ret;
+}
+
+QTEST_MAIN(TestJsonRpcFramer)
+#include "tst_jsonrpcframer.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_logpayload
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_logpayload.cpp
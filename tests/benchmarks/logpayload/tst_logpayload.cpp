@@ -0,0 +1,222 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "logging.h"
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QUuid>
+
+#include <climits>
+
+Q_LOGGING_CATEGORY(dcBenchmark, "Benchmark")
+
+static void discardMessage(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+/*
+ * Replays a steady-state session, a GetThingClasses reply followed by a stream of state
+ * change notifications, through debug logging the way the JSON-RPC handlers do it. Compares
+ * serialising the payload in the log statement against LogPayload, with the category on and off,
+ * and reports how many bytes of JSON each of them produced.
+ */
+class TestLogPayload: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void serialisation_data();
+    void serialisation();
+
+    void truncation();
+
+    void session_data();
+    void session();
+
+private:
+    QVariantMap createThingClassesReply(int thingClassCount) const;
+    QVariantMap createStateChangedNotification(int index) const;
+    quint64 replay(bool lazy);
+
+    QtMessageHandler m_oldHandler = nullptr;
+    QVariantMap m_thingClassesReply;
+    QList<QVariantMap> m_notifications;
+};
+
+void TestLogPayload::initTestCase()
+{
+    m_thingClassesReply = createThingClassesReply(300);
+    for (int i = 0; i < 5000; i++) {
+        m_notifications.append(createStateChangedNotification(i));
+    }
+    qDebug() << "GetThingClasses reply:" << QJsonDocument::fromVariant(m_thingClassesReply).toJson(QJsonDocument::Compact).size() / 1024 << "KiB";
+
+    // Only the formatting is of interest here, not the output
+    m_oldHandler = qInstallMessageHandler(&discardMessage);
+}
+
+void TestLogPayload::cleanupTestCase()
+{
+    qInstallMessageHandler(m_oldHandler);
+}
+
+void TestLogPayload::serialisation_data()
+{
+    QTest::addColumn<QVariant>("data");
+
+    QTest::newRow("notification") << QVariant(createStateChangedNotification(42));
+    QTest::newRow("thing classes") << QVariant(createThingClassesReply(3));
+    QTest::newRow("escaping") << QVariant(QVariantMap({{"na\"me", "a\\b\n\"c\" ä"}, {"list", QVariantList({true, false, QVariant(), 1.5, -3})}}));
+}
+
+void TestLogPayload::serialisation()
+{
+    QFETCH(QVariant, data);
+
+    QByteArray expected = QJsonDocument::fromVariant(data).toJson(QJsonDocument::Compact);
+    QCOMPARE(LogPayload(data, INT_MAX).toJson(), expected);
+    QCOMPARE(LogPayload(QJsonDocument::fromVariant(data), INT_MAX).toJson(), expected);
+}
+
+void TestLogPayload::truncation()
+{
+    LogPayload::resetStatistics();
+    QByteArray json = LogPayload(m_thingClassesReply, 1024).toJson();
+    QVERIFY(json.startsWith(QJsonDocument::fromVariant(m_thingClassesReply).toJson(QJsonDocument::Compact).left(1024)));
+    QVERIFY(json.endsWith("... (truncated)"));
+    QCOMPARE(LogPayload::statistics().payloads, quint64(1));
+    QCOMPARE(LogPayload::statistics().truncatedPayloads, quint64(1));
+    QCOMPARE(LogPayload::statistics().bytes, quint64(1024));
+}
+
+void TestLogPayload::session_data()
+{
+    QTest::addColumn<bool>("lazy");
+    QTest::addColumn<bool>("enabled");
+
+    QTest::newRow("toJson, category off") << false << false;
+    QTest::newRow("toJson, category on") << false << true;
+    QTest::newRow("LogPayload, category off") << true << false;
+    QTest::newRow("LogPayload, category on") << true << true;
+}
+
+void TestLogPayload::session()
+{
+    QFETCH(bool, lazy);
+    QFETCH(bool, enabled);
+
+    const_cast<QLoggingCategory&>(dcBenchmark()).setEnabled(QtDebugMsg, enabled);
+
+    quint64 bytes = 0;
+    QBENCHMARK {
+        bytes = replay(lazy);
+    }
+
+    const_cast<QLoggingCategory&>(dcBenchmark()).setEnabled(QtDebugMsg, false);
+    qInstallMessageHandler(m_oldHandler);
+    qDebug() << QTest::currentDataTag() << "serialised" << bytes / 1024 << "KiB of JSON per session";
+    qInstallMessageHandler(&discardMessage);
+}
+
+quint64 TestLogPayload::replay(bool lazy)
+{
+    quint64 bytes = 0;
+    if (lazy) {
+        LogPayload::resetStatistics();
+        qCDebug(dcBenchmark()) << "GetThingClasses response:" << LogPayload(m_thingClassesReply);
+        foreach (const QVariantMap &notification, m_notifications) {
+            qCDebug(dcBenchmark()) << "Incoming notification:" << LogPayload(notification);
+        }
+        bytes = LogPayload::statistics().bytes;
+    } else {
+        // What the handlers used to do
+        auto toJson = [&bytes](const QVariantMap &data) {
+            QByteArray json = QJsonDocument::fromVariant(data).toJson();
+            bytes += json.size();
+            return json;
+        };
+        qCDebug(dcBenchmark()) << "GetThingClasses response:" << qUtf8Printable(toJson(m_thingClassesReply));
+        foreach (const QVariantMap &notification, m_notifications) {
+            qCDebug(dcBenchmark()) << "Incoming notification:" << qUtf8Printable(toJson(notification));
+        }
+    }
+    return bytes;
+}
+
+QVariantMap TestLogPayload::createThingClassesReply(int thingClassCount) const
+{
+    QVariantList thingClasses;
+    for (int i = 0; i < thingClassCount; i++) {
+        QVariantList stateTypes;
+        for (int j = 0; j < 30; j++) {
+            QVariantMap stateType;
+            stateType.insert("id", QUuid::createUuid().toString().remove('{').remove('}'));
+            stateType.insert("name", QString("state%1").arg(j));
+            stateType.insert("displayName", QString("State %1 of thing class %2").arg(j).arg(i));
+            stateType.insert("type", "Double");
+            stateType.insert("defaultValue", 0);
+            stateType.insert("minValue", -100);
+            stateType.insert("maxValue", 100.5);
+            stateType.insert("unit", "UnitWatt");
+            stateTypes.append(stateType);
+        }
+        QVariantMap thingClass;
+        thingClass.insert("id", QUuid::createUuid().toString().remove('{').remove('}'));
+        thingClass.insert("name", QString("thingClass%1").arg(i));
+        thingClass.insert("displayName", QString("Thing class %1").arg(i));
+        thingClass.insert("interfaces", QStringList({"power", "connectable"}));
+        thingClass.insert("stateTypes", stateTypes);
+        thingClasses.append(thingClass);
+    }
+    QVariantMap params;
+    params.insert("thingClasses", thingClasses);
+    return params;
+}
+
+QVariantMap TestLogPayload::createStateChangedNotification(int index) const
+{
+    QVariantMap params;
+    params.insert("thingId", QUuid(index, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0).toString().remove('{').remove('}'));
+    params.insert("stateTypeId", QUuid(0, index % 30, 0, 0, 0, 0, 0, 0, 0, 0, 0).toString().remove('{').remove('}'));
+    params.insert("value", index * 0.25);
+    QVariantMap notification;
+    notification.insert("id", index);
+    notification.insert("notification", "Integrations.StateChanged");
+    notification.insert("params", params);
+    return notification;
+}
+
+QTEST_MAIN(TestLogPayload)
+#include "tst_logpayload.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_scripthighlighter
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_scripthighlighter.cpp
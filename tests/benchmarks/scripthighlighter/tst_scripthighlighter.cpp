@@ -0,0 +1,380 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "scriptsyntaxhighlighter.h"
+
+#include <QtTest>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextLayout>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSyntaxHighlighter>
+#include <QUuid>
+
+// The regular expression based highlighter from before the tokenizer, for comparison
+class LegacyHighlighter: public QSyntaxHighlighter
+{
+public:
+    LegacyHighlighter(QTextDocument *document): QSyntaxHighlighter(document)
+    {
+        HighlightingRule rule;
+        QTextCharFormat format;
+
+        format.setForeground(QColor("#800080"));
+        rule.pattern = QRegularExpression("\\b[A-Z][a-zA-Z0-9_]+\\b");
+        rule.format = format;
+        highlightingRules.append(rule);
+
+        format.setForeground(QColor("#800000"));
+        rule.pattern = QRegularExpression("[a-zA-Z][a-zA-Z0-9_.]+:");
+        rule.format = format;
+        highlightingRules.append(rule);
+
+        format.clearForeground();
+        rule.pattern = QRegularExpression("import .*$");
+        rule.format = format;
+        highlightingRules.append(rule);
+
+        QStringList keywords {
+            "if", "else", "return", "import", "signal", "property", "function", "readonly", "alias",
+            "for", "while", "break", "switch", "case", "default", "var", "null", "undefined",
+            "string", "bool", "int", "real", "double", "date", "true", "false"
+        };
+        format.setForeground(QColor("#80831a"));
+        foreach (const QString &keyword, keywords) {
+            rule.pattern = QRegularExpression("\\b" + keyword + "\\b");
+            rule.format = format;
+            highlightingRules.append(rule);
+        }
+
+        format.setForeground(Qt::darkGreen);
+        rule.format = format;
+        rule.pattern = QRegularExpression(R"**((?<!\\)([\"'])(.*?)(?<!\\)\1)**", QRegularExpression::DotMatchesEverythingOption | QRegularExpression::MultilineOption);
+        highlightingRules.append(rule);
+
+        format.setForeground(Qt::darkGray);
+        rule.format = format;
+        rule.pattern = QRegularExpression("//.*$");
+        highlightingRules.append(rule);
+        rule.pattern = QRegularExpression("/*.*\\*/");
+        highlightingRules.append(rule);
+    }
+
+protected:
+    void highlightBlock(const QString &text) override
+    {
+        foreach (const HighlightingRule &rule, highlightingRules) {
+            QRegularExpression expression(rule.pattern);
+            QRegularExpressionMatchIterator matches = expression.globalMatch(text);
+            while (matches.hasNext()) {
+                QRegularExpressionMatch match = matches.next();
+                setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+            }
+        }
+        if (text.trimmed().startsWith("import")) {
+            setCurrentBlockState(1);
+        } else if (text.trimmed().startsWith("Action")) {
+            setCurrentBlockState(2);
+        } else if (text.trimmed().startsWith("thingId:")) {
+            setCurrentBlockState(3);
+        } else {
+            setCurrentBlockState(0);
+        }
+    }
+
+private:
+    struct HighlightingRule
+    {
+        QRegularExpression pattern;
+        QTextCharFormat format;
+    };
+    QVector<HighlightingRule> highlightingRules;
+};
+
+class TestScriptHighlighter: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void highlight();
+
+    void incremental_data();
+    void incremental();
+
+    void typing_data();
+    void typing();
+
+    void typingLegacy_data();
+    void typingLegacy();
+
+private:
+    QString createScript(int items) const;
+    QColor colorAt(QTextDocument *document, int position) const;
+    QString dump(QTextDocument *document) const;
+
+    // QSyntaxHighlighter does the first pass on a new document from the event loop
+    void waitForHighlighting() const;
+};
+
+void TestScriptHighlighter::highlight()
+{
+    QTextDocument document;
+    document.setPlainText(
+                "import QtQuick 2.0\n"
+                "\n"
+                "Item {\n"
+                "    ThingAction {\n"
+                "        id: lampAction\n"
+                "        thingId: \"{6c4ed3ff-3f1e-4b4a-8b9e-9c7e1a7fb5c4}\" // Lamp \"one\"\n"
+                "        property string label: 'it\\'s \"quoted\"'\n"
+                "    }\n"
+                "    /* Item {\n"
+                "       property: \"commented out\" */ Timer { }\n"
+                "    property var text: `multi\n"
+                "        Item line`\n"
+                "    Component.onCompleted: if (x > 0x1F) lampAction.execute({})\n"
+                "}\n");
+
+    ScriptSyntaxHighlighter highlighter;
+    highlighter.setTextDocument(&document);
+    waitForHighlighting();
+
+    const QColor className("#800080");
+    const QColor binding("#800000");
+    const QColor keyword("#80831a");
+    const QColor string(Qt::darkGreen);
+    const QColor comment(Qt::darkGray);
+
+    QString text = document.toPlainText();
+    auto colorOf = [&](const QString &token, int from = 0) {
+        int position = text.indexOf(token, from);
+        return position < 0 ? QColor(Qt::transparent) : colorAt(&document, position);
+    };
+
+    QCOMPARE(colorOf("import"), keyword);
+    QCOMPARE(colorOf("QtQuick"), QColor());
+    QCOMPARE(colorOf("Item"), className);
+    QCOMPARE(colorOf("ThingAction"), className);
+    QCOMPARE(colorOf("id:"), binding);
+    QCOMPARE(colorOf("lampAction"), QColor());
+    QCOMPARE(colorOf("thingId:"), binding);
+    QCOMPARE(colorOf("{6c4ed3ff"), string);
+    QCOMPARE(colorOf("Lamp"), comment);
+    QCOMPARE(colorOf("one"), comment);
+    QCOMPARE(colorOf("property string"), keyword);
+    QCOMPARE(colorOf("string label"), keyword);
+    QCOMPARE(colorOf("label:"), binding);
+    QCOMPARE(colorOf("s \"quoted"), string);
+    QCOMPARE(colorOf("quoted"), string);
+    QCOMPARE(colorOf("Item {", text.indexOf("/*")), comment);
+    QCOMPARE(colorOf("property:"), comment);
+    QCOMPARE(colorOf("Timer"), className);
+    QCOMPARE(colorOf("multi"), string);
+    QCOMPARE(colorOf("Item line"), string);
+    QCOMPARE(colorOf("Component.onCompleted:"), binding);
+    QCOMPARE(colorOf("if (x"), keyword);
+    QCOMPARE(colorOf("x1F"), QColor());
+
+    // Opening a comment recolours the following lines, closing it again restores them
+    QTextCursor cursor(&document);
+    cursor.setPosition(text.indexOf("ThingAction"));
+    cursor.insertText("/*");
+    text = document.toPlainText();
+    QCOMPARE(colorOf("thingId:"), comment);
+    QCOMPARE(colorOf("Item {", text.indexOf("/* Item")), comment);
+    QCOMPARE(colorOf("Timer"), className);
+
+    cursor.insertText("*/");
+    text = document.toPlainText();
+    QCOMPARE(colorOf("ThingAction"), className);
+    QCOMPARE(colorOf("thingId:"), binding);
+}
+
+void TestScriptHighlighter::incremental_data()
+{
+    QTest::addColumn<int>("seed");
+
+    for (int seed = 1; seed <= 5; seed++) {
+        QTest::newRow(qPrintable(QString("seed %1").arg(seed))) << seed;
+    }
+}
+
+void TestScriptHighlighter::incremental()
+{
+    QFETCH(int, seed);
+
+    // Random edits, after each of which the highlighting must match a document highlighted from scratch
+    QRandomGenerator random(seed);
+    const QStringList snippets = {
+        "x", "\n", "/*", "*/", "\"", "'", "`", "\\", "// ", "Item%1 ", "label%1: ", "property ", "\"a\\\nb\"\n"
+    };
+
+    QTextDocument document;
+    document.setPlainText(createScript(10));
+    ScriptSyntaxHighlighter highlighter;
+    highlighter.setTextDocument(&document);
+    waitForHighlighting();
+
+    for (int i = 0; i < 200; i++) {
+        QTextCursor cursor(&document);
+        int position = random.bounded(document.characterCount());
+        cursor.setPosition(position);
+        if (random.bounded(3) == 0) {
+            cursor.setPosition(qMin(position + random.bounded(40), document.characterCount() - 1), QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+        } else {
+            cursor.insertText(snippets.at(random.bounded(snippets.count())).arg(i));
+        }
+
+        QTextDocument reference;
+        reference.setPlainText(document.toPlainText());
+        ScriptSyntaxHighlighter referenceHighlighter;
+        referenceHighlighter.setTextDocument(&reference);
+        waitForHighlighting();
+        QCOMPARE(dump(&document), dump(&reference));
+    }
+}
+
+void TestScriptHighlighter::typing_data()
+{
+    QTest::addColumn<int>("items");
+
+    // An item is about 15 lines
+    QTest::newRow("1500 lines") << 100;
+    QTest::newRow("7500 lines") << 500;
+    QTest::newRow("30000 lines") << 2000;
+}
+
+void TestScriptHighlighter::typing()
+{
+    QFETCH(int, items);
+
+    QTextDocument document;
+    document.setPlainText(createScript(items));
+    ScriptSyntaxHighlighter highlighter;
+    highlighter.setTextDocument(&document);
+    waitForHighlighting();
+
+    // Typing a property value in the middle of the script
+    QTextCursor cursor = document.find("interval: ", document.characterCount() / 2);
+    QVERIFY(!cursor.isNull());
+    cursor.clearSelection();
+    int keys = 0;
+    QBENCHMARK {
+        cursor.insertText(QString::number(keys++ % 10));
+    }
+}
+
+void TestScriptHighlighter::typingLegacy_data()
+{
+    typing_data();
+}
+
+void TestScriptHighlighter::typingLegacy()
+{
+    QFETCH(int, items);
+
+    QTextDocument document;
+    document.setPlainText(createScript(items));
+    LegacyHighlighter highlighter(&document);
+    waitForHighlighting();
+
+    QTextCursor cursor = document.find("interval: ", document.characterCount() / 2);
+    QVERIFY(!cursor.isNull());
+    cursor.clearSelection();
+    int keys = 0;
+    QBENCHMARK {
+        cursor.insertText(QString::number(keys++ % 10));
+    }
+}
+
+QString TestScriptHighlighter::createScript(int items) const
+{
+    QString script = "import QtQuick 2.0\nimport nymea 1.0\n\nItem {\n";
+    for (int i = 0; i < items; i++) {
+        QString thingId = QUuid::createUuid().toString();
+        script += QString("    ThingState {\n"
+                          "        id: state%1\n"
+                          "        thingId: \"%2\" // Thing %1\n"
+                          "        stateName: \"power\"\n"
+                          "        onValueChanged: {\n"
+                          "            /* Only switch on,\n"
+                          "               never off */\n"
+                          "            if (value) {\n"
+                          "                timer%1.start()\n"
+                          "            }\n"
+                          "        }\n"
+                          "    }\n"
+                          "    Timer {\n"
+                          "        id: timer%1; interval: 1000\n"
+                          "        onTriggered: action%1.execute({\"power\": false})\n"
+                          "    }\n"
+                          "    ThingAction { id: action%1; thingId: \"%2\"; actionName: 'power' }\n").arg(i).arg(thingId);
+    }
+    script += "}\n";
+    return script;
+}
+
+QColor TestScriptHighlighter::colorAt(QTextDocument *document, int position) const
+{
+    QTextBlock block = document->findBlock(position);
+    int offset = position - block.position();
+    foreach (const QTextLayout::FormatRange &range, block.layout()->formats()) {
+        if (offset >= range.start && offset < range.start + range.length && range.format.hasProperty(QTextFormat::ForegroundBrush)) {
+            return range.format.foreground().color();
+        }
+    }
+    return QColor();
+}
+
+QString TestScriptHighlighter::dump(QTextDocument *document) const
+{
+    QStringList ret;
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        QStringList ranges;
+        foreach (const QTextLayout::FormatRange &range, block.layout()->formats()) {
+            if (range.format.hasProperty(QTextFormat::ForegroundBrush)) {
+                ranges.append(QString("%1+%2 %3").arg(range.start).arg(range.length).arg(range.format.foreground().color().name()));
+            }
+        }
+        ret.append(QString("%1: %2 | %3").arg(block.blockNumber()).arg(block.text()).arg(ranges.join(", ")));
+    }
+    return ret.join('\n');
+}
+
+void TestScriptHighlighter::waitForHighlighting() const
+{
+    QCoreApplication::processEvents();
+}
+
+QTEST_MAIN(TestScriptHighlighter)
+#include "tst_scripthighlighter.moc"
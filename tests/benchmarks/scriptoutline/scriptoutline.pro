@@ -0,0 +1,6 @@
+TARGET = tst_scriptoutline
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_scriptoutline.cpp
@@ -0,0 +1,327 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "scripting/scriptoutline.h"
+
+#include <QtTest>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QRandomGenerator>
+#include <QUuid>
+
+class TestScriptOutline: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void outline();
+
+    void incremental_data();
+    void incremental();
+
+    void typing_data();
+    void typing();
+
+    void typingLegacy_data();
+    void typingLegacy();
+
+private:
+    QString createScript(int items) const;
+    QString dump(ScriptOutline *outline) const;
+
+    // What CodeCompletion did on every cursor move before the outline, for comparison
+    QString legacyBlockName(QTextDocument *document, int position) const;
+    QHash<QString, QString> legacyIdTypes(QTextDocument *document) const;
+};
+
+void TestScriptOutline::outline()
+{
+    QTextDocument document;
+    document.setPlainText(
+                "import QtQuick 2.0\n"
+                "import nymea 1.0\n"
+                "\n"
+                "Item {\n"
+                "    ThingAction {\n"
+                "        id: lampAction\n"
+                "        thingId: \"{6c4ed3ff-3f1e-4b4a-8b9e-9c7e1a7fb5c4}\" // Lamp\n"
+                "        actionName: \"power\"\n"
+                "    }\n"
+                "    Timer {\n"
+                "        id: timer; interval: 500\n"
+                "        property string label: \"{ not a block }\"\n"
+                "        onTriggered: {\n"
+                "            lampAction.execute({\"power\": true})\n"
+                "        }\n"
+                "        function restart(delay) {\n"
+                "            interval = delay\n"
+                "        }\n"
+                "    }\n"
+                "}\n");
+
+    ScriptOutline outline;
+    outline.setDocument(&document);
+
+    QCOMPARE(outline.blockCount(), 6);
+    QCOMPARE(outline.ids(), QStringList({"lampAction", "timer"}));
+    QCOMPARE(outline.balance(), 0);
+
+    const ScriptOutline::Block &action = outline.block(outline.blockForId("lampAction"));
+    QCOMPARE(action.name, QString("ThingAction"));
+    QCOMPARE(action.properties.value("actionName"), QString("power"));
+    QCOMPARE(action.properties.value("thingId"), QString("{6c4ed3ff-3f1e-4b4a-8b9e-9c7e1a7fb5c4}"));
+
+    const ScriptOutline::Block &timer = outline.block(outline.blockForId("timer"));
+    QCOMPARE(timer.name, QString("Timer"));
+    QCOMPARE(timer.properties.value("interval"), QString("500"));
+    QVERIFY(timer.properties.contains("label"));
+    QCOMPARE(timer.functions, QStringList({"restart"}));
+    QCOMPARE(outline.block(timer.parent).name, QString("Item"));
+
+    int inHandler = document.toPlainText().indexOf("lampAction.execute");
+    QCOMPARE(outline.block(outline.blockAt(inHandler)).name, QString("onTriggered:"));
+    QCOMPARE(outline.depthAt(inHandler), 3);
+    QCOMPARE(outline.blockAt(0), -1);
+
+    // Opening a block without closing it
+    QTextCursor cursor(&document);
+    cursor.setPosition(inHandler);
+    cursor.insertText("if (true) {\n");
+    QCOMPARE(outline.balance(), 1);
+    QCOMPARE(outline.block(outline.blockAt(cursor.position())).name, QString("(true)"));
+}
+
+void TestScriptOutline::incremental_data()
+{
+    QTest::addColumn<int>("seed");
+
+    for (int seed = 1; seed <= 5; seed++) {
+        QTest::newRow(qPrintable(QString("seed %1").arg(seed))) << seed;
+    }
+}
+
+void TestScriptOutline::incremental()
+{
+    QFETCH(int, seed);
+
+    // Random edits, after each of which the outline must match one built from scratch
+    QRandomGenerator random(seed);
+    const QStringList snippets = {
+        "x", "\n", "{", "}", "\n    }\n", "ThingState {\n    id: state%1\n    stateName: \"power\"\n}\n",
+        "function foo%1() {\n", "\"{\"", "// }\n", "; interval: %1", "    id: item%1\n"
+    };
+
+    QTextDocument document;
+    document.setPlainText(createScript(20));
+    ScriptOutline outline;
+    outline.setDocument(&document);
+
+    for (int i = 0; i < 200; i++) {
+        QTextCursor cursor(&document);
+        int position = random.bounded(document.characterCount());
+        cursor.setPosition(position);
+        if (random.bounded(3) == 0) {
+            cursor.setPosition(qMin(position + random.bounded(40), document.characterCount() - 1), QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+        } else {
+            cursor.insertText(snippets.at(random.bounded(snippets.count())).arg(i));
+        }
+
+        QTextDocument reference;
+        reference.setPlainText(document.toPlainText());
+        ScriptOutline referenceOutline;
+        referenceOutline.setDocument(&reference);
+        QCOMPARE(dump(&outline), dump(&referenceOutline));
+
+        int probe = random.bounded(document.characterCount());
+        QCOMPARE(outline.blockAt(probe), referenceOutline.blockAt(probe));
+        QCOMPARE(outline.depthAt(probe), referenceOutline.depthAt(probe));
+    }
+}
+
+void TestScriptOutline::typing_data()
+{
+    QTest::addColumn<int>("items");
+
+    // An item is about 15 lines
+    QTest::newRow("300 lines") << 20;
+    QTest::newRow("1500 lines") << 100;
+    QTest::newRow("7500 lines") << 500;
+}
+
+void TestScriptOutline::typing()
+{
+    QFETCH(int, items);
+
+    QTextDocument document;
+    document.setPlainText(createScript(items));
+    ScriptOutline outline;
+    outline.setDocument(&document);
+
+    // Typing a property value in the middle of the script, and what completion asks for after every key
+    QTextCursor cursor = document.find("interval: ", document.characterCount() / 2);
+    QVERIFY(!cursor.isNull());
+    cursor.clearSelection();
+    int keys = 0;
+    QBENCHMARK {
+        cursor.insertText(QString::number(keys++ % 10));
+        QVERIFY(outline.blockAt(cursor.position()) >= 0);
+        QVERIFY(!outline.ids().isEmpty());
+        QVERIFY(outline.blockForId("timer0") >= 0);
+    }
+}
+
+void TestScriptOutline::typingLegacy_data()
+{
+    QTest::addColumn<int>("items");
+
+    // The full scans are quadratic, larger scripts would take minutes
+    QTest::newRow("300 lines") << 20;
+    QTest::newRow("1500 lines") << 100;
+}
+
+void TestScriptOutline::typingLegacy()
+{
+    QFETCH(int, items);
+
+    QTextDocument document;
+    document.setPlainText(createScript(items));
+
+    QTextCursor cursor = document.find("interval: ", document.characterCount() / 2);
+    QVERIFY(!cursor.isNull());
+    cursor.clearSelection();
+    int keys = 0;
+    QBENCHMARK {
+        cursor.insertText(QString::number(keys++ % 10));
+        QVERIFY(!legacyBlockName(&document, cursor.position()).isEmpty());
+        QVERIFY(!legacyIdTypes(&document).isEmpty());
+    }
+}
+
+QString TestScriptOutline::createScript(int items) const
+{
+    QString script = "import QtQuick 2.0\nimport nymea 1.0\n\nItem {\n";
+    for (int i = 0; i < items; i++) {
+        QString thingId = QUuid::createUuid().toString();
+        script += QString("    ThingState {\n"
+                          "        id: state%1\n"
+                          "        thingId: \"%2\" // Thing %1\n"
+                          "        stateName: \"power\"\n"
+                          "        onValueChanged: {\n"
+                          "            if (value) {\n"
+                          "                timer%1.start()\n"
+                          "            }\n"
+                          "        }\n"
+                          "    }\n"
+                          "    Timer {\n"
+                          "        id: timer%1; interval: 1000\n"
+                          "        onTriggered: action%1.execute({\"power\": false})\n"
+                          "    }\n"
+                          "    ThingAction { id: action%1; thingId: \"%2\"; actionName: \"power\" }\n").arg(i).arg(thingId);
+    }
+    script += "}\n";
+    return script;
+}
+
+QString TestScriptOutline::dump(ScriptOutline *outline) const
+{
+    QStringList ret;
+    ret.append("ids: " + outline->ids().join(","));
+    foreach (const QString &id, outline->ids()) {
+        ret.append(QString("%1 -> %2").arg(id).arg(outline->blockForId(id)));
+    }
+    ret.append(QString("balance: %1").arg(outline->balance()));
+    for (int i = 0; i < outline->blockCount(); i++) {
+        const ScriptOutline::Block &block = outline->block(i);
+        QStringList properties;
+        foreach (const QString &name, block.properties.keys()) {
+            properties.append(name + "=" + block.properties.value(name));
+        }
+        properties.sort();
+        ret.append(QString("%1 %2 parent %3 %4:%5-%6:%7 [%8] (%9)").arg(i).arg(block.name).arg(block.parent)
+                   .arg(block.startLine).arg(block.startColumn).arg(block.endLine).arg(block.endColumn)
+                   .arg(properties.join(",")).arg(block.functions.join(",")));
+    }
+    return ret.join("\n");
+}
+
+QString TestScriptOutline::legacyBlockName(QTextDocument *document, int position) const
+{
+    QTextCursor blockStart = document->find("{", position, QTextDocument::FindBackward);
+    QTextCursor blockEnd = document->find("}", position, QTextDocument::FindBackward);
+    while (blockEnd.position() > blockStart.position() && !blockStart.isNull()) {
+        blockStart = document->find("{", blockStart, QTextDocument::FindBackward);
+        blockEnd = document->find("}", blockEnd, QTextDocument::FindBackward);
+    }
+    if (blockStart.isNull()) {
+        return QString();
+    }
+
+    QTextCursor tmp = blockStart;
+    blockEnd = blockStart;
+    while (!tmp.isNull() && blockEnd >= tmp) {
+        tmp = document->find("{", tmp.position());
+        blockEnd = document->find("}", blockEnd.position());
+    }
+
+    QString name = blockStart.block().text();
+    name.remove(QRegExp(" *\\{ *"));
+    while (name.contains(" ")) {
+        name.remove(QRegExp(".* "));
+    }
+    return name;
+}
+
+QHash<QString, QString> TestScriptOutline::legacyIdTypes(QTextDocument *document) const
+{
+    QHash<QString, QString> ret;
+    QTextCursor tmp = QTextCursor(document);
+    while (!tmp.atEnd()) {
+        tmp.movePosition(QTextCursor::StartOfWord, QTextCursor::MoveAnchor);
+        tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
+        QString word = tmp.selectedText();
+        if (word == "id") {
+            tmp.movePosition(QTextCursor::NextWord, QTextCursor::MoveAnchor);
+            tmp.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
+            QString idName = tmp.selectedText();
+            QString name = legacyBlockName(document, tmp.position());
+            if (!name.isEmpty()) {
+                ret.insert(idName, name);
+            }
+        }
+        tmp.movePosition(QTextCursor::NextWord);
+    }
+    return ret;
+}
+
+QTEST_MAIN(TestScriptOutline)
+#include "tst_scriptoutline.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_things
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_things.cpp
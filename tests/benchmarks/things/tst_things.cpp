@@ -0,0 +1,218 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "jsonrpc/jsonrpcclient.h"
+#include "thingmanager.h"
+#include "things.h"
+#include "types/thing.h"
+#include "types/thingclass.h"
+#include "types/states.h"
+#include "types/state.h"
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+
+class TestThings: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void lookup();
+    void lookupLinear();
+
+    void stateChangedThroughput_data();
+    void stateChangedThroughput();
+
+private:
+    void applyStateChanged(const QJsonObject &params);
+
+    JsonRpcClient *m_jsonRpcClient = nullptr;
+    ThingManager *m_thingManager = nullptr;
+    Things *m_things = nullptr;
+    ThingClass *m_thingClass = nullptr;
+    QList<QUuid> m_thingIds;
+    QList<QUuid> m_stateTypeIds;
+    QList<QByteArray> m_notifications;
+    int m_dataChangedCount = 0;
+};
+
+void TestThings::initTestCase()
+{
+    const int thingCount = 1000;
+    const int stateCount = 50;
+
+    m_jsonRpcClient = new JsonRpcClient(this);
+    m_thingManager = new ThingManager(m_jsonRpcClient, this);
+    m_things = m_thingManager->things();
+    m_thingClass = new ThingClass(this);
+    m_thingClass->setId(QUuid::createUuid());
+
+    for (int i = 0; i < stateCount; i++) {
+        m_stateTypeIds.append(QUuid::createUuid());
+    }
+
+    QList<Thing*> things;
+    for (int i = 0; i < thingCount; i++) {
+        Thing *thing = new Thing(m_thingManager, m_thingClass);
+        thing->setId(QUuid::createUuid());
+        thing->setName(QString("Thing %1").arg(i));
+        States *states = new States(thing);
+        foreach (const QUuid &stateTypeId, m_stateTypeIds) {
+            states->addState(new State(thing->id(), stateTypeId, QVariant(0), states));
+        }
+        thing->setStates(states);
+        things.append(thing);
+        m_thingIds.append(thing->id());
+    }
+    m_things->addThings(things);
+    QCOMPARE(m_things->rowCount(), thingCount);
+
+    connect(m_things, &Things::dataChanged, this, [this](){ m_dataChangedCount++; });
+
+    // Pre-serialize a batch of Integrations.StateChanged notifications spread over all things and states
+    for (int i = 0; i < 10000; i++) {
+        QJsonObject params;
+        params.insert("thingId", m_thingIds.at(QRandomGenerator::global()->bounded(thingCount)).toString());
+        params.insert("stateTypeId", m_stateTypeIds.at(QRandomGenerator::global()->bounded(stateCount)).toString());
+        params.insert("value", i);
+        QJsonObject notification;
+        notification.insert("id", i);
+        notification.insert("notification", "Integrations.StateChanged");
+        notification.insert("params", params);
+        m_notifications.append(QJsonDocument(notification).toJson(QJsonDocument::Compact));
+    }
+}
+
+void TestThings::cleanupTestCase()
+{
+    m_things->clearModel();
+}
+
+void TestThings::lookup()
+{
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        foreach (const QUuid &thingId, m_thingIds) {
+            Thing *thing = m_things->getThing(thingId);
+            if (thing && thing->state(m_stateTypeIds.last())) {
+                found++;
+            }
+        }
+    }
+    QCOMPARE(found, m_thingIds.count());
+}
+
+void TestThings::lookupLinear()
+{
+    // The way getThing() and getState() worked before they had an index, for comparison
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        foreach (const QUuid &thingId, m_thingIds) {
+            Thing *thing = nullptr;
+            foreach (Thing *t, m_things->devices()) {
+                if (t->id() == thingId) {
+                    thing = t;
+                    break;
+                }
+            }
+            if (!thing) {
+                continue;
+            }
+            foreach (State *state, thing->states()->states()) {
+                if (state->stateTypeId() == m_stateTypeIds.last()) {
+                    found++;
+                    break;
+                }
+            }
+        }
+    }
+    QCOMPARE(found, m_thingIds.count());
+}
+
+void TestThings::stateChangedThroughput_data()
+{
+    QTest::addColumn<bool>("parse");
+
+    QTest::newRow("lookup and update") << false;
+    QTest::newRow("parse, lookup and update") << true;
+}
+
+void TestThings::stateChangedThroughput()
+{
+    QFETCH(bool, parse);
+
+    QList<QJsonObject> parsed;
+    foreach (const QByteArray &notification, m_notifications) {
+        parsed.append(QJsonDocument::fromJson(notification).object().value("params").toObject());
+    }
+
+    int round = 0;
+    QBENCHMARK {
+        m_dataChangedCount = 0;
+        for (int i = 0; i < m_notifications.count(); i++) {
+            QJsonObject params;
+            if (parse) {
+                params = QJsonDocument::fromJson(m_notifications.at(i)).object().value("params").toObject();
+            } else {
+                params = parsed.at(i);
+            }
+            // Make sure every round actually changes the value
+            params.insert("value", params.value("value").toInt() + 1 + round * m_notifications.count());
+            applyStateChanged(params);
+        }
+        round++;
+    }
+    QCOMPARE(m_dataChangedCount, m_notifications.count());
+}
+
+void TestThings::applyStateChanged(const QJsonObject &params)
+{
+    // Mirrors the Integrations.StateChanged hot path in ThingManager
+    Thing *thing = m_things->getThing(QUuid(params.value("thingId").toString()));
+    if (!thing) {
+        return;
+    }
+    State *state = thing->state(QUuid(params.value("stateTypeId").toString()));
+    if (!state) {
+        return;
+    }
+    state->setValue(params.value("value").toVariant());
+}
+
+QTEST_MAIN(TestThings)
+#include "tst_things.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_thingsproxy
+TEMPLATE = app
+
+include(../benchmarks.pri)
+
+SOURCES += tst_thingsproxy.cpp
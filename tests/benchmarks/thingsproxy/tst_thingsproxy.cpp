@@ -0,0 +1,233 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free Software
+* Foundation, GNU version 3. This project is distributed in the hope that it
+* will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+* of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "engine.h"
+#include "thingmanager.h"
+#include "thingsproxy.h"
+#include "tagsmanager.h"
+#include "types/tag.h"
+#include "types/tags.h"
+#include "types/thing.h"
+#include "types/thingclass.h"
+#include "types/statetype.h"
+#include "types/statetypes.h"
+#include "types/states.h"
+#include "types/state.h"
+
+#include <QtTest>
+#include <QRandomGenerator>
+
+class TestThingsProxy: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void refilter();
+
+    void stateChanges_data();
+    void stateChanges();
+
+    void rename();
+
+private:
+    ThingClass *createThingClass(const QStringList &interfaces, const QStringList &stateNames);
+    int expectedCriticalCount() const;
+
+    Engine *m_engine = nullptr;
+    ThingClass *m_batteryClass = nullptr;
+    ThingClass *m_lightClass = nullptr;
+    QList<Thing*> m_things;
+
+    // Stacked: connectable -> battery critical -> name filter, plus a tag filter on the side
+    ThingsProxy *m_connectableProxy = nullptr;
+    ThingsProxy *m_criticalProxy = nullptr;
+    ThingsProxy *m_nameProxy = nullptr;
+    ThingsProxy *m_tagProxy = nullptr;
+};
+
+void TestThingsProxy::initTestCase()
+{
+    const int thingCount = 1000;
+
+    m_engine = new Engine(this);
+    m_batteryClass = createThingClass({"battery", "connectable", "temperaturesensor"}, {"batteryCritical", "batteryLevel", "connected", "temperature"});
+    m_lightClass = createThingClass({"light", "power", "connectable"}, {"power", "brightness", "connected"});
+
+    QList<Thing*> things;
+    QList<Tag*> tags;
+    for (int i = 0; i < thingCount; i++) {
+        ThingClass *thingClass = i % 2 ? m_lightClass : m_batteryClass;
+        Thing *thing = new Thing(m_engine->thingManager(), thingClass);
+        thing->setId(QUuid::createUuid());
+        thing->setName(QString("Thing %1").arg(i));
+        States *states = new States(thing);
+        for (int j = 0; j < thingClass->stateTypes()->rowCount(); j++) {
+            StateType *stateType = thingClass->stateTypes()->get(j);
+            states->addState(new State(thing->id(), stateType->id(), stateType->defaultValue(), states));
+        }
+        thing->setStates(states);
+        things.append(thing);
+
+        if (i % 10 == 0) {
+            Tag *tag = new Tag("favorites", QString::number(i));
+            tag->setThingId(thing->id());
+            tags.append(tag);
+        }
+    }
+    m_things = things;
+    m_engine->thingManager()->things()->addThings(things);
+    m_engine->tagsManager()->tags()->addTags(tags);
+
+    m_connectableProxy = new ThingsProxy(this);
+    m_connectableProxy->setEngine(m_engine);
+    m_connectableProxy->setShownInterfaces({"connectable"});
+
+    m_criticalProxy = new ThingsProxy(this);
+    m_criticalProxy->setEngine(m_engine);
+    m_criticalProxy->setParentProxy(m_connectableProxy);
+    m_criticalProxy->setFilterBatteryCritical(true);
+
+    m_nameProxy = new ThingsProxy(this);
+    m_nameProxy->setEngine(m_engine);
+    m_nameProxy->setParentProxy(m_criticalProxy);
+    m_nameProxy->setNameFilter("thing 1");
+
+    m_tagProxy = new ThingsProxy(this);
+    m_tagProxy->setEngine(m_engine);
+    m_tagProxy->setFilterTagId("favorites");
+
+    QCOMPARE(m_connectableProxy->rowCount(), thingCount);
+    QCOMPARE(m_criticalProxy->rowCount(), 0);
+    QCOMPARE(m_tagProxy->rowCount(), thingCount / 10);
+}
+
+void TestThingsProxy::cleanupTestCase()
+{
+    delete m_nameProxy;
+    delete m_criticalProxy;
+    delete m_connectableProxy;
+    delete m_tagProxy;
+    m_engine->thingManager()->things()->clearModel();
+}
+
+void TestThingsProxy::refilter()
+{
+    // A filter property change re-evaluates every row of the proxy and the ones stacked on it
+    QBENCHMARK {
+        m_connectableProxy->setShownInterfaces({"battery"});
+        m_connectableProxy->setShownInterfaces({"connectable"});
+        m_tagProxy->setFilterTagValue("10");
+        m_tagProxy->setFilterTagValue(QString());
+    }
+    QCOMPARE(m_connectableProxy->rowCount(), m_things.count());
+    QCOMPARE(m_criticalProxy->rowCount(), expectedCriticalCount());
+}
+
+void TestThingsProxy::stateChanges_data()
+{
+    QTest::addColumn<QString>("stateName");
+
+    QTest::newRow("state not in any filter") << "temperature";
+    QTest::newRow("state in filter") << "batteryCritical";
+}
+
+void TestThingsProxy::stateChanges()
+{
+    QFETCH(QString, stateName);
+
+    QList<State*> states;
+    for (int i = 0; i < 10000; i++) {
+        Thing *thing = m_things.at(QRandomGenerator::global()->bounded(m_things.count() / 2) * 2);
+        states.append(thing->stateByName(stateName));
+    }
+
+    int round = 0;
+    QBENCHMARK {
+        for (int i = 0; i < states.count(); i++) {
+            State *state = states.at(i);
+            if (stateName == "batteryCritical") {
+                state->setValue(!state->value().toBool());
+            } else {
+                state->setValue(i + round * states.count());
+            }
+        }
+        round++;
+    }
+    QCOMPARE(m_criticalProxy->rowCount(), expectedCriticalCount());
+}
+
+void TestThingsProxy::rename()
+{
+    // Only the name filter depends on names, the other proxies shouldn't re-evaluate anything
+    int round = 0;
+    QBENCHMARK {
+        for (int i = 0; i < m_things.count(); i++) {
+            m_things.at(i)->setName(QString("Thing %1").arg(i + (round % 2) * m_things.count()));
+        }
+        round++;
+    }
+    QCOMPARE(m_connectableProxy->rowCount(), m_things.count());
+}
+
+ThingClass *TestThingsProxy::createThingClass(const QStringList &interfaces, const QStringList &stateNames)
+{
+    ThingClass *thingClass = new ThingClass(this);
+    thingClass->setId(QUuid::createUuid());
+    thingClass->setInterfaces(interfaces);
+    StateTypes *stateTypes = new StateTypes(thingClass);
+    foreach (const QString &stateName, stateNames) {
+        StateType *stateType = new StateType(stateTypes);
+        stateType->setId(QUuid::createUuid());
+        stateType->setName(stateName);
+        stateType->setDefaultValue(stateName == "batteryCritical" || stateName == "connected" ? QVariant(false) : QVariant(0));
+        stateTypes->addStateType(stateType);
+    }
+    thingClass->setStateTypes(stateTypes);
+    return thingClass;
+}
+
+int TestThingsProxy::expectedCriticalCount() const
+{
+    int count = 0;
+    foreach (Thing *thing, m_things) {
+        State *state = thing->stateByName("batteryCritical");
+        if (state && state->value().toBool()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+QTEST_MAIN(TestThingsProxy)
+#include "tst_thingsproxy.moc"